@@ -35,6 +35,8 @@
 
 #include <nuttx/mutex.h>
 #include <nuttx/fs/fs.h>
+#include <nuttx/fs/pagecache.h>
+#include <nuttx/drivers/drivers.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -42,22 +44,67 @@
 
 #define MAX_OPENCNT       (255)                  /* Limit of uint8_t */
 
+/* The sector cache is CONFIG_BCH_CACHE_SECTORS lines organized in sets of
+ * CONFIG_BCH_CACHE_WAYS lines.  A sector may only be held by one of the
+ * lines of set (sector % BCH_CACHE_NSETS).
+ */
+
+#define BCH_CACHE_NLINES  CONFIG_BCH_CACHE_SECTORS
+#define BCH_CACHE_NWAYS   CONFIG_BCH_CACHE_WAYS
+#define BCH_CACHE_NSETS   (BCH_CACHE_NLINES / BCH_CACHE_NWAYS)
+#define BCH_CACHE_BATCH   CONFIG_BCH_CACHE_BATCH
+
+#if BCH_CACHE_NLINES % BCH_CACHE_NWAYS != 0
+#  error CONFIG_BCH_CACHE_SECTORS must be a multiple of CONFIG_BCH_CACHE_WAYS
+#endif
+
+/* Transfers to and from the block driver, through the page cache if it is
+ * enabled.
+ */
+
+#ifdef CONFIG_FS_PAGECACHE
+#  define bchlib_hwread(bch, buffer, start, nsectors) \
+     pagecache_read((bch)->inode, buffer, start, nsectors)
+#  define bchlib_hwwrite(bch, buffer, start, nsectors) \
+     pagecache_write((bch)->inode, buffer, start, nsectors)
+#else
+#  define bchlib_hwread(bch, buffer, start, nsectors) \
+     (bch)->inode->u.i_bops->read((bch)->inode, buffer, start, nsectors)
+#  define bchlib_hwwrite(bch, buffer, start, nsectors) \
+     (bch)->inode->u.i_bops->write((bch)->inode, buffer, start, nsectors)
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
 
+struct bchlib_line_s
+{
+  size_t sector;           /* The cached sector, (size_t)-1 if none */
+  uint32_t stamp;          /* Time of the last access, for LRU */
+  bool dirty;              /* true: Data has been written to the line */
+};
+
 struct bchlib_s
 {
   FAR struct inode *inode; /* I-node of the block driver */
   uint32_t sectsize;       /* The size of one sector on the device */
   size_t nsectors;         /* Number of sectors supported by the device */
   size_t sector;           /* The current sector in the buffer */
+  size_t next;             /* The sector following the last access */
   mutex_t lock;            /* For atomic accesses to this structure */
   uint8_t refs;            /* Number of references */
-  bool dirty;              /* true: Data has been written to the buffer */
   bool readonly;           /* true: Only read operations are supported */
   bool unlinked;           /* true: The driver has been unlinked */
-  FAR uint8_t *buffer;     /* One sector buffer */
+  FAR uint8_t *buffer;     /* Data of the current sector */
+  FAR uint8_t *cache;      /* Data of all cache lines */
+#if BCH_CACHE_BATCH > 1
+  FAR uint8_t *iobuf;      /* Staging buffer of batched transfers */
+#endif
+  FAR struct bchlib_line_s *line;     /* The line of the current sector */
+  uint32_t stamp;                     /* LRU clock */
+  struct bchlib_stats_s stats;        /* Cache statistics */
+  struct bchlib_line_s lines[BCH_CACHE_NLINES];
 
 #if defined(CONFIG_BCH_ENCRYPTION)
   uint8_t key[CONFIG_BCH_ENCRYPTION_KEY_SIZE];  /* Encryption key */
@@ -85,6 +132,11 @@ EXTERN const struct file_operations g_bch_fops;
 
 EXTERN int  bchlib_flushsector(FAR struct bchlib_s *bch, bool discard);
 EXTERN int  bchlib_readsector(FAR struct bchlib_s *bch, size_t sector);
+EXTERN void bchlib_overlay(FAR struct bchlib_s *bch, FAR uint8_t *buffer,
+                           size_t sector, size_t nsectors);
+EXTERN void bchlib_invalidate(FAR struct bchlib_s *bch, size_t sector,
+                              size_t nsectors);
+EXTERN void bchlib_freecache(FAR struct bchlib_s *bch);
 
 #undef EXTERN
 #if defined(__cplusplus)
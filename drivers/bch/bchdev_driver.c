@@ -437,17 +437,51 @@ static int bch_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 
       case BIOC_DISCARD:
         {
-          /* Invalidate the sector so next read is from the device- */
+          /* Write back the dirty sectors and empty the cache so next read
+           * is from the device.
+           */
+
+          ret = bchlib_flushsector(bch, true);
+          if (ret < 0)
+            {
+              break;
+            }
 
-          bch->sector = (size_t)-1;
+#ifdef CONFIG_FS_PAGECACHE
+          pagecache_invalidate(bch->inode);
+#endif
           goto ioctl_default;
         }
 
+      case BIOC_CACHESTATS:
+        {
+          FAR struct bchlib_stats_s *stats =
+            (FAR struct bchlib_stats_s *)((uintptr_t)arg);
+
+          if (stats == NULL)
+            {
+              ret = -EINVAL;
+            }
+          else
+            {
+              memcpy(stats, &bch->stats, sizeof(*stats));
+              ret = OK;
+            }
+        }
+        break;
+
       case BIOC_FLUSH:
         {
           /* Flush any dirty pages remaining in the cache */
 
           ret = bchlib_flushsector(bch, false);
+#ifdef CONFIG_FS_PAGECACHE
+          if (ret >= 0)
+            {
+              ret = pagecache_flush(bch->inode);
+            }
+#endif
+
           if (ret < 0)
             {
               break;
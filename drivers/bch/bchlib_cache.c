@@ -27,8 +27,10 @@
 #include <nuttx/config.h>
 #include <nuttx/kmalloc.h>
 
+#include <sys/param.h>
 #include <sys/types.h>
 #include <stdbool.h>
+#include <string.h>
 #include <errno.h>
 #include <assert.h>
 #include <nuttx/debug.h>
@@ -62,10 +64,11 @@ static void bch_xor(uint32_t *R, uint32_t *A, uint32_t *B)
  ****************************************************************************/
 
 #if defined(CONFIG_BCH_ENCRYPTION)
-static int bch_cypher(FAR struct bchlib_s *bch, int encrypt)
+static int bch_cypher(FAR struct bchlib_s *bch, FAR uint8_t *data,
+                      size_t sector, int encrypt)
 {
   int blocks = bch->sectsize / 16;
-  FAR uint32_t *buffer = (FAR uint32_t *)bch->buffer;
+  FAR uint32_t *buffer = (FAR uint32_t *)data;
   int i;
 
   for (i = 0; i < blocks; i++, buffer += 16 / sizeof(uint32_t) )
@@ -73,7 +76,7 @@ static int bch_cypher(FAR struct bchlib_s *bch, int encrypt)
       uint32_t T[4];
       uint32_t X[4] =
       {
-        bch->sector, 0, 0, i
+        sector, 0, 0, i
       };
 
       aes_cypher(X, X, 16, NULL, bch->key, CONFIG_BCH_ENCRYPTION_KEY_SIZE,
@@ -92,74 +95,405 @@ static int bch_cypher(FAR struct bchlib_s *bch, int encrypt)
 #endif
 
 /****************************************************************************
- * Public Functions
+ * Name: bchlib_linedata
+ *
+ * Description:
+ *   Return the sector data of a cache line.
+ *
  ****************************************************************************/
 
+static FAR uint8_t *bchlib_linedata(FAR struct bchlib_s *bch,
+                                    FAR struct bchlib_line_s *line)
+{
+  return bch->cache + (line - bch->lines) * bch->sectsize;
+}
+
 /****************************************************************************
- * Name: bchlib_flushsector
+ * Name: bchlib_lookup
  *
  * Description:
- *   Flush the current contents of the sector buffer (if dirty)
+ *   Find the cache line holding a sector.
  *
- * Assumptions:
- *   Caller must assume mutual exclusion
+ ****************************************************************************/
+
+static FAR struct bchlib_line_s *bchlib_lookup(FAR struct bchlib_s *bch,
+                                               size_t sector)
+{
+  FAR struct bchlib_line_s *line = &bch->lines[sector % BCH_CACHE_NSETS];
+  int way;
+
+  for (way = 0; way < BCH_CACHE_NWAYS; way++, line += BCH_CACHE_NSETS)
+    {
+      if (line->sector == sector)
+        {
+          return line;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: bchlib_victim
+ *
+ * Description:
+ *   Select the line of the set of a sector to be replaced: an unused line
+ *   if any, the least recently used line otherwise.
  *
  ****************************************************************************/
 
-int bchlib_flushsector(FAR struct bchlib_s *bch, bool discard)
+static FAR struct bchlib_line_s *bchlib_victim(FAR struct bchlib_s *bch,
+                                               size_t sector)
 {
-  FAR struct inode *inode;
-  ssize_t ret = OK;
+  FAR struct bchlib_line_s *line = &bch->lines[sector % BCH_CACHE_NSETS];
+  FAR struct bchlib_line_s *victim = line;
+  int way;
 
-  /* Check if the sector has been modified and is out of synch with the
-   * media.
-   */
+  for (way = 0; way < BCH_CACHE_NWAYS; way++, line += BCH_CACHE_NSETS)
+    {
+      if (line->sector == (size_t)-1)
+        {
+          return line;
+        }
+
+      if ((int32_t)(line->stamp - victim->stamp) < 0)
+        {
+          victim = line;
+        }
+    }
+
+  return victim;
+}
+
+/****************************************************************************
+ * Name: bchlib_alloccache
+ *
+ * Description:
+ *   Allocate the cache line data and the staging buffer on first use.
+ *
+ ****************************************************************************/
+
+static int bchlib_alloccache(FAR struct bchlib_s *bch)
+{
+  size_t size = BCH_CACHE_NLINES * bch->sectsize;
+
+  if (bch->cache != NULL)
+    {
+      return OK;
+    }
+
+#if CONFIG_BCH_BUFFER_ALIGNMENT != 0
+  bch->cache = kmm_memalign(CONFIG_BCH_BUFFER_ALIGNMENT, size);
+#else
+  bch->cache = kmm_malloc(size);
+#endif
+  if (bch->cache == NULL)
+    {
+      ferr("Failed to allocate sector buffer\n");
+      return -ENOMEM;
+    }
 
-  if (bch->dirty && bch->buffer != NULL)
+#if BCH_CACHE_BATCH > 1
+  size = BCH_CACHE_BATCH * bch->sectsize;
+#  if CONFIG_BCH_BUFFER_ALIGNMENT != 0
+  bch->iobuf = kmm_memalign(CONFIG_BCH_BUFFER_ALIGNMENT, size);
+#  else
+  bch->iobuf = kmm_malloc(size);
+#  endif
+  if (bch->iobuf == NULL)
     {
-      inode = bch->inode;
+      ferr("Failed to allocate staging buffer\n");
+      kmm_free(bch->cache);
+      bch->cache = NULL;
+      return -ENOMEM;
+    }
+#endif
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bchlib_readahead
+ *
+ * Description:
+ *   Return the number of sectors to read on a miss of a sector.  A miss
+ *   of the sector following the last access starts a read-ahead of the
+ *   next sectors, up to the first sector that is already cached or whose
+ *   line would have to be written back first.
+ *
+ ****************************************************************************/
 
+static size_t bchlib_readahead(FAR struct bchlib_s *bch, size_t sector)
+{
+  size_t nsectors = 1;
+
+#if defined(CONFIG_BCH_READAHEAD) && BCH_CACHE_BATCH > 1
+  size_t limit = MIN(BCH_CACHE_BATCH, BCH_CACHE_NSETS);
+
+  if (sector != bch->next)
+    {
+      return 1;
+    }
+
+  limit = MIN(limit, bch->nsectors - sector);
+  while (nsectors < limit &&
+         bchlib_lookup(bch, sector + nsectors) == NULL &&
+         !bchlib_victim(bch, sector + nsectors)->dirty)
+    {
+      nsectors++;
+    }
+#endif
+
+  return nsectors;
+}
+
+/****************************************************************************
+ * Name: bchlib_writeback
+ *
+ * Description:
+ *   Write back a dirty line, together with the dirty lines of the sectors
+ *   following it.
+ *
+ ****************************************************************************/
+
+static int bchlib_writeback(FAR struct bchlib_s *bch,
+                            FAR struct bchlib_line_s *first)
+{
+  FAR uint8_t *data = bchlib_linedata(bch, first);
+  size_t nsectors = 1;
+  ssize_t ret;
+
+#if BCH_CACHE_BATCH > 1
+  FAR struct bchlib_line_s *line;
+
+  while (nsectors < BCH_CACHE_BATCH &&
+         (line = bchlib_lookup(bch, first->sector + nsectors)) != NULL &&
+         line->dirty)
+    {
+      nsectors++;
+    }
+
+  if (nsectors > 1)
+    {
+      size_t i;
+
+      /* Gather the adjacent sectors in the staging buffer */
+
+      for (i = 0; i < nsectors; i++)
+        {
+          line = bchlib_lookup(bch, first->sector + i);
+          memcpy(bch->iobuf + i * bch->sectsize,
+                 bchlib_linedata(bch, line), bch->sectsize);
+#  if defined(CONFIG_BCH_ENCRYPTION)
+          bch_cypher(bch, bch->iobuf + i * bch->sectsize, line->sector,
+                     CYPHER_ENCRYPT);
+#  endif
+        }
+
+      data = bch->iobuf;
+    }
+  else
+#endif
+    {
 #if defined(CONFIG_BCH_ENCRYPTION)
       /* Encrypt data as necessary */
 
-      bch_cypher(bch, CYPHER_ENCRYPT);
+      bch_cypher(bch, data, first->sector, CYPHER_ENCRYPT);
 #endif
+    }
+
+  /* Write the sectors to the media */
+
+  ret = bchlib_hwwrite(bch, data, first->sector, nsectors);
+
+#if defined(CONFIG_BCH_ENCRYPTION)
+  /* Computation overhead to save memory for extra sector buffer */
+
+  if (nsectors == 1)
+    {
+      bch_cypher(bch, data, first->sector, CYPHER_DECRYPT);
+    }
+#endif
+
+  if (ret < 0)
+    {
+      ferr("Write failed: %zd\n", ret);
+      return (int)ret;
+    }
+
+  bch->stats.writes++;
+  bch->stats.coalesced += nsectors - 1;
+
+  /* The sectors are now in sync with the media */
+
+  while (nsectors-- > 0)
+    {
+      bchlib_lookup(bch, first->sector + nsectors)->dirty = false;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bchlib_fill
+ *
+ * Description:
+ *   Read a sector, and the sectors read ahead of it, into the cache.
+ *
+ ****************************************************************************/
+
+static int bchlib_fill(FAR struct bchlib_s *bch, size_t sector,
+                       FAR struct bchlib_line_s **result)
+{
+  FAR struct bchlib_line_s *line = bchlib_victim(bch, sector);
+  FAR uint8_t *data;
+  size_t nsectors;
+  size_t i;
+  ssize_t ret;
+
+  /* Write back the victim before it is reused.  Only the run of adjacent
+   * dirty sectors around it goes out; the other dirty lines stay cached.
+   */
+
+  if (line->dirty)
+    {
+      FAR struct bchlib_line_s *first = line;
 
-      /* Write the sector to the media */
+#if BCH_CACHE_BATCH > 1
+      FAR struct bchlib_line_s *prev;
+      size_t nprev = 0;
 
-      ret = inode->u.i_bops->write(inode, bch->buffer, bch->sector, 1);
+      while (nprev + 1 < BCH_CACHE_BATCH && first->sector > 0 &&
+             (prev = bchlib_lookup(bch, first->sector - 1)) != NULL &&
+             prev->dirty)
+        {
+          first = prev;
+          nprev++;
+        }
+#endif
+
+      ret = bchlib_writeback(bch, first);
       if (ret < 0)
         {
-          ferr("Write failed: %zd\n", ret);
+          ferr("Flush failed: %zd\n", ret);
           return (int)ret;
         }
+    }
 
-#if defined(CONFIG_BCH_ENCRYPTION)
-      /* Computation overhead to save memory for extra sector buffer
-       * TODO: Add configuration switch for extra sector buffer
-       */
+  nsectors = bchlib_readahead(bch, sector);
+  data     = bchlib_linedata(bch, line);
+
+#if BCH_CACHE_BATCH > 1
+  if (nsectors > 1)
+    {
+      data = bch->iobuf;
+    }
+#endif
+
+  ret = bchlib_hwread(bch, data, sector, nsectors);
+  if (ret < 0)
+    {
+      ferr("Read failed: %zd\n", ret);
+      return (int)ret;
+    }
+
+  bch->stats.reads++;
+  bch->stats.readaheads += nsectors - 1;
+
+  /* The sectors map to distinct sets, so filling one line never replaces
+   * another line filled here.
+   */
+
+  for (i = 0; i < nsectors; i++, data += bch->sectsize)
+    {
+      FAR struct bchlib_line_s *fill =
+        i == 0 ? line : bchlib_victim(bch, sector + i);
+
+      if (nsectors > 1)
+        {
+          memcpy(bchlib_linedata(bch, fill), data, bch->sectsize);
+        }
 
-      bch_cypher(bch, CYPHER_DECRYPT);
+      fill->sector = sector + i;
+      fill->stamp  = bch->stamp;
+      fill->dirty  = false;
+
+#if defined(CONFIG_BCH_ENCRYPTION)
+      bch_cypher(bch, bchlib_linedata(bch, fill), fill->sector,
+                 CYPHER_DECRYPT);
 #endif
+    }
+
+  *result = line;
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
 
-      /* The sector is now in sync with the media */
+/****************************************************************************
+ * Name: bchlib_flushsector
+ *
+ * Description:
+ *   Write back the dirty lines of the sector cache, merging the adjacent
+ *   dirty sectors into one transfer.  The cache is emptied if discard is
+ *   true.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+int bchlib_flushsector(FAR struct bchlib_s *bch, bool discard)
+{
+  FAR struct bchlib_line_s *first;
+  int ret;
+  int i;
+
+  /* Write back in ascending sector order, so that each run of adjacent
+   * dirty sectors goes out as one request.
+   */
+
+  for (; ; )
+    {
+      first = NULL;
+      for (i = 0; i < BCH_CACHE_NLINES; i++)
+        {
+          if (bch->lines[i].dirty &&
+              (first == NULL || bch->lines[i].sector < first->sector))
+            {
+              first = &bch->lines[i];
+            }
+        }
+
+      if (first == NULL)
+        {
+          break;
+        }
 
-      bch->dirty = false;
+      ret = bchlib_writeback(bch, first);
+      if (ret < 0)
+        {
+          return ret;
+        }
     }
 
   if (discard)
     {
-      bch->sector = (size_t)-1;
+      bchlib_invalidate(bch, 0, bch->nsectors);
     }
 
-  return (int)ret;
+  return OK;
 }
 
 /****************************************************************************
  * Name: bchlib_readsector
  *
  * Description:
- *   Read the current sector contents into buffer
+ *   Make a sector the current sector, reading it into the cache if needed.
+ *   On return, bch->buffer holds the sector data and bch->line its cache
+ *   line.
  *
  * Assumptions:
  *   Caller must assume mutual exclusion
@@ -168,46 +502,133 @@ int bchlib_flushsector(FAR struct bchlib_s *bch, bool discard)
 
 int bchlib_readsector(FAR struct bchlib_s *bch, size_t sector)
 {
-  FAR struct inode *inode;
-  ssize_t ret = OK;
+  FAR struct bchlib_line_s *line;
+  int ret;
 
-  if (bch->buffer == NULL)
+  ret = bchlib_alloccache(bch);
+  if (ret < 0)
     {
-#if CONFIG_BCH_BUFFER_ALIGNMENT != 0
-      bch->buffer = kmm_memalign(CONFIG_BCH_BUFFER_ALIGNMENT, bch->sectsize);
-#else
-      bch->buffer = kmm_malloc(bch->sectsize);
-#endif
-      if (bch->buffer == NULL)
-        {
-          ferr("Failed to allocate sector buffer\n");
-          return -ENOMEM;
-        }
+      return ret;
     }
 
-  if (bch->sector != sector)
+  bch->stamp++;
+
+  line = bchlib_lookup(bch, sector);
+  if (line != NULL)
+    {
+      bch->stats.hits++;
+    }
+  else
     {
-      inode = bch->inode;
+      bch->stats.misses++;
 
-      ret = bchlib_flushsector(bch, true);
+      ret = bchlib_fill(bch, sector, &line);
       if (ret < 0)
         {
-          ferr("Flush failed: %zd\n", ret);
-          return (int)ret;
+          return ret;
         }
+    }
 
-      ret = inode->u.i_bops->read(inode, bch->buffer, sector, 1);
-      if (ret < 0)
+  line->stamp = bch->stamp;
+  bch->line   = line;
+  bch->buffer = bchlib_linedata(bch, line);
+  bch->sector = sector;
+  bch->next   = sector + 1;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bchlib_overlay
+ *
+ * Description:
+ *   Copy the dirty cached sectors of a range over the data just read from
+ *   the device, so that direct reads see the data not yet written back.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+void bchlib_overlay(FAR struct bchlib_s *bch, FAR uint8_t *buffer,
+                    size_t sector, size_t nsectors)
+{
+  FAR struct bchlib_line_s *line;
+  int i;
+
+  for (i = 0; i < BCH_CACHE_NLINES; i++)
+    {
+      line = &bch->lines[i];
+      if (line->dirty && line->sector >= sector &&
+          line->sector - sector < nsectors)
         {
-          ferr("Read failed: %zd\n", ret);
-          return (int)ret;
+          memcpy(buffer + (line->sector - sector) * bch->sectsize,
+                 bchlib_linedata(bch, line), bch->sectsize);
         }
+    }
 
-      bch->sector = sector;
-#if defined(CONFIG_BCH_ENCRYPTION)
-      bch_cypher(bch, CYPHER_DECRYPT);
-#endif
+  bch->next = sector + nsectors;
+}
+
+/****************************************************************************
+ * Name: bchlib_invalidate
+ *
+ * Description:
+ *   Drop the cached sectors of a range, dirty or not.  Used when the range
+ *   is overwritten directly on the device.
+ *
+ * Assumptions:
+ *   Caller must assume mutual exclusion
+ *
+ ****************************************************************************/
+
+void bchlib_invalidate(FAR struct bchlib_s *bch, size_t sector,
+                       size_t nsectors)
+{
+  FAR struct bchlib_line_s *line;
+  int i;
+
+  for (i = 0; i < BCH_CACHE_NLINES; i++)
+    {
+      line = &bch->lines[i];
+      if (line->sector >= sector && line->sector - sector < nsectors)
+        {
+          line->sector = (size_t)-1;
+          line->dirty  = false;
+        }
+    }
+
+  if (bch->sector >= sector && bch->sector - sector < nsectors)
+    {
+      bch->sector = (size_t)-1;
+      bch->buffer = NULL;
+      bch->line   = NULL;
     }
+}
+
+/****************************************************************************
+ * Name: bchlib_freecache
+ *
+ * Description:
+ *   Free the sector cache.  The dirty lines must have been written back.
+ *
+ ****************************************************************************/
+
+void bchlib_freecache(FAR struct bchlib_s *bch)
+{
+  if (bch->cache != NULL)
+    {
+      kmm_free(bch->cache);
+      bch->cache = NULL;
+    }
+
+#if BCH_CACHE_BATCH > 1
+  if (bch->iobuf != NULL)
+    {
+      kmm_free(bch->iobuf);
+      bch->iobuf = NULL;
+    }
+#endif
 
-  return (int)ret;
+  bch->buffer = NULL;
+  bch->line   = NULL;
 }
@@ -148,14 +148,15 @@ ssize_t bchlib_read(FAR void *handle, FAR char *buffer, off_t offset,
           nsectors = bch->nsectors - sector;
         }
 
-      ret = bch->inode->u.i_bops->read(bch->inode, (FAR uint8_t *)buffer,
-                                       sector, nsectors);
+      ret = bchlib_hwread(bch, (FAR uint8_t *)buffer, sector, nsectors);
       if (ret < 0)
         {
           ferr("ERROR: Read failed: %d\n", ret);
           return ret;
         }
 
+      bchlib_overlay(bch, (FAR uint8_t *)buffer, sector, nsectors);
+
       /* Adjust pointers and counts */
 
       sector    += nsectors;
@@ -61,6 +61,7 @@ int bchlib_setup(FAR const char *blkdev, int oflags, FAR void **handle)
   struct geometry geo;
   bool readonly = (oflags & O_ACCMODE) == O_RDONLY;
   int ret;
+  int i;
 
   DEBUGASSERT(blkdev);
 
@@ -106,13 +107,32 @@ int bchlib_setup(FAR const char *blkdev, int oflags, FAR void **handle)
       goto errout_with_bch;
     }
 
+#ifdef CONFIG_FS_PAGECACHE
+  /* Share the cached sectors with the other users of the block driver.
+   * Without the cache, accesses go to the block driver directly.
+   */
+
+  ret = pagecache_attach(bch->inode);
+  if (ret < 0)
+    {
+      fwarn("WARNING: Page cache not available: %d\n", ret);
+    }
+#endif
+
   /* Save the geometry info and complete initialization of the structure */
 
   nxmutex_init(&bch->lock);
   bch->nsectors = geo.geo_nsectors;
   bch->sectsize = geo.geo_sectorsize;
   bch->sector   = (size_t)-1;
+  bch->next     = (size_t)-1;
   bch->readonly = readonly;
+
+  for (i = 0; i < BCH_CACHE_NLINES; i++)
+    {
+      bch->lines[i].sector = (size_t)-1;
+    }
+
   *handle = bch;
   return OK;
 
@@ -66,16 +66,17 @@ int bchlib_teardown(FAR void *handle)
 
   bchlib_flushsector(bch, false);
 
+#ifdef CONFIG_FS_PAGECACHE
+  pagecache_detach(bch->inode);
+#endif
+
   /* Close the block driver */
 
   close_blockdriver(bch->inode);
 
   /* Free the BCH state structure */
 
-  if (bch->buffer)
-    {
-      kmm_free(bch->buffer);
-    }
+  bchlib_freecache(bch);
 
   nxmutex_destroy(&bch->lock);
   kmm_free(bch);
@@ -107,7 +107,7 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, off_t offset,
         }
 
       memcpy(&bch->buffer[sectoffset], buffer, nbytes);
-      bch->dirty = true;
+      bch->line->dirty = true;
 
       /* Adjust pointers and counts */
 
@@ -144,9 +144,12 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, off_t offset,
 
       nbytes = len > bch->sectsize ? bch->sectsize : len;
       memcpy(bch->buffer, buffer, nbytes);
-      bch->dirty = true;
+      bch->line->dirty = true;
 
-      /* Write the sector back to the block device */
+#if BCH_CACHE_NLINES == 1
+      /* Write the sector back to the block device.  A larger cache keeps
+       * the dirty sectors and writes adjacent ones back together.
+       */
 
       ret = bchlib_flushsector(bch, false);
       if (ret < 0)
@@ -154,6 +157,7 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, off_t offset,
           ferr("ERROR: Flush failed: %d\n", ret);
           return ret;
         }
+#endif
 
       /* Adjust pointers and counts */
 
@@ -175,20 +179,13 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, off_t offset,
           nsectors = bch->nsectors - sector;
         }
 
-      /* Flush the dirty sector to keep the sector sequence */
+      /* The cached copies of the sectors are overwritten, dirty or not */
 
-      ret = bchlib_flushsector(bch, sector <= bch->sector &&
-                               bch->sector < (sector + nsectors));
-      if (ret < 0)
-        {
-          ferr("ERROR: Flush failed: %d\n", ret);
-          return ret;
-        }
+      bchlib_invalidate(bch, sector, nsectors);
 
       /* Write the contiguous sectors */
 
-      ret = bch->inode->u.i_bops->write(bch->inode, (FAR uint8_t *)buffer,
-                                        sector, nsectors);
+      ret = bchlib_hwwrite(bch, (FAR uint8_t *)buffer, sector, nsectors);
       if (ret < 0)
         {
           ferr("ERROR: Write failed: %d\n", ret);
@@ -225,7 +222,7 @@ ssize_t bchlib_write(FAR void *handle, FAR const char *buffer, off_t offset,
       /* Copy the head end of the sector from the user buffer */
 
       memcpy(bch->buffer, buffer, len);
-      bch->dirty = true;
+      bch->line->dirty = true;
 
       /* Adjust counts */
 
@@ -39,6 +39,8 @@
 #include <errno.h>
 
 #include <nuttx/kmalloc.h>
+#include <nuttx/nuttx.h>
+#include <nuttx/fs/blkqueue.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/drivers/ramdisk.h>
 
@@ -60,6 +62,10 @@
 #define RDFLAG_UNLINK(f)       do { (f) |= RDFLAG_UNLINKED; } while (0)
 #define RDFLAG_IS_UNLINKED(f)  (((f) & RDFLAG_UNLINKED) != 0)
 
+/* Requests merged into one copy of the request queue */
+
+#define RD_QUEUE_MAXSEGS       16
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -73,6 +79,9 @@ struct rd_struct_s
 #endif
   uint8_t rd_flags;             /* See RDFLAG_* definitions */
   FAR uint8_t *rd_buffer;       /* RAM disk backup memory */
+#ifdef CONFIG_FS_BLKQUEUE
+  struct blk_queue_s rd_queue;  /* Request queue */
+#endif
 };
 
 /****************************************************************************
@@ -99,11 +108,23 @@ static int     rd_ioctl(FAR struct inode *inode, int cmd,
 #ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
 static int     rd_unlink(FAR struct inode *inode);
 #endif
+#ifdef CONFIG_FS_BLKQUEUE
+static int     rd_dispatch(FAR struct blk_queue_s *queue,
+                           FAR struct blk_request_s *batch);
+#endif
 
 /****************************************************************************
  * Private Data
  ****************************************************************************/
 
+#ifdef CONFIG_FS_BLKQUEUE
+static const struct blk_queue_ops_s g_rd_qops =
+{
+  rd_dispatch, /* dispatch */
+  NULL         /* commit   */
+};
+#endif
+
 static const struct block_operations g_bops =
 {
 #ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
@@ -333,6 +354,56 @@ static int rd_geometry(FAR struct inode *inode,
   return -EINVAL;
 }
 
+/****************************************************************************
+ * Name: rd_dispatch
+ *
+ * Description:
+ *   Copy a batch of the request queue.  The copy is done before returning.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_BLKQUEUE
+static int rd_dispatch(FAR struct blk_queue_s *queue,
+                       FAR struct blk_request_s *batch)
+{
+  FAR struct rd_struct_s *dev =
+    container_of(queue, struct rd_struct_s, rd_queue);
+  FAR struct blk_request_s *req;
+  FAR uint8_t *ptr;
+  size_t len;
+
+  if (batch->op == BLK_REQ_WRITE && !RDFLAG_IS_WRENABLED(dev->rd_flags))
+    {
+      return -EACCES;
+    }
+
+  if (batch->sector >= dev->rd_nsectors ||
+      dev->rd_nsectors - batch->sector < batch->total)
+    {
+      return batch->op == BLK_REQ_WRITE ? -EFBIG : -EINVAL;
+    }
+
+  ptr = &dev->rd_buffer[batch->sector * dev->rd_sectsize];
+  blk_batch_for_every(batch, req)
+    {
+      len = req->nsectors * dev->rd_sectsize;
+      if (batch->op == BLK_REQ_WRITE)
+        {
+          memcpy(ptr, req->buffer, len);
+        }
+      else
+        {
+          memcpy(req->buffer, ptr, len);
+        }
+
+      ptr += len;
+    }
+
+  blk_queue_complete(queue, batch, OK);
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: rd_ioctl
  *
@@ -348,7 +419,7 @@ static int rd_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 
   finfo("Entry\n");
 
-  /* Only one ioctl command is supported */
+  /* Return the memory of the disk, or its request queue */
 
   DEBUGASSERT(inode->i_private);
   if (cmd == BIOC_XIPBASE && ppv)
@@ -360,6 +431,15 @@ static int rd_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
       return OK;
     }
 
+#ifdef CONFIG_FS_BLKQUEUE
+  if (cmd == BIOC_GETQUEUE && ppv)
+    {
+      dev  = inode->i_private;
+      *ppv = &dev->rd_queue;
+      return OK;
+    }
+#endif
+
   return -ENOTTY;
 }
 
@@ -448,6 +528,9 @@ int ramdisk_register(int minor, FAR uint8_t *buffer, uint32_t nsectors,
       dev->rd_sectsize     = sectsize;     /* The size of one sector */
       dev->rd_buffer       = buffer;       /* RAM disk backup memory */
       dev->rd_flags        = rdflags & RDFLAG_USER;
+#ifdef CONFIG_FS_BLKQUEUE
+      blk_queue_init(&dev->rd_queue, &g_rd_qops, 1, RD_QUEUE_MAXSEGS, 0);
+#endif
 
       /* Create a ramdisk device name */
 
@@ -47,6 +47,8 @@
 #include <nuttx/mtd/mtd.h>
 #include <nuttx/drivers/rwbuffer.h>
 
+#include "ftl.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -86,6 +88,10 @@ struct ftl_struct_s
   FAR off_t            *lptable;
   off_t                 lpcount;
 #endif
+
+#ifdef CONFIG_FTL_LOG
+  FAR struct ftl_log_s *log;      /* Log-structured mode, if not NULL */
+#endif
 };
 
 /****************************************************************************
@@ -135,6 +141,25 @@ static const struct block_operations g_bops =
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: ftl_nsectors
+ *
+ * Description: Return the number of sectors of the block device
+ *
+ ****************************************************************************/
+
+static blkcnt_t ftl_nsectors(FAR struct ftl_struct_s *dev)
+{
+#ifdef CONFIG_FTL_LOG
+  if (dev->log != NULL)
+    {
+      return ftl_log_nblocks(dev->log);
+    }
+#endif
+
+  return dev->geo.neraseblocks * dev->blkper;
+}
+
 #ifdef CONFIG_FTL_BBM
 
 /****************************************************************************
@@ -248,11 +273,25 @@ static int ftl_close(FAR struct inode *inode)
   rwb_flush(&dev->rwb);
 #endif
 
+#ifdef CONFIG_FTL_LOG
+  if (dev->log != NULL)
+    {
+      ftl_log_sync(dev->log);
+    }
+#endif
+
   if (--dev->refs == 0 && dev->unlinked)
     {
 #ifdef FTL_HAVE_RWBUFFER
       rwb_uninitialize(&dev->rwb);
 #endif
+#ifdef CONFIG_FTL_LOG
+      if (dev->log != NULL)
+        {
+          ftl_log_uninitialize(dev->log);
+        }
+#endif
+
       if (dev->eblock)
         {
           kmm_free(dev->eblock);
@@ -453,6 +492,13 @@ static ssize_t ftl_reload(FAR void *priv, FAR uint8_t *buffer,
 {
   struct ftl_struct_s *dev = (struct ftl_struct_s *)priv;
 
+#ifdef CONFIG_FTL_LOG
+  if (dev->log != NULL)
+    {
+      return ftl_log_read(dev->log, buffer, startblock, nblocks);
+    }
+#endif
+
   /* Read the full erase block into the buffer */
 
   return ftl_mtd_bread(dev, startblock, nblocks, buffer);
@@ -592,6 +638,13 @@ static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
   int    nbytes;
   int    ret;
 
+#ifdef CONFIG_FTL_LOG
+  if (dev->log != NULL)
+    {
+      return ftl_log_write(dev->log, buffer, startblock, nblocks);
+    }
+#endif
+
 #ifdef CONFIG_FTL_BBM
   if (dev->mtd->erase == NULL && dev->lptable == NULL)
 #else
@@ -825,7 +878,7 @@ static int ftl_geometry(FAR struct inode *inode,
       geometry->geo_available     = true;
       geometry->geo_mediachanged  = false;
       geometry->geo_writeenabled  = true;
-      geometry->geo_nsectors      = dev->geo.neraseblocks * dev->blkper;
+      geometry->geo_nsectors      = ftl_nsectors(dev);
       geometry->geo_sectorsize    = dev->geo.blocksize;
 
       strlcpy(geometry->geo_model, dev->geo.model,
@@ -870,9 +923,28 @@ static int ftl_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
     {
 #ifdef CONFIG_FTL_WRITEBUFFER
       rwb_flush(&dev->rwb);
+#endif
+#ifdef CONFIG_FTL_LOG
+      if (dev->log != NULL)
+        {
+          ftl_log_sync(dev->log);
+        }
 #endif
     }
 
+#ifdef CONFIG_FTL_LOG
+  if (cmd == BIOC_FTLSTATS)
+    {
+      if (dev->log == NULL || arg == 0)
+        {
+          return -ENOTTY;
+        }
+
+      return ftl_log_stats(dev->log,
+                           (FAR struct ftl_stats_s *)((uintptr_t)arg));
+    }
+#endif
+
   /* No other block driver ioctl commands are not recognized by this
    * driver.  Other possible MTD driver ioctl commands are passed through
    * to the MTD driver (unchanged).
@@ -908,6 +980,13 @@ static int ftl_unlink(FAR struct inode *inode)
 #ifdef FTL_HAVE_RWBUFFER
       rwb_uninitialize(&dev->rwb);
 #endif
+#ifdef CONFIG_FTL_LOG
+      if (dev->log != NULL)
+        {
+          ftl_log_uninitialize(dev->log);
+        }
+#endif
+
       if (dev->eblock)
         {
           kmm_free(dev->eblock);
@@ -980,11 +1059,28 @@ int ftl_initialize_by_path(FAR const char *path, FAR struct mtd_dev_s *mtd,
       dev->blkper = dev->geo.erasesize / dev->geo.blocksize;
       DEBUGASSERT(dev->blkper * dev->geo.blocksize == dev->geo.erasesize);
 
+#ifdef CONFIG_FTL_LOG
+      /* Use the log-structured mode unless the device cannot be erased or
+       * needs bad block management.
+       */
+
+      if (mtd->erase != NULL && MTD_ISBAD(mtd, 0) == -ENOSYS)
+        {
+          ret = ftl_log_initialize(mtd, &dev->geo, &dev->log);
+          if (ret < 0)
+            {
+              ferr("ERROR: ftl_log_initialize failed: %d\n", ret);
+              kmm_free(dev);
+              return ret;
+            }
+        }
+#endif
+
       /* Configure read-ahead/write buffering */
 
 #ifdef FTL_HAVE_RWBUFFER
       dev->rwb.blocksize     = dev->geo.blocksize;
-      dev->rwb.nblocks       = dev->geo.neraseblocks * dev->blkper;
+      dev->rwb.nblocks       = ftl_nsectors(dev);
       dev->rwb.dev           = (FAR void *)dev;
       dev->rwb.wrflush       = ftl_flush;
       dev->rwb.rhreload      = ftl_reload;
@@ -992,6 +1088,14 @@ int ftl_initialize_by_path(FAR const char *path, FAR struct mtd_dev_s *mtd,
 #if defined(CONFIG_FTL_WRITEBUFFER)
       dev->rwb.wrmaxblocks   = dev->blkper;
       dev->rwb.wralignblocks = dev->blkper;
+#  ifdef CONFIG_FTL_LOG
+      if (dev->log != NULL)
+        {
+          /* No need to pad writes to whole erase blocks */
+
+          dev->rwb.wralignblocks = 1;
+        }
+#  endif
 #endif
 
 #ifdef CONFIG_FTL_READAHEAD
@@ -1002,6 +1106,13 @@ int ftl_initialize_by_path(FAR const char *path, FAR struct mtd_dev_s *mtd,
       if (ret < 0)
         {
           ferr("ERROR: rwb_initialize failed: %d\n", ret);
+#ifdef CONFIG_FTL_LOG
+          if (dev->log != NULL)
+            {
+              ftl_log_uninitialize(dev->log);
+            }
+#endif
+
           kmm_free(dev);
           return ret;
         }
@@ -1031,6 +1142,13 @@ out:
 #ifdef FTL_HAVE_RWBUFFER
           rwb_uninitialize(&dev->rwb);
 #endif
+#ifdef CONFIG_FTL_LOG
+          if (dev->log != NULL)
+            {
+              ftl_log_uninitialize(dev->log);
+            }
+#endif
+
           kmm_free(dev);
         }
     }
@@ -0,0 +1,127 @@
+/****************************************************************************
+ * drivers/mtd/ftl.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __DRIVERS_MTD_FTL_H
+#define __DRIVERS_MTD_FTL_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#include <nuttx/mtd/mtd.h>
+
+#ifdef CONFIG_FTL_LOG
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+struct ftl_log_s; /* Opaque state of the log-structured mode */
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftl_log_initialize
+ *
+ * Description:
+ *   Set up the log-structured mode for an MTD device and rebuild its
+ *   sector map from the summary pages on the device.
+ *
+ * Input Parameters:
+ *   mtd  - The MTD device.
+ *   geo  - Its geometry.
+ *   logp - The location to return the new state.
+ *
+ * Returned Value:
+ *   Zero on success, otherwise a negated errno value.
+ *
+ ****************************************************************************/
+
+int ftl_log_initialize(FAR struct mtd_dev_s *mtd,
+                       FAR const struct mtd_geometry_s *geo,
+                       FAR struct ftl_log_s **logp);
+
+/****************************************************************************
+ * Name: ftl_log_uninitialize
+ *
+ * Description:
+ *   Commit the written data and free the state.
+ *
+ ****************************************************************************/
+
+void ftl_log_uninitialize(FAR struct ftl_log_s *log);
+
+/****************************************************************************
+ * Name: ftl_log_nblocks
+ *
+ * Description:
+ *   Return the number of sectors exported by the log-structured mode.
+ *
+ ****************************************************************************/
+
+blkcnt_t ftl_log_nblocks(FAR struct ftl_log_s *log);
+
+/****************************************************************************
+ * Name: ftl_log_read / ftl_log_write
+ *
+ * Description:
+ *   Read or write sectors.  The methods have the signature of the rwbuffer
+ *   reload and flush callbacks and return the number of sectors transferred
+ *   or a negated errno value.
+ *
+ ****************************************************************************/
+
+ssize_t ftl_log_read(FAR struct ftl_log_s *log, FAR uint8_t *buffer,
+                     off_t startblock, size_t nblocks);
+ssize_t ftl_log_write(FAR struct ftl_log_s *log, FAR const uint8_t *buffer,
+                      off_t startblock, size_t nblocks);
+
+/****************************************************************************
+ * Name: ftl_log_sync
+ *
+ * Description:
+ *   Commit the data written so far, so that it survives a power loss.
+ *
+ ****************************************************************************/
+
+int ftl_log_sync(FAR struct ftl_log_s *log);
+
+/****************************************************************************
+ * Name: ftl_log_stats
+ *
+ * Description:
+ *   Return the statistics for BIOC_FTLSTATS.
+ *
+ ****************************************************************************/
+
+int ftl_log_stats(FAR struct ftl_log_s *log,
+                  FAR struct ftl_stats_s *stats);
+
+#endif /* CONFIG_FTL_LOG */
+#endif /* __DRIVERS_MTD_FTL_H */
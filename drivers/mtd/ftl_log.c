@@ -0,0 +1,1037 @@
+/****************************************************************************
+ * drivers/mtd/ftl_log.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/* The log-structured mode of the FTL layer.
+ *
+ * A sector is never rewritten in place.  Every write goes to the next free
+ * page of the open erase block, the write frontier, and a map in RAM
+ * records the page that holds the newest copy of each logical sector.
+ *
+ * An erase block ("segment") is divided into chunks of data pages, each
+ * followed by a summary page that holds the logical sector of every data
+ * page of the chunk, a sequence number and the erase count of the segment.
+ * The summary is written when the chunk is full or when the data is
+ * committed (BIOC_FLUSH, close); the rest of a committed chunk stays
+ * unused.  At initialization the summaries are scanned and the copy with
+ * the highest sequence number of each sector wins.
+ *
+ * Garbage collection moves the valid pages of a segment to the frontier.
+ * The segment, like any segment whose pages have all been superseded, is
+ * only erased after the summary describing the new copies was written, so
+ * that a power loss at any time reverts the device to the last committed
+ * state.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <nuttx/debug.h>
+
+#include <nuttx/crc32.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/mutex.h>
+#include <nuttx/wqueue.h>
+#include <nuttx/fs/ioctl.h>
+#include <nuttx/mtd/mtd.h>
+
+#include "ftl.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define FTL_LOG_MAGIC     0x474c5446  /* "FTLG" */
+#define FTL_LOG_NONE      UINT32_MAX  /* No page or segment */
+
+/* Free segments kept for garbage collection.  A write that would leave
+ * fewer collects segments first.
+ */
+
+#define FTL_LOG_MINFREE   2
+
+/* States of a segment */
+
+#define FTL_SEG_CLEAN     0           /* Erased */
+#define FTL_SEG_DIRTY     1           /* Free, to be erased before use */
+#define FTL_SEG_OPEN      2           /* The write frontier */
+#define FTL_SEG_USED      3           /* Holds data */
+#define FTL_SEG_PREFREE   4           /* No valid pages, free after the
+                                       * next summary */
+
+#define ftl_log_tags(l) \
+  ((FAR uint32_t *)((l)->page + sizeof(struct ftl_log_summary_s)))
+#define ftl_log_sumsize(n) \
+  (sizeof(struct ftl_log_summary_s) + (n) * sizeof(uint32_t))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The start of a summary page, followed by the logical sector of each data
+ * page of the chunk.
+ */
+
+struct ftl_log_summary_s
+{
+  uint32_t magic;       /* FTL_LOG_MAGIC */
+  uint32_t seq;         /* Sequence number */
+  uint32_t erases;      /* Erase count of the segment */
+  uint16_t count;       /* Data pages of the chunk written */
+  uint16_t chunkpages;  /* Data pages per chunk of the layout */
+  uint32_t crc;         /* CRC32 of the summary with this field zero */
+};
+
+struct ftl_log_s
+{
+  FAR struct mtd_dev_s *mtd;
+  mutex_t               lock;
+  uint32_t              blocksize;  /* Page size */
+  uint32_t              nsegs;      /* Number of segments */
+  uint32_t              reserve;    /* Segments not exported */
+  uint32_t              npages;     /* Logical sectors exported */
+  uint16_t              segpages;   /* Pages per segment */
+  uint16_t              chunkpages; /* Data pages per chunk */
+  uint16_t              nchunks;    /* Chunks per segment */
+  uint16_t              segcap;     /* Data pages per segment */
+  uint8_t               erasestate;
+  bool                  ingc;       /* Garbage collection in progress */
+
+  /* The write frontier */
+
+  uint32_t              open;       /* Open segment or FTL_LOG_NONE */
+  uint16_t              chunk;      /* Chunk being written */
+  uint16_t              slot;       /* Next data page of the chunk */
+  uint32_t              seq;        /* Sequence number of the next summary */
+  uint32_t              nfree;      /* Clean and dirty segments */
+  uint32_t              nprefree;   /* Prefree segments */
+
+  FAR uint32_t         *l2p;        /* Page of each logical sector */
+  FAR uint16_t         *valid;      /* Valid pages per segment */
+  FAR uint32_t         *erases;     /* Erase count per segment */
+  FAR uint32_t         *segseq;     /* Last sequence number per segment */
+  FAR uint8_t          *state;      /* FTL_SEG_* per segment */
+  FAR uint8_t          *page;       /* Summary of the open chunk */
+  FAR uint8_t          *buffer;     /* Two pages for mount and GC */
+#ifdef CONFIG_FTL_LOG_BGGC
+  struct work_s         work;       /* Background garbage collection */
+#endif
+  struct ftl_stats_s    stats;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftl_log_phys
+ *
+ * Description:
+ *   Return the page of a data slot of a chunk; 'slot' equal to
+ *   'chunkpages' is the summary page.
+ *
+ ****************************************************************************/
+
+static inline uint32_t ftl_log_phys(FAR struct ftl_log_s *log, uint32_t seg,
+                                    uint32_t chunk, uint32_t slot)
+{
+  return seg * log->segpages + chunk * (log->chunkpages + 1) + slot;
+}
+
+/****************************************************************************
+ * Name: ftl_log_check
+ *
+ * Description:
+ *   Return true if the page in 'buffer' is a valid summary of this layout.
+ *
+ ****************************************************************************/
+
+static bool ftl_log_check(FAR struct ftl_log_s *log, FAR uint8_t *buffer)
+{
+  FAR struct ftl_log_summary_s *sum =
+    (FAR struct ftl_log_summary_s *)buffer;
+  uint32_t crc;
+  bool ok;
+
+  if (sum->magic != FTL_LOG_MAGIC || sum->chunkpages != log->chunkpages ||
+      sum->count == 0 || sum->count > log->chunkpages || sum->seq == 0)
+    {
+      return false;
+    }
+
+  crc      = sum->crc;
+  sum->crc = 0;
+  ok       = crc32(buffer, ftl_log_sumsize(sum->count)) == crc;
+  sum->crc = crc;
+  return ok;
+}
+
+/****************************************************************************
+ * Name: ftl_log_invalidate
+ *
+ * Description:
+ *   A page has been superseded.  A segment without valid pages becomes
+ *   prefree: it may be erased once the copies that replaced its data have
+ *   been committed.
+ *
+ ****************************************************************************/
+
+static void ftl_log_invalidate(FAR struct ftl_log_s *log, uint32_t phys)
+{
+  uint32_t seg = phys / log->segpages;
+
+  DEBUGASSERT(log->valid[seg] > 0);
+  if (--log->valid[seg] == 0 && log->state[seg] == FTL_SEG_USED)
+    {
+      log->state[seg] = FTL_SEG_PREFREE;
+      log->nprefree++;
+    }
+}
+
+/****************************************************************************
+ * Name: ftl_log_commit
+ *
+ * Description:
+ *   Write the summary of the open chunk, if it has data pages, and release
+ *   the prefree segments, whose data is superseded by committed pages now.
+ *
+ ****************************************************************************/
+
+static int ftl_log_commit(FAR struct ftl_log_s *log)
+{
+  FAR struct ftl_log_summary_s *sum;
+  uint32_t seg;
+  ssize_t ret;
+
+  if (log->open != FTL_LOG_NONE && log->slot > 0)
+    {
+      seg = log->open;
+      sum = (FAR struct ftl_log_summary_s *)log->page;
+
+      sum->magic      = FTL_LOG_MAGIC;
+      sum->seq        = log->seq;
+      sum->erases     = log->erases[seg];
+      sum->count      = log->slot;
+      sum->chunkpages = log->chunkpages;
+      sum->crc        = 0;
+      sum->crc        = crc32(log->page, ftl_log_sumsize(log->slot));
+
+      ret = MTD_BWRITE(log->mtd,
+                       ftl_log_phys(log, seg, log->chunk, log->chunkpages),
+                       1, log->page);
+      if (ret != 1)
+        {
+          ferr("ERROR: Summary write failed: %zd\n", ret);
+          return ret < 0 ? ret : -EIO;
+        }
+
+      log->stats.flashwrites++;
+      log->segseq[seg] = log->seq++;
+      log->slot = 0;
+
+      if (++log->chunk >= log->nchunks)
+        {
+          log->open = FTL_LOG_NONE;
+          if (log->valid[seg] > 0)
+            {
+              log->state[seg] = FTL_SEG_USED;
+            }
+          else
+            {
+              log->state[seg] = FTL_SEG_PREFREE;
+              log->nprefree++;
+            }
+        }
+    }
+
+  if (log->nprefree > 0)
+    {
+      for (seg = 0; seg < log->nsegs; seg++)
+        {
+          if (log->state[seg] == FTL_SEG_PREFREE)
+            {
+              log->state[seg] = FTL_SEG_DIRTY;
+              log->nfree++;
+            }
+        }
+
+      log->nprefree = 0;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_victim
+ *
+ * Description:
+ *   Select the segment to be garbage collected, or FTL_LOG_NONE if no
+ *   segment would give free space.
+ *
+ ****************************************************************************/
+
+static uint32_t ftl_log_victim(FAR struct ftl_log_s *log)
+{
+  uint32_t best = FTL_LOG_NONE;
+  uint64_t bestscore = 0;
+  uint64_t score;
+  uint32_t seg;
+#if CONFIG_FTL_LOG_WEARLIMIT > 0
+  uint32_t cold = FTL_LOG_NONE;
+  uint32_t maxerase = 0;
+
+  /* Static wear leveling: if the least worn segment holding data lags too
+   * far behind, move its (cold) data so that the segment is reused.
+   */
+
+  for (seg = 0; seg < log->nsegs; seg++)
+    {
+      maxerase = MAX(maxerase, log->erases[seg]);
+      if (log->state[seg] == FTL_SEG_USED &&
+          (cold == FTL_LOG_NONE || log->erases[seg] < log->erases[cold]))
+        {
+          cold = seg;
+        }
+    }
+
+  if (cold != FTL_LOG_NONE &&
+      maxerase - log->erases[cold] > CONFIG_FTL_LOG_WEARLIMIT)
+    {
+      log->stats.wearmoves++;
+      return cold;
+    }
+#endif
+
+  for (seg = 0; seg < log->nsegs; seg++)
+    {
+      if (log->state[seg] != FTL_SEG_USED ||
+          log->valid[seg] >= log->segcap)
+        {
+          continue;
+        }
+
+#ifdef CONFIG_FTL_LOG_COSTBENEFIT
+      /* (1 - u) * age / (1 + u), u being the fraction of valid pages */
+
+      score = (uint64_t)(log->segcap - log->valid[seg]) *
+              (log->seq - log->segseq[seg]) /
+              (log->segcap + log->valid[seg]) + 1;
+#else
+      score = log->segcap - log->valid[seg];
+#endif
+
+      if (score > bestscore ||
+          (score == bestscore && log->erases[seg] < log->erases[best]))
+        {
+          best      = seg;
+          bestscore = score;
+        }
+    }
+
+  return best;
+}
+
+/****************************************************************************
+ * Name: ftl_log_openseg
+ *
+ * Description:
+ *   Open a new segment for the write frontier: the least worn free one,
+ *   after garbage collection if few are left.
+ *
+ ****************************************************************************/
+
+static int ftl_log_collect(FAR struct ftl_log_s *log, uint32_t victim);
+
+static int ftl_log_openseg(FAR struct ftl_log_s *log)
+{
+  uint32_t best = FTL_LOG_NONE;
+  uint32_t seg;
+  uint32_t n;
+  int ret;
+
+  if (!log->ingc)
+    {
+      for (n = 0; n < log->nsegs &&
+                  log->nfree + log->nprefree < FTL_LOG_MINFREE; n++)
+        {
+          seg = ftl_log_victim(log);
+          if (seg == FTL_LOG_NONE)
+            {
+              break;
+            }
+
+          ret = ftl_log_collect(log, seg);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+
+      /* Garbage collection may have opened a segment itself */
+
+      if (log->open != FTL_LOG_NONE)
+        {
+          return OK;
+        }
+    }
+
+  if (log->nfree == 0)
+    {
+      if (log->nprefree == 0)
+        {
+          ferr("ERROR: No free erase block\n");
+          return -ENOSPC;
+        }
+
+      ret = ftl_log_commit(log);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  for (seg = 0; seg < log->nsegs; seg++)
+    {
+      if (log->state[seg] <= FTL_SEG_DIRTY &&
+          (best == FTL_LOG_NONE || log->erases[seg] < log->erases[best]))
+        {
+          best = seg;
+        }
+    }
+
+  DEBUGASSERT(best != FTL_LOG_NONE);
+  if (log->state[best] == FTL_SEG_DIRTY)
+    {
+      ret = MTD_ERASE(log->mtd, best, 1);
+      if (ret < 0)
+        {
+          ferr("ERROR: Erase block %" PRIu32 " failed: %d\n", best, ret);
+          return ret;
+        }
+
+      log->erases[best]++;
+      log->stats.erases++;
+    }
+
+  log->state[best] = FTL_SEG_OPEN;
+  log->nfree--;
+  log->open  = best;
+  log->chunk = 0;
+  log->slot  = 0;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_append
+ *
+ * Description:
+ *   Write consecutive logical sectors at the write frontier, as many as fit
+ *   in the open chunk.  Returns the number of sectors written.
+ *
+ ****************************************************************************/
+
+static ssize_t ftl_log_append(FAR struct ftl_log_s *log, uint32_t lpage,
+                              FAR const uint8_t *buffer, size_t npages)
+{
+  FAR uint32_t *tags = ftl_log_tags(log);
+  uint32_t phys;
+  size_t i;
+  ssize_t ret;
+
+  if (log->open == FTL_LOG_NONE)
+    {
+      ret = ftl_log_openseg(log);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  npages = MIN(npages, log->chunkpages - log->slot);
+  phys   = ftl_log_phys(log, log->open, log->chunk, log->slot);
+
+  ret = MTD_BWRITE(log->mtd, phys, npages, buffer);
+  if (ret != (ssize_t)npages)
+    {
+      ferr("ERROR: Write of page %" PRIu32 " failed: %zd\n", phys, ret);
+      return ret < 0 ? ret : -EIO;
+    }
+
+  log->stats.flashwrites += npages;
+
+  for (i = 0; i < npages; i++, lpage++, phys++)
+    {
+      if (log->l2p[lpage] != FTL_LOG_NONE)
+        {
+          ftl_log_invalidate(log, log->l2p[lpage]);
+        }
+
+      log->l2p[lpage] = phys;
+      log->valid[log->open]++;
+      tags[log->slot++] = lpage;
+    }
+
+  if (log->slot >= log->chunkpages)
+    {
+      ret = ftl_log_commit(log);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  return npages;
+}
+
+/****************************************************************************
+ * Name: ftl_log_collect
+ *
+ * Description:
+ *   Move the valid pages of a segment to the write frontier.  The segment
+ *   becomes prefree when its last valid page has been moved.
+ *
+ ****************************************************************************/
+
+static int ftl_log_collect(FAR struct ftl_log_s *log, uint32_t victim)
+{
+  FAR uint8_t *data = log->buffer + log->blocksize;
+  FAR struct ftl_log_summary_s *sum =
+    (FAR struct ftl_log_summary_s *)log->buffer;
+  FAR uint32_t *tags =
+    (FAR uint32_t *)(log->buffer + sizeof(struct ftl_log_summary_s));
+  uint32_t chunk;
+  uint32_t slot;
+  uint32_t phys;
+  uint32_t lpage;
+  ssize_t ret = OK;
+
+  finfo("Collecting erase block %" PRIu32 ", %u valid pages\n",
+        victim, log->valid[victim]);
+
+  log->ingc = true;
+  log->stats.collections++;
+
+  for (chunk = 0; chunk < log->nchunks && log->valid[victim] > 0; chunk++)
+    {
+      ret = MTD_BREAD(log->mtd,
+                      ftl_log_phys(log, victim, chunk, log->chunkpages),
+                      1, log->buffer);
+      if (ret < 0)
+        {
+          goto out;
+        }
+
+      if (!ftl_log_check(log, log->buffer))
+        {
+          break;
+        }
+
+      for (slot = 0; slot < sum->count && log->valid[victim] > 0; slot++)
+        {
+          lpage = tags[slot];
+          phys  = ftl_log_phys(log, victim, chunk, slot);
+          if (lpage >= log->npages || log->l2p[lpage] != phys)
+            {
+              continue;
+            }
+
+          ret = MTD_BREAD(log->mtd, phys, 1, data);
+          if (ret < 0)
+            {
+              goto out;
+            }
+
+          ret = ftl_log_append(log, lpage, data, 1);
+          if (ret < 0)
+            {
+              goto out;
+            }
+
+          log->stats.relocations++;
+        }
+    }
+
+  ret = OK;
+
+out:
+  log->ingc = false;
+  return ret;
+}
+
+#ifdef CONFIG_FTL_LOG_BGGC
+/****************************************************************************
+ * Name: ftl_log_kick / ftl_log_worker
+ *
+ * Description:
+ *   Collect segments in the background, one per run of the worker, while
+ *   fewer than the over-provisioned segments are free.
+ *
+ ****************************************************************************/
+
+static void ftl_log_worker(FAR void *arg);
+
+static void ftl_log_kick(FAR struct ftl_log_s *log)
+{
+  if (log->nfree + log->nprefree < log->reserve &&
+      work_available(&log->work))
+    {
+      work_queue(LPWORK, &log->work, ftl_log_worker, log, 0);
+    }
+}
+
+static void ftl_log_worker(FAR void *arg)
+{
+  FAR struct ftl_log_s *log = arg;
+  uint32_t seg;
+
+  if (nxmutex_lock(&log->lock) < 0)
+    {
+      return;
+    }
+
+  if (log->nfree + log->nprefree < log->reserve)
+    {
+      seg = ftl_log_victim(log);
+      if (seg != FTL_LOG_NONE && ftl_log_collect(log, seg) >= 0)
+        {
+          ftl_log_kick(log);
+        }
+    }
+
+  nxmutex_unlock(&log->lock);
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_mount
+ *
+ * Description:
+ *   Rebuild the sector map, the valid page counts, the erase counts and the
+ *   segment states from the summary pages.
+ *
+ ****************************************************************************/
+
+static int ftl_log_mount(FAR struct ftl_log_s *log)
+{
+  FAR struct ftl_log_summary_s *sum =
+    (FAR struct ftl_log_summary_s *)log->buffer;
+  FAR uint32_t *tags =
+    (FAR uint32_t *)(log->buffer + sizeof(struct ftl_log_summary_s));
+  FAR uint32_t *lseq;
+  uint64_t total = 0;
+  uint32_t known = 0;
+  uint32_t chunk;
+  uint32_t slot;
+  uint32_t seg;
+  uint32_t lpage;
+  ssize_t ret;
+
+  /* The sequence number of the newest copy of each sector found so far */
+
+  lseq = kmm_zalloc(log->npages * sizeof(uint32_t));
+  if (lseq == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  memset(log->l2p, 0xff, log->npages * sizeof(uint32_t));
+  log->seq = 1;
+
+  for (seg = 0; seg < log->nsegs; seg++)
+    {
+      log->state[seg] = FTL_SEG_DIRTY;
+
+      /* Chunks are written in order, so the first one without a valid
+       * summary ends the written part of the segment.
+       */
+
+      for (chunk = 0; chunk < log->nchunks; chunk++)
+        {
+          ret = MTD_BREAD(log->mtd,
+                          ftl_log_phys(log, seg, chunk, log->chunkpages),
+                          1, log->buffer);
+          if (ret < 0 || !ftl_log_check(log, log->buffer))
+            {
+              break;
+            }
+
+          log->state[seg]  = FTL_SEG_USED;
+          log->segseq[seg] = sum->seq;
+          log->erases[seg] = MAX(log->erases[seg], sum->erases);
+          log->seq         = MAX(log->seq, sum->seq + 1);
+
+          for (slot = 0; slot < sum->count; slot++)
+            {
+              lpage = tags[slot];
+              if (lpage < log->npages && sum->seq >= lseq[lpage])
+                {
+                  lseq[lpage]      = sum->seq;
+                  log->l2p[lpage] = ftl_log_phys(log, seg, chunk, slot);
+                }
+            }
+        }
+
+      if (log->state[seg] == FTL_SEG_USED)
+        {
+          total += log->erases[seg];
+          known++;
+        }
+    }
+
+  kmm_free(lseq);
+
+  for (lpage = 0; lpage < log->npages; lpage++)
+    {
+      if (log->l2p[lpage] != FTL_LOG_NONE)
+        {
+          log->valid[log->l2p[lpage] / log->segpages]++;
+        }
+    }
+
+  /* Segments without valid pages are free.  The erase count of a segment
+   * without summaries is unknown: assume the average.
+   */
+
+  for (seg = 0; seg < log->nsegs; seg++)
+    {
+      if (log->state[seg] == FTL_SEG_USED && log->valid[seg] == 0)
+        {
+          log->state[seg] = FTL_SEG_DIRTY;
+        }
+
+      if (log->state[seg] == FTL_SEG_DIRTY)
+        {
+          log->nfree++;
+          if (log->erases[seg] == 0 && known > 0)
+            {
+              log->erases[seg] = total / known;
+            }
+        }
+    }
+
+  finfo("%" PRIu32 " of %" PRIu32 " erase blocks free, sequence %" PRIu32
+        "\n", log->nfree, log->nsegs, log->seq);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftl_log_free
+ ****************************************************************************/
+
+static void ftl_log_free(FAR struct ftl_log_s *log)
+{
+  kmm_free(log->l2p);
+  kmm_free(log->valid);
+  kmm_free(log->erases);
+  kmm_free(log->segseq);
+  kmm_free(log->state);
+  kmm_free(log->page);
+  kmm_free(log->buffer);
+  nxmutex_destroy(&log->lock);
+  kmm_free(log);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftl_log_initialize
+ ****************************************************************************/
+
+int ftl_log_initialize(FAR struct mtd_dev_s *mtd,
+                       FAR const struct mtd_geometry_s *geo,
+                       FAR struct ftl_log_s **logp)
+{
+  FAR struct ftl_log_s *log;
+  uint32_t segpages;
+  uint32_t chunkpages;
+  int ret;
+
+  /* Fit a chunk and its summary into the erase block */
+
+  segpages   = geo->erasesize / geo->blocksize;
+  chunkpages = MIN(CONFIG_FTL_LOG_CHUNKPAGES, segpages - 1);
+  chunkpages = MIN(chunkpages, (geo->blocksize -
+                   sizeof(struct ftl_log_summary_s)) / sizeof(uint32_t));
+  if (segpages < 2 || segpages > UINT16_MAX || chunkpages < 1)
+    {
+      ferr("ERROR: Erase block of %" PRIu32 " pages not supported\n",
+           segpages);
+      return -EINVAL;
+    }
+
+  log = kmm_zalloc(sizeof(struct ftl_log_s));
+  if (log == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  nxmutex_init(&log->lock);
+  log->mtd        = mtd;
+  log->blocksize  = geo->blocksize;
+  log->nsegs      = geo->neraseblocks;
+  log->segpages   = segpages;
+  log->chunkpages = chunkpages;
+  log->nchunks    = segpages / (chunkpages + 1);
+  log->segcap     = log->nchunks * chunkpages;
+  log->open       = FTL_LOG_NONE;
+  log->reserve    = MAX(FTL_LOG_MINFREE + 1, log->nsegs *
+                        CONFIG_FTL_LOG_OVERPROVISION / 100);
+
+  if (log->nsegs <= log->reserve)
+    {
+      ferr("ERROR: Too few erase blocks: %" PRIu32 "\n", log->nsegs);
+      ret = -ENOSPC;
+      goto errout;
+    }
+
+  log->npages = (log->nsegs - log->reserve) * log->segcap;
+
+  if (MTD_IOCTL(mtd, MTDIOC_ERASESTATE,
+                (unsigned long)((uintptr_t)&log->erasestate)) < 0)
+    {
+      log->erasestate = 0xff;
+    }
+
+  log->l2p    = kmm_malloc(log->npages * sizeof(uint32_t));
+  log->valid  = kmm_zalloc(log->nsegs * sizeof(uint16_t));
+  log->erases = kmm_zalloc(log->nsegs * sizeof(uint32_t));
+  log->segseq = kmm_zalloc(log->nsegs * sizeof(uint32_t));
+  log->state  = kmm_zalloc(log->nsegs);
+  log->page   = kmm_malloc(log->blocksize);
+  log->buffer = kmm_malloc(2 * log->blocksize);
+
+  if (log->l2p == NULL || log->valid == NULL || log->erases == NULL ||
+      log->segseq == NULL || log->state == NULL || log->page == NULL ||
+      log->buffer == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  memset(log->page, log->erasestate, log->blocksize);
+
+  ret = ftl_log_mount(log);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  finfo("%" PRIu32 " sectors, %u data pages per erase block\n",
+        log->npages, log->segcap);
+
+  *logp = log;
+  return OK;
+
+errout:
+  ftl_log_free(log);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ftl_log_uninitialize
+ ****************************************************************************/
+
+void ftl_log_uninitialize(FAR struct ftl_log_s *log)
+{
+#ifdef CONFIG_FTL_LOG_BGGC
+  work_cancel_sync(LPWORK, &log->work);
+#endif
+
+  ftl_log_commit(log);
+  ftl_log_free(log);
+}
+
+/****************************************************************************
+ * Name: ftl_log_nblocks
+ ****************************************************************************/
+
+blkcnt_t ftl_log_nblocks(FAR struct ftl_log_s *log)
+{
+  return log->npages;
+}
+
+/****************************************************************************
+ * Name: ftl_log_read
+ ****************************************************************************/
+
+ssize_t ftl_log_read(FAR struct ftl_log_s *log, FAR uint8_t *buffer,
+                     off_t startblock, size_t nblocks)
+{
+  uint32_t phys;
+  size_t remaining;
+  size_t n;
+  ssize_t ret;
+
+  if (startblock < 0 || startblock + nblocks > log->npages)
+    {
+      return -EINVAL;
+    }
+
+  ret = nxmutex_lock(&log->lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  for (remaining = nblocks; remaining > 0; remaining -= n)
+    {
+      /* Read runs of sectors that are in consecutive pages at once */
+
+      phys = log->l2p[startblock];
+      n    = 1;
+
+      if (phys == FTL_LOG_NONE)
+        {
+          memset(buffer, log->erasestate, log->blocksize);
+        }
+      else
+        {
+          while (n < remaining && log->l2p[startblock + n] == phys + n)
+            {
+              n++;
+            }
+
+          ret = MTD_BREAD(log->mtd, phys, n, buffer);
+          if (ret < 0)
+            {
+              ferr("ERROR: Read of page %" PRIu32 " failed: %zd\n",
+                   phys, ret);
+              goto out;
+            }
+        }
+
+      startblock += n;
+      buffer     += n * log->blocksize;
+    }
+
+  ret = nblocks;
+
+out:
+  nxmutex_unlock(&log->lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ftl_log_write
+ ****************************************************************************/
+
+ssize_t ftl_log_write(FAR struct ftl_log_s *log, FAR const uint8_t *buffer,
+                      off_t startblock, size_t nblocks)
+{
+  size_t remaining;
+  ssize_t ret;
+
+  if (startblock < 0 || startblock + nblocks > log->npages)
+    {
+      return -EINVAL;
+    }
+
+  ret = nxmutex_lock(&log->lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  for (remaining = nblocks; remaining > 0; remaining -= ret)
+    {
+      ret = ftl_log_append(log, startblock, buffer, remaining);
+      if (ret < 0)
+        {
+          goto out;
+        }
+
+      startblock += ret;
+      buffer     += ret * log->blocksize;
+    }
+
+  log->stats.hostwrites += nblocks;
+  ret = nblocks;
+
+#ifdef CONFIG_FTL_LOG_BGGC
+  ftl_log_kick(log);
+#endif
+
+out:
+  nxmutex_unlock(&log->lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ftl_log_sync
+ ****************************************************************************/
+
+int ftl_log_sync(FAR struct ftl_log_s *log)
+{
+  int ret;
+
+  ret = nxmutex_lock(&log->lock);
+  if (ret >= 0)
+    {
+      ret = ftl_log_commit(log);
+      nxmutex_unlock(&log->lock);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ftl_log_stats
+ ****************************************************************************/
+
+int ftl_log_stats(FAR struct ftl_log_s *log,
+                  FAR struct ftl_stats_s *stats)
+{
+  uint32_t seg;
+  int ret;
+
+  ret = nxmutex_lock(&log->lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  *stats            = log->stats;
+  stats->freeblocks = log->nfree + log->nprefree;
+  stats->minerase   = UINT32_MAX;
+  stats->maxerase   = 0;
+
+  for (seg = 0; seg < log->nsegs; seg++)
+    {
+      stats->minerase = MIN(stats->minerase, log->erases[seg]);
+      stats->maxerase = MAX(stats->maxerase, log->erases[seg]);
+    }
+
+  nxmutex_unlock(&log->lock);
+  return OK;
+}
@@ -44,6 +44,48 @@
 
 #include <nuttx/mtd/hamming.h>
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The byte at offset 'b' of a 32-bit word read from memory */
+
+#ifdef CONFIG_ENDIAN_BIG
+#  define HAMMING_LANE(w,b)  (((w) >> (24 - 8 * (b))) & 0xff)
+#else
+#  define HAMMING_LANE(w,b)  (((w) >> (8 * (b))) & 0xff)
+#endif
+
+/* Parity of a byte */
+
+#define HAMMING_PARITY(b)    (g_bitsinbyte[(uint8_t)(b)] & 1)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The number of bits set to '1' in each byte value */
+
+static const uint8_t g_bitsinbyte[256] =
+{
+  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+  4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8
+};
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -64,19 +106,7 @@
 
 static unsigned int hamming_bitsinbyte(uint8_t byte)
 {
-  unsigned int count = 0;
-
-  while (byte != 0)
-    {
-      if ((byte & 1) != 0)
-        {
-          count++;
-        }
-
-      byte >>= 1;
-    }
-
-  return count;
+  return g_bitsinbyte[byte];
 }
 
 /****************************************************************************
@@ -118,73 +148,127 @@ static uint8_t hamming_bitsincode256(FAR uint8_t *code)
 static void hamming_compute256(FAR const uint8_t *data, FAR uint8_t *code)
 {
   uint8_t colsum = 0;
-  uint8_t evenline = 0;
+  uint8_t evenline;
   uint8_t oddline = 0;
-  uint8_t evencol = 0;
-  uint8_t oddcol = 0;
+  uint8_t evencol;
+  uint8_t oddcol;
   int i;
 
   /* Xor all bytes together to get the column sum;
-   * At the same time, calculate the even and odd line codes
+   * At the same time, calculate the odd line codes
    */
 
-  for (i = 0; i < 256; i++)
+  if (((uintptr_t)data & 3) == 0)
     {
-      colsum ^= data[i];
+      FAR const uint32_t *words = (FAR const uint32_t *)data;
+      uint32_t wordsum = 0;
+      uint32_t fold;
 
-      /* If the xor sum of the byte is 0, then this byte has no incidence on
-       * the computed code; so check if the sum is 1.
+      /* Handle the data a word at a time.  Bits 2-7 of the index of a byte
+       * are the index of its word, so a word of odd parity toggles them
+       * like a byte of odd parity would (see below).
        */
 
-      if ((hamming_bitsinbyte(data[i]) & 1) == 1)
+      for (i = 0; i < 64; i++)
         {
-          /* Parity groups are formed by forcing a particular index bit to 0
-           * (even) or 1 (odd).
-           * Example on one byte:
-           *
-           * bits (dec)  7   6   5   4   3   2   1   0
-           *      (bin) 111 110 101 100 011 010 001 000
-           *                            '---'---'---'----------.
-           *                                                   |
-           * groups P4' ooooooooooooooo eeeeeeeeeeeeeee P4     |
-           *        P2' ooooooo eeeeeee ooooooo eeeeeee P2     |
-           *        P1' ooo eee ooo eee ooo eee ooo eee P1     |
-           *                                                   |
-           * We can see that:                                  |
-           *  - P4  -> bit 2 of index is 0 --------------------'
-           *  - P4' -> bit 2 of index is 1.
-           *  - P2  -> bit 1 of index if 0.
-           *  - etc...
-           * We deduce that a bit position has an impact on all even Px if
-           * the log2(x)nth bit of its index is 0
-           *     ex: log2(4) = 2, bit2 of the index must be 0 (-> 0 1 2 3)
-           * and on all odd Px' if the log2(x)nth bit of its index is 1
-           *     ex: log2(2) = 1, bit1 of the index must be 1 (-> 0 1 4 5)
-           *
-           * As such, we calculate all the possible Px and Px' values at the
-           * same time in two variables, evenline and oddline, such as
-           *     evenline bits: P128  P64  P32  P16  P8  P4  P2  P1
-           *     oddline  bits: P128' P64' P32' P16' P8' P4' P2' P1'
+          wordsum ^= words[i];
+
+          fold  = words[i] ^ (words[i] >> 16);
+          fold ^= fold >> 8;
+          if (HAMMING_PARITY(fold))
+            {
+              oddline ^= i << 2;
+            }
+        }
+
+      /* Bits 0 and 1 of the index are the offset of a byte in its word.
+       * The bytes at the same offset of all words are summed up in the
+       * same byte of wordsum.
+       */
+
+      if (HAMMING_PARITY(HAMMING_LANE(wordsum, 1) ^
+                         HAMMING_LANE(wordsum, 3)))
+        {
+          oddline ^= 1;
+        }
+
+      if (HAMMING_PARITY(HAMMING_LANE(wordsum, 2) ^
+                         HAMMING_LANE(wordsum, 3)))
+        {
+          oddline ^= 2;
+        }
+
+      colsum = HAMMING_LANE(wordsum, 0) ^ HAMMING_LANE(wordsum, 1) ^
+               HAMMING_LANE(wordsum, 2) ^ HAMMING_LANE(wordsum, 3);
+    }
+  else
+    {
+      for (i = 0; i < 256; i++)
+        {
+          colsum ^= data[i];
+
+          /* If the xor sum of the byte is 0, then this byte has no
+           * incidence on the computed code; so check if the sum is 1.
            */
 
-          evenline ^= (255 - i);
-          oddline ^= i;
+          if (HAMMING_PARITY(data[i]))
+            {
+              /* Parity groups are formed by forcing a particular index bit
+               * to 0 (even) or 1 (odd).
+               * Example on one byte:
+               *
+               * bits (dec)  7   6   5   4   3   2   1   0
+               *      (bin) 111 110 101 100 011 010 001 000
+               *                            '---'---'---'----------.
+               *                                                   |
+               * groups P4' ooooooooooooooo eeeeeeeeeeeeeee P4     |
+               *        P2' ooooooo eeeeeee ooooooo eeeeeee P2     |
+               *        P1' ooo eee ooo eee ooo eee ooo eee P1     |
+               *                                                   |
+               * We can see that:                                  |
+               *  - P4  -> bit 2 of index is 0 --------------------'
+               *  - P4' -> bit 2 of index is 1.
+               *  - P2  -> bit 1 of index if 0.
+               *  - etc...
+               * We deduce that a bit position has an impact on all even Px
+               * if the log2(x)nth bit of its index is 0
+               *     ex: log2(4) = 2, bit2 of index must be 0 (-> 0 1 2 3)
+               * and on all odd Px' if the log2(x)nth bit of its index is 1
+               *     ex: log2(2) = 1, bit1 of index must be 1 (-> 0 1 4 5)
+               *
+               * As such, we calculate all the possible Px' values at the
+               * same time in the variable oddline, such as
+               *     oddline  bits: P128' P64' P32' P16' P8' P4' P2' P1'
+               */
+
+              oddline ^= i;
+            }
         }
     }
 
+  /* The even line codes (P128 ... P1) are the parities of the bytes whose
+   * index has the bit cleared.  They follow from the odd ones and the
+   * parity of the whole block, which is the parity of the column sum.
+   */
+
+  evenline = oddline;
+  if (HAMMING_PARITY(colsum))
+    {
+      evenline ^= 0xff;
+    }
+
   /* At this point, we have the line parities, and the column sum. First, We
    * must calculate the parity group values on the column sum.
    */
 
-  for (i = 0; i < 8; i++)
-    {
-      if (colsum & 1)
-        {
-          evencol ^= (7 - i);
-          oddcol ^= i;
-        }
+  oddcol  = HAMMING_PARITY(colsum & 0xaa);
+  oddcol |= HAMMING_PARITY(colsum & 0xcc) << 1;
+  oddcol |= HAMMING_PARITY(colsum & 0xf0) << 2;
 
-      colsum >>= 1;
+  evencol = oddcol;
+  if (HAMMING_PARITY(colsum))
+    {
+      evencol ^= 7;
     }
 
   /* Now, we must interleave the parity values,
@@ -416,7 +500,7 @@ int hamming_verify256x(FAR uint8_t *data,
 {
   ssize_t remaining = (ssize_t)size;
   int result = HAMMING_SUCCESS;
-  int ret;
+  int ret = HAMMING_SUCCESS;
 
   DEBUGASSERT((size & 0xff) == 0);
 
@@ -75,6 +75,18 @@
  * Private Types
  ****************************************************************************/
 
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+/* A slot of the RAM index: the hash id of a live key and the address of
+ * its newest ate.  Free slots have the address NVS_CACHE_NO_ADDR.
+ */
+
+struct nvs_index_s
+{
+  uint32_t              id;
+  uint32_t              addr;
+};
+#endif
+
 /* Non-volatile Storage File system structure */
 
 struct nvs_fs
@@ -95,6 +107,11 @@ struct nvs_fs
 #if CONFIG_MTD_CONFIG_CACHE_SIZE > 0
   uint32_t              cache[CONFIG_MTD_CONFIG_CACHE_SIZE];
 #endif
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+  FAR struct nvs_index_s *index;       /* Live entries by hash id */
+  uint32_t              index_size;    /* Slots, a power of 2 */
+  uint32_t              index_count;   /* Slots in use */
+#endif
 };
 
 /* Allocation Table Entry */
@@ -180,6 +197,252 @@ static void nvs_invalid_cache(struct nvs_fs *fs, uint32_t sector)
 }
 #endif /* CONFIG_MTD_CONFIG_CACHE_SIZE */
 
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+/****************************************************************************
+ * Name: nvs_index_slot
+ *
+ * Description:
+ *   Return the first slot to probe for a hash id.  The index is an open
+ *   addressing hash table with linear probing.
+ *
+ ****************************************************************************/
+
+static inline uint32_t nvs_index_slot(FAR struct nvs_fs *fs, uint32_t id)
+{
+  return (id ^ (id >> 16)) & (fs->index_size - 1);
+}
+
+/****************************************************************************
+ * Name: nvs_index_reset
+ ****************************************************************************/
+
+static void nvs_index_reset(FAR struct nvs_fs *fs)
+{
+  kmm_free(fs->index);
+  fs->index = NULL;
+  fs->index_size = 0;
+  fs->index_count = 0;
+}
+
+/****************************************************************************
+ * Name: nvs_index_reserve
+ *
+ * Description:
+ *   Make room for one more entry, doubling the table if it would be more
+ *   than 3/4 full.  Called before an entry is written, so that a failure
+ *   to allocate leaves the flash unchanged.
+ *
+ ****************************************************************************/
+
+static int nvs_index_reserve(FAR struct nvs_fs *fs)
+{
+  FAR struct nvs_index_s *old = fs->index;
+  uint32_t oldsize = fs->index_size;
+  uint32_t size;
+  uint32_t slot;
+  uint32_t i;
+
+  if ((fs->index_count + 1) * 4 <= fs->index_size * 3)
+    {
+      return 0;
+    }
+
+  size = oldsize > 0 ? oldsize * 2 : CONFIG_MTD_CONFIG_NVS_INDEX_SIZE;
+  fs->index = kmm_malloc(size * sizeof(struct nvs_index_s));
+  if (fs->index == NULL)
+    {
+      fs->index = old;
+      return -ENOMEM;
+    }
+
+  memset(fs->index, 0xff, size * sizeof(struct nvs_index_s));
+  fs->index_size = size;
+
+  for (i = 0; i < oldsize; i++)
+    {
+      if (old[i].addr != NVS_CACHE_NO_ADDR)
+        {
+          slot = nvs_index_slot(fs, old[i].id);
+          while (fs->index[slot].addr != NVS_CACHE_NO_ADDR)
+            {
+              slot = (slot + 1) & (size - 1);
+            }
+
+          fs->index[slot] = old[i];
+        }
+    }
+
+  kmm_free(old);
+  return 0;
+}
+
+/****************************************************************************
+ * Name: nvs_index_insert
+ *
+ * Description:
+ *   Add the ate of a key that is not in the index yet.  Room must have
+ *   been made with nvs_index_reserve().
+ *
+ ****************************************************************************/
+
+static void nvs_index_insert(FAR struct nvs_fs *fs, uint32_t id,
+                             uint32_t addr)
+{
+  uint32_t slot;
+
+  DEBUGASSERT((fs->index_count + 1) * 4 <= fs->index_size * 3);
+
+  slot = nvs_index_slot(fs, id);
+  while (fs->index[slot].addr != NVS_CACHE_NO_ADDR)
+    {
+      slot = (slot + 1) & (fs->index_size - 1);
+    }
+
+  fs->index[slot].id = id;
+  fs->index[slot].addr = addr;
+  fs->index_count++;
+}
+
+/****************************************************************************
+ * Name: nvs_index_find
+ *
+ * Description:
+ *   Return the slot of the ate at addr, or NULL.
+ *
+ ****************************************************************************/
+
+static FAR struct nvs_index_s *nvs_index_find(FAR struct nvs_fs *fs,
+                                              uint32_t id, uint32_t addr)
+{
+  uint32_t slot;
+
+  if (fs->index_size == 0)
+    {
+      return NULL;
+    }
+
+  slot = nvs_index_slot(fs, id);
+  while (fs->index[slot].addr != NVS_CACHE_NO_ADDR)
+    {
+      if (fs->index[slot].id == id && fs->index[slot].addr == addr)
+        {
+          return &fs->index[slot];
+        }
+
+      slot = (slot + 1) & (fs->index_size - 1);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: nvs_index_move
+ *
+ * Description:
+ *   The ate at 'from' has been superseded by, or copied to, 'to'.
+ *
+ ****************************************************************************/
+
+static void nvs_index_move(FAR struct nvs_fs *fs, uint32_t id,
+                           uint32_t from, uint32_t to)
+{
+  FAR struct nvs_index_s *entry = nvs_index_find(fs, id, from);
+
+  if (entry != NULL)
+    {
+      entry->addr = to;
+    }
+}
+
+/****************************************************************************
+ * Name: nvs_index_remove_slot
+ *
+ * Description:
+ *   Free a slot and move the following entries of its probe sequence back,
+ *   so that no lookup stops early at the hole.
+ *
+ ****************************************************************************/
+
+static void nvs_index_remove_slot(FAR struct nvs_fs *fs, uint32_t hole)
+{
+  uint32_t mask = fs->index_size - 1;
+  uint32_t slot = hole;
+  uint32_t home;
+
+  while (1)
+    {
+      slot = (slot + 1) & mask;
+      if (fs->index[slot].addr == NVS_CACHE_NO_ADDR)
+        {
+          break;
+        }
+
+      /* The entry can fill the hole if its home slot is not cyclically
+       * between the hole and its current slot.
+       */
+
+      home = nvs_index_slot(fs, fs->index[slot].id);
+      if (((slot - home) & mask) >= ((slot - hole) & mask))
+        {
+          fs->index[hole] = fs->index[slot];
+          hole = slot;
+        }
+    }
+
+  fs->index[hole].addr = NVS_CACHE_NO_ADDR;
+  fs->index_count--;
+}
+
+/****************************************************************************
+ * Name: nvs_index_remove
+ *
+ * Description:
+ *   The key of the ate at addr has been deleted or its ate expired.
+ *
+ ****************************************************************************/
+
+static void nvs_index_remove(FAR struct nvs_fs *fs, uint32_t id,
+                             uint32_t addr)
+{
+  FAR struct nvs_index_s *entry = nvs_index_find(fs, id, addr);
+
+  if (entry != NULL)
+    {
+      nvs_index_remove_slot(fs, entry - fs->index);
+    }
+}
+
+/****************************************************************************
+ * Name: nvs_index_invalid
+ *
+ * Description:
+ *   Drop the entries of a block that is erased.  Garbage collection has
+ *   moved all the live entries before, so only entries that could not be
+ *   moved remain.
+ *
+ ****************************************************************************/
+
+static void nvs_index_invalid(FAR struct nvs_fs *fs, uint32_t block)
+{
+  uint32_t slot = 0;
+
+  while (slot < fs->index_size)
+    {
+      if (fs->index[slot].addr != NVS_CACHE_NO_ADDR &&
+          (fs->index[slot].addr >> NVS_ADDR_BLOCK_SHIFT) == block)
+        {
+          /* Check the slot again, an entry may have been moved to it */
+
+          nvs_index_remove_slot(fs, slot);
+        }
+      else
+        {
+          slot++;
+        }
+    }
+}
+#endif /* CONFIG_MTD_CONFIG_NVS_INDEX */
+
 /****************************************************************************
  * Name: nvs_fnv_hash_part
  ****************************************************************************/
@@ -685,6 +948,9 @@ static int nvs_flash_erase_block(FAR struct nvs_fs *fs, uint32_t addr)
 #if CONFIG_MTD_CONFIG_CACHE_SIZE > 0
   nvs_invalid_cache(fs, addr >> NVS_ADDR_BLOCK_SHIFT);
 #endif
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+  nvs_index_invalid(fs, addr >> NVS_ADDR_BLOCK_SHIFT);
+#endif
 
   rc = MTD_ERASE(fs->mtd,
                  CONFIG_MTD_CONFIG_BLOCKSIZE_MULTIPLE *
@@ -1063,6 +1329,160 @@ static int nvs_prev_ate(FAR struct nvs_fs *fs, FAR uint32_t *addr,
   return nvs_recover_last_ate(fs, addr);
 }
 
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+/****************************************************************************
+ * Name: nvs_index_lookup
+ *
+ * Description:
+ *   Find the newest live ate of a key in the index.  The ate is read into
+ *   'ate' and its address returned in 'addr'.  Returns -ENOENT if the key
+ *   does not exist or is deleted.
+ *
+ ****************************************************************************/
+
+static int nvs_index_lookup(FAR struct nvs_fs *fs, uint32_t id,
+                            FAR const uint8_t *key, size_t key_size,
+                            FAR struct nvs_ate *ate, FAR uint32_t *addr)
+{
+  uint32_t slot;
+  int rc;
+
+  if (fs->index_size == 0)
+    {
+      return -ENOENT;
+    }
+
+  slot = nvs_index_slot(fs, id);
+  while (fs->index[slot].addr != NVS_CACHE_NO_ADDR)
+    {
+      if (fs->index[slot].id == id)
+        {
+          rc = nvs_flash_ate_rd(fs, fs->index[slot].addr, ate);
+          if (rc)
+            {
+              return rc;
+            }
+
+          if (nvs_ate_valid(fs, ate) && ate->key_len == key_size)
+            {
+              rc = nvs_flash_block_cmp(fs, (fs->index[slot].addr &
+                                            NVS_ADDR_BLOCK_MASK) +
+                                       ate->offset, key, key_size);
+              if (rc < 0)
+                {
+                  return rc;
+                }
+
+              if (rc == 0)
+                {
+                  *addr = fs->index[slot].addr;
+                  return 0;
+                }
+            }
+
+          fwarn("hash conflict\n");
+        }
+
+      slot = (slot + 1) & (fs->index_size - 1);
+    }
+
+  return -ENOENT;
+}
+
+/****************************************************************************
+ * Name: nvs_index_build
+ *
+ * Description:
+ *   Build the index by walking all ates from the newest to the oldest.
+ *   The first live ate found for a key is its newest one.
+ *
+ ****************************************************************************/
+
+static int nvs_index_build(FAR struct nvs_fs *fs)
+{
+  size_t ate_size = nvs_ate_size(fs);
+  NVS_ATE(wlk_ate, ate_size);
+  NVS_ATE(idx_ate, ate_size);
+  uint32_t wlk_addr = fs->ate_wra;
+  uint32_t rd_addr;
+  uint32_t slot;
+  bool found;
+  int rc;
+
+  nvs_index_reset(fs);
+
+  do
+    {
+      rd_addr = wlk_addr;
+      rc = nvs_prev_ate(fs, &wlk_addr, wlk_ate);
+      if (rc)
+        {
+          return rc;
+        }
+
+      if (!nvs_ate_valid(fs, wlk_ate) ||
+          wlk_ate->id == nvs_special_ate_id(fs) ||
+          nvs_ate_expired(fs, wlk_ate))
+        {
+          continue;
+        }
+
+      /* An older ate of a key left live by a power loss is not indexed */
+
+      found = false;
+      slot = fs->index_size > 0 ? nvs_index_slot(fs, wlk_ate->id) : 0;
+      while (fs->index_size > 0 &&
+             fs->index[slot].addr != NVS_CACHE_NO_ADDR && !found)
+        {
+          if (fs->index[slot].id == wlk_ate->id)
+            {
+              rc = nvs_flash_ate_rd(fs, fs->index[slot].addr, idx_ate);
+              if (rc)
+                {
+                  return rc;
+                }
+
+              if (idx_ate->key_len == wlk_ate->key_len)
+                {
+                  rc = nvs_flash_direct_cmp(fs,
+                                            (fs->index[slot].addr &
+                                             NVS_ADDR_BLOCK_MASK) +
+                                            idx_ate->offset,
+                                            (rd_addr &
+                                             NVS_ADDR_BLOCK_MASK) +
+                                            wlk_ate->offset,
+                                            wlk_ate->key_len);
+                  if (rc < 0)
+                    {
+                      return rc;
+                    }
+
+                  found = rc == 0;
+                }
+            }
+
+          slot = (slot + 1) & (fs->index_size - 1);
+        }
+
+      if (!found)
+        {
+          rc = nvs_index_reserve(fs);
+          if (rc < 0)
+            {
+              return rc;
+            }
+
+          nvs_index_insert(fs, wlk_ate->id, rd_addr);
+        }
+    }
+  while (wlk_addr != fs->ate_wra);
+
+  finfo("index: %" PRIu32 " keys in %" PRIu32 " slots\n",
+        fs->index_count, fs->index_size);
+  return 0;
+}
+#endif /* CONFIG_MTD_CONFIG_NVS_INDEX */
+
 /****************************************************************************
  * Name: nvs_block_advance
  ****************************************************************************/
@@ -1256,6 +1676,10 @@ static int nvs_gc(FAR struct nvs_fs *fs)
               return rc;
             }
 
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+          nvs_index_move(fs, gc_ate->id, gc_prev_addr, fs->ate_wra);
+#endif
+
           rc = nvs_flash_ate_wrt(fs, gc_ate);
           if (rc)
             {
@@ -1310,6 +1734,10 @@ static int nvs_startup(FAR struct nvs_fs *fs)
   fs->events = 0;
   fs->fds = NULL;
 
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+  nvs_index_reset(fs);
+#endif
+
   /* Get the device geometry. (Casting to uintptr_t first eliminates
    * complaints on some architectures where the sizeof long is different
    * from the size of a pointer).
@@ -1654,6 +2082,13 @@ end:
       rc = nvs_add_gc_done_ate(fs);
     }
 
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+  if (!rc)
+    {
+      rc = nvs_index_build(fs);
+    }
+#endif
+
   finfo("%" PRIu32 " Eraseblocks of %" PRIu32 " bytes\n",
         fs->nblocks, fs->blocksize);
   finfo("alloc wra: %" PRIu32 ", 0x%" PRIx32 "\n",
@@ -1694,15 +2129,27 @@ static ssize_t nvs_read_entry(FAR struct nvs_fs *fs, FAR const uint8_t *key,
                 FAR uint32_t *ate_addr)
 {
   NVS_ATE(wlk_ate, nvs_ate_size(fs));
-  uint32_t wlk_addr;
   uint32_t rd_addr;
   uint32_t hist_addr;
   uint32_t hash_id;
   uint8_t data_crc8;
+#ifndef CONFIG_MTD_CONFIG_NVS_INDEX
+  uint32_t wlk_addr;
   bool hit = true;
+#endif
   int rc;
 
   hash_id = nvs_fnv_hash_id(nvs_fnv_hash(key, key_size));
+
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+  rc = nvs_index_lookup(fs, hash_id, key, key_size, wlk_ate, &hist_addr);
+  if (rc)
+    {
+      return rc;
+    }
+
+  rd_addr = hist_addr;
+#else
 #if CONFIG_MTD_CONFIG_CACHE_SIZE > 0
   wlk_addr = fs->cache[nvs_cache_index(hash_id)];
   if (wlk_addr == NVS_CACHE_NO_ADDR)
@@ -1765,6 +2212,7 @@ static ssize_t nvs_read_entry(FAR struct nvs_fs *fs, FAR const uint8_t *key,
         }
     }
   while (true);
+#endif /* CONFIG_MTD_CONFIG_NVS_INDEX */
 
   if (data && len)
     {
@@ -1788,6 +2236,9 @@ static ssize_t nvs_read_entry(FAR struct nvs_fs *fs, FAR const uint8_t *key,
               ferr("Invalid data crc: %" PRIx8 ", wlk_ate->data_crc8: "
                    "%" PRIx8 "\n", data_crc8, wlk_ate->data_crc8);
               nvs_expire_ate(fs, hist_addr);
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+              nvs_index_remove(fs, hash_id, hist_addr);
+#endif
               return -EIO;
             }
         }
@@ -1833,7 +2284,11 @@ static ssize_t nvs_write(FAR struct nvs_fs *fs,
   bool prev_found = false;
   uint32_t hash_id;
   uint16_t block_to_write_befor_gc;
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+  uint32_t new_addr;
+#else
   bool hit = true;
+#endif
 
 #ifdef CONFIG_MTD_CONFIG_NAMED
   FAR const uint8_t *key;
@@ -1873,6 +2328,18 @@ static ssize_t nvs_write(FAR struct nvs_fs *fs,
 
   /* Find latest entry with same id. */
 
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+  rc = nvs_index_lookup(fs, hash_id, key, key_size, wlk_ate, &hist_addr);
+  if (rc == 0)
+    {
+      rd_addr = hist_addr;
+      prev_found = true;
+    }
+  else if (rc != -ENOENT)
+    {
+      return rc;
+    }
+#else
 #if CONFIG_MTD_CONFIG_CACHE_SIZE > 0
   wlk_addr = fs->cache[nvs_cache_index(hash_id)];
   if (wlk_addr == NVS_CACHE_NO_ADDR)
@@ -1926,6 +2393,7 @@ static ssize_t nvs_write(FAR struct nvs_fs *fs,
           break;
         }
     }
+#endif /* CONFIG_MTD_CONFIG_NVS_INDEX */
 
   if (prev_found)
     {
@@ -1956,6 +2424,10 @@ static ssize_t nvs_write(FAR struct nvs_fs *fs,
                   return rc;
                 }
 
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+              nvs_index_remove(fs, hash_id, hist_addr);
+#endif
+
               /* Delete now requires no extra space, so skip write and gc. */
 
               finfo("nvs_delete success\n");
@@ -1986,6 +2458,16 @@ static ssize_t nvs_write(FAR struct nvs_fs *fs,
         {
           return 0;
         }
+
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+      /* Make room in the index before anything is written */
+
+      rc = nvs_index_reserve(fs);
+      if (rc < 0)
+        {
+          return rc;
+        }
+#endif
     }
 
   /* Leave space for gc_done ate */
@@ -2036,6 +2518,9 @@ static ssize_t nvs_write(FAR struct nvs_fs *fs,
           finfo("Write entry, ate_wra=0x%" PRIx32 ", "
                 "data_wra=0x%" PRIx32 "\n",
                 fs->ate_wra, fs->data_wra);
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+          new_addr = fs->ate_wra;
+#endif
           rc = nvs_flash_wrt_entry(fs, hash_id, key, key_size,
                                    pdata->configdata, pdata->len);
           if (rc)
@@ -2065,6 +2550,17 @@ static ssize_t nvs_write(FAR struct nvs_fs *fs,
                 }
             }
 
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+          if (prev_found)
+            {
+              nvs_index_move(fs, hash_id, hist_addr, new_addr);
+            }
+          else
+            {
+              nvs_index_insert(fs, hash_id, new_addr);
+            }
+#endif
+
           break;
         }
 
@@ -2475,6 +2971,10 @@ int mtdconfig_register_by_path(FAR struct mtd_dev_s *mtd,
   /* Initialize the mtdnvs device structure */
 
   fs->mtd = mtd;
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+  fs->index = NULL;
+#endif
+
   rc = nxmutex_init(&fs->nvs_lock);
   if (rc < 0)
     {
@@ -2499,6 +2999,9 @@ int mtdconfig_register_by_path(FAR struct mtd_dev_s *mtd,
   return rc;
 
 mutex_err:
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+  nvs_index_reset(fs);
+#endif
   nxmutex_destroy(&fs->nvs_lock);
 
 errout:
@@ -2543,6 +3046,9 @@ int mtdconfig_unregister_by_path(FAR const char *path)
 
   inode = file.f_inode;
   fs = inode->i_private;
+#ifdef CONFIG_MTD_CONFIG_NVS_INDEX
+  nvs_index_reset(fs);
+#endif
   nxmutex_destroy(&fs->nvs_lock);
   kmm_free(fs);
   file_close(&file);
@@ -40,6 +40,7 @@
 #include <nuttx/config.h>
 #include <nuttx/mtd/nand_config.h>
 
+#include <sys/param.h>
 #include <inttypes.h>
 #include <string.h>
 #include <assert.h>
@@ -71,6 +72,16 @@
  * Private Types
  ****************************************************************************/
 
+#if defined(CONFIG_MTD_NAND_PIPELINE) && defined(CONFIG_MTD_NAND_SWECC)
+/* State of a multi-page read with software ECC */
+
+struct nand_xfer_s
+{
+  FAR struct nand_raw_s *raw; /* The lower half */
+  int result;                 /* OK or -EUCLEAN if an error was corrected */
+};
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -93,6 +104,20 @@ static int      nand_readpage(FAR struct nand_dev_s *nand, off_t block,
                               unsigned int page, FAR uint8_t *data);
 static int      nand_writepage(FAR struct nand_dev_s *nand, off_t block,
                                unsigned int page, FAR const void *data);
+#ifdef CONFIG_MTD_NAND_PIPELINE
+#ifdef CONFIG_MTD_NAND_SWECC
+static int      nand_readdone(FAR void *arg, FAR void *data,
+                              FAR void *spare);
+static int      nand_writeprep(FAR void *arg, FAR void *data,
+                               FAR void *spare);
+#endif
+static int      nand_readpages(FAR struct nand_dev_s *nand, off_t block,
+                               unsigned int page, unsigned int npages,
+                               FAR uint8_t *data);
+static int      nand_writepages(FAR struct nand_dev_s *nand, off_t block,
+                                unsigned int page, unsigned int npages,
+                                FAR const uint8_t *data);
+#endif
 
 /* MTD driver methods */
 
@@ -522,6 +547,167 @@ static int nand_writepage(FAR struct nand_dev_s *nand, off_t block,
     }
 }
 
+#ifdef CONFIG_MTD_NAND_PIPELINE
+#ifdef CONFIG_MTD_NAND_SWECC
+/****************************************************************************
+ * Name: nand_readdone
+ *
+ * Description:
+ *   Called by the lower half after each page of a multi-page read to verify
+ *   the page with its ECC, while the lower half reads the next page.
+ *
+ ****************************************************************************/
+
+static int nand_readdone(FAR void *arg, FAR void *data, FAR void *spare)
+{
+  FAR struct nand_xfer_s *xfer = arg;
+  int ret;
+
+  ret = nandecc_checkpage(xfer->raw, data, spare);
+  if (ret == -EUCLEAN)
+    {
+      xfer->result = -EUCLEAN;
+      ret = OK;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nand_writeprep
+ *
+ * Description:
+ *   Called by the lower half before each page of a multi-page write to
+ *   compute the ECC of the page, while the lower half programs the previous
+ *   page.
+ *
+ ****************************************************************************/
+
+static int nand_writeprep(FAR void *arg, FAR void *data, FAR void *spare)
+{
+  FAR struct nand_raw_s *raw = arg;
+
+  memset(spare, 0xff, nandmodel_getsparesize(&raw->model));
+  nandecc_fillspare(raw, data, spare);
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: nand_readpages
+ *
+ * Description:
+ *   Reads the data area of consecutive pages of one block with the
+ *   multi-page method of the lower half.  The software ECC of each page is
+ *   verified while the next page is read.
+ *
+ * Input Parameters:
+ *   nand   - Upper-half, NAND FLASH interface
+ *   block  - Number of the block where the pages to read reside.
+ *   page   - Number of the first page to read inside the given block.
+ *   npages - Number of pages to read.
+ *   data   - Buffer where the data areas will be stored.
+ *
+ * Returned Value:
+ *   OK is returned in success; a negated errno value is returned on failure.
+ *
+ ****************************************************************************/
+
+static int nand_readpages(FAR struct nand_dev_s *nand, off_t block,
+                          unsigned int page, unsigned int npages,
+                          FAR uint8_t *data)
+{
+  FAR struct nand_raw_s *raw = nand->raw;
+
+  finfo("block=%d page=%d npages=%d data=%p\n",
+        (int)block, page, npages, data);
+
+#ifdef CONFIG_MTD_NAND_BLOCKCHECK
+  /* Check that the block is not BAD if data is requested */
+
+  if (nand_checkblock(nand, block) != GOODBLOCK)
+    {
+      ferr("ERROR: Block is BAD\n");
+      return -EAGAIN;
+    }
+#endif
+
+#ifdef CONFIG_MTD_NAND_SWECC
+  if (raw->ecctype == NANDECC_SWECC)
+    {
+      struct nand_xfer_s xfer;
+      int ret;
+
+      /* Read data with software ECC verification */
+
+      xfer.raw    = raw;
+      xfer.result = OK;
+
+      ret = NAND_RAWREADPAGES(raw, block, page, npages, data, raw->spare,
+                              nand_readdone, &xfer);
+      return ret < 0 ? ret : xfer.result;
+    }
+  else
+#endif
+    {
+      return NAND_RAWREADPAGES(raw, block, page, npages, data, NULL,
+                               NULL, NULL);
+    }
+}
+
+/****************************************************************************
+ * Name: nand_writepages
+ *
+ * Description:
+ *   Writes the data area of consecutive pages of one block with the
+ *   multi-page method of the lower half.  The software ECC of each page is
+ *   computed while the previous page is programmed.
+ *
+ * Input Parameters:
+ *   nand   - Upper-half, NAND FLASH interface
+ *   block  - Number of the block where the pages to write reside.
+ *   page   - Number of the first page to write inside the given block.
+ *   npages - Number of pages to write.
+ *   data   - Buffer containing the data to be written.
+ *
+ * Returned Value:
+ *   OK is returned in success; a negated errno value is returned on failure.
+ *
+ ****************************************************************************/
+
+static int nand_writepages(FAR struct nand_dev_s *nand, off_t block,
+                           unsigned int page, unsigned int npages,
+                           FAR const uint8_t *data)
+{
+  FAR struct nand_raw_s *raw = nand->raw;
+
+#ifdef CONFIG_MTD_NAND_BLOCKCHECK
+  /* Check that the block is good */
+
+  if (nand_checkblock(nand, block) != GOODBLOCK)
+    {
+      ferr("ERROR: Block is BAD\n");
+      return -EAGAIN;
+    }
+#endif
+
+#ifdef CONFIG_MTD_NAND_SWECC
+  if (raw->ecctype == NANDECC_SWECC)
+    {
+      /* Write data with software ECC calculation */
+
+      return NAND_RAWWRITEPAGES(raw, block, page, npages, data, raw->spare,
+                                nand_writeprep, raw);
+    }
+  else
+#endif
+    {
+      return NAND_RAWWRITEPAGES(raw, block, page, npages, data, NULL,
+                                NULL, NULL);
+    }
+}
+#endif /* CONFIG_MTD_NAND_PIPELINE */
+
 /****************************************************************************
  * Name: nand_erase
  *
@@ -578,6 +764,7 @@ static ssize_t nand_bread(FAR struct mtd_dev_s *dev, off_t startpage,
   FAR struct nand_model_s *model;
   bool fixedecc = false;
   unsigned int pagesperblock;
+  unsigned int count;
   unsigned int page;
   uint16_t pagesize;
   size_t remaining;
@@ -612,7 +799,7 @@ static ssize_t nand_bread(FAR struct mtd_dev_s *dev, off_t startpage,
 
   /* Then read every page from NAND */
 
-  for (remaining = npages; remaining > 0; remaining--)
+  for (remaining = npages; remaining > 0; remaining -= count)
     {
       /* Check for attempt to read beyond the end of NAND */
 
@@ -625,9 +812,24 @@ static ssize_t nand_bread(FAR struct mtd_dev_s *dev, off_t startpage,
           goto errout_with_lock;
         }
 
-      /* Read the next page from NAND */
+      count = 1;
+
+#ifdef CONFIG_MTD_NAND_PIPELINE
+      if (raw->rawreadpages != NULL && raw->ecctype < NANDECC_HWECC)
+        {
+          /* Read the pages up to the end of the block at once */
+
+          count = MIN(remaining, pagesperblock - page);
+          ret   = nand_readpages(nand, block, page, count, buffer);
+        }
+      else
+#endif
+        {
+          /* Read the next page from NAND */
+
+          ret = nand_readpage(nand, block, page, buffer);
+        }
 
-      ret = nand_readpage(nand, block, page, buffer);
       if (ret == -EUCLEAN)
         {
           fixedecc = true;
@@ -644,15 +846,16 @@ static ssize_t nand_bread(FAR struct mtd_dev_s *dev, off_t startpage,
        * the block number.
        */
 
-      if (++page >= pagesperblock)
+      page += count;
+      if (page >= pagesperblock)
         {
           page = 0;
           block++;
         }
 
-      /* Increment the buffer point by the size of one page */
+      /* Increment the buffer point by the size of the pages */
 
-      buffer += pagesize;
+      buffer += pagesize * count;
     }
 
   nxmutex_unlock(&nand->lock);
@@ -678,6 +881,7 @@ static ssize_t nand_bwrite(FAR struct mtd_dev_s *dev, off_t startpage,
   FAR struct nand_raw_s *raw;
   FAR struct nand_model_s *model;
   unsigned int pagesperblock;
+  unsigned int count;
   unsigned int page;
   uint16_t pagesize;
   size_t remaining;
@@ -712,7 +916,7 @@ static ssize_t nand_bwrite(FAR struct mtd_dev_s *dev, off_t startpage,
 
   /* Then write every page into NAND */
 
-  for (remaining = npages; remaining > 0; remaining--)
+  for (remaining = npages; remaining > 0; remaining -= count)
     {
       /* Check for attempt to write beyond the end of NAND */
 
@@ -725,9 +929,24 @@ static ssize_t nand_bwrite(FAR struct mtd_dev_s *dev, off_t startpage,
           goto errout_with_lock;
         }
 
-      /* Write the next page into NAND */
+      count = 1;
+
+#ifdef CONFIG_MTD_NAND_PIPELINE
+      if (raw->rawwritepages != NULL && raw->ecctype < NANDECC_HWECC)
+        {
+          /* Write the pages up to the end of the block at once */
+
+          count = MIN(remaining, pagesperblock - page);
+          ret   = nand_writepages(nand, block, page, count, buffer);
+        }
+      else
+#endif
+        {
+          /* Write the next page into NAND */
+
+          ret = nand_writepage(nand, block, page, buffer);
+        }
 
-      ret = nand_writepage(nand, block, page, buffer);
       if (ret < 0)
         {
           ferr("ERROR: nand_writepage failed block=%ld page=%d: %d\n",
@@ -740,15 +959,16 @@ static ssize_t nand_bwrite(FAR struct mtd_dev_s *dev, off_t startpage,
        * the block number.
        */
 
-      if (++page >= pagesperblock)
+      page += count;
+      if (page >= pagesperblock)
         {
           page = 0;
           block++;
         }
 
-      /* Increment the buffer point by the size of one page */
+      /* Increment the buffer point by the size of the pages */
 
-      buffer += pagesize;
+      buffer += pagesize * count;
     }
 
   nxmutex_unlock(&nand->lock);
@@ -59,6 +59,88 @@
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: nandecc_checkpage
+ *
+ * Description:
+ *   Verifies the data area of a NAND FLASH page using the ECC information
+ *   in its spare area, and corrects a single bit error.
+ *
+ * Input Parameters:
+ *   raw   - Lower-half, raw NAND FLASH interface
+ *   data  - The data area of the page.
+ *   spare - The spare area of the page.
+ *
+ * Returned Value:
+ *   OK if the data is valid, -EUCLEAN if an error was corrected and
+ *   -EBADMSG if the data cannot be corrected.
+ *
+ ****************************************************************************/
+
+int nandecc_checkpage(FAR struct nand_raw_s *raw, FAR void *data,
+                      FAR const void *spare)
+{
+  FAR struct nand_model_s *model = &raw->model;
+  int ret;
+
+  /* Retrieve ECC information from page */
+
+  nandscheme_readecc(nandmodel_getscheme(model), spare, raw->ecc);
+
+  /* Use the ECC data to verify the page */
+
+  ret = hamming_verify256x(data, nandmodel_getpagesize(model), raw->ecc);
+  switch (ret)
+    {
+      case HAMMING_SUCCESS:
+        return OK;
+
+      case HAMMING_ERROR_SINGLEBIT:
+        return -EUCLEAN;
+
+      default:
+        return -EBADMSG;
+    }
+}
+
+/****************************************************************************
+ * Name: nandecc_fillspare
+ *
+ * Description:
+ *   Calculates the ECC for the data area of a NAND FLASH page and stores it
+ *   in the spare area.  If no data is provided, the ECC bytes are set to
+ *   0xff to keep the existing bytes.
+ *
+ * Input Parameters:
+ *   raw   - Lower-half, raw NAND FLASH interface
+ *   data  - The data area of the page, may be NULL.
+ *   spare - The spare area of the page.
+ *
+ ****************************************************************************/
+
+void nandecc_fillspare(FAR struct nand_raw_s *raw, FAR const void *data,
+                       FAR void *spare)
+{
+  FAR struct nand_model_s *model = &raw->model;
+
+  /* Set hamming code set to 0xffff.. to keep existing bytes */
+
+  memset(raw->ecc, 0xff, CONFIG_MTD_NAND_MAXSPAREECCBYTES);
+
+  /* Compute ECC on the new data, if provided */
+
+  if (data)
+    {
+      /* Compute hamming code on data */
+
+      hamming_compute256x(data, nandmodel_getpagesize(model), raw->ecc);
+    }
+
+  /* Write the ECC */
+
+  nandscheme_writeecc(nandmodel_getscheme(model), spare, raw->ecc);
+}
+
 /****************************************************************************
  * Name: nandecc_readpage
  *
@@ -84,9 +166,6 @@ int nandecc_readpage(FAR struct nand_dev_s *nand, off_t block,
                      unsigned int page, FAR void *data, FAR void *spare)
 {
   FAR struct nand_raw_s *raw;
-  FAR struct nand_model_s *model;
-  FAR const struct nand_scheme_s *scheme;
-  unsigned int pagesize;
   unsigned int sparesize;
   int ret;
 
@@ -96,13 +175,11 @@ int nandecc_readpage(FAR struct nand_dev_s *nand, off_t block,
   /* Get convenience pointers */
 
   DEBUGASSERT(nand && nand->raw);
-  raw   = nand->raw;
-  model = &raw->model;
+  raw = nand->raw;
 
   /* Get size parameters */
 
-  pagesize  = nandmodel_getpagesize(model);
-  sparesize = nandmodel_getsparesize(model);
+  sparesize = nandmodel_getsparesize(&raw->model);
 
   /* Store code in spare buffer, either the buffer provided by the caller or
    * the scratch buffer in the raw NAND structure.
@@ -132,27 +209,16 @@ int nandecc_readpage(FAR struct nand_dev_s *nand, off_t block,
       return ret;
     }
 
-  /* Retrieve ECC information from page */
-
-  scheme = nandmodel_getscheme(model);
-  nandscheme_readecc(scheme, spare, raw->ecc);
-
   /* Use the ECC data to verify the page */
 
-  ret = hamming_verify256x(data, pagesize, raw->ecc);
-  switch (ret)
+  ret = nandecc_checkpage(raw, data, spare);
+  if (ret == -EBADMSG)
     {
-      case HAMMING_SUCCESS:
-        return OK;
-
-      case HAMMING_ERROR_SINGLEBIT:
-        return -EUCLEAN;
-
-      default:
-      ferr("ERROR: Block=%" PRIdOFF " page=%d Unrecoverable error: %d\n",
-           block, page, ret);
-      return -EBADMSG;
+      ferr("ERROR: Block=%" PRIdOFF " page=%d Unrecoverable error\n",
+           block, page);
     }
+
+  return ret;
 }
 
 /****************************************************************************
@@ -182,9 +248,6 @@ int nandecc_writepage(FAR struct nand_dev_s *nand, off_t block,
                       FAR void *spare)
 {
   FAR struct nand_raw_s *raw;
-  FAR struct nand_model_s *model;
-  FAR const struct nand_scheme_s *scheme;
-  unsigned int pagesize;
   unsigned int sparesize;
   int ret;
 
@@ -194,26 +257,11 @@ int nandecc_writepage(FAR struct nand_dev_s *nand, off_t block,
   /* Get convenience pointers */
 
   DEBUGASSERT(nand && nand->raw);
-  raw   = nand->raw;
-  model = &raw->model;
+  raw = nand->raw;
 
   /* Get size parameters */
 
-  pagesize  = nandmodel_getpagesize(model);
-  sparesize = nandmodel_getsparesize(model);
-
-  /* Set hamming code set to 0xffff.. to keep existing bytes */
-
-  memset(raw->ecc, 0xff, CONFIG_MTD_NAND_MAXSPAREECCBYTES);
-
-  /* Compute ECC on the new data, if provided */
-
-  if (data)
-    {
-      /* Compute hamming code on data */
-
-      hamming_compute256x(data, pagesize, raw->ecc);
-    }
+  sparesize = nandmodel_getsparesize(&raw->model);
 
   /* Store code in spare buffer, either the buffer provided by the caller or
    * the scratch buffer in the raw NAND structure.
@@ -225,10 +273,9 @@ int nandecc_writepage(FAR struct nand_dev_s *nand, off_t block,
       memset(spare, 0xff, sparesize);
     }
 
-  /* Write the ECC */
+  /* Compute and write the ECC */
 
-  scheme = nandmodel_getscheme(model);
-  nandscheme_writeecc(scheme, spare, raw->ecc);
+  nandecc_fillspare(raw, data, spare);
 
   /* Perform page write operation */
 
@@ -444,6 +444,160 @@ errout:
   return ret;
 }
 
+#ifdef CONFIG_MTD_NAND_PIPELINE
+/****************************************************************************
+ * Name: nand_ram_rawreadpages
+ *
+ * Description:
+ *   Reads consecutive pages from the device the way a chip with a cache
+ *   register does: the next page is loaded before 'done' is called for the
+ *   current one, which keeps its spare area in the other half of the
+ *   register.  The copies run on the CPU, so the order of the calls is the
+ *   same as on such a chip but nothing actually runs in parallel.
+ *
+ * Input Parameters:
+ *   raw: NAND MTD Device raw structure.
+ *   block: Block number (0 indexing) of the pages
+ *   page: First page number (0 indexing) in (relative to) that block
+ *   npages: Number of pages to read
+ *   data: Preallocated memory where the data will be copied to
+ *   spare: Preallocated memory where the spare data of each page will be
+ *          copied to
+ *   done: Called after each page
+ *   arg: Argument of done
+ *
+ * Returned Value:
+ *   0: Successful
+ *   < 0: Error returned by done
+ *
+ ****************************************************************************/
+
+int nand_ram_rawreadpages(FAR struct nand_raw_s *raw, off_t block,
+                          unsigned int page, unsigned int npages,
+                          FAR void *data, FAR void *spare,
+                          nand_pagecb_t done, FAR void *arg)
+{
+  uint8_t      cache[2][NAND_RAM_SPARE_SIZE];
+  FAR uint8_t *buffer = data;
+  unsigned int i;
+  int          ret;
+
+  if (npages == 0)
+    {
+      return OK;
+    }
+
+  ret = nand_ram_rawread(raw, block, page, buffer, cache[0]);
+  for (i = 0; i < npages && ret >= 0; i++)
+    {
+      /* Load the next page while the current one is checked */
+
+      if (i + 1 < npages)
+        {
+          ret = nand_ram_rawread(raw, block, page + i + 1,
+                                 buffer + NAND_RAM_PAGE_SIZE,
+                                 cache[(i + 1) & 1]);
+        }
+
+      if (ret >= 0 && done != NULL)
+        {
+          ret = done(arg, buffer, cache[i & 1]);
+        }
+
+      buffer += NAND_RAM_PAGE_SIZE;
+    }
+
+  if (ret >= 0 && spare != NULL)
+    {
+      memcpy(spare, cache[(npages - 1) & 1], NAND_RAM_SPARE_SIZE);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nand_ram_rawwritepages
+ *
+ * Description:
+ *   Writes consecutive pages to the device the way a chip with a cache
+ *   register does: a page is latched after 'prepare' and only programmed
+ *   once 'prepare' has run for the next page.  As for reads, the order is
+ *   that of such a chip but nothing actually runs in parallel.
+ *
+ * Input Parameters:
+ *   raw: NAND MTD Device raw structure.
+ *   block: Block number (0 indexing) of the pages
+ *   page: First page number (0 indexing) in (relative to) that block
+ *   npages: Number of pages to write
+ *   data: Data of the pages
+ *   spare: Spare data of each page, filled in by prepare
+ *   prepare: Called before each page
+ *   arg: Argument of prepare
+ *
+ * Returned Value:
+ *   0: Successful
+ *   -EACCESS: A page's block needs to be erased first before writing to it
+ *
+ ****************************************************************************/
+
+int nand_ram_rawwritepages(FAR struct nand_raw_s *raw, off_t block,
+                           unsigned int page, unsigned int npages,
+                           FAR const void *data, FAR void *spare,
+                           nand_pagecb_t prepare, FAR void *arg)
+{
+  uint8_t            cache[2][NAND_RAM_SPARE_SIZE];
+  FAR const uint8_t *buffer = data;
+  FAR uint8_t       *latch;
+  unsigned int       i;
+  int                ret    = OK;
+
+  if (npages == 0)
+    {
+      return OK;
+    }
+
+  /* Without 'prepare' the spare area given by the caller goes to every
+   * page.
+   */
+
+  memset(cache, 0xff, sizeof(cache));
+  if (spare != NULL)
+    {
+      memcpy(cache[0], spare, NAND_RAM_SPARE_SIZE);
+      memcpy(cache[1], spare, NAND_RAM_SPARE_SIZE);
+    }
+
+  if (prepare != NULL)
+    {
+      ret = prepare(arg, (FAR void *)buffer, cache[0]);
+    }
+
+  for (i = 0; i < npages && ret >= 0; i++)
+    {
+      latch = cache[i & 1];
+
+      /* Prepare the next page before the latched one is programmed */
+
+      if (i + 1 < npages && prepare != NULL)
+        {
+          ret = prepare(arg, (FAR void *)(buffer + NAND_RAM_PAGE_SIZE),
+                        cache[(i + 1) & 1]);
+        }
+
+      if (ret >= 0)
+        {
+          ret = nand_ram_rawwrite(raw, block, page + i, buffer,
+                                  spare != NULL || prepare != NULL ?
+                                  latch : NULL);
+        }
+
+      buffer += NAND_RAM_PAGE_SIZE;
+    }
+
+  return ret;
+}
+#endif /* CONFIG_MTD_NAND_PIPELINE */
+
 /****************************************************************************
  * Name: nand_ram_init
  *
@@ -476,6 +630,10 @@ FAR struct mtd_dev_s *nand_ram_initialize(struct nand_raw_s *raw)
   raw->eraseblock      = nand_ram_eraseblock;
   raw->rawread         = nand_ram_rawread;
   raw->rawwrite        = nand_ram_rawwrite;
+#ifdef CONFIG_MTD_NAND_PIPELINE
+  raw->rawreadpages    = nand_ram_rawreadpages;
+  raw->rawwritepages   = nand_ram_rawwritepages;
+#endif
 
   return nand_raw_initialize(raw);
 }
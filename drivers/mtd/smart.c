@@ -45,6 +45,7 @@
 #include <nuttx/crc16.h>
 #include <nuttx/crc32.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/mutex.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/ioctl.h>
 #include <nuttx/mtd/mtd.h>
@@ -98,6 +99,8 @@
 #define SMART_FMT_VERSION_POS     (SMART_FMT_POS1 + 4)
 #define SMART_FMT_NAMESIZE_POS    (SMART_FMT_POS1 + 5)
 #define SMART_FMT_ROOTDIRS_POS    (SMART_FMT_POS1 + 6)
+#define SMART_FMT_CHECKPOINT_POS  (SMART_FMT_POS1 + 7)
+#define SMART_FMT_CHECKPOINT      'C'
 #define SMARTFS_FMT_WEAR_POS      36
 #define SMART_WEAR_LEVEL_FORMAT_SIG 32
 #define SMART_PARTNAME_SIZE         4
@@ -112,6 +115,21 @@
                                              * such as format, sector,
                                              * etc.) */
 
+/* Sectors holding a checkpoint of the sector map use a logical sector
+ * number that is never valid.  The anchor records that locate them are
+ * appended to the last erase block of volumes formatted for checkpoints.
+ */
+
+#define SMART_CHECKPOINT_SECTOR     0xfffe
+#define SMART_CHECKPOINT_MAGIC      0x50434d53  /* "SMCP" */
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+#  define smart_checkpoint_block(d, b) \
+     ((d)->cpreserved && (b) == (d)->neraseblocks - 1)
+#else
+#  define smart_checkpoint_block(d, b) false
+#endif
+
 #if defined(CONFIG_MTD_SMART_READAHEAD) || (defined(CONFIG_DRVR_WRITABLE) && \
     defined(CONFIG_MTD_SMART_WRITEBUFFER))
 #  define SMART_HAVE_RWBUFFER 1
@@ -299,6 +317,15 @@ struct smart_struct_s
   size_t                bytesalloc;
   struct smart_alloc_s  alloc[SMART_MAX_ALLOCS];   /* Array of memory allocations */
 #endif
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  mutex_t               cplock;           /* Protects crefs and checkpoints */
+  uint16_t              crefs;            /* Number of opens of the volume */
+  bool                  cpreserved;       /* Last erase block holds checkpoints */
+  uint16_t              cpanchor;         /* Anchor of the valid checkpoint */
+  uint16_t              cpcount;          /* Number of sectors in cpsectors */
+  FAR uint16_t         *cpsectors;        /* Sectors of the valid checkpoint */
+  uint32_t              cpseq;            /* Sequence number of the last one */
+#endif
 };
 
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
@@ -378,6 +405,33 @@ typedef uint32_t crc_t;
 
 #endif
 
+/* Checkpoint anchor record.  It follows the sector header of a sector in
+ * the reserved erase block and is followed by the list of the physical
+ * sectors holding the saved map, which is the sector map followed by the
+ * released and free sector counts of every erase block.
+ */
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+struct smart_checkpoint_s
+{
+  uint32_t              magic;            /* SMART_CHECKPOINT_MAGIC */
+  uint32_t              crc;              /* CRC-32 of the rest and the list */
+  uint32_t              seq;              /* Sequence number */
+  uint32_t              mapcrc;           /* CRC-32 of the saved map */
+  uint32_t              maplen;           /* Length of the saved map */
+  uint16_t              sectorsize;       /* Geometry the map belongs to */
+  uint16_t              totalsectors;
+  uint16_t              neraseblocks;
+  uint16_t              freesectors;      /* Counts when the map was saved */
+  uint16_t              releasesectors;
+  uint16_t              nsectors;         /* Number of sectors in the list */
+  uint8_t               formatversion;    /* Format information */
+  uint8_t               namesize;
+  uint8_t               rootdirentries;
+  uint8_t               reserved;
+};
+#endif
+
 /* Following two definitions copied from internal definition of fs/smartfs.
  * Because needed to search chain_header and entry_header.
  */
@@ -451,6 +505,14 @@ static int     smart_relocate_sector(FAR struct smart_struct_s *dev,
 #ifdef CONFIG_MTD_SMART_FSCK
 static int     smart_fsck(FAR struct smart_struct_s *dev);
 #endif
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static int     smart_checkpoint_load(FAR struct smart_struct_s *dev);
+static int     smart_checkpoint_write(FAR struct smart_struct_s *dev);
+static int     smart_checkpoint_invalidate(FAR struct smart_struct_s *dev);
+static void    smart_checkpoint_reserve(FAR struct smart_struct_s *dev);
+static int     smart_checkpoint_release(FAR struct smart_struct_s *dev,
+                                        uint16_t physical);
+#endif
 
 #ifdef CONFIG_SMART_DEV_LOOP
 static ssize_t smart_loop_read(FAR struct file *filep, FAR char *buffer,
@@ -500,7 +562,24 @@ static const struct file_operations g_fops =
 
 static int smart_open(FAR struct inode *inode)
 {
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  FAR struct smart_struct_s *dev;
+#endif
+
   finfo("Entry\n");
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
+  dev = ((FAR struct smart_multiroot_device_s *)inode->i_private)->dev;
+#else
+  dev = inode->i_private;
+#endif
+
+  nxmutex_lock(&dev->cplock);
+  dev->crefs++;
+  nxmutex_unlock(&dev->cplock);
+#endif
+
   return OK;
 }
 
@@ -513,7 +592,38 @@ static int smart_open(FAR struct inode *inode)
 
 static int smart_close(FAR struct inode *inode)
 {
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  FAR struct smart_struct_s *dev;
+  int ret;
+#endif
+
   finfo("Entry\n");
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
+  dev = ((FAR struct smart_multiroot_device_s *)inode->i_private)->dev;
+#else
+  dev = inode->i_private;
+#endif
+
+  /* Save the sector map when the last user closes the volume so that the
+   * next mount doesn't have to scan it.  The lock keeps an open from
+   * racing with the write.
+   */
+
+  nxmutex_lock(&dev->cplock);
+  if (dev->crefs > 0 && --dev->crefs == 0)
+    {
+      ret = smart_checkpoint_write(dev);
+      if (ret < 0)
+        {
+          fwarn("WARNING: No checkpoint saved: %d\n", ret);
+        }
+    }
+
+  nxmutex_unlock(&dev->cplock);
+#endif
+
   return OK;
 }
 
@@ -951,6 +1061,16 @@ static ssize_t smart_write(FAR struct inode *inode,
 
   /* I think maybe we need to lock on a mutex here */
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* Raw writes change the volume behind the back of the sector map */
+
+  ret = smart_checkpoint_invalidate(dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+#endif
+
   /* Get the aligned block.  Here it is assumed: (1) The number of R/W blocks
    * per erase block is a power of 2, and (2) the erase begins with that same
    * alignment.
@@ -1934,6 +2054,66 @@ static int smart_set_wear_level(FAR struct smart_struct_s *dev,
 }
 #endif
 
+/****************************************************************************
+ * Name: smart_register_rootdirs
+ *
+ * Description: Registers the block devices of the additional root
+ *              directories of a volume formatted with more than one.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
+static int smart_register_rootdirs(FAR struct smart_struct_s *dev)
+{
+  FAR struct smart_multiroot_device_s *rootdirdev;
+  char devname[32];
+  int x;
+
+  /* If rootdirentries is greater than 1, then we need to register
+   * additional block devices.
+   */
+
+  for (x = 1; x < dev->rootdirentries; x++)
+    {
+      if (dev->partname[0] != '\0')
+        {
+          snprintf(devname, sizeof(devname), "/dev/smart%d%sd%d",
+                   dev->minor, dev->partname, x + 1);
+        }
+      else
+        {
+          snprintf(devname, sizeof(devname), "/dev/smart%dd%d",
+                   dev->minor, x + 1);
+        }
+
+      /* Inode private data is a reference to a struct containing
+       * the SMART device structure and the root directory number.
+       */
+
+      rootdirdev = (FAR struct smart_multiroot_device_s *)
+        smart_malloc(dev, sizeof(*rootdirdev), "Root Dir");
+      if (rootdirdev == NULL)
+        {
+          ferr("ERROR: Memory alloc failed\n");
+          return -ENOMEM;
+        }
+
+      /* Populate the rootdirdev */
+
+      rootdirdev->dev = dev;
+      rootdirdev->rootdirnum = x;
+
+      /* Inode private data is a reference to the SMART device
+       * structure.
+       */
+
+      register_blockdriver(devname, &g_bops, 0, rootdirdev);
+    }
+
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: smart_scan
  *
@@ -1962,11 +2142,6 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 #ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
   int       dupsector;
   uint16_t  duplogsector;
-#endif
-#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
-  int       x;
-  char      devname[32];
-  FAR struct smart_multiroot_device_s *rootdirdev;
 #endif
   static const uint16_t sizetbl[8] =
   {
@@ -2037,6 +2212,31 @@ static int smart_scan(FAR struct smart_struct_s *dev)
       goto err_out;
     }
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* Forget the checkpoint of an earlier scan */
+
+  kmm_free(dev->cpsectors);
+  dev->cpsectors  = NULL;
+  dev->cpreserved = false;
+
+  /* If the volume has a valid checkpoint, then load the sector map and the
+   * free and released counts from it instead of scanning the device.
+   */
+
+  if (smart_checkpoint_load(dev) == OK)
+    {
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
+      ret = smart_register_rootdirs(dev);
+      if (ret < 0)
+        {
+          goto err_out;
+        }
+#endif
+
+      goto loaded;
+    }
+#endif
+
   /* Initialize the device variables */
 
   totalsectors        = dev->totalsectors;
@@ -2156,6 +2356,25 @@ static int smart_scan(FAR struct smart_struct_s *dev)
           continue;
         }
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+      /* The sectors of a checkpoint that could not be loaded are stale.
+       * Release them so that garbage collection can reclaim them.
+       */
+
+      if (logicalsector == SMART_CHECKPOINT_SECTOR)
+        {
+          ret = smart_checkpoint_release(dev, sector);
+          if (ret < 0)
+            {
+              goto err_out;
+            }
+
+          dev->releasesectors++;
+          dev->releasecount[sector / dev->sectorsperblk]++;
+          continue;
+        }
+#endif
+
       if ((header.status & SMART_STATUS_VERBITS) != SMART_STATUS_VERSION)
         {
           continue;
@@ -2208,49 +2427,18 @@ static int smart_scan(FAR struct smart_struct_s *dev)
           dev->namesize = dev->rwbuffer[SMART_FMT_NAMESIZE_POS];
           dev->formatversion = dev->rwbuffer[SMART_FMT_VERSION_POS];
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+          dev->cpreserved = dev->rwbuffer[SMART_FMT_CHECKPOINT_POS] ==
+                            SMART_FMT_CHECKPOINT;
+#endif
+
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
           dev->rootdirentries = dev->rwbuffer[SMART_FMT_ROOTDIRS_POS];
 
-          /* If rootdirentries is greater than 1, then we need to register
-           * additional block devices.
-           */
-
-          for (x = 1; x < dev->rootdirentries; x++)
+          ret = smart_register_rootdirs(dev);
+          if (ret < 0)
             {
-              if (dev->partname[0] != '\0')
-                {
-                  snprintf(devname, sizeof(devname), "/dev/smart%d%sd%d",
-                           dev->minor, dev->partname, x + 1);
-                }
-              else
-                {
-                  snprintf(devname, sizeof(devname), "/dev/smart%dd%d",
-                           dev->minor, x + 1);
-                }
-
-              /* Inode private data is a reference to a struct containing
-               * the SMART device structure and the root directory number.
-               */
-
-              rootdirdev = (FAR struct smart_multiroot_device_s *)
-                smart_malloc(dev, sizeof(*rootdirdev), "Root Dir");
-              if (rootdirdev == NULL)
-                {
-                  ferr("ERROR: Memory alloc failed\n");
-                  ret = -ENOMEM;
-                  goto err_out;
-                }
-
-              /* Populate the rootdirdev */
-
-              rootdirdev->dev = dev;
-              rootdirdev->rootdirnum = x;
-
-              /* Inode private data is a reference to the SMART device
-               * structure.
-               */
-
-              ret = register_blockdriver(devname, &g_bops, 0, rootdirdev);
+              goto err_out;
             }
 #endif
         }
@@ -2497,6 +2685,12 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 #endif
     }
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* Take the erase block of the checkpoint records out of the counts */
+
+  smart_checkpoint_reserve(dev);
+#endif
+
 #if defined (CONFIG_MTD_SMART_WEAR_LEVEL) && (SMART_STATUS_VERSION == 1)
 #ifdef CONFIG_MTD_SMART_CONVERT_WEAR_FORMAT
 
@@ -2577,6 +2771,10 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 #ifdef CONFIG_MTD_SMART_FSCK
   smart_fsck(dev);
 #endif
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+loaded:
+#endif
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
   /* Read the wear leveling status bits */
 
@@ -2843,7 +3041,8 @@ static int smart_relocate_static_data(FAR struct smart_struct_s *dev,
       minblock = dev->geo.neraseblocks;
       for (x = 0; x < dev->geo.neraseblocks; x++)
         {
-          if (smart_get_wear_level(dev, x) == dev->minwearlevel)
+          if (smart_get_wear_level(dev, x) == dev->minwearlevel &&
+              !smart_checkpoint_block(dev, x))
             {
               /* Don't allow the format sector or directory sector to
                * be moved into a worn block.  First get the format and
@@ -3168,6 +3367,17 @@ static inline int smart_llformat(FAR struct smart_struct_s *dev,
       return ret;
     }
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* The erase took any checkpoint with it.  Reserve the last erase block
+   * for checkpoints, except on volumes of 65536 sectors which already
+   * lose two sectors of that block.
+   */
+
+  kmm_free(dev->cpsectors);
+  dev->cpsectors  = NULL;
+  dev->cpreserved = dev->totalsectors != 65534;
+#endif
+
   /* Now construct a logical sector zero header to write to the device. */
 
   sectorheader = (FAR struct smart_sect_header_s *)dev->rwbuffer;
@@ -3230,6 +3440,13 @@ static inline int smart_llformat(FAR struct smart_struct_s *dev,
 
   dev->rwbuffer[SMART_FMT_ROOTDIRS_POS] = (uint8_t)(arg & 0xff);
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  if (dev->cpreserved)
+    {
+      dev->rwbuffer[SMART_FMT_CHECKPOINT_POS] = SMART_FMT_CHECKPOINT;
+    }
+#endif
+
 #ifdef CONFIG_SMART_CRC_8
   sectorheader->crc8 = smart_calc_sector_crc(dev);
 #elif defined(CONFIG_SMART_CRC_16)
@@ -3303,6 +3520,10 @@ static inline int smart_llformat(FAR struct smart_struct_s *dev,
   dev->freecount[0]--;
 #endif
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  smart_checkpoint_reserve(dev);
+#endif
+
   /* Now initialize the logical to physical sector map */
 
 #ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
@@ -3466,81 +3687,784 @@ errout:
   return ret;
 }
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+
 /****************************************************************************
- * Name: smart_relocate_block
+ * Name: smart_checkpoint_erased
  *
- * Description:  Relocates the specified MTD erase block by moving any
- *               active sectors to a different erase block and then erases
- *               the selected block.
+ * Description:  Tests if a sector header is in the erased state, using the
+ *               same test as the free sector allocation.
  *
  ****************************************************************************/
 
-static int smart_relocate_block(FAR struct smart_struct_s *dev,
-                                uint16_t block)
+static bool smart_checkpoint_erased(FAR struct smart_sect_header_s *header)
 {
-  uint16_t newsector;
-  uint16_t oldrelease;
-  int x;
-  int ret;
-  FAR struct smart_sect_header_s *header;
-  uint8_t prerelease;
-  uint16_t freecount;
-#if defined(CONFIG_SMART_LOCAL_CHECKFREE) && defined(CONFIG_DEBUG_FS)
-  uint16_t releasecount;
-#endif
-#ifdef CONFIG_MTD_SMART_ENABLE_CRC
-  FAR struct smart_allocsector_s *allocsector;
+  return *((FAR uint16_t *)header->logicalsector) == 0xffff &&
+#if SMART_STATUS_VERSION == 1
+         *((FAR uint16_t *)&header->seq) == 0xffff &&
+#else
+         header->seq == CONFIG_SMARTFS_ERASEDSTATE &&
 #endif
+         (header->status & SMART_STATUS_COMMITTED) ==
+         (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_COMMITTED);
+}
 
-  /* Perform collection on block with the most released sectors.
-   * First mark the block as having no free sectors so we don't
-   * try to move sectors into the block we are trying to erase.
-   */
-
-  header = (FAR struct smart_sect_header_s *)dev->rwbuffer;
+/****************************************************************************
+ * Name: smart_checkpoint_live
+ *
+ * Description:  Tests if a sector header is that of a committed and not
+ *               released checkpoint sector.
+ *
+ ****************************************************************************/
 
-#ifdef CONFIG_SMART_LOCAL_CHECKFREE
-  if (smart_checkfree(dev, __LINE__) != OK)
-    {
-      fwarn("   ...while relocating block %d, free=%d\n",
-            block, dev->freesectors);
-    }
-#endif
+static bool smart_checkpoint_live(FAR struct smart_sect_header_s *header)
+{
+  return *((FAR uint16_t *)header->logicalsector) ==
+         SMART_CHECKPOINT_SECTOR &&
+         (header->status & SMART_STATUS_COMMITTED) !=
+         (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_COMMITTED) &&
+         (header->status & SMART_STATUS_RELEASED) ==
+         (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_RELEASED) &&
+         (header->status & SMART_STATUS_VERBITS) == SMART_STATUS_VERSION;
+}
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
-  freecount = smart_get_count(dev, dev->freecount, block);
+/****************************************************************************
+ * Name: smart_checkpoint_header
+ *
+ * Description:  Prepares the RW buffer with the header of a committed
+ *               checkpoint sector.
+ *
+ ****************************************************************************/
 
-#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
-#if defined(CONFIG_SMART_LOCAL_CHECKFREE) && defined(CONFIG_DEBUG_FS)
-  releasecount = smart_get_count(dev, dev->releasecount, block);
-#endif
-#endif
+static void smart_checkpoint_header(FAR struct smart_struct_s *dev)
+{
+  FAR struct smart_sect_header_s *header;
+  uint8_t sectsize;
 
-  /* Ensure we aren't relocating a block containing the only free sectors */
+  header = (FAR struct smart_sect_header_s *)dev->rwbuffer;
+  memset(dev->rwbuffer, CONFIG_SMARTFS_ERASEDSTATE, dev->sectorsize);
 
-  if (freecount >= dev->freesectors)
-    {
-      ferr("ERROR: Program bug!  "
-           "Relocating the only block (%d) with free sectors!\n",
-           block);
-      ret = -EIO;
-      goto errout;
-    }
+#if SMART_STATUS_VERSION == 1 && !defined(CONFIG_MTD_SMART_ENABLE_CRC)
+  *((FAR uint16_t *)&header->seq) = 0;
+#else
+  header->seq = 0;
+#endif
 
-  smart_set_count(dev, dev->freecount, block, 0);
+  sectsize = dev->sectorsize < 4096  ? (dev->sectorsize >> 9) :
+             dev->sectorsize == 4096 ? 3 : 5 + (dev->sectorsize >> 14);
+  sectsize <<= 2;
 
-#else /* CONFIG_MTD_SMART_PACK_COUNTS */
+  *((FAR uint16_t *)header->logicalsector) = SMART_CHECKPOINT_SECTOR;
 
-  freecount = dev->freecount[block];
-#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
-#if defined(CONFIG_SMART_LOCAL_CHECKFREE) && defined(CONFIG_DEBUG_FS)
-  releasecount = dev->releasecount[block];
+#if CONFIG_SMARTFS_ERASEDSTATE == 0xff
+  header->status = (uint8_t)~(SMART_STATUS_COMMITTED |
+                              SMART_STATUS_VERBITS |
+                              SMART_STATUS_SIZEBITS) |
+                              SMART_STATUS_VERSION |
+                              sectsize;
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+  header->status &= ~SMART_STATUS_CRC;
 #endif
+#else
+  header->status = (uint8_t)(SMART_STATUS_COMMITTED |
+                             SMART_STATUS_VERSION |
+                             sectsize);
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+  header->status |= SMART_STATUS_CRC;
 #endif
-  dev->freecount[block] = 0;
 #endif
+}
 
-  /* Next move all live data in the block to a new home. */
+/****************************************************************************
+ * Name: smart_checkpoint_program
+ *
+ * Description:  Writes the checkpoint sector prepared in the RW buffer to
+ *               an erased physical sector.
+ *
+ ****************************************************************************/
+
+static int smart_checkpoint_program(FAR struct smart_struct_s *dev,
+                                    uint16_t physical)
+{
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+  FAR struct smart_sect_header_s *header;
+#endif
+  size_t wrcount;
+
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+  header = (FAR struct smart_sect_header_s *)dev->rwbuffer;
+#endif
+
+#ifdef CONFIG_SMART_CRC_8
+  header->crc8 = smart_calc_sector_crc(dev);
+#elif defined(CONFIG_SMART_CRC_16)
+  *((FAR uint16_t *)header->crc16) = smart_calc_sector_crc(dev);
+#elif defined(CONFIG_SMART_CRC_32)
+  *((FAR uint32_t *)header->crc32) = smart_calc_sector_crc(dev);
+#endif
+
+  wrcount = MTD_BWRITE(dev->mtd, physical * dev->mtdblkspersector,
+                       dev->mtdblkspersector, (FAR uint8_t *)dev->rwbuffer);
+  if (wrcount != dev->mtdblkspersector)
+    {
+      ferr("ERROR: Error writing checkpoint sector %d\n", physical);
+      return -EIO;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: smart_checkpoint_release
+ *
+ * Description:  Marks a checkpoint sector as released.
+ *
+ ****************************************************************************/
+
+static int smart_checkpoint_release(FAR struct smart_struct_s *dev,
+                                    uint16_t physical)
+{
+  uint8_t status;
+  size_t offset;
+  int ret;
+
+  offset = physical * dev->mtdblkspersector * dev->geo.blocksize +
+           offsetof(struct smart_sect_header_s, status);
+  ret = MTD_READ(dev->mtd, offset, 1, &status);
+  if (ret != 1)
+    {
+      return -EIO;
+    }
+
+#if CONFIG_SMARTFS_ERASEDSTATE == 0xff
+  status &= ~SMART_STATUS_RELEASED;
+#else
+  status |= SMART_STATUS_RELEASED;
+#endif
+
+  ret = smart_bytewrite(dev, offset, 1, &status);
+  return ret < 0 ? ret : OK;
+}
+
+/****************************************************************************
+ * Name: smart_checkpoint_reserve
+ *
+ * Description:  Takes the erase block of the checkpoint anchors out of the
+ *               free and released sector counts, so that sectors are never
+ *               allocated from it and it is never garbage collected.
+ *
+ ****************************************************************************/
+
+static void smart_checkpoint_reserve(FAR struct smart_struct_s *dev)
+{
+  uint16_t block = dev->neraseblocks - 1;
+
+  if (dev->cpreserved)
+    {
+      dev->freesectors        -= dev->freecount[block];
+      dev->releasesectors     -= dev->releasecount[block];
+      dev->freecount[block]    = 0;
+      dev->releasecount[block] = 0;
+    }
+}
+
+/****************************************************************************
+ * Name: smart_checkpoint_load
+ *
+ * Description:  Loads the sector map and the free and released counts from
+ *               the last checkpoint of the volume.  Fails if there is none
+ *               or if it was invalidated, doesn't match the geometry or is
+ *               corrupt, in which case the volume must be scanned.
+ *
+ ****************************************************************************/
+
+static int smart_checkpoint_load(FAR struct smart_struct_s *dev)
+{
+  FAR struct smart_sect_header_s *header;
+  struct smart_sect_header_s sectheader;
+  struct smart_checkpoint_s cp;
+  FAR uint8_t *list;
+  FAR uint8_t *map;
+  uint32_t readaddress;
+  uint32_t crc;
+  size_t mapsize;
+  size_t remaining;
+  size_t len;
+  int physical;
+  int anchor;
+  int first;
+  int ret;
+  int x;
+
+  /* Find the last anchor appended to the reserved erase block */
+
+  first  = (dev->neraseblocks - 1) * dev->sectorsperblk;
+  anchor = -1;
+
+  for (physical = first; physical < first + dev->availsectperblk;
+       physical++)
+    {
+      readaddress = physical * dev->mtdblkspersector * dev->geo.blocksize;
+      ret = MTD_READ(dev->mtd, readaddress,
+                     sizeof(struct smart_sect_header_s),
+                     (FAR uint8_t *)&sectheader);
+      if (ret != sizeof(struct smart_sect_header_s))
+        {
+          return -EIO;
+        }
+
+      if (smart_checkpoint_erased(&sectheader))
+        {
+          break;
+        }
+
+      if ((sectheader.status & SMART_STATUS_COMMITTED) ==
+          (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_COMMITTED))
+        {
+          /* An anchor whose write was interrupted */
+
+          continue;
+        }
+
+      if (*((FAR uint16_t *)sectheader.logicalsector) !=
+          SMART_CHECKPOINT_SECTOR)
+        {
+          /* Not a volume formatted for checkpoints */
+
+          return -ENOENT;
+        }
+
+      anchor = physical;
+    }
+
+  if (anchor < 0)
+    {
+      return -ENOENT;
+    }
+
+  ret = MTD_BREAD(dev->mtd, anchor * dev->mtdblkspersector,
+                  dev->mtdblkspersector, (FAR uint8_t *)dev->rwbuffer);
+  if (ret != dev->mtdblkspersector)
+    {
+      return -EIO;
+    }
+
+  /* An anchor is released when the volume changes after it was written */
+
+  header = (FAR struct smart_sect_header_s *)dev->rwbuffer;
+  if (!smart_checkpoint_live(header))
+    {
+      finfo("Checkpoint out of date\n");
+      return -ENOENT;
+    }
+
+  memcpy(&cp, &dev->rwbuffer[sizeof(struct smart_sect_header_s)],
+         sizeof(cp));
+  list = (FAR uint8_t *)&dev->rwbuffer[sizeof(struct smart_sect_header_s) +
+                                       sizeof(cp)];
+  mapsize = dev->totalsectors * sizeof(uint16_t) + (dev->neraseblocks << 1);
+
+  if (cp.magic != SMART_CHECKPOINT_MAGIC ||
+      cp.sectorsize != dev->sectorsize ||
+      cp.totalsectors != dev->totalsectors ||
+      cp.neraseblocks != dev->neraseblocks ||
+      cp.maplen != mapsize || cp.nsectors == 0 ||
+      cp.nsectors > (dev->sectorsize - sizeof(struct smart_sect_header_s) -
+                     sizeof(cp)) / sizeof(uint16_t))
+    {
+      ferr("ERROR: Checkpoint doesn't match the volume\n");
+      return -EINVAL;
+    }
+
+  crc = crc32part((FAR uint8_t *)&cp.seq,
+                  sizeof(cp) - offsetof(struct smart_checkpoint_s, seq), 0);
+  crc = crc32part(list, cp.nsectors * sizeof(uint16_t), crc);
+  if (crc != cp.crc)
+    {
+      ferr("ERROR: Checkpoint anchor CRC error\n");
+      return -EBADMSG;
+    }
+
+  dev->cpsectors = kmm_malloc(cp.nsectors * sizeof(uint16_t));
+  if (dev->cpsectors == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  memcpy(dev->cpsectors, list, cp.nsectors * sizeof(uint16_t));
+
+  /* Read the map straight into the sector map and count arrays, which are
+   * a single allocation.
+   */
+
+  map       = (FAR uint8_t *)dev->smap;
+  remaining = mapsize;
+  crc       = 0;
+
+  for (x = 0; x < cp.nsectors; x++)
+    {
+      physical = dev->cpsectors[x];
+      if (physical >= first)
+        {
+          ret = -EINVAL;
+          goto errout;
+        }
+
+      readaddress = physical * dev->mtdblkspersector * dev->geo.blocksize;
+      ret = MTD_READ(dev->mtd, readaddress,
+                     sizeof(struct smart_sect_header_s),
+                     (FAR uint8_t *)&sectheader);
+      if (ret != sizeof(struct smart_sect_header_s))
+        {
+          ret = -EIO;
+          goto errout;
+        }
+
+      if (!smart_checkpoint_live(&sectheader))
+        {
+          ret = -EINVAL;
+          goto errout;
+        }
+
+      len = dev->sectorsize - sizeof(struct smart_sect_header_s);
+      if (len > remaining)
+        {
+          len = remaining;
+        }
+
+      ret = MTD_READ(dev->mtd, readaddress +
+                     sizeof(struct smart_sect_header_s), len, map);
+      if (ret != len)
+        {
+          ret = -EIO;
+          goto errout;
+        }
+
+      crc        = crc32part(map, len, crc);
+      map       += len;
+      remaining -= len;
+    }
+
+  if (remaining != 0 || crc != cp.mapcrc)
+    {
+      ferr("ERROR: Checkpoint map CRC error\n");
+      ret = -EBADMSG;
+      goto errout;
+    }
+
+  /* The map was saved before the sectors holding it were written */
+
+  for (x = 0; x < cp.nsectors; x++)
+    {
+      dev->freecount[dev->cpsectors[x] / dev->sectorsperblk]--;
+    }
+
+  dev->freesectors    = cp.freesectors - cp.nsectors;
+  dev->releasesectors = cp.releasesectors;
+  dev->formatstatus   = SMART_FMT_STAT_FORMATTED;
+  dev->formatversion  = cp.formatversion;
+  dev->namesize       = cp.namesize;
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
+  dev->rootdirentries = cp.rootdirentries;
+#endif
+  dev->cpreserved     = true;
+  dev->cpanchor       = anchor;
+  dev->cpcount        = cp.nsectors;
+  dev->cpseq          = cp.seq;
+
+  finfo("Loaded checkpoint %" PRIu32 " from %d sectors\n",
+        cp.seq, cp.nsectors);
+  return OK;
+
+errout:
+  ferr("ERROR: Invalid checkpoint sector %d: %d\n", physical, ret);
+  kmm_free(dev->cpsectors);
+  dev->cpsectors = NULL;
+  return ret;
+}
+
+/****************************************************************************
+ * Name: smart_checkpoint_write
+ *
+ * Description:  Saves the sector map and the free and released counts to
+ *               sectors of the volume and appends an anchor locating them
+ *               to the reserved erase block.  Nothing is written if the
+ *               checkpoint on the volume is still valid.
+ *
+ ****************************************************************************/
+
+static int smart_checkpoint_write(FAR struct smart_struct_s *dev)
+{
+  struct smart_sect_header_s sectheader;
+  struct smart_checkpoint_s cp;
+  FAR uint16_t *sectors;
+  FAR uint8_t *map;
+  uint32_t readaddress;
+  size_t mapsize;
+  size_t remaining;
+  size_t chunk;
+  size_t len;
+  uint16_t nsectors;
+  uint16_t block;
+  int physical;
+  int written;
+  int count;
+  int first;
+  int ret;
+  int x;
+
+  if (!dev->cpreserved || dev->cpsectors != NULL ||
+      dev->formatstatus != SMART_FMT_STAT_FORMATTED)
+    {
+      return OK;
+    }
+
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+  /* Sectors allocated but not written yet are only known in RAM */
+
+  if (dev->allocsector != NULL)
+    {
+      return -EBUSY;
+    }
+#endif
+
+  mapsize  = dev->totalsectors * sizeof(uint16_t) + (dev->neraseblocks << 1);
+  chunk    = dev->sectorsize - sizeof(struct smart_sect_header_s);
+  nsectors = (mapsize + chunk - 1) / chunk;
+
+  if (nsectors > (chunk - sizeof(cp)) / sizeof(uint16_t))
+    {
+      return -E2BIG;
+    }
+
+  /* Don't use up the sectors kept for garbage collection */
+
+  if (dev->freesectors <= nsectors + dev->sectorsperblk + 4)
+    {
+      return -ENOSPC;
+    }
+
+  sectors = kmm_malloc(nsectors * sizeof(uint16_t));
+  if (sectors == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  /* Pick the sectors for the map.  All of them are chosen before any is
+   * written, so that the counts saved with the map don't change while it
+   * is being written.
+   */
+
+  count = 0;
+  block = dev->lastallocblock;
+
+  for (x = 0; x < dev->neraseblocks && count < nsectors; x++)
+    {
+      if (++block >= dev->neraseblocks)
+        {
+          block = 0;
+        }
+
+      if (dev->freecount[block] == 0 || smart_checkpoint_block(dev, block))
+        {
+          continue;
+        }
+
+      first = block * dev->sectorsperblk;
+      for (physical = first; physical < first + dev->availsectperblk &&
+           count < nsectors; physical++)
+        {
+          readaddress = physical * dev->mtdblkspersector *
+                        dev->geo.blocksize;
+          ret = MTD_READ(dev->mtd, readaddress,
+                         sizeof(struct smart_sect_header_s),
+                         (FAR uint8_t *)&sectheader);
+          if (ret != sizeof(struct smart_sect_header_s))
+            {
+              ret = -EIO;
+              goto errout;
+            }
+
+          if (smart_checkpoint_erased(&sectheader))
+            {
+              sectors[count++] = physical;
+            }
+        }
+    }
+
+  if (count < nsectors)
+    {
+      ret = -ENOSPC;
+      goto errout;
+    }
+
+  memset(&cp, 0, sizeof(cp));
+  cp.magic          = SMART_CHECKPOINT_MAGIC;
+  cp.seq            = dev->cpseq + 1;
+  cp.maplen         = mapsize;
+  cp.sectorsize     = dev->sectorsize;
+  cp.totalsectors   = dev->totalsectors;
+  cp.neraseblocks   = dev->neraseblocks;
+  cp.freesectors    = dev->freesectors;
+  cp.releasesectors = dev->releasesectors;
+  cp.nsectors       = nsectors;
+  cp.formatversion  = dev->formatversion;
+  cp.namesize       = dev->namesize;
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
+  cp.rootdirentries = dev->rootdirentries;
+#else
+  cp.rootdirentries = 1;
+#endif
+
+  /* Save the map */
+
+  map       = (FAR uint8_t *)dev->smap;
+  remaining = mapsize;
+  ret       = OK;
+
+  for (written = 0; written < nsectors; written++)
+    {
+      len = chunk < remaining ? chunk : remaining;
+
+      smart_checkpoint_header(dev);
+      memcpy(&dev->rwbuffer[sizeof(struct smart_sect_header_s)], map, len);
+      cp.mapcrc = crc32part(map, len, cp.mapcrc);
+
+      ret = smart_checkpoint_program(dev, sectors[written]);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      map       += len;
+      remaining -= len;
+    }
+
+  /* The sectors written are in use now */
+
+  for (x = 0; x < written; x++)
+    {
+      dev->freecount[sectors[x] / dev->sectorsperblk]--;
+      dev->freesectors--;
+    }
+
+  if (ret < 0)
+    {
+      goto errout_release;
+    }
+
+  /* Find the place of the anchor, after the last one in the reserved
+   * erase block.  Erase the block when it is full.
+   */
+
+  block = dev->neraseblocks - 1;
+  first = block * dev->sectorsperblk;
+
+  for (physical = first; physical < first + dev->availsectperblk;
+       physical++)
+    {
+      readaddress = physical * dev->mtdblkspersector * dev->geo.blocksize;
+      ret = MTD_READ(dev->mtd, readaddress,
+                     sizeof(struct smart_sect_header_s),
+                     (FAR uint8_t *)&sectheader);
+      if (ret != sizeof(struct smart_sect_header_s))
+        {
+          ret = -EIO;
+          goto errout_release;
+        }
+
+      if (smart_checkpoint_erased(&sectheader))
+        {
+          break;
+        }
+    }
+
+  if (physical == first + dev->availsectperblk)
+    {
+      ret = MTD_ERASE(dev->mtd, block, 1);
+      if (ret < 0)
+        {
+          goto errout_release;
+        }
+
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+      smart_set_wear_level(dev, block, smart_get_wear_level(dev, block) + 1);
+#endif
+      physical = first;
+    }
+
+  /* Write the anchor */
+
+  smart_checkpoint_header(dev);
+  memcpy(&dev->rwbuffer[sizeof(struct smart_sect_header_s) + sizeof(cp)],
+         sectors, nsectors * sizeof(uint16_t));
+
+  cp.crc = crc32part((FAR uint8_t *)&cp.seq,
+                     sizeof(cp) - offsetof(struct smart_checkpoint_s, seq),
+                     0);
+  cp.crc = crc32part((FAR uint8_t *)sectors, nsectors * sizeof(uint16_t),
+                     cp.crc);
+  memcpy(&dev->rwbuffer[sizeof(struct smart_sect_header_s)], &cp,
+         sizeof(cp));
+
+  ret = smart_checkpoint_program(dev, physical);
+  if (ret < 0)
+    {
+      goto errout_release;
+    }
+
+  dev->cpsectors = sectors;
+  dev->cpanchor  = physical;
+  dev->cpcount   = nsectors;
+  dev->cpseq     = cp.seq;
+
+  finfo("Saved checkpoint %" PRIu32 " to %d sectors\n", cp.seq, nsectors);
+  return OK;
+
+errout_release:
+
+  /* Release the sectors of the incomplete checkpoint */
+
+  for (x = 0; x < written; x++)
+    {
+      if (smart_checkpoint_release(dev, sectors[x]) >= 0)
+        {
+          dev->releasecount[sectors[x] / dev->sectorsperblk]++;
+          dev->releasesectors++;
+        }
+    }
+
+errout:
+  kmm_free(sectors);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: smart_checkpoint_invalidate
+ *
+ * Description:  Drops the checkpoint of the volume before it is changed.
+ *               The anchor is released first: if power fails before the
+ *               map sectors are released too, the next mount finds no
+ *               valid checkpoint and its full scan releases them.
+ *
+ ****************************************************************************/
+
+static int smart_checkpoint_invalidate(FAR struct smart_struct_s *dev)
+{
+  uint16_t physical;
+  int ret;
+  int x;
+
+  if (dev->cpsectors == NULL)
+    {
+      return OK;
+    }
+
+  ret = smart_checkpoint_release(dev, dev->cpanchor);
+  if (ret < 0)
+    {
+      ferr("ERROR: Error %d releasing checkpoint anchor\n", -ret);
+      return ret;
+    }
+
+  for (x = 0; x < dev->cpcount; x++)
+    {
+      physical = dev->cpsectors[x];
+      ret = smart_checkpoint_release(dev, physical);
+      if (ret < 0)
+        {
+          /* It stays in use until the next full scan */
+
+          ferr("ERROR: Error %d releasing checkpoint sector %d\n",
+               -ret, physical);
+          continue;
+        }
+
+      dev->releasecount[physical / dev->sectorsperblk]++;
+      dev->releasesectors++;
+    }
+
+  kmm_free(dev->cpsectors);
+  dev->cpsectors = NULL;
+  return OK;
+}
+#endif /* CONFIG_MTD_SMART_CHECKPOINT */
+
+/****************************************************************************
+ * Name: smart_relocate_block
+ *
+ * Description:  Relocates the specified MTD erase block by moving any
+ *               active sectors to a different erase block and then erases
+ *               the selected block.
+ *
+ ****************************************************************************/
+
+static int smart_relocate_block(FAR struct smart_struct_s *dev,
+                                uint16_t block)
+{
+  uint16_t newsector;
+  uint16_t oldrelease;
+  int x;
+  int ret;
+  FAR struct smart_sect_header_s *header;
+  uint8_t prerelease;
+  uint16_t freecount;
+#if defined(CONFIG_SMART_LOCAL_CHECKFREE) && defined(CONFIG_DEBUG_FS)
+  uint16_t releasecount;
+#endif
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+  FAR struct smart_allocsector_s *allocsector;
+#endif
+
+  /* Perform collection on block with the most released sectors.
+   * First mark the block as having no free sectors so we don't
+   * try to move sectors into the block we are trying to erase.
+   */
+
+  header = (FAR struct smart_sect_header_s *)dev->rwbuffer;
+
+#ifdef CONFIG_SMART_LOCAL_CHECKFREE
+  if (smart_checkfree(dev, __LINE__) != OK)
+    {
+      fwarn("   ...while relocating block %d, free=%d\n",
+            block, dev->freesectors);
+    }
+#endif
+
+#ifdef CONFIG_MTD_SMART_PACK_COUNTS
+  freecount = smart_get_count(dev, dev->freecount, block);
+
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+#if defined(CONFIG_SMART_LOCAL_CHECKFREE) && defined(CONFIG_DEBUG_FS)
+  releasecount = smart_get_count(dev, dev->releasecount, block);
+#endif
+#endif
+
+  /* Ensure we aren't relocating a block containing the only free sectors */
+
+  if (freecount >= dev->freesectors)
+    {
+      ferr("ERROR: Program bug!  "
+           "Relocating the only block (%d) with free sectors!\n",
+           block);
+      ret = -EIO;
+      goto errout;
+    }
+
+  smart_set_count(dev, dev->freecount, block, 0);
+
+#else /* CONFIG_MTD_SMART_PACK_COUNTS */
+
+  freecount = dev->freecount[block];
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+#if defined(CONFIG_SMART_LOCAL_CHECKFREE) && defined(CONFIG_DEBUG_FS)
+  releasecount = dev->releasecount[block];
+#endif
+#endif
+  dev->freecount[block] = 0;
+#endif
+
+  /* Next move all live data in the block to a new home. */
 
   for (x = block * dev->sectorsperblk; x <
      block * dev->sectorsperblk + dev->availsectperblk; x++)
@@ -3610,6 +4534,13 @@ static int smart_relocate_block(FAR struct smart_struct_s *dev,
               continue;
             }
 
+          if (*((FAR uint16_t *)header->logicalsector) >= dev->totalsectors)
+            {
+              /* Not a logical sector (i.e. a checkpoint sector) */
+
+              continue;
+            }
+
           /* Find a new sector where it can live, NOT in this erase block */
 
           newsector = smart_findfreephyssector(dev, false);
@@ -3857,7 +4788,8 @@ retry:
           for (i = 0; i < 8; )
             {
               if (smart_get_wear_level(dev, block) <
-                  SMART_WEAR_FORCE_REORG_THRESHOLD)
+                  SMART_WEAR_FORCE_REORG_THRESHOLD &&
+                  !smart_checkpoint_block(dev, block))
                 {
                   if (smart_relocate_block(dev, block) < 0)
                     {
@@ -4588,6 +5520,16 @@ static int smart_writesector(FAR struct smart_struct_s *dev,
   DEBUGASSERT(req->offset <= dev->sectorsize);
   DEBUGASSERT(req->offset + req->count <= dev->sectorsize);
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* The sector map changes: drop the checkpoint first */
+
+  ret = smart_checkpoint_invalidate(dev);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+#endif
+
   /* Ensure the logical sector has been allocated */
 
   if (req->logsector >= dev->totalsectors)
@@ -5128,11 +6070,22 @@ static inline int smart_allocsector(FAR struct smart_struct_s *dev,
 {
   uint16_t logsector = 0xffff; /* Logical sector number selected */
   uint16_t physicalsector;     /* The selected physical sector */
-#ifndef CONFIG_MTD_SMART_ENABLE_CRC
+#if !defined(CONFIG_MTD_SMART_ENABLE_CRC) || \
+    defined(CONFIG_MTD_SMART_CHECKPOINT)
   int ret;
 #endif
   int x;
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* The sector map changes: drop the checkpoint first */
+
+  ret = smart_checkpoint_invalidate(dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+#endif
+
   /* Validate that we have enough sectors available to perform an
    * allocation.  We have to ensure we keep enough reserved sectors
    * on hand to do released sector garbage collection.
@@ -5382,6 +6335,16 @@ static inline int smart_freesector(FAR struct smart_struct_s *dev,
   struct smart_sect_header_s header;
   size_t offset;
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* The sector map changes: drop the checkpoint first */
+
+  ret = smart_checkpoint_invalidate(dev);
+  if (ret < 0)
+    {
+      return ret;
+    }
+#endif
+
   /* Check if the logical sector is within bounds */
 
   if ((logicalsector > 2) && (logicalsector < dev->totalsectors))
@@ -5556,6 +6519,17 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
       ret = smart_freesector(dev, arg);
       goto ok_out;
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+    case BIOC_CHECKPOINT:
+
+      /* Save the sector map for the next mount */
+
+      nxmutex_lock(&dev->cplock);
+      ret = smart_checkpoint_write(dev);
+      nxmutex_unlock(&dev->cplock);
+      goto ok_out;
+#endif
+
     case BIOC_WRITESECT:
 
       /* Write to the sector */
@@ -6183,6 +7157,9 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd,
       /* Initialize the SMART device structure */
 
       dev->mtd = mtd;
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+      nxmutex_init(&dev->cplock);
+#endif
 
       /* Get the device geometry. (casting to uintptr_t first eliminates
        * complaints on some architectures where the sizeof long is different
@@ -6332,6 +7309,9 @@ errout:
     }
 #endif
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  nxmutex_destroy(&dev->cplock);
+#endif
   kmm_free(dev);
   return ret;
 }
@@ -6466,6 +7446,9 @@ static int smart_loteardown(FAR const char *devname)
   filemtd_teardown(dev->mtd);
   unregister_blockdriver(devname);
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  nxmutex_destroy(&dev->cplock);
+#endif
   kmm_free(dev);
 
   return OK;
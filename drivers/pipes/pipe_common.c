@@ -85,6 +85,152 @@ static void pipecommon_wakeup(FAR sem_t *sem)
     }
 }
 
+/****************************************************************************
+ * Name: pipecommon_pollnotify
+ *
+ * Description:
+ *   Notify the poll waiters of a buffer update made by a reader or a
+ *   writer.  Those do not hold d_bflock, so the update is ordered against
+ *   a concurrent poll setup through d_npollers: either the setup sees the
+ *   update, or we see the new poller.
+ *
+ ****************************************************************************/
+
+static void pipecommon_pollnotify(FAR struct pipe_dev_s *dev,
+                                  pollevent_t eventset)
+{
+  int ret;
+
+  /* Order the buffer update before the d_npollers load */
+
+  SMP_MB();
+  if (atomic_read(&dev->d_npollers) == 0)
+    {
+      return;
+    }
+
+  /* A signal must not make us lose the notification */
+
+  do
+    {
+      ret = nxrmutex_lock(&dev->d_bflock);
+    }
+  while (ret == -EINTR);
+
+  if (ret >= 0)
+    {
+      poll_notify(dev->d_fds, CONFIG_DEV_PIPE_NPOLLWAITERS, eventset);
+      nxrmutex_unlock(&dev->d_bflock);
+    }
+}
+
+/****************************************************************************
+ * Name: pipecommon_waitdata
+ *
+ * Description:
+ *   Wait with d_rdlock held until there is data in the pipe.
+ *
+ * Returned Value:
+ *   The number of bytes in the pipe with d_rdlock still held; zero at end
+ *   of file or a negated errno value on failure, both with d_rdlock
+ *   released.
+ *
+ ****************************************************************************/
+
+static ssize_t pipecommon_waitdata(FAR struct file *filep,
+                                   FAR struct pipe_dev_s *dev,
+                                   bool nonblock)
+{
+  size_t nused;
+  int nwriters;
+  int ret;
+
+  while ((nused = circbuf_lf_used(&dev->d_buffer)) == 0)
+    {
+      /* If there are no writers on the pipe, then return end of file.  The
+       * writer count is updated under d_bflock, so check the buffer again
+       * after taking it: data written by the last writer before it closed
+       * the pipe must still be returned.
+       */
+
+      ret = nxrmutex_lock(&dev->d_bflock);
+      if (ret < 0)
+        {
+          nxmutex_unlock(&dev->d_rdlock);
+          return ret;
+        }
+
+      nwriters = dev->d_nwriters;
+      nxrmutex_unlock(&dev->d_bflock);
+
+      if (nwriters <= 0 && PIPE_IS_POLICY_0(dev->d_flags))
+        {
+          nused = circbuf_lf_used(&dev->d_buffer);
+          if (nused > 0)
+            {
+              break;
+            }
+
+          nxmutex_unlock(&dev->d_rdlock);
+          return 0;
+        }
+
+      /* If O_NONBLOCK was set, then return EGAIN */
+
+      if (nonblock || (filep->f_oflags & O_NONBLOCK) != 0)
+        {
+          nxmutex_unlock(&dev->d_rdlock);
+          return -EAGAIN;
+        }
+
+      /* Otherwise, wait for something to be written to the pipe.  The
+       * wakeup is sticky, so data written after the check above is not
+       * missed.
+       */
+
+      nxmutex_unlock(&dev->d_rdlock);
+      ret = nxsem_wait(&dev->d_rdsem);
+
+      if (ret < 0 || (ret = nxmutex_lock(&dev->d_rdlock)) < 0)
+        {
+          /* May fail because a signal was received or if the task was
+           * canceled.
+           */
+
+          return ret;
+        }
+    }
+
+  return nused;
+}
+
+/****************************************************************************
+ * Name: pipecommon_readdone
+ *
+ * Description:
+ *   Let writers know that data was removed from the pipe.
+ *
+ ****************************************************************************/
+
+static void pipecommon_readdone(FAR struct pipe_dev_s *dev)
+{
+  /* Notify all poll/select waiters that they can write to the
+   * FIFO when buffer can accept more than d_polloutthrd bytes.
+   */
+
+  if (circbuf_lf_used(&dev->d_buffer) <=
+      (dev->d_bufsize - dev->d_polloutthrd))
+    {
+      pipecommon_pollnotify(dev, POLLOUT);
+    }
+
+  /* Notify all waiting writers that bytes have been removed from the
+   * buffer.
+   */
+
+  pipecommon_wakeup(&dev->d_wrsem);
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -107,6 +253,8 @@ FAR struct pipe_dev_s *pipecommon_allocdev(size_t bufsize)
       /* Initialize the private structure */
 
       nxrmutex_init(&dev->d_bflock);
+      nxmutex_init(&dev->d_rdlock);
+      nxmutex_init(&dev->d_wrlock);
       nxsem_init(&dev->d_rdsem, 0, 0);
       nxsem_init(&dev->d_wrsem, 0, 0);
       dev->d_bufsize = bufsize;
@@ -122,6 +270,8 @@ FAR struct pipe_dev_s *pipecommon_allocdev(size_t bufsize)
 void pipecommon_freedev(FAR struct pipe_dev_s *dev)
 {
   nxrmutex_destroy(&dev->d_bflock);
+  nxmutex_destroy(&dev->d_rdlock);
+  nxmutex_destroy(&dev->d_wrlock);
   nxsem_destroy(&dev->d_rdsem);
   nxsem_destroy(&dev->d_wrsem);
   kmm_free(dev);
@@ -153,9 +303,9 @@ int pipecommon_open(FAR struct file *filep)
 
   /* If d_buffer is not initialized, init it. */
 
-  if (!circbuf_is_init(&dev->d_buffer))
+  if (!circbuf_lf_is_init(&dev->d_buffer))
     {
-      ret = circbuf_init(&dev->d_buffer, NULL, dev->d_bufsize);
+      ret = circbuf_lf_init(&dev->d_buffer, NULL, dev->d_bufsize);
       if (ret < 0)
         {
           nxrmutex_unlock(&dev->d_bflock);
@@ -187,7 +337,7 @@ int pipecommon_open(FAR struct file *filep)
   while ((filep->f_oflags & O_NONBLOCK) == 0 &&       /* Blocking */
          (filep->f_oflags & O_ACCMODE) == O_WRONLY && /* Write-only */
          dev->d_nreaders < 1 &&                       /* No readers on the pipe */
-         circbuf_is_empty(&dev->d_buffer))            /* Buffer is empty */
+         circbuf_lf_is_empty(&dev->d_buffer))         /* Buffer is empty */
     {
       /* If opened for write-only, then wait for at least one reader
        * on the pipe.
@@ -251,7 +401,7 @@ int pipecommon_open(FAR struct file *filep)
   while ((filep->f_oflags & O_NONBLOCK) == 0 &&       /* Blocking */
          (filep->f_oflags & O_ACCMODE) == O_RDONLY && /* Read-only */
          dev->d_nwriters < 1 &&                       /* No writers on the pipe */
-         circbuf_is_empty(&dev->d_buffer))            /* Buffer is empty */
+         circbuf_lf_is_empty(&dev->d_buffer))         /* Buffer is empty */
     {
       /* If opened for read-only, then wait for either at least one writer
        * on the pipe.
@@ -380,11 +530,11 @@ int pipecommon_close(FAR struct file *filep)
    */
 
   else if (PIPE_IS_POLICY_0(dev->d_flags) ||
-           circbuf_is_empty(&dev->d_buffer))
+           circbuf_lf_is_empty(&dev->d_buffer))
     {
       /* Policy 0 or the buffer is empty ... deallocate the buffer now. */
 
-      circbuf_uninit(&dev->d_buffer);
+      circbuf_lf_uninit(&dev->d_buffer);
 
       /* And reset all counts and indices */
 
@@ -426,9 +576,11 @@ ssize_t pipecommon_read(FAR struct file *filep, FAR char *buffer, size_t len)
       return 0;
     }
 
-  /* Make sure that we have exclusive access to the device structure */
+  /* Make sure that we are the only reader of the buffer.  Writers and
+   * other pipe operations do not contend for this lock.
+   */
 
-  ret = nxrmutex_lock(&dev->d_bflock);
+  ret = nxmutex_lock(&dev->d_rdlock);
   if (ret < 0)
     {
       /* May fail because a signal was received or if the task was
@@ -440,61 +592,17 @@ ssize_t pipecommon_read(FAR struct file *filep, FAR char *buffer, size_t len)
 
   /* If the pipe is empty, then wait for something to be written to it */
 
-  while (circbuf_is_empty(&dev->d_buffer))
+  nread = pipecommon_waitdata(filep, dev, false);
+  if (nread <= 0)
     {
-      /* If there are no writers on the pipe, then return end of file */
-
-      if (dev->d_nwriters <= 0 && PIPE_IS_POLICY_0(dev->d_flags))
-        {
-          nxrmutex_unlock(&dev->d_bflock);
-          return 0;
-        }
-
-      /* If O_NONBLOCK was set, then return EGAIN */
-
-      if (filep->f_oflags & O_NONBLOCK)
-        {
-          nxrmutex_unlock(&dev->d_bflock);
-          return -EAGAIN;
-        }
-
-      /* Otherwise, wait for something to be written to the pipe */
-
-      nxrmutex_unlock(&dev->d_bflock);
-      ret = nxsem_wait(&dev->d_rdsem);
-
-      if (ret < 0 || (ret = nxrmutex_lock(&dev->d_bflock)) < 0)
-        {
-          /* May fail because a signal was received or if the task was
-           * canceled.
-           */
-
-          return ret;
-        }
+      return nread;
     }
 
-  /* Then return whatever is available in the pipe (which is at least one
-   * byte).
-   */
+  nread = circbuf_lf_read(&dev->d_buffer, buffer, len);
+  nxmutex_unlock(&dev->d_rdlock);
 
-  nread = circbuf_read(&dev->d_buffer, buffer, len);
+  pipecommon_readdone(dev);
 
-  /* Notify all poll/select waiters that they can write to the
-   * FIFO when buffer can accept more than d_polloutthrd bytes.
-   */
-
-  if (circbuf_used(&dev->d_buffer) <= (dev->d_bufsize - dev->d_polloutthrd))
-    {
-      poll_notify(dev->d_fds, CONFIG_DEV_PIPE_NPOLLWAITERS, POLLOUT);
-    }
-
-  /* Notify all waiting writers that bytes have been removed from the
-   * buffer.
-   */
-
-  pipecommon_wakeup(&dev->d_wrsem);
-
-  nxrmutex_unlock(&dev->d_bflock);
   pipe_dumpbuffer("From PIPE:", buffer, nread);
   return nread;
 }
@@ -537,9 +645,11 @@ ssize_t pipecommon_write(FAR struct file *filep, FAR const char *buffer,
 
   DEBUGASSERT(up_interrupt_context() == false);
 
-  /* Make sure that we have exclusive access to the device structure */
+  /* Make sure that we are the only writer of the buffer.  Readers and
+   * other pipe operations do not contend for this lock.
+   */
 
-  ret = nxrmutex_lock(&dev->d_bflock);
+  ret = nxmutex_lock(&dev->d_wrlock);
   if (ret < 0)
     {
       /* May fail because a signal was received or if the task was
@@ -562,97 +672,353 @@ ssize_t pipecommon_write(FAR struct file *filep, FAR const char *buffer,
 
       if (dev->d_nreaders <= 0 && PIPE_IS_POLICY_0(dev->d_flags))
         {
-          nxrmutex_unlock(&dev->d_bflock);
+          nxmutex_unlock(&dev->d_wrlock);
           return nwritten == 0 ? -EPIPE : nwritten;
         }
 
-      /* Would the next write overflow the circular buffer? */
+      nwritten += circbuf_lf_write(&dev->d_buffer,
+                                   buffer + nwritten, len - nwritten);
 
-      if (!circbuf_is_full(&dev->d_buffer))
+      if ((size_t)nwritten == len)
         {
-          /* Loop until all of the bytes have been written */
+          break;
+        }
 
-          nwritten += circbuf_write(&dev->d_buffer,
-                                    buffer + nwritten, len - nwritten);
+      /* There is not enough room for the next byte.  Was anything written
+       * in this pass?
+       */
 
-          if ((size_t)nwritten == len)
-            {
-              /* Notify all poll/select waiters that they can read from the
-               * FIFO when buffer used exceeds poll threshold.
-               */
+      if (last < nwritten)
+        {
+          /* Notify all poll/select waiters that they can read from the
+           * FIFO.
+           */
 
-              if (circbuf_used(&dev->d_buffer) > dev->d_pollinthrd)
-                {
-                  poll_notify(dev->d_fds, CONFIG_DEV_PIPE_NPOLLWAITERS,
-                              POLLIN);
-                }
+          pipecommon_pollnotify(dev, POLLIN);
 
-              /* Yes.. Notify all of the waiting readers that more data is
-               * available.
-               */
+          /* Yes.. Notify all of the waiting readers that more data is
+           * available.
+           */
 
-              pipecommon_wakeup(&dev->d_rdsem);
+          pipecommon_wakeup(&dev->d_rdsem);
+        }
+
+      last = nwritten;
 
-              /* Return the number of bytes written */
+      /* If O_NONBLOCK was set, then return partial bytes written or
+       * EGAIN.
+       */
 
-              nxrmutex_unlock(&dev->d_bflock);
-              return len;
+      if (filep->f_oflags & O_NONBLOCK)
+        {
+          if (nwritten == 0)
+            {
+              nwritten = -EAGAIN;
             }
+
+          nxmutex_unlock(&dev->d_wrlock);
+          return nwritten;
         }
-      else
+
+      /* There is more to be written.. wait for data to be removed from
+       * the pipe
+       */
+
+      nxmutex_unlock(&dev->d_wrlock);
+      ret = nxsem_wait(&dev->d_wrsem);
+      if (ret < 0 || (ret = nxmutex_lock(&dev->d_wrlock)) < 0)
         {
-          /* There is not enough room for the next byte.  Was anything
-           * written in this pass?
+          /* Either call nxsem_wait may fail because a signal was
+           * received or if the task was canceled.
            */
 
-          if (last < nwritten)
+          return nwritten == 0 ? (ssize_t)ret : nwritten;
+        }
+    }
+
+  nxmutex_unlock(&dev->d_wrlock);
+
+  /* Notify all poll/select waiters that they can read from the FIFO when
+   * buffer used exceeds poll threshold.
+   */
+
+  if (circbuf_lf_used(&dev->d_buffer) > dev->d_pollinthrd)
+    {
+      pipecommon_pollnotify(dev, POLLIN);
+    }
+
+  /* Notify all of the waiting readers that more data is available */
+
+  pipecommon_wakeup(&dev->d_rdsem);
+
+  /* Return the number of bytes written */
+
+  return len;
+}
+
+/****************************************************************************
+ * Name: pipe_ispipe
+ *
+ * Description:
+ *   Check whether a file is an open pipe or FIFO.
+ *
+ ****************************************************************************/
+
+bool pipe_ispipe(FAR struct file *filep)
+{
+  FAR struct inode *inode = filep->f_inode;
+
+  return inode != NULL && INODE_IS_DRIVER(inode) && inode->u.i_ops &&
+         inode->u.i_ops->read == pipecommon_read;
+}
+
+/****************************************************************************
+ * Name: pipe_splice_read
+ *
+ * Description:
+ *   Move data out of a pipe by writing it to 'outfile' straight from the
+ *   pipe buffer.  Blocks like read() until the pipe has data, then moves
+ *   what is there, up to 'len' bytes.
+ *
+ * Returned Value:
+ *   The number of bytes moved, zero at end of file, -ENOSYS if 'filep' is
+ *   not a pipe, or a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t pipe_splice_read(FAR struct file *filep, FAR struct file *outfile,
+                         FAR off_t *outoff, size_t len, bool nonblock)
+{
+  FAR struct pipe_dev_s *dev;
+  ssize_t nmoved = 0;
+  ssize_t ret;
+
+  if (!pipe_ispipe(filep))
+    {
+      return -ENOSYS;
+    }
+
+  if ((filep->f_oflags & O_ACCMODE) == O_WRONLY)
+    {
+      return -EBADF;
+    }
+
+  if (outfile->f_inode == filep->f_inode)
+    {
+      return -EINVAL;
+    }
+
+  if (len == 0)
+    {
+      return 0;
+    }
+
+  dev = filep->f_inode->i_private;
+  ret = nxmutex_lock(&dev->d_rdlock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = pipecommon_waitdata(filep, dev, nonblock);
+  if (ret <= 0)
+    {
+      return ret;
+    }
+
+  while ((size_t)nmoved < len)
+    {
+      FAR void *ptr;
+      size_t size;
+
+      ptr = circbuf_lf_get_readptr(&dev->d_buffer, &size);
+      if (size == 0)
+        {
+          break;
+        }
+
+      size = MIN(size, len - nmoved);
+      if (outoff != NULL)
+        {
+          ret = file_pwrite(outfile, ptr, size, *outoff);
+        }
+      else
+        {
+          ret = file_write(outfile, ptr, size);
+        }
+
+      if (ret <= 0)
+        {
+          if (nmoved == 0)
             {
-              /* Notify all poll/select waiters that they can read from the
-               * FIFO.
-               */
+              nmoved = ret;
+            }
 
-              poll_notify(dev->d_fds, CONFIG_DEV_PIPE_NPOLLWAITERS, POLLIN);
+          break;
+        }
 
-              /* Yes.. Notify all of the waiting readers that more data is
-               * available.
-               */
+      pipe_dumpbuffer("From PIPE:", ptr, ret);
+      circbuf_lf_readcommit(&dev->d_buffer, ret);
+      nmoved += ret;
 
-              pipecommon_wakeup(&dev->d_rdsem);
+      if (outoff != NULL)
+        {
+          *outoff += ret;
+        }
+
+      if ((size_t)ret < size)
+        {
+          break;
+        }
+    }
+
+  nxmutex_unlock(&dev->d_rdlock);
+
+  if (nmoved > 0)
+    {
+      pipecommon_readdone(dev);
+    }
+
+  return nmoved;
+}
+
+/****************************************************************************
+ * Name: pipe_splice_write
+ *
+ * Description:
+ *   Move data into a pipe by reading it from 'infile' straight into the
+ *   pipe buffer.  Blocks like write() until there is room in the pipe,
+ *   then fills it with up to 'len' bytes.
+ *
+ * Returned Value:
+ *   The number of bytes moved, zero at end of 'infile', -ENOSYS if 'filep'
+ *   is not a pipe, or a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t pipe_splice_write(FAR struct file *filep, FAR struct file *infile,
+                          FAR off_t *inoff, size_t len, bool nonblock)
+{
+  FAR struct pipe_dev_s *dev;
+  ssize_t nmoved = 0;
+  ssize_t ret;
+
+  if (!pipe_ispipe(filep))
+    {
+      return -ENOSYS;
+    }
+
+  if ((filep->f_oflags & O_ACCMODE) == O_RDONLY)
+    {
+      return -EBADF;
+    }
+
+  if (infile->f_inode == filep->f_inode)
+    {
+      return -EINVAL;
+    }
+
+  if (len == 0)
+    {
+      return 0;
+    }
+
+  nonblock |= (filep->f_oflags & O_NONBLOCK) != 0;
+  dev = filep->f_inode->i_private;
+  ret = nxmutex_lock(&dev->d_wrlock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  while ((size_t)nmoved < len)
+    {
+      FAR void *ptr;
+      size_t size;
+
+      if (dev->d_nreaders <= 0 && PIPE_IS_POLICY_0(dev->d_flags))
+        {
+          if (nmoved == 0)
+            {
+              nmoved = -EPIPE;
             }
 
-          last = nwritten;
+          break;
+        }
 
-          /* If O_NONBLOCK was set, then return partial bytes written or
-           * EGAIN.
+      ptr = circbuf_lf_get_writeptr(&dev->d_buffer, &size);
+      if (size == 0)
+        {
+          /* The pipe is full.  Return what was moved so far, or wait for
+           * the readers to make room.
            */
 
-          if (filep->f_oflags & O_NONBLOCK)
+          if (nmoved > 0 || nonblock)
             {
-              if (nwritten == 0)
+              if (nmoved == 0)
                 {
-                  nwritten = -EAGAIN;
+                  nmoved = -EAGAIN;
                 }
 
-              nxrmutex_unlock(&dev->d_bflock);
-              return nwritten;
+              break;
             }
 
-          /* There is more to be written.. wait for data to be removed from
-           * the pipe
-           */
-
-          nxrmutex_unlock(&dev->d_bflock);
+          nxmutex_unlock(&dev->d_wrlock);
           ret = nxsem_wait(&dev->d_wrsem);
-          if (ret < 0 || (ret = nxrmutex_lock(&dev->d_bflock)) < 0)
+          if (ret < 0 || (ret = nxmutex_lock(&dev->d_wrlock)) < 0)
             {
-              /* Either call nxsem_wait may fail because a signal was
-               * received or if the task was canceled.
-               */
+              return ret;
+            }
 
-              return nwritten == 0 ? (ssize_t)ret : nwritten;
+          continue;
+        }
+
+      size = MIN(size, len - nmoved);
+      if (inoff != NULL)
+        {
+          ret = file_pread(infile, ptr, size, *inoff);
+        }
+      else
+        {
+          ret = file_read(infile, ptr, size);
+        }
+
+      if (ret <= 0)
+        {
+          if (nmoved == 0)
+            {
+              nmoved = ret;
             }
+
+          break;
+        }
+
+      pipe_dumpbuffer("To PIPE:", ptr, ret);
+      circbuf_lf_writecommit(&dev->d_buffer, ret);
+      nmoved += ret;
+
+      if (inoff != NULL)
+        {
+          *inoff += ret;
+        }
+
+      /* Notify all poll/select waiters and the waiting readers */
+
+      if (circbuf_lf_used(&dev->d_buffer) > dev->d_pollinthrd)
+        {
+          pipecommon_pollnotify(dev, POLLIN);
+        }
+
+      pipecommon_wakeup(&dev->d_rdsem);
+
+      if ((size_t)ret < size)
+        {
+          break;
         }
     }
+
+  nxmutex_unlock(&dev->d_wrlock);
+  return nmoved;
 }
 
 /****************************************************************************
@@ -706,11 +1072,17 @@ int pipecommon_poll(FAR struct file *filep, FAR struct pollfd *fds,
           goto errout;
         }
 
+      /* Count the poller before looking at the buffer, see
+       * pipecommon_pollnotify().
+       */
+
+      atomic_fetch_add(&dev->d_npollers, 1);
+
       /* Should immediately notify on any of the requested events?
        * First, determine how many bytes are in the buffer
        */
 
-      nbytes = circbuf_used(&dev->d_buffer);
+      nbytes = circbuf_lf_used(&dev->d_buffer);
 
       /* Notify the POLLOUT event if the pipe buffer can accept
        * more than d_polloutthrd bytes, but only if
@@ -772,6 +1144,7 @@ int pipecommon_poll(FAR struct file *filep, FAR struct pollfd *fds,
 
       *slot     = NULL;
       fds->priv = NULL;
+      atomic_fetch_sub(&dev->d_npollers, 1);
     }
 
 errout:
@@ -798,12 +1171,26 @@ int pipecommon_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
     }
 #endif
 
-  ret = nxrmutex_lock(&dev->d_bflock);
+  /* Stop readers and writers too, the buffer may be resized */
+
+  ret = nxmutex_lock(&dev->d_rdlock);
   if (ret < 0)
     {
       return ret;
     }
 
+  ret = nxmutex_lock(&dev->d_wrlock);
+  if (ret < 0)
+    {
+      goto errout_with_rdlock;
+    }
+
+  ret = nxrmutex_lock(&dev->d_bflock);
+  if (ret < 0)
+    {
+      goto errout_with_wrlock;
+    }
+
   switch (cmd)
     {
       case PIPEIOC_POLICY:
@@ -855,9 +1242,8 @@ int pipecommon_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 
           DEBUGASSERT(peek && peek->buf);
 
-          ret = circbuf_peekat(&dev->d_buffer,
-                               dev->d_buffer.tail + peek->offset,
-                               peek->buf, peek->size);
+          ret = circbuf_lf_peekat(&dev->d_buffer, peek->offset,
+                                  peek->buf, peek->size);
         }
         break;
 
@@ -871,7 +1257,7 @@ int pipecommon_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
             }
 
           size = MIN(size, CONFIG_DEV_PIPE_MAXSIZE);
-          ret = circbuf_resize(&dev->d_buffer, size);
+          ret = circbuf_lf_resize(&dev->d_buffer, size);
           if (ret != 0)
             {
               break;
@@ -890,7 +1276,7 @@ int pipecommon_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
       case FIONWRITE:  /* Number of bytes waiting in send queue */
       case FIONREAD:   /* Number of bytes available for reading */
         {
-          *(FAR int *)((uintptr_t)arg) = circbuf_used(&dev->d_buffer);
+          *(FAR int *)((uintptr_t)arg) = circbuf_lf_used(&dev->d_buffer);
           ret = 0;
         }
         break;
@@ -899,7 +1285,7 @@ int pipecommon_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 
       case FIONSPACE:
         {
-          *(FAR int *)((uintptr_t)arg) = circbuf_space(&dev->d_buffer);
+          *(FAR int *)((uintptr_t)arg) = circbuf_lf_space(&dev->d_buffer);
           ret = 0;
         }
         break;
@@ -914,6 +1300,12 @@ int pipecommon_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
     }
 
   nxrmutex_unlock(&dev->d_bflock);
+
+errout_with_wrlock:
+  nxmutex_unlock(&dev->d_wrlock);
+
+errout_with_rdlock:
+  nxmutex_unlock(&dev->d_rdlock);
   return ret;
 }
 
@@ -938,7 +1330,7 @@ int pipecommon_unlink(FAR struct inode *inode)
 
   if (dev->d_crefs <= 0)
     {
-      circbuf_uninit(&dev->d_buffer);
+      circbuf_lf_uninit(&dev->d_buffer);
       pipecommon_freedev(dev);
       return OK;
     }
@@ -29,6 +29,7 @@
 
 #include <nuttx/config.h>
 #include <nuttx/mutex.h>
+#include <nuttx/atomic.h>
 #include <nuttx/circbuf.h>
 #include <sys/types.h>
 
@@ -117,7 +118,9 @@ typedef uint8_t pipe_ndx_t;   /*  8-bit index */
 
 struct pipe_dev_s
 {
-  rmutex_t         d_bflock;      /* Used to serialize access to d_buffer and indices */
+  rmutex_t         d_bflock;      /* Used to serialize open/close/poll/ioctl */
+  mutex_t          d_rdlock;      /* Used to serialize readers of d_buffer */
+  mutex_t          d_wrlock;      /* Used to serialize writers of d_buffer */
   sem_t            d_rdsem;       /* Empty buffer - Reader waits for data write AND
                                    * block O_RDONLY open until there is at least one writer */
   sem_t            d_wrsem;       /* Full buffer - Writer waits for data read AND
@@ -129,7 +132,13 @@ struct pipe_dev_s
   uint8_t          d_nreaders;    /* Number of reference counts for read access */
   uint8_t          d_flags;       /* See PIPE_FLAG_* definitions */
   int16_t          d_crefs;       /* References to dev */
-  struct circbuf_s d_buffer;      /* Buffer allocated when device opened */
+  atomic_t         d_npollers;    /* Number of poll structures in d_fds */
+
+  /* The buffer is allocated when device opened.  One reader and one writer
+   * may access it at the same time without holding d_bflock.
+   */
+
+  struct circbuf_lf_s d_buffer;
 
   /* The following is a list if poll structures of threads waiting for
    * driver events. The 'struct pollfd' reference for each open is also
@@ -25,9 +25,11 @@
  ****************************************************************************/
 
 #include <nuttx/debug.h>
+#include <sys/param.h>
 #include <errno.h>
 #include <stdio.h>
 
+#include <nuttx/fs/blkqueue.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/ioctl.h>
 #include <nuttx/semaphore.h>
@@ -46,9 +48,11 @@
 
 /* Block feature bits */
 
+#define VIRTIO_BLK_F_SEG_MAX        2  /* Max segments of a request given */
 #define VIRTIO_BLK_F_RO             5  /* Disk is read-only */
 #define VIRTIO_BLK_F_BLK_SIZE       6  /* Block size of disk is available */
 #define VIRTIO_BLK_F_FLUSH          9  /* Cache flush command support */
+#define VIRTIO_BLK_F_MQ             12 /* Multiple virtqueues support */
 
 /* Block request type */
 
@@ -67,6 +71,22 @@
 #define VIRTIO_BLK_SECTOR_BITS      9
 #define VIRTIO_BLK_SECTOR_SIZE      (1UL << VIRTIO_BLK_SECTOR_BITS)
 
+/* Block request queue */
+
+#ifdef CONFIG_FS_BLKQUEUE
+#  define VIRTIO_BLK_NQUEUES        CONFIG_DRIVERS_VIRTIO_BLK_NQUEUES
+#  define VIRTIO_BLK_QUEUE_DEPTH    CONFIG_DRIVERS_VIRTIO_BLK_QUEUE_DEPTH
+#  define VIRTIO_BLK_QUEUE_SEGS     CONFIG_DRIVERS_VIRTIO_BLK_QUEUE_SEGS
+#else
+#  define VIRTIO_BLK_NQUEUES        1
+#endif
+
+/* Descriptors of virtqueue 0 kept for the synchronous requests: a polled
+ * read or write and a flush.
+ */
+
+#define VIRTIO_BLK_SYNC_DESCS       5
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -115,13 +135,43 @@ begin_packed_struct struct virtio_blk_config_s
   uint32_t secure_erase_sector_alignment;
 } end_packed_struct;
 
+#ifdef CONFIG_FS_BLKQUEUE
+/* The headers of a request queue batch in flight */
+
+struct virtio_blk_ctx_s
+{
+  struct virtio_blk_req_s       req;            /* Block out header */
+  struct virtio_blk_resp_s      resp;           /* Block in header */
+  FAR struct blk_request_s     *batch;          /* NULL if free */
+};
+#endif
+
 struct virtio_blk_priv_s
 {
   FAR struct virtio_device     *vdev;           /* Virtio device */
-  spinlock_t                    lock;           /* Lock */
+
+  /* The lock of each virtqueue */
+
+  spinlock_t                    lock[VIRTIO_BLK_NQUEUES];
   uint64_t                      nsectors;       /* Sectore numbers */
   uint32_t                      block_size;     /* Block size */
   char                          name[NAME_MAX]; /* Device name */
+#ifdef CONFIG_FS_BLKQUEUE
+  uint16_t                      nvqs;           /* Virtqueues in use */
+  uint16_t                      depth;          /* Batches per virtqueue */
+
+  /* Buffers were added to the virtqueue since the last notification */
+
+  bool                          kick[VIRTIO_BLK_NQUEUES];
+  struct blk_queue_s            queue;          /* Request queue */
+
+  /* The contexts of virtqueue n are ctx[n * depth] to
+   * ctx[(n + 1) * depth - 1], protected by lock[n].
+   */
+
+  struct virtio_blk_ctx_s       ctx[VIRTIO_BLK_NQUEUES *
+                                    VIRTIO_BLK_QUEUE_DEPTH];
+#endif
 };
 
 /****************************************************************************
@@ -149,10 +199,21 @@ static int     virtio_blk_flush(FAR struct virtio_blk_priv_s *priv);
 
 /* Other functions */
 
+#ifdef CONFIG_FS_BLKQUEUE
+static void virtio_blk_queue_init(FAR struct virtio_blk_priv_s *priv,
+                                  int nvqs);
+#endif
 static int  virtio_blk_init(FAR struct virtio_blk_priv_s *priv,
                             FAR struct virtio_device *vdev);
 static void virtio_blk_uninit(FAR struct virtio_blk_priv_s *priv);
 static void virtio_blk_done(FAR struct virtqueue *vq);
+static void virtio_blk_handle(FAR struct virtio_blk_priv_s *priv,
+                              FAR void *cookie);
+#ifdef CONFIG_FS_BLKQUEUE
+static int  virtio_blk_dispatch(FAR struct blk_queue_s *queue,
+                                FAR struct blk_request_s *batch);
+static void virtio_blk_commit(FAR struct blk_queue_s *queue);
+#endif
 static int  virtio_blk_probe(FAR struct virtio_device *vdev);
 static void virtio_blk_remove(FAR struct virtio_device *vdev);
 
@@ -178,6 +239,14 @@ static const struct block_operations g_virtio_blk_bops =
   virtio_blk_ioctl     /* ioctl    */
 };
 
+#ifdef CONFIG_FS_BLKQUEUE
+static const struct blk_queue_ops_s g_virtio_blk_qops =
+{
+  virtio_blk_dispatch, /* dispatch */
+  virtio_blk_commit    /* commit */
+};
+#endif
+
 static int g_virtio_blk_idx = 0;
 
 /****************************************************************************
@@ -196,20 +265,21 @@ static void virtio_blk_wait_complete(FAR struct virtqueue *vq,
                                      FAR sem_t *respsem)
 {
   FAR struct virtio_blk_priv_s *priv = vq->vq_dev->priv;
-  FAR sem_t *sem;
+  FAR void *cookie;
 
   if (up_interrupt_context() || OSINIT_IS_PANIC())
     {
       for (; ; )
         {
-          sem = virtqueue_get_buffer_lock(vq, NULL, NULL, &priv->lock);
-          if (sem == respsem)
+          cookie = virtqueue_get_buffer_lock(vq, NULL, NULL,
+                                             &priv->lock[0]);
+          if (cookie == respsem)
             {
               break;
             }
-          else if (sem != NULL)
+          else if (cookie != NULL)
             {
-              nxsem_post(sem);
+              virtio_blk_handle(priv, cookie);
             }
         }
     }
@@ -266,20 +336,20 @@ static ssize_t virtio_blk_rdwr(FAR struct virtio_blk_priv_s *priv,
 
   if (up_interrupt_context())
     {
-      virtqueue_disable_cb_lock(vq, &priv->lock);
+      virtqueue_disable_cb_lock(vq, &priv->lock[0]);
     }
 
-  flags = spin_lock_irqsave(&priv->lock);
+  flags = spin_lock_irqsave(&priv->lock[0]);
   ret = virtqueue_add_buffer(vq, vb, readnum, 3 - readnum, &respsem);
   if (ret < 0)
     {
-      spin_unlock_irqrestore(&priv->lock, flags);
+      spin_unlock_irqrestore(&priv->lock[0], flags);
       vrterr("virtqueue_add_buffer failed, ret=%zd\n", ret);
       goto err;
     }
 
   virtqueue_kick(vq);
-  spin_unlock_irqrestore(&priv->lock, flags);
+  spin_unlock_irqrestore(&priv->lock[0], flags);
 
   /* Wait for the request completion */
 
@@ -294,12 +364,144 @@ static ssize_t virtio_blk_rdwr(FAR struct virtio_blk_priv_s *priv,
 err:
   if (up_interrupt_context())
     {
-      virtqueue_enable_cb_lock(vq, &priv->lock);
+      virtqueue_enable_cb_lock(vq, &priv->lock[0]);
     }
 
   return ret >= 0 ? nsectors : ret;
 }
 
+#ifdef CONFIG_FS_BLKQUEUE
+/****************************************************************************
+ * Name: virtio_blk_dispatch
+ *
+ * Description:
+ *   Start a batch of the request queue: one virtio-blk request with a
+ *   buffer for each request of the batch.  The virtqueue of the current
+ *   CPU is preferred, and the device is notified later by
+ *   virtio_blk_commit().
+ *
+ ****************************************************************************/
+
+static int virtio_blk_dispatch(FAR struct blk_queue_s *queue,
+                               FAR struct blk_request_s *batch)
+{
+  FAR struct virtio_blk_priv_s *priv =
+    container_of(queue, struct virtio_blk_priv_s, queue);
+  struct virtqueue_buf vb[VIRTIO_BLK_QUEUE_SEGS + 2];
+  FAR struct virtio_blk_ctx_s *ctx = NULL;
+  FAR struct blk_request_s *req;
+  bool write = batch->op == BLK_REQ_WRITE;
+  irqstate_t flags;
+  int readnum;
+  int nvb = 0;
+  int ret;
+  int q;
+  int i;
+  int n;
+
+  if (write && virtio_has_feature(priv->vdev, VIRTIO_BLK_F_RO))
+    {
+      return -EPERM;
+    }
+
+  /* The queue never has more batches in flight than there are contexts,
+   * so some virtqueue has a free one.
+   */
+
+  q = this_cpu() % priv->nvqs;
+  for (n = 0; n < priv->nvqs; n++, q = (q + 1) % priv->nvqs)
+    {
+      flags = spin_lock_irqsave(&priv->lock[q]);
+      for (i = q * priv->depth; i < (q + 1) * priv->depth; i++)
+        {
+          if (priv->ctx[i].batch == NULL)
+            {
+              ctx = &priv->ctx[i];
+              break;
+            }
+        }
+
+      if (ctx != NULL)
+        {
+          break;
+        }
+
+      spin_unlock_irqrestore(&priv->lock[q], flags);
+    }
+
+  DEBUGASSERT(ctx != NULL);
+
+  ctx->batch        = batch;
+  ctx->req.type     = write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+  ctx->req.reserved = 0;
+  ctx->req.sector   = batch->sector * priv->block_size >>
+                      VIRTIO_BLK_SECTOR_BITS;
+  ctx->resp.status  = VIRTIO_BLK_S_IOERR;
+
+  /* Fill the virtqueue buffer: the block out header, the buffers of the
+   * requests in sector order and the block in header.
+   */
+
+  vb[nvb].buf = &ctx->req;
+  vb[nvb].len = VIRTIO_BLK_REQ_HEADER_SIZE;
+  nvb++;
+
+  blk_batch_for_every(batch, req)
+    {
+      vb[nvb].buf = req->buffer;
+      vb[nvb].len = req->nsectors * priv->block_size;
+      nvb++;
+    }
+
+  vb[nvb].buf = &ctx->resp;
+  vb[nvb].len = VIRTIO_BLK_RESP_HEADER_SIZE;
+  nvb++;
+
+  readnum = write ? nvb - 1 : 1;
+  ret = virtqueue_add_buffer(priv->vdev->vrings_info[q].vq, vb, readnum,
+                             nvb - readnum, ctx);
+  if (ret < 0)
+    {
+      ctx->batch = NULL;
+      spin_unlock_irqrestore(&priv->lock[q], flags);
+      vrterr("virtqueue_add_buffer failed, ret=%d\n", ret);
+      return ret;
+    }
+
+  priv->kick[q] = true;
+  spin_unlock_irqrestore(&priv->lock[q], flags);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: virtio_blk_commit
+ *
+ * Description:
+ *   Notify the device once of all batches dispatched in a row.
+ *
+ ****************************************************************************/
+
+static void virtio_blk_commit(FAR struct blk_queue_s *queue)
+{
+  FAR struct virtio_blk_priv_s *priv =
+    container_of(queue, struct virtio_blk_priv_s, queue);
+  irqstate_t flags;
+  int q;
+
+  for (q = 0; q < priv->nvqs; q++)
+    {
+      flags = spin_lock_irqsave(&priv->lock[q]);
+      if (priv->kick[q])
+        {
+          priv->kick[q] = false;
+          virtqueue_kick(priv->vdev->vrings_info[q].vq);
+        }
+
+      spin_unlock_irqrestore(&priv->lock[q], flags);
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: virtio_blk_open
  *
@@ -343,6 +545,15 @@ static ssize_t virtio_blk_read(FAR struct inode *inode,
 
   DEBUGASSERT(inode->i_private);
   priv = inode->i_private;
+
+#ifdef CONFIG_FS_BLKQUEUE
+  if (!up_interrupt_context() && !OSINIT_IS_PANIC())
+    {
+      return blk_queue_rdwr(&priv->queue, buffer, startsector, nsectors,
+                            false);
+    }
+#endif
+
   return virtio_blk_rdwr(priv, buffer, startsector, nsectors, false);
 }
 
@@ -368,6 +579,14 @@ static ssize_t virtio_blk_write(FAR struct inode *inode,
       return -EPERM;
     }
 
+#ifdef CONFIG_FS_BLKQUEUE
+  if (!up_interrupt_context() && !OSINIT_IS_PANIC())
+    {
+      return blk_queue_rdwr(&priv->queue, (FAR unsigned char *)buffer,
+                            startsector, nsectors, true);
+    }
+#endif
+
   return virtio_blk_rdwr(priv, (FAR void *)buffer, startsector, nsectors,
                          true);
 }
@@ -430,16 +649,16 @@ static int virtio_blk_flush(FAR struct virtio_blk_priv_s *priv)
   vb[1].buf = &resp;
   vb[1].len = VIRTIO_BLK_RESP_HEADER_SIZE;
 
-  flags = spin_lock_irqsave(&priv->lock);
+  flags = spin_lock_irqsave(&priv->lock[0]);
   ret = virtqueue_add_buffer(vq, vb, 1, 1, &respsem);
   if (ret < 0)
     {
-      spin_unlock_irqrestore(&priv->lock, flags);
+      spin_unlock_irqrestore(&priv->lock[0], flags);
       return ret;
     }
 
   virtqueue_kick(vq);
-  spin_unlock_irqrestore(&priv->lock, flags);
+  spin_unlock_irqrestore(&priv->lock[0], flags);
 
   /* Wait for the request completion */
 
@@ -474,31 +693,143 @@ static int virtio_blk_ioctl(FAR struct inode *inode, int cmd,
             ret = virtio_blk_flush(priv);
           }
         break;
+
+#ifdef CONFIG_FS_BLKQUEUE
+      case BIOC_GETQUEUE:
+        *(FAR struct blk_queue_s **)(uintptr_t)arg = &priv->queue;
+        ret = OK;
+        break;
+#endif
     }
 
   return ret;
 }
 
+/****************************************************************************
+ * Name: virtio_blk_handle
+ *
+ * Description:
+ *   Finish a used buffer: the cookie is either the context of a request
+ *   queue batch or the semaphore of a synchronous request.
+ *
+ ****************************************************************************/
+
+static void virtio_blk_handle(FAR struct virtio_blk_priv_s *priv,
+                              FAR void *cookie)
+{
+#ifdef CONFIG_FS_BLKQUEUE
+  FAR struct virtio_blk_ctx_s *ctx = cookie;
+
+  if (ctx >= priv->ctx && ctx < priv->ctx + nitems(priv->ctx))
+    {
+      FAR struct blk_request_s *batch = ctx->batch;
+      int q = (ctx - priv->ctx) / priv->depth;
+      int result = OK;
+      irqstate_t flags;
+
+      if (ctx->resp.status != VIRTIO_BLK_S_OK)
+        {
+          vrterr("%s Error\n",
+                 batch->op == BLK_REQ_WRITE ? "Write" : "Read");
+          result = -EIO;
+        }
+
+      flags = spin_lock_irqsave(&priv->lock[q]);
+      ctx->batch = NULL;
+      spin_unlock_irqrestore(&priv->lock[q], flags);
+
+      blk_queue_complete(&priv->queue, batch, result);
+      return;
+    }
+#endif
+
+  nxsem_post(cookie);
+}
+
 /****************************************************************************
  * Name: virtio_blk_done
+ *
+ * Description:
+ *   Reap the used buffers of a virtqueue.  The callback stays disabled
+ *   while the ring is drained, and the ring is checked again once it is
+ *   enabled, so that a burst of completions takes one interrupt.
+ *
  ****************************************************************************/
 
 static void virtio_blk_done(FAR struct virtqueue *vq)
 {
   FAR struct virtio_blk_priv_s *priv = vq->vq_dev->priv;
-  FAR sem_t *respsem;
+  FAR spinlock_t *lock = &priv->lock[vq->vq_queue_index];
+  FAR void *cookie;
+
+  virtqueue_disable_cb_lock(vq, lock);
 
-  for (; ; )
+  do
     {
-      respsem = virtqueue_get_buffer_lock(vq, NULL, NULL, &priv->lock);
-      if (respsem == NULL)
+      for (; ; )
         {
-          break;
+          cookie = virtqueue_get_buffer_lock(vq, NULL, NULL, lock);
+          if (cookie == NULL)
+            {
+              break;
+            }
+
+          virtio_blk_handle(priv, cookie);
         }
+    }
+  while (virtqueue_enable_cb_lock(vq, lock) != 0);
+}
+
+#ifdef CONFIG_FS_BLKQUEUE
+/****************************************************************************
+ * Name: virtio_blk_queue_init
+ *
+ * Description:
+ *   Size the request queue so that the batches in flight always fit in
+ *   the virtqueues, and initialize it.
+ *
+ ****************************************************************************/
+
+static void virtio_blk_queue_init(FAR struct virtio_blk_priv_s *priv,
+                                  int nvqs)
+{
+  FAR struct virtio_device *vdev = priv->vdev;
+  unsigned int size = UINT16_MAX;
+  unsigned int depth;
+  unsigned int segs;
+  uint32_t seg_max;
+  int i;
+
+  for (i = 0; i < nvqs; i++)
+    {
+      size = MIN(size, vdev->vrings_info[i].vq->vq_nentries);
+    }
+
+  /* A batch takes a descriptor for each buffer and two for the headers */
+
+  DEBUGASSERT(size >= VIRTIO_BLK_SYNC_DESCS + 3);
+  size -= VIRTIO_BLK_SYNC_DESCS;
+  depth = MIN(VIRTIO_BLK_QUEUE_DEPTH, size / 3);
+  segs  = MIN(VIRTIO_BLK_QUEUE_SEGS, size / depth - 2);
 
-      nxsem_post(respsem);
+  if (virtio_has_feature(vdev, VIRTIO_BLK_F_SEG_MAX))
+    {
+      virtio_read_config_member(vdev, struct virtio_blk_config_s,
+                                seg_max, &seg_max);
+      if (seg_max > 0)
+        {
+          segs = MIN(segs, seg_max);
+        }
     }
+
+  priv->nvqs  = nvqs;
+  priv->depth = depth;
+  blk_queue_init(&priv->queue, &g_virtio_blk_qops, nvqs * depth, segs, 0);
+
+  vrtinfo("Virtio blk queues=%d depth=%u segments=%u\n",
+          nvqs, depth, segs);
 }
+#endif
 
 /****************************************************************************
  * Name: virtio_blk_init
@@ -507,33 +838,67 @@ static void virtio_blk_done(FAR struct virtqueue *vq)
 static int virtio_blk_init(FAR struct virtio_blk_priv_s *priv,
                            FAR struct virtio_device *vdev)
 {
-  FAR const char *vqname[1];
-  vq_callback callback[1];
+  FAR const char *vqname[VIRTIO_BLK_NQUEUES];
+  vq_callback callback[VIRTIO_BLK_NQUEUES];
+  int nvqs = 1;
   int ret;
+  int i;
 
   priv->vdev = vdev;
   vdev->priv = priv;
-  spin_lock_init(&priv->lock);
+  for (i = 0; i < VIRTIO_BLK_NQUEUES; i++)
+    {
+      spin_lock_init(&priv->lock[i]);
+    }
 
   /* Initialize the virtio device */
 
   virtio_set_status(vdev, VIRTIO_CONFIG_STATUS_DRIVER);
   virtio_negotiate_features(vdev, (1UL << VIRTIO_BLK_F_RO) |
                                   (1UL << VIRTIO_BLK_F_BLK_SIZE) |
+#ifdef CONFIG_FS_BLKQUEUE
+                                  (1UL << VIRTIO_BLK_F_SEG_MAX) |
+                                  (1UL << VIRTIO_BLK_F_MQ) |
+#endif
                                   (1UL << VIRTIO_BLK_F_FLUSH), NULL);
   virtio_set_status(vdev, VIRTIO_CONFIG_FEATURES_OK);
 
-  vqname[0]   = "virtio_blk_vq";
-  callback[0] = virtio_blk_done;
-  ret = virtio_create_virtqueues(vdev, 0, 1, vqname, callback, NULL);
+#ifdef CONFIG_FS_BLKQUEUE
+  /* Use a virtqueue per CPU if the device has enough */
+
+  if (virtio_has_feature(vdev, VIRTIO_BLK_F_MQ))
+    {
+      uint16_t num_queues;
+
+      virtio_read_config_member(vdev, struct virtio_blk_config_s,
+                                num_queues, &num_queues);
+      nvqs = MAX(MIN(num_queues, VIRTIO_BLK_NQUEUES), 1);
+    }
+#endif
+
+  for (i = 0; i < nvqs; i++)
+    {
+      vqname[i]   = "virtio_blk_vq";
+      callback[i] = virtio_blk_done;
+    }
+
+  ret = virtio_create_virtqueues(vdev, 0, nvqs, vqname, callback, NULL);
   if (ret < 0)
     {
       vrterr("virtio_device_create_virtqueue failed, ret=%d\n", ret);
       return ret;
     }
 
+#ifdef CONFIG_FS_BLKQUEUE
+  virtio_blk_queue_init(priv, nvqs);
+#endif
+
   virtio_set_status(vdev, VIRTIO_CONFIG_STATUS_DRIVER_OK);
-  virtqueue_enable_cb(vdev->vrings_info[0].vq);
+  for (i = 0; i < nvqs; i++)
+    {
+      virtqueue_enable_cb(vdev->vrings_info[i].vq);
+    }
+
   return ret;
 }
 
@@ -48,6 +48,28 @@
 #  define CONFIG_FS_NAIOC 8
 #endif
 
+/* The priority of the low priority work queue is boosted to the one of the
+ * waiting task.  The threads of the dedicated AIO work queue keep their
+ * configured priority.
+ */
+
+#if defined(CONFIG_PRIORITY_INHERITANCE) && !defined(CONFIG_FS_AIO_WORKQUEUE)
+#  define AIO_PRIORITY_INHERITANCE 1
+#endif
+
+/* The transfers of one file are serialized, because file_pread() and
+ * file_pwrite() move the file position shared by all of its requests.
+ * There is one lock per worker thread, the files are hashed over them.
+ */
+
+#if defined(CONFIG_FS_AIO_WORKQUEUE)
+#  define AIO_NFILELOCKS CONFIG_FS_AIO_NTHREADS
+#elif defined(CONFIG_SCHED_LPNTHREADS)
+#  define AIO_NFILELOCKS CONFIG_SCHED_LPNTHREADS
+#else
+#  define AIO_NFILELOCKS 1
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -65,7 +87,8 @@ struct aio_container_s
   FAR struct file *aioc_filep;     /* File structure to use with the I/O */
   struct work_s aioc_work;         /* Used to defer I/O to the work thread */
   pid_t aioc_pid;                  /* ID of the waiting task */
-#ifdef CONFIG_PRIORITY_INHERITANCE
+  uint8_t aioc_opcode;             /* LIO_READ, LIO_WRITE or LIO_NOP */
+#ifdef AIO_PRIORITY_INHERITANCE
   uint8_t aioc_prio;               /* Priority of the waiting task */
 #endif
 };
@@ -128,6 +151,30 @@ void aio_initialize(void);
 int aio_lock(void);
 void aio_unlock(void);
 
+/****************************************************************************
+ * Name: aio_filelock/aio_fileunlock
+ *
+ * Description:
+ *   Take/give the lock serializing the transfers of a file on the worker
+ *   threads.  With a single worker thread, the transfers are serialized
+ *   already and these do nothing.
+ *
+ * Input Parameters:
+ *   filep - The file of the transfer
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#if AIO_NFILELOCKS > 1
+void aio_filelock(FAR struct file *filep);
+void aio_fileunlock(FAR struct file *filep);
+#else
+#  define aio_filelock(filep)
+#  define aio_fileunlock(filep)
+#endif
+
 /****************************************************************************
  * Name: aioc_alloc
  *
@@ -220,6 +267,45 @@ FAR struct aiocb *aioc_decant(FAR struct aio_container_s *aioc);
 
 int aio_queue(FAR struct aio_container_s *aioc, worker_t worker);
 
+/****************************************************************************
+ * Name: aio_cancel_work
+ *
+ * Description:
+ *   Remove the queued work of an asynchronous I/O from its work queue.
+ *
+ * Input Parameters:
+ *   aioc - The AIO container of the I/O
+ *
+ * Returned Value:
+ *   Zero (OK) if the work was removed before it started; a negated errno
+ *   value if it has started already or was never queued.
+ *
+ ****************************************************************************/
+
+int aio_cancel_work(FAR struct aio_container_s *aioc);
+
+#ifdef CONFIG_FS_AIO_MERGE
+
+/****************************************************************************
+ * Name: aio_merge
+ *
+ * Description:
+ *   Perform a read or write together with the requests queued after it
+ *   that continue it in the same file, as one vectored transfer.  This
+ *   runs on the worker thread in place of the normal worker and consumes
+ *   the container like it.
+ *
+ * Input Parameters:
+ *   aioc - The AIO container of the I/O to start with
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void aio_merge(FAR struct aio_container_s *aioc);
+#endif
+
 /****************************************************************************
  * Name: aio_signal
  *
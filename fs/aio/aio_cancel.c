@@ -131,7 +131,7 @@ int aio_cancel(int fildes, FAR struct aiocb *aiocbp)
                * first case.
                */
 
-              status = work_cancel(LPWORK, &aioc->aioc_work);
+              status = aio_cancel_work(aioc);
               if (status >= 0)
                 {
                   /* Remove the container from the list of pending
@@ -188,7 +188,7 @@ int aio_cancel(int fildes, FAR struct aiocb *aiocbp)
                * first case.
                */
 
-              status = work_cancel(LPWORK, &aioc->aioc_work);
+              status = aio_cancel_work(aioc);
               if (status >= 0)
                 {
                   /* Remove the container from the list of pending
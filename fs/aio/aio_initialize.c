@@ -30,6 +30,7 @@
 #include <errno.h>
 
 #include <nuttx/sched.h>
+#include <nuttx/fs/fs.h>
 #include <nuttx/mutex.h>
 #include <nuttx/queue.h>
 
@@ -60,6 +61,12 @@ static sem_t g_aioc_freesem = SEM_INITIALIZER(CONFIG_FS_NAIOC);
 
 static rmutex_t g_aio_lock = NXRMUTEX_INITIALIZER;
 
+#if AIO_NFILELOCKS > 1
+/* These locks serialize the transfers of each file */
+
+static mutex_t g_aio_filelock[AIO_NFILELOCKS];
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -100,6 +107,13 @@ void aio_initialize(void)
 
       dq_addlast(&g_aioc_alloc[i].aioc_link, &g_aioc_free);
     }
+
+#if AIO_NFILELOCKS > 1
+  for (i = 0; i < AIO_NFILELOCKS; i++)
+    {
+      nxmutex_init(&g_aio_filelock[i]);
+    }
+#endif
 }
 
 /****************************************************************************
@@ -126,6 +140,36 @@ void aio_unlock(void)
   nxrmutex_unlock(&g_aio_lock);
 }
 
+/****************************************************************************
+ * Name: aio_filelock/aio_fileunlock
+ *
+ * Description:
+ *   Take/give the lock serializing the transfers of a file
+ *
+ * Input Parameters:
+ *   filep - The file of the transfer
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#if AIO_NFILELOCKS > 1
+void aio_filelock(FAR struct file *filep)
+{
+  uintptr_t hash = (uintptr_t)filep / sizeof(struct file);
+
+  nxmutex_lock(&g_aio_filelock[hash % AIO_NFILELOCKS]);
+}
+
+void aio_fileunlock(FAR struct file *filep)
+{
+  uintptr_t hash = (uintptr_t)filep / sizeof(struct file);
+
+  nxmutex_unlock(&g_aio_filelock[hash % AIO_NFILELOCKS]);
+}
+#endif
+
 /****************************************************************************
  * Name: aioc_alloc
  *
@@ -26,22 +26,120 @@
 
 #include <nuttx/config.h>
 
+#include <sys/param.h>
+#include <sys/uio.h>
 #include <sched.h>
 #include <aio.h>
 #include <assert.h>
 #include <errno.h>
+#include <unistd.h>
 #include <nuttx/debug.h>
 
+#include <nuttx/fs/fs.h>
 #include <nuttx/wqueue.h>
 
 #include "aio/aio.h"
 
 #ifdef CONFIG_FS_AIO
 
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_AIO_WORKQUEUE
+/* The work queue dedicated to asynchronous I/O, created on first use */
+
+static FAR struct kwork_wqueue_s *g_aio_wqueue;
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+#ifdef CONFIG_FS_AIO_WORKQUEUE
+
+/****************************************************************************
+ * Name: aio_wqueue
+ *
+ * Description:
+ *   Return the AIO work queue, creating its worker threads the first time.
+ *
+ ****************************************************************************/
+
+static FAR struct kwork_wqueue_s *aio_wqueue(void)
+{
+  if (g_aio_wqueue == NULL && aio_lock() >= 0)
+    {
+      if (g_aio_wqueue == NULL)
+        {
+          g_aio_wqueue = work_queue_create("aio", CONFIG_FS_AIO_PRIORITY,
+                                           NULL, CONFIG_FS_AIO_STACKSIZE,
+                                           CONFIG_FS_AIO_NTHREADS);
+        }
+
+      aio_unlock();
+    }
+
+  return g_aio_wqueue;
+}
+#endif
+
+#ifdef CONFIG_FS_AIO_MERGE
+
+/****************************************************************************
+ * Name: aio_transfer
+ *
+ * Description:
+ *   Read or write a vector at a file offset, leaving the file position
+ *   unchanged like file_pread() and file_pwrite() do.  The file lock keeps
+ *   the other workers from moving the position in the meantime.
+ *
+ ****************************************************************************/
+
+static ssize_t aio_transfer(FAR struct file *filep, uint8_t opcode,
+                            FAR const struct iovec *iov, int iovcnt,
+                            off_t offset)
+{
+  off_t savepos;
+  off_t pos;
+  ssize_t ret;
+
+  aio_filelock(filep);
+  savepos = file_seek(filep, 0, SEEK_CUR);
+  if (savepos < 0)
+    {
+      ret = (ssize_t)savepos;
+      goto out;
+    }
+
+  pos = file_seek(filep, offset, SEEK_SET);
+  if (pos < 0)
+    {
+      ret = (ssize_t)pos;
+      goto out;
+    }
+
+  if (opcode == LIO_READ)
+    {
+      ret = file_readv(filep, iov, iovcnt);
+    }
+  else
+    {
+      ret = file_writev(filep, iov, iovcnt);
+    }
+
+  pos = file_seek(filep, savepos, SEEK_SET);
+  if (pos < 0 && ret >= 0)
+    {
+      ret = (ssize_t)pos;
+    }
+
+out:
+  aio_fileunlock(filep);
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * Name: aio_queue
  *
@@ -60,9 +158,12 @@
 
 int aio_queue(FAR struct aio_container_s *aioc, worker_t worker)
 {
+#ifdef CONFIG_FS_AIO_WORKQUEUE
+  FAR struct kwork_wqueue_s *wqueue = aio_wqueue();
+#endif
   int ret;
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_PRIORITY_INHERITANCE
   /* Prohibit context switches until we complete the queuing */
 
   sched_lock();
@@ -74,15 +175,23 @@ int aio_queue(FAR struct aio_container_s *aioc, worker_t worker)
   lpwork_boostpriority(aioc->aioc_prio);
 #endif
 
+#ifdef CONFIG_FS_AIO_WORKQUEUE
+  /* Schedule the work on the AIO worker threads */
+
+  ret = wqueue != NULL ?
+        work_queue_wq(wqueue, &aioc->aioc_work, worker, aioc, 0) :
+        -ENOMEM;
+#else
   /* Schedule the work on the low priority worker thread */
 
   ret = work_queue(LPWORK, &aioc->aioc_work, worker, aioc, 0);
+#endif
   if (ret < 0)
     {
       FAR struct aiocb *aiocbp = aioc->aioc_aiocbp;
       DEBUGASSERT(aiocbp);
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_PRIORITY_INHERITANCE
       lpwork_restorepriority(aioc->aioc_prio);
 #endif
       aiocbp->aio_result = ret;
@@ -90,7 +199,7 @@ int aio_queue(FAR struct aio_container_s *aioc, worker_t worker)
       ret = ERROR;
     }
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_PRIORITY_INHERITANCE
   /* Now the low-priority work queue might run at its new priority */
 
   sched_unlock();
@@ -98,4 +207,127 @@ int aio_queue(FAR struct aio_container_s *aioc, worker_t worker)
   return ret;
 }
 
+/****************************************************************************
+ * Name: aio_cancel_work
+ *
+ * Description:
+ *   Remove the queued work of an asynchronous I/O from its work queue.
+ *
+ ****************************************************************************/
+
+int aio_cancel_work(FAR struct aio_container_s *aioc)
+{
+#ifdef CONFIG_FS_AIO_WORKQUEUE
+  if (g_aio_wqueue == NULL)
+    {
+      return -ENOENT;
+    }
+
+  return work_cancel_wq(g_aio_wqueue, &aioc->aioc_work);
+#else
+  return work_cancel(LPWORK, &aioc->aioc_work);
+#endif
+}
+
+#ifdef CONFIG_FS_AIO_MERGE
+
+/****************************************************************************
+ * Name: aio_merge
+ *
+ * Description:
+ *   Perform a read or write together with the requests queued after it
+ *   that continue it in the same file, as one vectored transfer.
+ *
+ ****************************************************************************/
+
+void aio_merge(FAR struct aio_container_s *aioc)
+{
+  FAR struct aio_container_s *batch[CONFIG_FS_AIO_MERGE_MAX];
+  FAR struct aiocb *aiocbp[CONFIG_FS_AIO_MERGE_MAX];
+  struct iovec iov[CONFIG_FS_AIO_MERGE_MAX];
+  pid_t pid[CONFIG_FS_AIO_MERGE_MAX];
+  FAR struct aio_container_s *next;
+  FAR struct file *filep;
+  uint8_t opcode;
+  ssize_t nxfer;
+  off_t offset;
+  off_t end;
+  size_t len;
+  int count = 1;
+  int i;
+
+  DEBUGASSERT(aioc && aioc->aioc_aiocbp);
+
+  filep    = aioc->aioc_filep;
+  opcode   = aioc->aioc_opcode;
+  offset   = aioc->aioc_aiocbp->aio_offset;
+  end      = offset + aioc->aioc_aiocbp->aio_nbytes;
+  batch[0] = aioc;
+
+  /* Collect the requests that continue where the batch ends.  Only
+   * requests whose work can still be canceled are taken, the others are
+   * already running on another worker thread.
+   */
+
+  aio_lock();
+  for (next = (FAR struct aio_container_s *)g_aio_pending.head;
+       next != NULL && count < CONFIG_FS_AIO_MERGE_MAX;
+       next = (FAR struct aio_container_s *)next->aioc_link.flink)
+    {
+      if (next != aioc && next->aioc_filep == filep &&
+          next->aioc_opcode == opcode &&
+          next->aioc_aiocbp->aio_offset == end &&
+          aio_cancel_work(next) >= 0)
+        {
+          batch[count++] = next;
+          end += next->aioc_aiocbp->aio_nbytes;
+        }
+    }
+
+  /* Decant all of them.  Keep a reference to the file for the transfer,
+   * the containers release theirs.
+   */
+
+  file_ref(filep);
+  for (i = 0; i < count; i++)
+    {
+      pid[i]            = batch[i]->aioc_pid;
+      aiocbp[i]         = aioc_decant(batch[i]);
+      iov[i].iov_base   = (FAR void *)aiocbp[i]->aio_buf;
+      iov[i].iov_len    = aiocbp[i]->aio_nbytes;
+    }
+
+  aio_unlock();
+
+  nxfer = aio_transfer(filep, opcode, iov, count, offset);
+  if (nxfer < 0)
+    {
+      ferr("ERROR: %s failed: %zd\n",
+           opcode == LIO_READ ? "read" : "write", nxfer);
+    }
+
+  /* Hand out the bytes transferred in request order and signal each
+   * client.
+   */
+
+  for (i = 0; i < count; i++)
+    {
+      if (nxfer < 0)
+        {
+          aiocbp[i]->aio_result = nxfer;
+        }
+      else
+        {
+          len                   = MIN(iov[i].iov_len, (size_t)nxfer);
+          aiocbp[i]->aio_result = len;
+          nxfer                -= len;
+        }
+
+      aio_signal(pid[i], aiocbp[i]);
+    }
+
+  file_put(filep);
+}
+#endif /* CONFIG_FS_AIO_MERGE */
+
 #endif /* CONFIG_FS_AIO */
@@ -64,11 +64,18 @@ static void aio_read_worker(FAR void *arg)
   FAR struct aio_container_s *aioc = (FAR struct aio_container_s *)arg;
   FAR struct aiocb *aiocbp;
   pid_t pid;
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_PRIORITY_INHERITANCE
   uint8_t prio;
 #endif
   ssize_t nread = 0;
 
+#ifdef CONFIG_FS_AIO_MERGE
+  /* Read along with the requests continuing this one */
+
+  aio_merge(aioc);
+  return;
+#endif
+
   /* Get the information from the container, decant the AIO control block,
    * and free the container before starting any I/O.  That will minimize
    * the delays by any other threads waiting for a pre-allocated container.
@@ -76,7 +83,7 @@ static void aio_read_worker(FAR void *arg)
 
   DEBUGASSERT(aioc && aioc->aioc_aiocbp);
   pid    = aioc->aioc_pid;
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_PRIORITY_INHERITANCE
   prio   = aioc->aioc_prio;
 #endif
   aiocbp = aioc_decant(aioc);
@@ -89,8 +96,10 @@ static void aio_read_worker(FAR void *arg)
    *   aio_offset   - File offset
    */
 
+  aio_filelock(aioc->aioc_filep);
   nread = file_pread(aioc->aioc_filep, (FAR void *)aiocbp->aio_buf,
                      aiocbp->aio_nbytes, aiocbp->aio_offset);
+  aio_fileunlock(aioc->aioc_filep);
 
   /* Set the result of the read operation. */
 
@@ -107,7 +116,7 @@ static void aio_read_worker(FAR void *arg)
 
   aio_signal(pid, aiocbp);
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_PRIORITY_INHERITANCE
   /* Restore the low priority worker thread default priority */
 
   lpwork_restorepriority(prio);
@@ -268,6 +277,8 @@ int aio_read(FAR struct aiocb *aiocbp)
       return ERROR;
     }
 
+  aioc->aioc_opcode = LIO_READ;
+
   /* Defer the work to the worker thread */
 
   ret = aio_queue(aioc, aio_read_worker);
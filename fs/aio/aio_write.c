@@ -66,12 +66,24 @@ static void aio_write_worker(FAR void *arg)
   FAR struct aio_container_s *aioc = (FAR struct aio_container_s *)arg;
   FAR struct aiocb *aiocbp;
   pid_t pid;
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_PRIORITY_INHERITANCE
   uint8_t prio;
 #endif
   ssize_t nwritten = 0;
   int oflags;
 
+#ifdef CONFIG_FS_AIO_MERGE
+  /* Write along with the requests continuing this one, unless the file
+   * is in append mode and the offsets are meaningless.
+   */
+
+  if ((aioc->aioc_filep->f_oflags & O_APPEND) == 0)
+    {
+      aio_merge(aioc);
+      return;
+    }
+#endif
+
   /* Get the information from the container, decant the AIO control block,
    * and free the container before starting any I/O.  That will minimize
    * the delays by any other threads waiting for a pre-allocated container.
@@ -79,7 +91,7 @@ static void aio_write_worker(FAR void *arg)
 
   DEBUGASSERT(aioc && aioc->aioc_aiocbp);
   pid    = aioc->aioc_pid;
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_PRIORITY_INHERITANCE
   prio   = aioc->aioc_prio;
 #endif
   aiocbp = aioc_decant(aioc);
@@ -104,6 +116,7 @@ static void aio_write_worker(FAR void *arg)
 
   /* Check if O_APPEND is set in the file open flags */
 
+  aio_filelock(aioc->aioc_filep);
   if ((oflags & O_APPEND) != 0)
     {
       /* Append to the current file position */
@@ -120,6 +133,7 @@ static void aio_write_worker(FAR void *arg)
                              aiocbp->aio_offset);
     }
 
+  aio_fileunlock(aioc->aioc_filep);
   if (nwritten < 0)
     {
       ferr("ERROR: write/pwrite/send failed: %zd\n", nwritten);
@@ -135,7 +149,7 @@ errout:
 
   aio_signal(pid, aiocbp);
 
-#ifdef CONFIG_PRIORITY_INHERITANCE
+#ifdef AIO_PRIORITY_INHERITANCE
   /* Restore the low priority worker thread default priority */
 
   lpwork_restorepriority(prio);
@@ -305,6 +319,8 @@ int aio_write(FAR struct aiocb *aiocbp)
       return ERROR;
     }
 
+  aioc->aioc_opcode = LIO_WRITE;
+
   /* Defer the work to the worker thread */
 
   ret = aio_queue(aioc, aio_write_worker);
@@ -0,0 +1,557 @@
+/****************************************************************************
+ * fs/driver/fs_blkqueue.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include <nuttx/fs/blkqueue.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/spinlock.h>
+
+#ifdef CONFIG_FS_BLKQUEUE
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: blk_queue_overlap
+ *
+ * Description:
+ *   Check whether a request overlaps a list of batches.
+ *
+ ****************************************************************************/
+
+static bool blk_queue_overlap(FAR struct blk_request_s *list,
+                              FAR struct blk_request_s *req)
+{
+  for (; list != NULL; list = list->next)
+    {
+      if (list->sector < req->sector + req->nsectors &&
+          req->sector < list->sector + list->total)
+        {
+          return true;
+        }
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: blk_queue_mergeable
+ *
+ * Description:
+ *   Check whether batch 'b' may be appended to batch 'a'.
+ *
+ ****************************************************************************/
+
+static bool blk_queue_mergeable(FAR struct blk_queue_s *queue,
+                                FAR struct blk_request_s *a,
+                                FAR struct blk_request_s *b)
+{
+  return a->op == b->op && a->sector + a->total == b->sector &&
+         a->nsegs + b->nsegs <= queue->maxsegs &&
+         a->total + b->total <= queue->maxsectors;
+}
+
+/****************************************************************************
+ * Name: blk_queue_append
+ *
+ * Description:
+ *   Append batch 'b' to batch 'a'.
+ *
+ ****************************************************************************/
+
+static void blk_queue_append(FAR struct blk_queue_s *queue,
+                             FAR struct blk_request_s *a,
+                             FAR struct blk_request_s *b)
+{
+  a->last->seg = b;
+  a->last      = b->last;
+  a->total    += b->total;
+  a->nsegs    += b->nsegs;
+  a->next      = b->next;
+  queue->merged++;
+}
+
+/****************************************************************************
+ * Name: blk_queue_insert
+ *
+ * Description:
+ *   Insert a request into the sorted pending list, merging it with the
+ *   batches in front of and behind it when the sectors are adjacent.
+ *
+ ****************************************************************************/
+
+static void blk_queue_insert(FAR struct blk_queue_s *queue,
+                             FAR struct blk_request_s *req)
+{
+  FAR struct blk_request_s *prev = NULL;
+  FAR struct blk_request_s *cur = queue->pending;
+
+  req->seg   = NULL;
+  req->last  = req;
+  req->total = req->nsectors;
+  req->nsegs = 1;
+
+  while (cur != NULL && cur->sector < req->sector)
+    {
+      prev = cur;
+      cur  = cur->next;
+    }
+
+  req->next = cur;
+
+  if (prev != NULL && blk_queue_mergeable(queue, prev, req))
+    {
+      /* Back merge; the request may also close the gap to the next
+       * batch.
+       */
+
+      blk_queue_append(queue, prev, req);
+      if (cur != NULL && blk_queue_mergeable(queue, prev, cur))
+        {
+          blk_queue_append(queue, prev, cur);
+        }
+
+      return;
+    }
+
+  if (cur != NULL && blk_queue_mergeable(queue, req, cur))
+    {
+      /* Front merge, the request takes the place of the batch */
+
+      blk_queue_append(queue, req, cur);
+    }
+
+  if (prev != NULL)
+    {
+      prev->next = req;
+    }
+  else
+    {
+      queue->pending = req;
+    }
+}
+
+/****************************************************************************
+ * Name: blk_queue_undefer
+ *
+ * Description:
+ *   Move the held back requests to the pending list once they do not
+ *   overlap any queued or active request anymore, in submission order.
+ *
+ ****************************************************************************/
+
+static void blk_queue_undefer(FAR struct blk_queue_s *queue)
+{
+  FAR struct blk_request_s *req;
+
+  while ((req = queue->deferred) != NULL &&
+         !blk_queue_overlap(queue->pending, req) &&
+         !blk_queue_overlap(queue->active, req))
+    {
+      queue->deferred = req->next;
+      blk_queue_insert(queue, req);
+    }
+}
+
+/****************************************************************************
+ * Name: blk_queue_pick
+ *
+ * Description:
+ *   Take the next batch to dispatch: the first one at or after the
+ *   elevator position, or the first one of the queue if there is none.
+ *
+ ****************************************************************************/
+
+static FAR struct blk_request_s *
+blk_queue_pick(FAR struct blk_queue_s *queue)
+{
+  FAR struct blk_request_s *prev = NULL;
+  FAR struct blk_request_s *cur = queue->pending;
+
+  while (cur != NULL && cur->sector < queue->position)
+    {
+      prev = cur;
+      cur  = cur->next;
+    }
+
+  if (cur == NULL)
+    {
+      prev = NULL;
+      cur  = queue->pending;
+      if (cur == NULL)
+        {
+          return NULL;
+        }
+    }
+
+  if (prev != NULL)
+    {
+      prev->next = cur->next;
+    }
+  else
+    {
+      queue->pending = cur->next;
+    }
+
+  queue->position = cur->sector + cur->total;
+  return cur;
+}
+
+/****************************************************************************
+ * Name: blk_queue_run
+ *
+ * Description:
+ *   Dispatch batches while the driver has room for them.  Only one context
+ *   runs the queue at a time; the others leave the work to it.
+ *
+ ****************************************************************************/
+
+static void blk_queue_run(FAR struct blk_queue_s *queue)
+{
+  FAR struct blk_request_s *batch;
+  irqstate_t flags;
+  int count = 0;
+  int ret;
+
+  flags = spin_lock_irqsave(&queue->lock);
+  if (queue->running)
+    {
+      spin_unlock_irqrestore(&queue->lock, flags);
+      return;
+    }
+
+  queue->running = true;
+
+  for (; ; )
+    {
+      blk_queue_undefer(queue);
+
+      if (queue->plugged > 0 || queue->inflight >= queue->depth ||
+          (batch = blk_queue_pick(queue)) == NULL)
+        {
+          break;
+        }
+
+      batch->next   = queue->active;
+      queue->active = batch;
+      queue->inflight++;
+      queue->dispatched++;
+      spin_unlock_irqrestore(&queue->lock, flags);
+
+      ret = queue->ops->dispatch(queue, batch);
+      if (ret < 0)
+        {
+          blk_queue_complete(queue, batch, ret);
+        }
+      else
+        {
+          count++;
+        }
+
+      flags = spin_lock_irqsave(&queue->lock);
+    }
+
+  queue->running = false;
+  spin_unlock_irqrestore(&queue->lock, flags);
+
+  if (count > 0 && queue->ops->commit != NULL)
+    {
+      queue->ops->commit(queue);
+    }
+}
+
+/****************************************************************************
+ * Name: blk_queue_wakeup
+ *
+ * Description:
+ *   Completion callback of blk_queue_rdwr().
+ *
+ ****************************************************************************/
+
+static void blk_queue_wakeup(FAR struct blk_request_s *req)
+{
+  nxsem_post(req->arg);
+}
+
+/****************************************************************************
+ * Name: blk_getqueue
+ *
+ * Description:
+ *   Return the request queue of a block driver, or NULL.
+ *
+ ****************************************************************************/
+
+static FAR struct blk_queue_s *blk_getqueue(FAR struct inode *inode)
+{
+  FAR struct blk_queue_s *queue = NULL;
+
+  if (inode->u.i_bops->ioctl == NULL ||
+      inode->u.i_bops->ioctl(inode, BIOC_GETQUEUE,
+                             (unsigned long)(uintptr_t)&queue) < 0)
+    {
+      return NULL;
+    }
+
+  return queue;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: blk_queue_init
+ ****************************************************************************/
+
+void blk_queue_init(FAR struct blk_queue_s *queue,
+                    FAR const struct blk_queue_ops_s *ops,
+                    uint16_t depth, uint16_t maxsegs, uint32_t maxsectors)
+{
+  DEBUGASSERT(queue != NULL && ops != NULL && ops->dispatch != NULL);
+
+  memset(queue, 0, sizeof(*queue));
+  spin_lock_init(&queue->lock);
+
+  queue->ops        = ops;
+  queue->depth      = depth > 0 ? depth : 1;
+  queue->maxsegs    = maxsegs > 0 ? maxsegs : 1;
+  queue->maxsectors = maxsectors > 0 ? maxsectors : UINT32_MAX;
+}
+
+/****************************************************************************
+ * Name: blk_queue_submit
+ ****************************************************************************/
+
+void blk_queue_submit(FAR struct blk_queue_s *queue,
+                      FAR struct blk_request_s *req)
+{
+  irqstate_t flags;
+
+  DEBUGASSERT(req->complete != NULL && req->nsectors > 0);
+
+  flags = spin_lock_irqsave(&queue->lock);
+  queue->submitted++;
+
+  /* A request overlapping a queued or active one must not pass it, and
+   * nothing may pass a held back request.
+   */
+
+  if (queue->deferred != NULL ||
+      blk_queue_overlap(queue->pending, req) ||
+      blk_queue_overlap(queue->active, req))
+    {
+      req->next = NULL;
+      req->total = req->nsectors;
+      if (queue->deferred == NULL)
+        {
+          queue->deferred = req;
+        }
+      else
+        {
+          queue->deftail->next = req;
+        }
+
+      queue->deftail = req;
+    }
+  else
+    {
+      blk_queue_insert(queue, req);
+    }
+
+  spin_unlock_irqrestore(&queue->lock, flags);
+  blk_queue_run(queue);
+}
+
+/****************************************************************************
+ * Name: blk_queue_complete
+ ****************************************************************************/
+
+void blk_queue_complete(FAR struct blk_queue_s *queue,
+                        FAR struct blk_request_s *batch, int result)
+{
+  FAR struct blk_request_s **pp;
+  FAR struct blk_request_s *req;
+  FAR struct blk_request_s *seg;
+  irqstate_t flags;
+
+  flags = spin_lock_irqsave(&queue->lock);
+  for (pp = &queue->active; *pp != NULL; pp = &(*pp)->next)
+    {
+      if (*pp == batch)
+        {
+          *pp = batch->next;
+          break;
+        }
+    }
+
+  DEBUGASSERT(queue->inflight > 0);
+  queue->inflight--;
+  spin_unlock_irqrestore(&queue->lock, flags);
+
+  /* The callbacks may free or reuse the requests */
+
+  for (req = batch; req != NULL; req = seg)
+    {
+      seg = req->seg;
+      req->result = result < 0 ? result : (ssize_t)req->nsectors;
+      req->complete(req);
+    }
+
+  blk_queue_run(queue);
+}
+
+/****************************************************************************
+ * Name: blk_queue_plug
+ ****************************************************************************/
+
+void blk_queue_plug(FAR struct blk_queue_s *queue)
+{
+  irqstate_t flags;
+
+  flags = spin_lock_irqsave(&queue->lock);
+  queue->plugged++;
+  spin_unlock_irqrestore(&queue->lock, flags);
+}
+
+/****************************************************************************
+ * Name: blk_queue_unplug
+ ****************************************************************************/
+
+void blk_queue_unplug(FAR struct blk_queue_s *queue)
+{
+  irqstate_t flags;
+
+  flags = spin_lock_irqsave(&queue->lock);
+  DEBUGASSERT(queue->plugged > 0);
+  queue->plugged--;
+  spin_unlock_irqrestore(&queue->lock, flags);
+
+  blk_queue_run(queue);
+}
+
+/****************************************************************************
+ * Name: blk_queue_rdwr
+ ****************************************************************************/
+
+ssize_t blk_queue_rdwr(FAR struct blk_queue_s *queue,
+                       FAR unsigned char *buffer, blkcnt_t sector,
+                       unsigned int nsectors, bool write)
+{
+  struct blk_request_s req;
+  sem_t sem;
+
+  if (nsectors == 0)
+    {
+      return 0;
+    }
+
+  nxsem_init(&sem, 0, 0);
+
+  req.op       = write ? BLK_REQ_WRITE : BLK_REQ_READ;
+  req.buffer   = buffer;
+  req.sector   = sector;
+  req.nsectors = nsectors;
+  req.complete = blk_queue_wakeup;
+  req.arg      = &sem;
+
+  blk_queue_submit(queue, &req);
+  nxsem_wait_uninterruptible(&sem);
+  nxsem_destroy(&sem);
+
+  return req.result;
+}
+
+/****************************************************************************
+ * Name: blk_submit
+ ****************************************************************************/
+
+void blk_submit(FAR struct inode *inode, FAR struct blk_request_s *req)
+{
+  FAR const struct block_operations *bops = inode->u.i_bops;
+  FAR struct blk_queue_s *queue;
+
+  queue = blk_getqueue(inode);
+  if (queue != NULL)
+    {
+      blk_queue_submit(queue, req);
+      return;
+    }
+
+  /* No queue, execute the request synchronously */
+
+  if (req->op == BLK_REQ_WRITE)
+    {
+      req->result = bops->write != NULL ?
+                    bops->write(inode, req->buffer, req->sector,
+                                req->nsectors) : -EACCES;
+    }
+  else
+    {
+      req->result = bops->read != NULL ?
+                    bops->read(inode, req->buffer, req->sector,
+                               req->nsectors) : -EACCES;
+    }
+
+  req->complete(req);
+}
+
+/****************************************************************************
+ * Name: blk_plug
+ ****************************************************************************/
+
+void blk_plug(FAR struct inode *inode)
+{
+  FAR struct blk_queue_s *queue = blk_getqueue(inode);
+
+  if (queue != NULL)
+    {
+      blk_queue_plug(queue);
+    }
+}
+
+/****************************************************************************
+ * Name: blk_unplug
+ ****************************************************************************/
+
+void blk_unplug(FAR struct inode *inode)
+{
+  FAR struct blk_queue_s *queue = blk_getqueue(inode);
+
+  if (queue != NULL)
+    {
+      blk_queue_unplug(queue);
+    }
+}
+
+#endif /* CONFIG_FS_BLKQUEUE */
@@ -30,25 +30,54 @@
 #include <sys/mount.h>
 #include <sys/stat.h>
 
+#include <nuttx/fs/blkqueue.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/ioctl.h>
 #include <nuttx/mtd/mtd.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/nuttx.h>
 
 #include "driver/driver.h"
 #include "inode/inode.h"
 #include "fs_heap.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Requests of a partition passed on to the parent queue at a time */
+
+#define PART_QUEUE_DEPTH 4
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
+#ifdef CONFIG_FS_BLKQUEUE
+struct part_struct_s;
+
+/* A request of the partition queue, passed on to the queue of the parent
+ * with the sectors of the parent.
+ */
+
+struct part_request_s
+{
+  struct blk_request_s      req;   /* The request to the parent */
+  FAR struct blk_request_s *batch; /* The partition request, NULL if free */
+  FAR struct part_struct_s *dev;
+};
+#endif
+
 struct part_struct_s
 {
   FAR struct inode *parent;
   size_t sectorsize;
   off_t firstsector;
   off_t nsectors;
+#ifdef CONFIG_FS_BLKQUEUE
+  struct blk_queue_s queue;
+  struct part_request_s reqs[PART_QUEUE_DEPTH];
+#endif
 };
 
 /****************************************************************************
@@ -69,11 +98,23 @@ static int     part_ioctl(FAR struct inode *inode, int cmd,
 #ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
 static int     part_unlink(FAR struct inode *inode);
 #endif
+#ifdef CONFIG_FS_BLKQUEUE
+static int     part_dispatch(FAR struct blk_queue_s *queue,
+                             FAR struct blk_request_s *batch);
+#endif
 
 /****************************************************************************
  * Private Data
  ****************************************************************************/
 
+#ifdef CONFIG_FS_BLKQUEUE
+static const struct blk_queue_ops_s g_part_qops =
+{
+  part_dispatch, /* dispatch */
+  NULL           /* commit   */
+};
+#endif
+
 static const struct block_operations g_part_bops =
 {
   part_open,     /* open     */
@@ -239,6 +280,26 @@ static int part_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
         }
         break;
 
+#ifdef CONFIG_FS_BLKQUEUE
+      /* The partition has a queue of its own if the parent has one: the
+       * parent queue works with the sectors of the parent.
+       */
+
+      case BIOC_GETQUEUE:
+        if (ptr_arg != 0 && parent->u.i_bops->ioctl != NULL)
+          {
+            ret = parent->u.i_bops->ioctl(parent, cmd, arg);
+            if (ret >= 0)
+              {
+                *(FAR struct blk_queue_s **)ptr_arg = &dev->queue;
+              }
+          }
+        break;
+#else
+      case BIOC_GETQUEUE:
+        break;
+#endif
+
       default:
         if (parent->u.i_bops->ioctl)
           {
@@ -293,6 +354,74 @@ static int part_unlink(FAR struct inode *inode)
 }
 #endif
 
+#ifdef CONFIG_FS_BLKQUEUE
+/****************************************************************************
+ * Name: part_complete
+ *
+ * Description: Complete a partition request when the parent is done
+ *
+ ****************************************************************************/
+
+static void part_complete(FAR struct blk_request_s *req)
+{
+  FAR struct part_request_s *preq = req->arg;
+  FAR struct blk_request_s *batch = preq->batch;
+
+  /* Free the slot first, completing may dispatch the next request */
+
+  preq->batch = NULL;
+  blk_queue_complete(&preq->dev->queue, batch,
+                     req->result < 0 ? (int)req->result : OK);
+}
+
+/****************************************************************************
+ * Name: part_dispatch
+ *
+ * Description: Pass a request on to the queue of the parent
+ *
+ ****************************************************************************/
+
+static int part_dispatch(FAR struct blk_queue_s *queue,
+                         FAR struct blk_request_s *batch)
+{
+  FAR struct part_struct_s *dev =
+    container_of(queue, struct part_struct_s, queue);
+  FAR struct part_request_s *preq = NULL;
+  int i;
+
+  if (batch->sector >= dev->nsectors ||
+      dev->nsectors - batch->sector < batch->total)
+    {
+      return -EINVAL;
+    }
+
+  /* The queue depth bounds the requests in flight */
+
+  for (i = 0; i < PART_QUEUE_DEPTH; i++)
+    {
+      if (dev->reqs[i].batch == NULL)
+        {
+          preq = &dev->reqs[i];
+          break;
+        }
+    }
+
+  DEBUGASSERT(preq != NULL && batch->seg == NULL);
+
+  preq->batch        = batch;
+  preq->dev          = dev;
+  preq->req.op       = batch->op;
+  preq->req.buffer   = batch->buffer;
+  preq->req.sector   = batch->sector + dev->firstsector;
+  preq->req.nsectors = batch->nsectors;
+  preq->req.complete = part_complete;
+  preq->req.arg      = preq;
+
+  blk_submit(dev->parent, &preq->req);
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -356,6 +485,12 @@ int register_partition_with_inode(FAR const char *partition,
 
   dev->sectorsize = geo.geo_sectorsize;
 
+#ifdef CONFIG_FS_BLKQUEUE
+  /* Each request is passed on alone, the parent merges them */
+
+  blk_queue_init(&dev->queue, &g_part_qops, PART_QUEUE_DEPTH, 1, 0);
+#endif
+
   /* Inode private data is a reference to the partition device structure */
 
   ret = register_blockdriver(partition, &g_part_bops, mode, dev);
@@ -26,6 +26,7 @@
 
 #include <nuttx/config.h>
 
+#include <sys/param.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/statfs.h>
@@ -42,6 +43,7 @@
 #include <nuttx/kmalloc.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/fat.h>
+#include <nuttx/fs/pagecache.h>
 
 #include "inode/inode.h"
 #include "fs_fat32.h"
@@ -620,6 +622,24 @@ static int fat_get_sectors(FAR struct file *filep, bool read)
       num_traversed = 1;
     }
 
+#if CONFIG_FAT_EXTENTS > 0
+  /* Skip the part of the chain already known from the cluster runs */
+
+  if (cluster != 0 && MIN(num_clu, new_num_clu) > num_traversed)
+    {
+      uint32_t known;
+      uint32_t found;
+
+      fat_extentadd(ff, 0, ff->ff_startcluster);
+      known = fat_extentfind(ff, MIN(num_clu, new_num_clu) - 1, &found);
+      if ((int)known > num_traversed)
+        {
+          cluster       = found;
+          num_traversed = known;
+        }
+    }
+#endif
+
   /* Traverse the existing chain */
 
   for (i = num_traversed; i < num_clu && i < new_num_clu; i++)
@@ -632,6 +652,10 @@ static int fat_get_sectors(FAR struct file *filep, bool read)
         {
           return -EIO;
         }
+
+#if CONFIG_FAT_EXTENTS > 0
+      fat_extentadd(ff, i, cluster);
+#endif
     }
 
   if (read)
@@ -684,6 +708,10 @@ static int fat_get_sectors(FAR struct file *filep, bool read)
           return -EIO;
         }
 
+#if CONFIG_FAT_EXTENTS > 0
+      fat_extentadd(ff, i, cluster);
+#endif
+
       /* zero area (2) */
 
       ret = fat_zero_cluster(fs, cluster, 0, clu_size);
@@ -707,6 +735,10 @@ static int fat_get_sectors(FAR struct file *filep, bool read)
           return -EIO;
         }
 
+#if CONFIG_FAT_EXTENTS > 0
+      fat_extentadd(ff, i, cluster);
+#endif
+
       /* zero area (3) */
 
       zero_end = filep->f_pos & (clu_size -1);
@@ -1905,6 +1937,15 @@ static int fat_sync(FAR struct file *filep)
       ret          = fat_updatefsinfo(fs);
     }
 
+#ifdef CONFIG_FS_PAGECACHE
+  /* Write the cached sectors back to the media */
+
+  if (ret >= 0 && fs->fs_pagecache)
+    {
+      ret = pagecache_flush(fs->fs_blkdriver);
+    }
+#endif
+
 errout_with_lock:
   nxmutex_unlock(&fs->fs_lock);
   return ret;
@@ -2012,6 +2053,7 @@ static int fat_dup(FAR const struct file *oldp, FAR struct file *newp)
   newff->ff_startcluster     = oldff->ff_startcluster;     /* Start cluster of file on media */
   newff->ff_currentsector    = oldff->ff_currentsector;    /* Current sector */
   newff->ff_cachesector      = 0;                          /* Sector in file buffer */
+  fat_extentreset(newff);                                  /* Cluster runs */
 
   /* Attach the private date to the struct file instance */
 
@@ -2344,6 +2386,10 @@ static int fat_truncate(FAR struct file *filep, off_t length)
           ret = fat_dirshrink(fs, direntry, length);
         }
 
+      /* The chain has changed, forget its cluster runs */
+
+      fat_extentreset(ff);
+
       if (ret >= 0)
         {
           /* The truncation has completed without error.  Update the file
@@ -2662,6 +2708,22 @@ static int fat_bind(FAR struct inode *blkdriver, FAR const void *data,
   fs->fs_blkdriver = blkdriver;   /* Save the block driver reference */
   nxmutex_init(&fs->fs_lock);     /* Initialize the mutex that controls access */
 
+#ifdef CONFIG_FS_PAGECACHE
+  /* Cache the sectors of the volume.  Without the cache, accesses go to the
+   * block driver directly.
+   */
+
+  ret = pagecache_attach(blkdriver);
+  if (ret < 0)
+    {
+      fwarn("WARNING: Page cache not available: %d\n", ret);
+    }
+  else
+    {
+      fs->fs_pagecache = true;
+    }
+#endif
+
   /* Then get information about the FAT32 filesystem on the devices managed
    * by this block driver.
    */
@@ -2669,6 +2731,13 @@ static int fat_bind(FAR struct inode *blkdriver, FAR const void *data,
   ret = fat_mount(fs, true);
   if (ret != 0)
     {
+#ifdef CONFIG_FS_PAGECACHE
+      if (fs->fs_pagecache)
+        {
+          pagecache_detach(blkdriver);
+        }
+#endif
+
       nxmutex_destroy(&fs->fs_lock);
       fs_heap_free(fs);
       return ret;
@@ -2746,6 +2815,20 @@ static int fat_unbind(FAR void *handle, FAR struct inode **blkdriver,
       FAR struct inode *inode = fs->fs_blkdriver;
       if (inode)
         {
+          /* Write back the cached FAT sectors */
+
+          fat_fatcacheflush(fs);
+
+#ifdef CONFIG_FS_PAGECACHE
+          /* Write back and release the cached sectors */
+
+          if (fs->fs_pagecache)
+            {
+              pagecache_detach(inode);
+              fs->fs_pagecache = false;
+            }
+#endif
+
           if (inode->u.i_bops && inode->u.i_bops->close)
             {
               inode->u.i_bops->close(inode);
@@ -2766,6 +2849,7 @@ static int fat_unbind(FAR void *handle, FAR struct inode **blkdriver,
 
   /* Release the mountpoint private data */
 
+  fat_fatcachefree(fs);
   if (fs->fs_buffer)
     {
       fat_io_free(fs->fs_buffer, fs->fs_hwsectorsize);
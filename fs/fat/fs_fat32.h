@@ -891,7 +891,29 @@ struct fat_mountpt_s
   uint8_t  fs_fatsecperclus;       /* MBR: Sectors per allocation unit: 2**n, n=0..7 */
   uint8_t *fs_buffer;              /* This is an allocated buffer to hold one
                                     * sector from the device */
+#if CONFIG_FAT_FATCACHE_SECTORS > 0
+  off_t    fs_fatcachesector;      /* First FAT sector in fs_fatcache, -1 if none */
+  uint32_t fs_fatcachedirty;       /* Bit set of the dirty sectors in fs_fatcache */
+  uint8_t *fs_fatcache;            /* Buffer of consecutive FAT sectors */
+#endif
+#ifdef CONFIG_FAT_FREEMAP
+  uint32_t *fs_freemap;            /* Bit set of the clusters in use */
+#endif
+#ifdef CONFIG_FS_PAGECACHE
+  bool     fs_pagecache;           /* true: Holds a page cache reference */
+#endif
+};
+
+/* A run of consecutive clusters in the cluster chain of a file */
+
+#if CONFIG_FAT_EXTENTS > 0
+struct fat_extent_s
+{
+  uint32_t fe_index;               /* Index of the first cluster in the file */
+  uint32_t fe_cluster;             /* First cluster of the run */
+  uint32_t fe_count;               /* Number of clusters in the run */
 };
+#endif
 
 /* This structure represents on open file under the mountpoint.  An instance
  * of this structure is retained as struct file specific information on each
@@ -913,6 +935,11 @@ struct fat_file_s
   off_t    ff_cachesector;         /* Current sector in the file buffer */
   off_t    ff_pos;                 /* Current position in the file */
   uint8_t *ff_buffer;              /* File buffer (for partial sector accesses) */
+#if CONFIG_FAT_EXTENTS > 0
+  uint32_t ff_nmapped;             /* Number of leading clusters in ff_extents */
+  uint16_t ff_nextents;            /* Number of runs in ff_extents */
+  struct fat_extent_s ff_extents[CONFIG_FAT_EXTENTS];
+#endif
 };
 
 /* This structure holds the sequence of directory entries used by one
@@ -1100,6 +1127,26 @@ EXTERN int    fat_ffcacheread(FAR struct fat_mountpt_s *fs,
 EXTERN int    fat_ffcacheinvalidate(FAR struct fat_mountpt_s *fs,
                                     FAR struct fat_file_s *ff);
 
+/* FAT table cache and free cluster map */
+
+EXTERN FAR uint8_t *fat_fatcacheread(FAR struct fat_mountpt_s *fs,
+                                     off_t sector, bool dirty);
+EXTERN int    fat_fatcacheflush(FAR struct fat_mountpt_s *fs);
+EXTERN void   fat_fatcachefree(FAR struct fat_mountpt_s *fs);
+
+/* Cluster run cache of the open files */
+
+#if CONFIG_FAT_EXTENTS > 0
+EXTERN uint32_t fat_extentfind(FAR struct fat_file_s *ff, uint32_t index,
+                               FAR uint32_t *cluster);
+EXTERN void   fat_extentadd(FAR struct fat_file_s *ff, uint32_t index,
+                            uint32_t cluster);
+#  define fat_extentreset(ff) \
+     do { (ff)->ff_nmapped = 0; (ff)->ff_nextents = 0; } while (0)
+#else
+#  define fat_extentreset(ff)
+#endif
+
 /* FSINFO sector support */
 
 EXTERN int    fat_updatefsinfo(FAR struct fat_mountpt_s *fs);
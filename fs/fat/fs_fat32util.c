@@ -26,12 +26,14 @@
 
 #include <nuttx/config.h>
 
+#include <sys/param.h>
 #include <sys/types.h>
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
 #include <assert.h>
 #include <errno.h>
@@ -40,6 +42,7 @@
 #include <nuttx/kmalloc.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/fat.h>
+#include <nuttx/fs/pagecache.h>
 
 #include "inode/inode.h"
 #include "fs_fat32.h"
@@ -270,6 +273,124 @@ static int fat_checkbootrecord(struct fat_mountpt_s *fs)
   return OK;
 }
 
+/****************************************************************************
+ * Name: fat_findfreecluster
+ *
+ * Description:
+ *   Find a free cluster after startcluster, wrapping around at the end of
+ *   the FAT.  With CONFIG_FAT_FREEMAP, the free cluster map built at mount
+ *   time is searched instead of the FAT itself.
+ *
+ * Returned Value:
+ *   <0:error, 0: no free cluster, >=2: free cluster number
+ *
+ ****************************************************************************/
+
+static int32_t fat_findfreecluster(FAR struct fat_mountpt_s *fs,
+                                   uint32_t startcluster)
+{
+  uint32_t newcluster;
+  off_t    startsector;
+
+#ifdef CONFIG_FAT_FREEMAP
+  if (fs->fs_freemap != NULL)
+    {
+      uint32_t end = fs->fs_nclusters + 2;
+      uint32_t word;
+      int pass;
+
+      /* Search from the start cluster to the end of the map, then from
+       * the beginning of the map.  Whole words in use are skipped.
+       */
+
+      newcluster = startcluster + 1;
+      for (pass = 0; pass < 2; pass++)
+        {
+          while (newcluster < end)
+            {
+              word = ~fs->fs_freemap[newcluster / 32] &
+                     (UINT32_MAX << (newcluster % 32));
+              if (word != 0)
+                {
+                  newcluster = (newcluster & ~31) + ffs(word) - 1;
+                  if (newcluster < end)
+                    {
+                      return newcluster;
+                    }
+
+                  break;
+                }
+
+              newcluster = (newcluster & ~31) + 32;
+            }
+
+          end        = MIN(startcluster + 1, fs->fs_nclusters + 2);
+          newcluster = 2;
+        }
+
+      return 0;
+    }
+#endif
+
+  /* Loop until (1) we discover that there are not free clusters
+   * (return 0), an errors occurs (return -errno), or (3) we find
+   * the next cluster (return the new cluster number).
+   */
+
+  newcluster = startcluster;
+  for (; ; )
+    {
+      /* Examine the next cluster in the FAT */
+
+      newcluster++;
+      if (newcluster >= fs->fs_nclusters + 2)
+        {
+          /* If we hit the end of the available clusters, then
+           * wrap back to the beginning because we might have
+           * started at a non-optimal place.  But don't continue
+           * past the start cluster.
+           */
+
+          newcluster = 2;
+          if (newcluster > startcluster)
+            {
+              /* We are back past the starting cluster, then there
+               * is no free cluster.
+               */
+
+              return 0;
+            }
+        }
+
+      /* We have a candidate cluster.  Check if the cluster number is
+       * mapped to a group of sectors.
+       */
+
+      startsector = fat_getcluster(fs, newcluster);
+      if (startsector == 0)
+        {
+          /* Found have found a free cluster */
+
+          return newcluster;
+        }
+      else if (startsector < 0)
+        {
+          /* Some error occurred, return the error number */
+
+          return startsector;
+        }
+
+      /* We wrap all the back to the starting cluster?  If so, then
+       * there are no free clusters.
+       */
+
+      if (newcluster == startcluster)
+        {
+          return 0;
+        }
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -626,15 +747,37 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
         }
     }
 
-  /* Enforce computation of free clusters if configured */
+  /* Enforce computation of free clusters if configured.  Building the free
+   * cluster map computes them too.
+   */
 
-#ifdef CONFIG_FAT_COMPUTE_FSINFO
-  ret = fat_computefreeclusters(fs);
-  if (ret != OK)
+#ifdef CONFIG_FAT_FREEMAP
+  fs->fs_freemap = fs_heap_malloc(howmany(fs->fs_nclusters + 2, 32) *
+                                  sizeof(uint32_t));
+  if (fs->fs_freemap == NULL)
     {
-      goto errout_with_buffer;
+      fwarn("WARNING: No memory for the free cluster map\n");
+    }
+
+  if (fs->fs_freemap != NULL)
+    {
+      ret = fat_computefreeclusters(fs);
+      if (ret != OK)
+        {
+          goto errout_with_buffer;
+        }
     }
+  else
 #endif
+    {
+#ifdef CONFIG_FAT_COMPUTE_FSINFO
+      ret = fat_computefreeclusters(fs);
+      if (ret != OK)
+        {
+          goto errout_with_buffer;
+        }
+#endif
+    }
 
   /* We did it! */
 
@@ -658,6 +801,7 @@ int fat_mount(struct fat_mountpt_s *fs, bool writeable)
   return OK;
 
 errout_with_buffer:
+  fat_fatcachefree(fs);
   fat_io_free(fs->fs_buffer, fs->fs_hwsectorsize);
   fs->fs_buffer = NULL;
 
@@ -728,8 +872,13 @@ int fat_hwread(struct fat_mountpt_s *fs, uint8_t *buffer,  off_t sector,
       struct inode *inode = fs->fs_blkdriver;
       if (inode && inode->u.i_bops && inode->u.i_bops->read)
         {
+#ifdef CONFIG_FS_PAGECACHE
+          ssize_t nsectorsread = pagecache_read(inode, buffer,
+                                                sector, nsectors);
+#else
           ssize_t nsectorsread = inode->u.i_bops->read(inode, buffer,
                                                        sector, nsectors);
+#endif
           if (nsectorsread == nsectors)
             {
               ret = OK;
@@ -761,8 +910,13 @@ int fat_hwwrite(struct fat_mountpt_s *fs, uint8_t *buffer, off_t sector,
       struct inode *inode = fs->fs_blkdriver;
       if (inode && inode->u.i_bops && inode->u.i_bops->write)
         {
+#ifdef CONFIG_FS_PAGECACHE
+          ssize_t nsectorswritten =
+              pagecache_write(inode, buffer, sector, nsectors);
+#else
           ssize_t nsectorswritten =
               inode->u.i_bops->write(inode, buffer, sector, nsectors);
+#endif
 
           if (nsectorswritten == nsectors)
             {
@@ -822,6 +976,7 @@ off_t fat_getcluster(struct fat_mountpt_s *fs, uint32_t clusterno)
         {
           case FSTYPE_FAT12 :
             {
+              FAR uint8_t *buffer;
               off_t        fatsector;
               unsigned int fatoffset;
               unsigned int cluster;
@@ -836,7 +991,8 @@ off_t fat_getcluster(struct fat_mountpt_s *fs, uint32_t clusterno)
 
               /* Read the sector at this offset */
 
-              if (fat_fscacheread(fs, fatsector) < 0)
+              buffer = fat_fatcacheread(fs, fatsector, false);
+              if (buffer == NULL)
                 {
                   /* Read error */
 
@@ -846,7 +1002,7 @@ off_t fat_getcluster(struct fat_mountpt_s *fs, uint32_t clusterno)
               /* Get the first, LS byte of the cluster from the FAT */
 
               fatindex = fatoffset & SEC_NDXMASK(fs);
-              cluster  = fs->fs_buffer[fatindex];
+              cluster  = buffer[fatindex];
 
               /* With FAT12, the second byte of the cluster number may lie in
                * a different sector than the first byte.
@@ -858,7 +1014,8 @@ off_t fat_getcluster(struct fat_mountpt_s *fs, uint32_t clusterno)
                   fatsector++;
                   fatindex = 0;
 
-                  if (fat_fscacheread(fs, fatsector) < 0)
+                  buffer = fat_fatcacheread(fs, fatsector, false);
+                  if (buffer == NULL)
                     {
                       /* Read error */
 
@@ -871,7 +1028,7 @@ off_t fat_getcluster(struct fat_mountpt_s *fs, uint32_t clusterno)
                * on the fact that the byte stream is little-endian.
                */
 
-              cluster |= (unsigned int)fs->fs_buffer[fatindex] << 8;
+              cluster |= (unsigned int)buffer[fatindex] << 8;
 
               /* Now, pick out the correct 12 bit cluster start sector
                * value.
@@ -901,15 +1058,17 @@ off_t fat_getcluster(struct fat_mountpt_s *fs, uint32_t clusterno)
               off_t        fatsector = fs->fs_fatbase +
                                        SEC_NSECTORS(fs, fatoffset);
               unsigned int fatindex  = fatoffset & SEC_NDXMASK(fs);
+              FAR uint8_t *buffer;
 
-              if (fat_fscacheread(fs, fatsector) < 0)
+              buffer = fat_fatcacheread(fs, fatsector, false);
+              if (buffer == NULL)
                 {
                   /* Read error */
 
                   break;
                 }
 
-              return FAT_GETFAT16(fs->fs_buffer, fatindex);
+              return FAT_GETFAT16(buffer, fatindex);
             }
 
           case FSTYPE_FAT32 :
@@ -920,15 +1079,17 @@ off_t fat_getcluster(struct fat_mountpt_s *fs, uint32_t clusterno)
               off_t        fatsector = fs->fs_fatbase +
                                        SEC_NSECTORS(fs, fatoffset);
               unsigned int fatindex  = fatoffset & SEC_NDXMASK(fs);
+              FAR uint8_t *buffer;
 
-              if (fat_fscacheread(fs, fatsector) < 0)
+              buffer = fat_fatcacheread(fs, fatsector, false);
+              if (buffer == NULL)
                 {
                   /* Read error */
 
                   break;
                 }
 
-              return FAT_GETFAT32(fs->fs_buffer, fatindex) & 0x0fffffff;
+              return FAT_GETFAT32(buffer, fatindex) & 0x0fffffff;
             }
 
           default:
@@ -966,6 +1127,7 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
         {
           case FSTYPE_FAT12 :
             {
+              FAR uint8_t *buffer;
               off_t        fatsector;
               unsigned int fatoffset;
               unsigned int fatindex;
@@ -980,7 +1142,8 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
 
               /* Make sure that the sector at this offset is in the cache */
 
-              if (fat_fscacheread(fs, fatsector) < 0)
+              buffer = fat_fatcacheread(fs, fatsector, true);
+              if (buffer == NULL)
                 {
                   /* Read error */
 
@@ -996,7 +1159,7 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
                 {
                   /* Save the LS four bits of the next cluster */
 
-                  value = (fs->fs_buffer[fatindex] & 0x0f) |
+                  value = (buffer[fatindex] & 0x0f) |
                            (uint8_t)nextcluster << 4;
                 }
               else
@@ -1006,7 +1169,7 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
                   value = (uint8_t)nextcluster;
                 }
 
-              fs->fs_buffer[fatindex] = value;
+              buffer[fatindex] = value;
 
               /* With FAT12, the second byte of the cluster number may lie in
                * a different sector than the first byte.
@@ -1020,12 +1183,12 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
                   fatsector++;
                   fatindex = 0;
 
-                  /* Set the dirty flag to make sure the sector that we
-                   * just modified is written out.
+                  /* The sector that we just modified was marked dirty when
+                   * it was read, so it will be written out.
                    */
 
-                  fs->fs_dirty = true;
-                  if (fat_fscacheread(fs, fatsector) < 0)
+                  buffer = fat_fatcacheread(fs, fatsector, true);
+                  if (buffer == NULL)
                     {
                       /* Read error */
 
@@ -1047,11 +1210,11 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
                 {
                   /* Save the MS four bits of the next cluster */
 
-                  value = (fs->fs_buffer[fatindex] & 0xf0) |
+                  value = (buffer[fatindex] & 0xf0) |
                           ((nextcluster >> 8) & 0x0f);
                 }
 
-              fs->fs_buffer[fatindex] = value;
+              buffer[fatindex] = value;
             }
           break;
 
@@ -1061,15 +1224,17 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
               off_t        fatsector = fs->fs_fatbase +
                                        SEC_NSECTORS(fs, fatoffset);
               unsigned int fatindex  = fatoffset & SEC_NDXMASK(fs);
+              FAR uint8_t *buffer;
 
-              if (fat_fscacheread(fs, fatsector) < 0)
+              buffer = fat_fatcacheread(fs, fatsector, true);
+              if (buffer == NULL)
                 {
                   /* Read error */
 
                   break;
                 }
 
-              FAT_PUTFAT16(fs->fs_buffer, fatindex, nextcluster & 0xffff);
+              FAT_PUTFAT16(buffer, fatindex, nextcluster & 0xffff);
             }
           break;
 
@@ -1079,9 +1244,11 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
               off_t        fatsector = fs->fs_fatbase +
                                        SEC_NSECTORS(fs, fatoffset);
               unsigned int fatindex  = fatoffset & SEC_NDXMASK(fs);
+              FAR uint8_t *buffer;
               uint32_t     val;
 
-              if (fat_fscacheread(fs, fatsector) < 0)
+              buffer = fat_fatcacheread(fs, fatsector, true);
+              if (buffer == NULL)
                 {
                   /* Read error */
 
@@ -1090,8 +1257,8 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
 
               /* Keep the top 4 bits */
 
-              val = FAT_GETFAT32(fs->fs_buffer, fatindex) & 0xf0000000;
-              FAT_PUTFAT32(fs->fs_buffer, fatindex,
+              val = FAT_GETFAT32(buffer, fatindex) & 0xf0000000;
+              FAT_PUTFAT32(buffer, fatindex,
                            val | (nextcluster & 0x0fffffff));
             }
           break;
@@ -1100,9 +1267,26 @@ int fat_putcluster(struct fat_mountpt_s *fs, uint32_t clusterno,
             return -EINVAL;
         }
 
-      /* Mark the modified sector as "dirty" and return success */
+      /* The modified sector was marked "dirty" when it was read.  Keep
+       * the free cluster map in sync and return success.
+       */
+
+#ifdef CONFIG_FAT_FREEMAP
+      if (fs->fs_freemap != NULL && clusterno >= 2)
+        {
+          if (nextcluster != 0)
+            {
+              fs->fs_freemap[clusterno / 32] |=
+                UINT32_C(1) << (clusterno % 32);
+            }
+          else
+            {
+              fs->fs_freemap[clusterno / 32] &=
+                ~(UINT32_C(1) << (clusterno % 32));
+            }
+        }
+#endif
 
-      fs->fs_dirty = true;
       return OK;
     }
 
@@ -1226,62 +1410,14 @@ int32_t fat_extendchain(struct fat_mountpt_s *fs, uint32_t cluster)
       startcluster = cluster;
     }
 
-  /* Loop until (1) we discover that there are not free clusters
-   * (return 0), an errors occurs (return -errno), or (3) we find
-   * the next cluster (return the new cluster number).
-   */
+  /* Find a free cluster following the start cluster */
 
-  newcluster = startcluster;
-  for (; ; )
+  newcluster = fat_findfreecluster(fs, startcluster);
+  if ((int32_t)newcluster <= 0)
     {
-      /* Examine the next cluster in the FAT */
+      /* No free cluster, or an error occurred */
 
-      newcluster++;
-      if (newcluster >= fs->fs_nclusters + 2)
-        {
-          /* If we hit the end of the available clusters, then
-           * wrap back to the beginning because we might have
-           * started at a non-optimal place.  But don't continue
-           * past the start cluster.
-           */
-
-          newcluster = 2;
-          if (newcluster > startcluster)
-            {
-              /* We are back past the starting cluster, then there
-               * is no free cluster.
-               */
-
-              return 0;
-            }
-        }
-
-      /* We have a candidate cluster.  Check if the cluster number is
-       * mapped to a group of sectors.
-       */
-
-      startsector = fat_getcluster(fs, newcluster);
-      if (startsector == 0)
-        {
-          /* Found have found a free cluster break out */
-
-          break;
-        }
-      else if (startsector < 0)
-        {
-          /* Some error occurred, return the error number */
-
-          return startsector;
-        }
-
-      /* We wrap all the back to the starting cluster?  If so, then
-       * there are no free clusters.
-       */
-
-      if (newcluster == startcluster)
-        {
-          return 0;
-        }
+      return (int32_t)newcluster;
     }
 
   /* We get here only if we break out with an available cluster
@@ -1858,6 +1994,275 @@ int fat_fscacheread(struct fat_mountpt_s *fs, off_t sector)
   return OK;
 }
 
+/****************************************************************************
+ * Name: fat_fatcacheread
+ *
+ * Description:
+ *   Read a FAT sector into the FAT table cache and return its data.  The
+ *   cache holds CONFIG_FAT_FATCACHE_SECTORS consecutive FAT sectors that
+ *   are read with one request, so the FAT entries do not evict the
+ *   directory sector in fs_buffer.  If dirty is true, the sector is
+ *   written back to every FAT copy by the next fat_fatcacheflush().
+ *
+ *   Without the FAT table cache, the FAT sectors go through fs_buffer.
+ *
+ * Returned Value:
+ *   The sector data on success; NULL on a read error.
+ *
+ ****************************************************************************/
+
+FAR uint8_t *fat_fatcacheread(FAR struct fat_mountpt_s *fs, off_t sector,
+                              bool dirty)
+{
+#if CONFIG_FAT_FATCACHE_SECTORS > 0
+  unsigned int index;
+
+  if (fs->fs_fatcache == NULL)
+    {
+      fs->fs_fatcache = (FAR uint8_t *)
+        fat_io_alloc(CONFIG_FAT_FATCACHE_SECTORS * fs->fs_hwsectorsize);
+      if (fs->fs_fatcache == NULL)
+        {
+          return NULL;
+        }
+
+      fs->fs_fatcachesector = -1;
+      fs->fs_fatcachedirty  = 0;
+    }
+
+  if (fs->fs_fatcachesector < 0 || sector < fs->fs_fatcachesector ||
+      sector >= fs->fs_fatcachesector + CONFIG_FAT_FATCACHE_SECTORS)
+    {
+      off_t first;
+      unsigned int nsectors;
+
+      if (fat_fatcacheflush(fs) < 0)
+        {
+          return NULL;
+        }
+
+      /* Read the aligned group of FAT sectors holding the sector */
+
+      first    = sector - (sector - fs->fs_fatbase) %
+                 CONFIG_FAT_FATCACHE_SECTORS;
+      nsectors = MIN(CONFIG_FAT_FATCACHE_SECTORS,
+                     fs->fs_fatbase + fs->fs_nfatsects - first);
+
+      fs->fs_fatcachesector = -1;
+      if (fat_hwread(fs, fs->fs_fatcache, first, nsectors) < 0)
+        {
+          return NULL;
+        }
+
+      fs->fs_fatcachesector = first;
+    }
+
+  index = sector - fs->fs_fatcachesector;
+  if (dirty)
+    {
+      fs->fs_fatcachedirty |= UINT32_C(1) << index;
+    }
+
+  return fs->fs_fatcache + index * fs->fs_hwsectorsize;
+#else
+  if (fat_fscacheread(fs, sector) < 0)
+    {
+      return NULL;
+    }
+
+  if (dirty)
+    {
+      fs->fs_dirty = true;
+    }
+
+  return fs->fs_buffer;
+#endif
+}
+
+/****************************************************************************
+ * Name: fat_fatcacheflush
+ *
+ * Description:
+ *   Write the dirty sectors of the FAT table cache to every FAT copy, with
+ *   one request per copy.
+ *
+ ****************************************************************************/
+
+int fat_fatcacheflush(FAR struct fat_mountpt_s *fs)
+{
+#if CONFIG_FAT_FATCACHE_SECTORS > 0
+  unsigned int first;
+  unsigned int nsectors;
+  off_t sector;
+  int ret;
+  int i;
+
+  if (fs->fs_fatcachedirty == 0)
+    {
+      return OK;
+    }
+
+  /* The clean sectors between the dirty ones are written too, they are
+   * the same as on the media.
+   */
+
+  first    = ffs(fs->fs_fatcachedirty) - 1;
+  nsectors = fls(fs->fs_fatcachedirty) - first;
+  sector   = fs->fs_fatcachesector + first;
+
+  for (i = 0; i < fs->fs_fatnumfats; i++, sector += fs->fs_nfatsects)
+    {
+      ret = fat_hwwrite(fs, fs->fs_fatcache + first * fs->fs_hwsectorsize,
+                        sector, nsectors);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  fs->fs_fatcachedirty = 0;
+#endif
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fat_fatcachefree
+ *
+ * Description:
+ *   Free the FAT table cache and the free cluster map of a mountpoint.
+ *   The dirty FAT sectors are discarded.
+ *
+ ****************************************************************************/
+
+void fat_fatcachefree(FAR struct fat_mountpt_s *fs)
+{
+#if CONFIG_FAT_FATCACHE_SECTORS > 0
+  if (fs->fs_fatcache != NULL)
+    {
+      fat_io_free(fs->fs_fatcache,
+                  CONFIG_FAT_FATCACHE_SECTORS * fs->fs_hwsectorsize);
+      fs->fs_fatcache = NULL;
+    }
+#endif
+
+#ifdef CONFIG_FAT_FREEMAP
+  if (fs->fs_freemap != NULL)
+    {
+      fs_heap_free(fs->fs_freemap);
+      fs->fs_freemap = NULL;
+    }
+#endif
+}
+
+#if CONFIG_FAT_EXTENTS > 0
+/****************************************************************************
+ * Name: fat_extentfind
+ *
+ * Description:
+ *   Look up a cluster of the chain of a file in its cluster runs.  The
+ *   runs map the leading clusters of the chain; if the cluster lies past
+ *   them, the last mapped cluster is returned as the place to continue
+ *   walking the FAT from.
+ *
+ * Input Parameters:
+ *   ff      - The open file
+ *   index   - The index of the cluster in the file
+ *   cluster - The cluster found
+ *
+ * Returned Value:
+ *   The number of clusters of the chain up to and including the cluster
+ *   found; zero if no cluster is mapped.
+ *
+ ****************************************************************************/
+
+uint32_t fat_extentfind(FAR struct fat_file_s *ff, uint32_t index,
+                        FAR uint32_t *cluster)
+{
+  FAR struct fat_extent_s *extent;
+  int low;
+  int high;
+
+  if (ff->ff_nmapped == 0)
+    {
+      return 0;
+    }
+
+  if (index >= ff->ff_nmapped)
+    {
+      extent   = &ff->ff_extents[ff->ff_nextents - 1];
+      *cluster = extent->fe_cluster + extent->fe_count - 1;
+      return ff->ff_nmapped;
+    }
+
+  /* Binary search of the run holding the cluster */
+
+  low  = 0;
+  high = ff->ff_nextents - 1;
+  while (low < high)
+    {
+      int mid = (low + high + 1) / 2;
+
+      if (ff->ff_extents[mid].fe_index <= index)
+        {
+          low = mid;
+        }
+      else
+        {
+          high = mid - 1;
+        }
+    }
+
+  extent   = &ff->ff_extents[low];
+  *cluster = extent->fe_cluster + index - extent->fe_index;
+  return index + 1;
+}
+
+/****************************************************************************
+ * Name: fat_extentadd
+ *
+ * Description:
+ *   Record the cluster at an index of the chain of a file.  Only the
+ *   cluster following the mapped ones is recorded, so that the runs
+ *   always map the leading clusters of the chain.  Mapping stops when all
+ *   run entries are used.
+ *
+ ****************************************************************************/
+
+void fat_extentadd(FAR struct fat_file_s *ff, uint32_t index,
+                   uint32_t cluster)
+{
+  FAR struct fat_extent_s *extent;
+
+  if (index != ff->ff_nmapped)
+    {
+      return;
+    }
+
+  /* Extend the last run if the cluster follows it on the media */
+
+  if (ff->ff_nextents > 0)
+    {
+      extent = &ff->ff_extents[ff->ff_nextents - 1];
+      if (extent->fe_cluster + extent->fe_count == cluster)
+        {
+          extent->fe_count++;
+          ff->ff_nmapped++;
+          return;
+        }
+    }
+
+  if (ff->ff_nextents < CONFIG_FAT_EXTENTS)
+    {
+      extent = &ff->ff_extents[ff->ff_nextents++];
+      extent->fe_index   = index;
+      extent->fe_cluster = cluster;
+      extent->fe_count   = 1;
+      ff->ff_nmapped++;
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: fat_ffcacheflush
  *
@@ -1988,9 +2393,14 @@ int fat_updatefsinfo(struct fat_mountpt_s *fs)
 {
   int ret;
 
-  /* Flush the fs_buffer if it is dirty */
+  /* Flush the FAT table cache and the fs_buffer if they are dirty */
+
+  ret = fat_fatcacheflush(fs);
+  if (ret == OK)
+    {
+      ret = fat_fscacheflush(fs);
+    }
 
-  ret = fat_fscacheflush(fs);
   if (ret == OK)
     {
       /* The FSINFO sector only has to be update for the case of a FAT32 file
@@ -2038,48 +2448,73 @@ int fat_computefreeclusters(struct fat_mountpt_s *fs)
   /* We have to count the number of free clusters */
 
   uint32_t nfreeclusters = 0;
+  uint32_t cluster;
+  bool     inuse;
+
+#ifdef CONFIG_FAT_FREEMAP
+  /* Rebuild the free cluster map while counting.  Clusters 0 and 1 do not
+   * exist and are never handed out.
+   */
+
+  if (fs->fs_freemap != NULL)
+    {
+      memset(fs->fs_freemap, 0,
+             howmany(fs->fs_nclusters + 2, 32) * sizeof(uint32_t));
+      fs->fs_freemap[0] = 3;
+    }
+#endif
+
   if (fs->fs_type == FSTYPE_FAT12)
     {
-      off_t sector;
+      off_t next;
 
       /* Examine every cluster in the fat */
 
-      for (sector = 2; sector < fs->fs_nclusters + 2; sector++)
+      for (cluster = 2; cluster < fs->fs_nclusters + 2; cluster++)
         {
-          /* If the cluster is unassigned, then increment the count of free
-           * clusters
-           */
+          next = fat_getcluster(fs, cluster);
+          if (next < 0)
+            {
+              return next;
+            }
 
-          if ((uint16_t)fat_getcluster(fs, sector) == 0)
+          inuse = (uint16_t)next != 0;
+          if (!inuse)
             {
               nfreeclusters++;
             }
+
+#ifdef CONFIG_FAT_FREEMAP
+          if (inuse && fs->fs_freemap != NULL)
+            {
+              fs->fs_freemap[cluster / 32] |= UINT32_C(1) << (cluster % 32);
+            }
+#endif
         }
     }
   else
     {
-      unsigned int cluster;
+      FAR uint8_t  *buffer = NULL;
       off_t        fatsector;
       unsigned int offset;
-      int          ret;
 
       fatsector    = fs->fs_fatbase;
       offset       = fs->fs_hwsectorsize;
 
-      /* Examine each cluster in the fat */
+      /* Examine each cluster in the fat.  The first two entries do not
+       * describe clusters.
+       */
 
-      for (cluster = fs->fs_nclusters; cluster > 0; cluster--)
+      for (cluster = 0; cluster < fs->fs_nclusters + 2; cluster++)
         {
-          /* If we are starting a new sector, then read the new sector in
-           * fs_buffer
-           */
+          /* If we are starting a new sector, then read the new sector */
 
           if (offset >= fs->fs_hwsectorsize)
             {
-              ret = fat_fscacheread(fs, fatsector);
-              if (ret < 0)
+              buffer = fat_fatcacheread(fs, fatsector, false);
+              if (buffer == NULL)
                 {
-                  return ret;
+                  return -EIO;
                 }
 
               /* Reset the offset to the next FAT entry.
@@ -2096,22 +2531,31 @@ int fat_computefreeclusters(struct fat_mountpt_s *fs)
 
           if (fs->fs_type == FSTYPE_FAT16)
             {
-              if (FAT_GETFAT16(fs->fs_buffer, offset) == 0)
-                {
-                  nfreeclusters++;
-                }
-
+              inuse   = FAT_GETFAT16(buffer, offset) != 0;
               offset += 2;
             }
           else
             {
-              if (FAT_GETFAT32(fs->fs_buffer, offset) == 0)
-                {
-                  nfreeclusters++;
-                }
-
+              inuse   = (FAT_GETFAT32(buffer, offset) & 0x0fffffff) != 0;
               offset += 4;
             }
+
+          if (cluster < 2)
+            {
+              continue;
+            }
+
+          if (!inuse)
+            {
+              nfreeclusters++;
+            }
+
+#ifdef CONFIG_FAT_FREEMAP
+          else if (fs->fs_freemap != NULL)
+            {
+              fs->fs_freemap[cluster / 32] |= UINT32_C(1) << (cluster % 32);
+            }
+#endif
         }
     }
 
@@ -42,8 +42,8 @@
 #include <nuttx/fs/ioctl.h>
 #include <nuttx/mutex.h>
 #include <nuttx/sched.h>
+#include <nuttx/seqlock.h>
 #include <nuttx/spawn.h>
-#include <nuttx/spinlock.h>
 #include <nuttx/lib/lib.h>
 
 #ifdef CONFIG_FDCHECK
@@ -54,35 +54,175 @@
 #include "inode/inode.h"
 #include "fs_heap.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Keep the reader counters of different CPUs in different cache lines */
+
+#define FDLIST_READER_ALIGN CONFIG_SMP_CACHE_BYTES
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_SMP
+struct fdlist_reader_s
+{
+  volatile uint32_t seq;  /* Odd while the CPU is looking up a descriptor */
+  uint8_t pad[FDLIST_READER_ALIGN - sizeof(uint32_t)];
+};
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Descriptor lookups do not take the list lock, so a reader may still use
+ * a file or a row array that a concurrent update has just unlinked.  Each
+ * CPU counts its way in and out of a lookup, and updates wait for the
+ * lookups in progress before they drop a file reference or free memory.
+ */
+
+#ifdef CONFIG_SMP
+static struct fdlist_reader_s g_fdlist_readers[CONFIG_SMP_NCPUS]
+  aligned_data(FDLIST_READER_ALIGN);
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: fdlist_read_enter/fdlist_read_leave
+ *
+ * Description:
+ *   Bracket a lockless lookup of a file descriptor list.  Interrupts stay
+ *   disabled in between so that the lookup cannot be preempted.
+ *
+ ****************************************************************************/
+
+static inline_function irqstate_t fdlist_read_enter(void)
+{
+  irqstate_t flags = up_irq_save();
+
+#ifdef CONFIG_SMP
+  g_fdlist_readers[this_cpu()].seq++;
+  SMP_MB();
+#endif
+
+  return flags;
+}
+
+static inline_function void fdlist_read_leave(irqstate_t flags)
+{
+#ifdef CONFIG_SMP
+  SMP_MB();
+  g_fdlist_readers[this_cpu()].seq++;
+#endif
+
+  up_irq_restore(flags);
+}
+
+/****************************************************************************
+ * Name: fdlist_sync
+ *
+ * Description:
+ *   Wait until the lookups running on other CPUs have finished.  After an
+ *   update has unlinked a file or a row array, no lookup started later can
+ *   find it, so once this returns the file reference may be dropped and
+ *   the memory freed.
+ *
+ ****************************************************************************/
+
+static void fdlist_sync(void)
+{
+#ifdef CONFIG_SMP
+  uint32_t seq;
+  int cpu;
+
+  SMP_MB();
+
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      seq = g_fdlist_readers[cpu].seq;
+      if ((seq & 1) != 0)
+        {
+          while (g_fdlist_readers[cpu].seq == seq)
+            {
+            }
+        }
+    }
+#endif
+}
+
 /****************************************************************************
  * Name: fdlist_get_by_index
+ *
+ * Description:
+ *   Look up a file descriptor and take a reference to its file without
+ *   taking the list lock.  The sequence count of the list is only used to
+ *   detect a concurrent update and retry.
+ *
+ * Returned Value:
+ *   Zero (OK) if the descriptor is within the list, -EBADF otherwise.  The
+ *   file returned is NULL if the descriptor is not open.
+ *
  ****************************************************************************/
 
-static void fdlist_get_by_index(FAR struct fdlist *list,
-                                int l1, int l2,
-                                FAR struct file **filep,
-                                FAR struct fd **fdp)
+static int fdlist_get_by_index(FAR struct fdlist *list,
+                               int l1, int l2,
+                               FAR struct file **filep,
+                               FAR struct fd **fdp)
 {
-  FAR struct fd *fdp1;
+  FAR struct fd *fdp1 = NULL;
+  FAR struct fd **fds;
   irqstate_t flags;
+  uint32_t seq;
+  int rows;
 
-  flags = spin_lock_irqsave_notrace(&list->fl_lock);
-  fdp1 = &list->fl_fds[l1][l2];
-  *filep = fdp1->f_file;
-  if (*filep != NULL)
+  *filep = NULL;
+  flags  = fdlist_read_enter();
+
+  /* Take a consistent snapshot of the row array and its size before
+   * indexing it: an update could be growing the array meanwhile.
+   */
+
+  do
     {
-      atomic_fetch_add(&(*filep)->f_refs, 1);
+      seq  = read_seqbegin(&list->fl_seq);
+      rows = list->fl_rows;
+      fds  = list->fl_fds;
     }
+  while (read_seqretry(&list->fl_seq, seq));
+
+  /* The rows of the snapshot cannot be freed before fdlist_read_leave(),
+   * nor the file, see fdlist_sync().
+   */
 
-  spin_unlock_irqrestore_notrace(&list->fl_lock, flags);
+  if (l1 < rows)
+    {
+      do
+        {
+          seq    = read_seqbegin(&list->fl_seq);
+          fdp1   = &fds[l1][l2];
+          *filep = fdp1->f_file;
+        }
+      while (read_seqretry(&list->fl_seq, seq));
+
+      if (*filep != NULL)
+        {
+          atomic_fetch_add(&(*filep)->f_refs, 1);
+        }
+    }
+
+  fdlist_read_leave(flags);
   if (fdp != NULL)
     {
       *fdp = fdp1;
     }
+
+  return fdp1 != NULL ? OK : -EBADF;
 }
 
 /****************************************************************************
@@ -94,7 +234,7 @@ static int fdlist_extend(FAR struct fdlist *list, size_t row)
   FAR struct fd **fds;
   uint8_t orig_rows;
   FAR void *tmp;
-  int flags;
+  irqstate_t flags;
   int i;
   int j;
 
@@ -135,7 +275,7 @@ static int fdlist_extend(FAR struct fdlist *list, size_t row)
     }
   while (++i < row);
 
-  flags = spin_lock_irqsave_notrace(&list->fl_lock);
+  flags = write_seqlock_irqsave(&list->fl_seq);
 
   /* To avoid race condition, if the file list is updated by other threads
    * and list rows is greater or equal than temp list,
@@ -144,7 +284,7 @@ static int fdlist_extend(FAR struct fdlist *list, size_t row)
 
   if (orig_rows != list->fl_rows && list->fl_rows >= row)
     {
-      spin_unlock_irqrestore_notrace(&list->fl_lock, flags);
+      write_sequnlock_irqrestore(&list->fl_seq, flags);
 
       for (j = orig_rows; j < i; j++)
         {
@@ -165,10 +305,11 @@ static int fdlist_extend(FAR struct fdlist *list, size_t row)
   list->fl_fds = fds;
   list->fl_rows = row;
 
-  spin_unlock_irqrestore_notrace(&list->fl_lock, flags);
+  write_sequnlock_irqrestore(&list->fl_seq, flags);
 
   if (tmp != NULL && tmp != &list->fl_prefd)
     {
+      fdlist_sync();
       fs_heap_free(tmp);
     }
 
@@ -184,7 +325,7 @@ static void fdlist_uninstall(FAR struct fdlist *list, FAR struct fd *fdp)
   FAR struct file *filep = NULL;
   irqstate_t flags;
 
-  flags = spin_lock_irqsave_notrace(&list->fl_lock);
+  flags = write_seqlock_irqsave(&list->fl_seq);
 
   if (fdp->f_file != NULL)
     {
@@ -198,8 +339,13 @@ static void fdlist_uninstall(FAR struct fdlist *list, FAR struct fd *fdp)
       fdp->f_file        = NULL;
     }
 
-  spin_unlock_irqrestore_notrace(&list->fl_lock, flags);
-  file_put(filep);
+  write_sequnlock_irqrestore(&list->fl_seq, flags);
+
+  if (filep != NULL)
+    {
+      fdlist_sync();
+      file_put(filep);
+    }
 }
 
 static void fdlist_install(FAR struct fdlist *list, int fd,
@@ -215,7 +361,7 @@ static void fdlist_install(FAR struct fdlist *list, int fd,
   l1 = fd / CONFIG_NFILE_DESCRIPTORS_PER_BLOCK;
   l2 = fd % CONFIG_NFILE_DESCRIPTORS_PER_BLOCK;
 
-  flags = spin_lock_irqsave_notrace(&list->fl_lock);
+  flags = write_seqlock_irqsave(&list->fl_seq);
 
   fdp1 = &list->fl_fds[l1][l2];
   filep1 = fdp1->f_file;
@@ -233,8 +379,13 @@ static void fdlist_install(FAR struct fdlist *list, int fd,
 #endif
     }
 
-  spin_unlock_irqrestore_notrace(&list->fl_lock, flags);
-  file_put(filep1);
+  write_sequnlock_irqrestore(&list->fl_seq, flags);
+
+  if (filep1 != NULL)
+    {
+      fdlist_sync();
+      file_put(filep1);
+    }
 }
 
 /****************************************************************************
@@ -366,7 +517,7 @@ void fdlist_init(FAR struct fdlist *list)
   list->fl_rows = 1;
   list->fl_fds = &list->fl_prefd;
   list->fl_prefd = list->fl_prefds;
-  spin_lock_init(&list->fl_lock);
+  seqlock_init(&list->fl_seq);
 }
 
 /****************************************************************************
@@ -533,16 +684,17 @@ int fdlist_get2(FAR struct fdlist *list, int fd,
   fd = fdcheck_restore(fd);
 #endif
 
-  if (fd < 0 || fd >= fdlist_count(list))
+  if (fd < 0)
     {
       return -EBADF;
     }
 
-  fdlist_get_by_index(list,
-                      fd / CONFIG_NFILE_DESCRIPTORS_PER_BLOCK,
-                      fd % CONFIG_NFILE_DESCRIPTORS_PER_BLOCK,
-                      filep, fdp);
-  if (*filep == NULL)
+  /* The descriptor is checked against the list size inside the lookup */
+
+  if (fdlist_get_by_index(list,
+                          fd / CONFIG_NFILE_DESCRIPTORS_PER_BLOCK,
+                          fd % CONFIG_NFILE_DESCRIPTORS_PER_BLOCK,
+                          filep, fdp) < 0 || *filep == NULL)
     {
       return -EBADF;
     }
@@ -583,13 +735,13 @@ int fdlist_dupfile(FAR struct fdlist *list, int oflags, int minfd,
 
   /* Find free file descriptor */
 
-  flags = spin_lock_irqsave_notrace(&list->fl_lock);
+  flags = write_seqlock_irqsave(&list->fl_seq);
 
   for (; ; i++, j = 0)
     {
       if (i >= list->fl_rows)
         {
-          spin_unlock_irqrestore_notrace(&list->fl_lock, flags);
+          write_sequnlock_irqrestore(&list->fl_seq, flags);
 
           ret = fdlist_extend(list, i + 1);
           if (ret < 0)
@@ -597,7 +749,7 @@ int fdlist_dupfile(FAR struct fdlist *list, int oflags, int minfd,
               return ret;
             }
 
-          flags = spin_lock_irqsave_notrace(&list->fl_lock);
+          flags = write_seqlock_irqsave(&list->fl_seq);
         }
 
       do
@@ -621,7 +773,7 @@ int fdlist_dupfile(FAR struct fdlist *list, int oflags, int minfd,
     }
 
 found:
-  spin_unlock_irqrestore_notrace(&list->fl_lock, flags);
+  write_sequnlock_irqrestore(&list->fl_seq, flags);
 
   FS_ADD_BACKTRACE(fdp);
 
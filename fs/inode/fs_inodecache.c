@@ -0,0 +1,265 @@
+/****************************************************************************
+ * fs/inode/fs_inodecache.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include <nuttx/fs/fs.h>
+#include <nuttx/seqlock.h>
+
+#include "inode/inode.h"
+
+#ifdef CONFIG_FS_INODE_CACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define INODE_CACHE_NENTRIES CONFIG_FS_INODE_CACHE_ENTRIES
+#define INODE_CACHE_PATHLEN  CONFIG_FS_INODE_CACHE_PATHLEN
+
+#if (INODE_CACHE_NENTRIES & (INODE_CACHE_NENTRIES - 1)) != 0
+#  error CONFIG_FS_INODE_CACHE_ENTRIES must be a power of two
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The result of one _inode_search() of a path.  Offsets are relative to
+ * the start of the path, a relpath offset of -1 stands for NULL.
+ */
+
+struct inode_cache_s
+{
+  seqcount_t        seq;      /* Lets lookups run without a lock */
+  uint32_t          gen;      /* Tree generation the entry is valid for */
+  uint32_t          hash;     /* Hash of the path */
+  FAR struct inode *node;     /* Search results */
+  FAR struct inode *peer;
+  FAR struct inode *parent;
+  int16_t           ret;      /* OK or -ENOENT */
+  uint16_t          nameoff;  /* Offset of desc->path */
+  int16_t           reloff;   /* Offset of desc->relpath */
+  char              path[INODE_CACHE_PATHLEN];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Searches run concurrently under the inode tree read lock: the entries
+ * are filled under their sequence counter, and lookups retry if an entry
+ * changed while they copied it.  Changes of the tree hold the write lock,
+ * so no search runs while the generation is bumped.
+ *
+ * The children of a directory are not indexed.  The peers of a node are
+ * kept sorted by name, so a lookup only walks the peers sorting before the
+ * name, and a per-directory index would have to be kept in sync by every
+ * place that builds or relinks struct inode.  Caching whole paths avoids
+ * the walk for the repeated open()/stat() of the same nodes instead.
+ */
+
+static struct inode_cache_s g_inode_cache[INODE_CACHE_NENTRIES];
+
+/* Bumped on every change of the inode tree; entries of older generations
+ * are stale.
+ */
+
+static uint32_t g_inode_cache_gen = 1;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: inode_cache_hash
+ *
+ * Description:
+ *   FNV-1a hash of a path.  Return the path length in 'len'.
+ *
+ ****************************************************************************/
+
+static uint32_t inode_cache_hash(FAR const char *path, FAR size_t *len)
+{
+  FAR const char *ptr = path;
+  uint32_t hash = 2166136261u;
+
+  while (*ptr != '\0')
+    {
+      hash ^= (uint8_t)*ptr++;
+      hash *= 16777619u;
+    }
+
+  *len = ptr - path;
+  return hash;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: inode_cache_lookup
+ *
+ * Description:
+ *   Look up the result of an earlier search of desc->path.
+ *
+ ****************************************************************************/
+
+bool inode_cache_lookup(FAR struct inode_search_s *desc, FAR int *ret)
+{
+  FAR struct inode_cache_s *entry;
+  FAR const char *path = desc->path;
+  struct inode_search_s result;
+  uint32_t hash;
+  uint32_t seq;
+  size_t len;
+  bool found;
+  int16_t sret;
+
+  hash = inode_cache_hash(path, &len);
+  if (len >= INODE_CACHE_PATHLEN)
+    {
+      return false;
+    }
+
+  entry = &g_inode_cache[hash & (INODE_CACHE_NENTRIES - 1)];
+
+  /* strcmp() stops at the end of 'path', which is shorter than the entry
+   * path buffer, even if the entry is being rewritten.
+   */
+
+  do
+    {
+      seq   = read_seqbegin(&entry->seq);
+      found = entry->gen == g_inode_cache_gen && entry->hash == hash &&
+              strcmp(entry->path, path) == 0;
+      if (found)
+        {
+          result.path    = path + entry->nameoff;
+          result.node    = entry->node;
+          result.peer    = entry->peer;
+          result.parent  = entry->parent;
+          result.relpath = entry->reloff < 0 ? NULL : path + entry->reloff;
+          sret           = entry->ret;
+        }
+    }
+  while (read_seqretry(&entry->seq, seq));
+
+  if (found)
+    {
+      desc->path    = result.path;
+      desc->node    = result.node;
+      desc->peer    = result.peer;
+      desc->parent  = result.parent;
+      desc->relpath = result.relpath;
+      *ret          = sret;
+    }
+
+  return found;
+}
+
+/****************************************************************************
+ * Name: inode_cache_add
+ *
+ * Description:
+ *   Remember the result of a search of 'path'.  desc->path and
+ *   desc->relpath must point into 'path'.
+ *
+ ****************************************************************************/
+
+void inode_cache_add(FAR const char *path,
+                     FAR const struct inode_search_s *desc, int ret)
+{
+  FAR struct inode_cache_s *entry;
+  irqstate_t flags;
+  uint32_t hash;
+  size_t len;
+
+  if (ret != OK && ret != -ENOENT)
+    {
+      return;
+    }
+
+  hash = inode_cache_hash(path, &len);
+  if (len >= INODE_CACHE_PATHLEN)
+    {
+      return;
+    }
+
+  DEBUGASSERT(desc->path >= path && desc->path <= path + len);
+  DEBUGASSERT(desc->relpath == NULL ||
+              (desc->relpath >= path && desc->relpath <= path + len));
+
+  entry = &g_inode_cache[hash & (INODE_CACHE_NENTRIES - 1)];
+
+  flags = write_seqlock_irqsave(&entry->seq);
+  entry->gen     = g_inode_cache_gen;
+  entry->hash    = hash;
+  entry->node    = desc->node;
+  entry->peer    = desc->peer;
+  entry->parent  = desc->parent;
+  entry->ret     = ret;
+  entry->nameoff = desc->path - path;
+  entry->reloff  = desc->relpath == NULL ? -1 : desc->relpath - path;
+  memcpy(entry->path, path, len + 1);
+  write_sequnlock_irqrestore(&entry->seq, flags);
+}
+
+/****************************************************************************
+ * Name: inode_cache_invalidate
+ *
+ * Description:
+ *   Forget all cached search results.  Called whenever the shape of the
+ *   inode tree or the type of a node changes.
+ *
+ * Assumptions:
+ *   The caller holds the inode tree write lock.
+ *
+ ****************************************************************************/
+
+void inode_cache_invalidate(void)
+{
+  int i;
+
+  if (++g_inode_cache_gen == 0)
+    {
+      /* Wrapped around, make sure that no old entry can match again */
+
+      for (i = 0; i < INODE_CACHE_NENTRIES; i++)
+        {
+          g_inode_cache[i].gen = 0;
+        }
+
+      g_inode_cache_gen = 1;
+    }
+}
+
+#endif /* CONFIG_FS_INODE_CACHE */
@@ -33,6 +33,7 @@
 #include <nuttx/fs/fs.h>
 
 #include "inode/inode.h"
+#include "vfs/vfs.h"
 #include "fs_heap.h"
 
 /****************************************************************************
@@ -76,6 +77,7 @@ void inode_free(FAR struct inode *inode)
         }
 #endif
 
+      file_readahead_release(inode);
       fs_heap_free(inode);
     }
 }
@@ -221,6 +221,9 @@ static int _inode_search(FAR struct inode_search_s *desc)
   FAR struct inode *left    = NULL;
   FAR struct inode *above   = NULL;
   FAR const char   *relpath = NULL;
+#ifdef CONFIG_FS_INODE_CACHE
+  bool              cache   = true;
+#endif
   int ret = -ENOENT;
 
   /* Get the search path, skipping over the leading '/'.  The leading '/' is
@@ -235,6 +238,17 @@ static int _inode_search(FAR struct inode_search_s *desc)
       return -EINVAL;
     }
 
+#ifdef CONFIG_FS_INODE_CACHE
+  /* Use the result of an earlier search of the same path if the tree has
+   * not changed since.
+   */
+
+  if (inode_cache_lookup(desc, &ret))
+    {
+      return ret;
+    }
+#endif
+
   /* Traverse the pseudo file system node tree until either (1) all nodes
    * have been examined without finding the matching node, or (2) the
    * matching node is found.
@@ -306,6 +320,12 @@ static int _inode_search(FAR struct inode_search_s *desc)
                 {
                   int status;
 
+#ifdef CONFIG_FS_INODE_CACHE
+                  /* The results would point into the link target */
+
+                  cache = false;
+#endif
+
                   /* If this intermediate inode in the is a soft link, then
                    * (1) recursively look-up the inode referenced by the
                    * soft link, and (2) continue searching with that inode
@@ -407,6 +427,21 @@ static int _inode_search(FAR struct inode_search_s *desc)
    *   (4) When the node matching the full path is found
    */
 
+#ifdef CONFIG_FS_INODE_CACHE
+  if (cache)
+    {
+      FAR const char *path = desc->path;
+
+      desc->path    = name;
+      desc->node    = inode;
+      desc->peer    = left;
+      desc->parent  = above;
+      desc->relpath = relpath;
+      inode_cache_add(path, desc, ret);
+      return ret;
+    }
+#endif
+
   desc->path    = name;
   desc->node    = inode;
   desc->peer    = left;
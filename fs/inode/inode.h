@@ -423,6 +423,27 @@ void inode_addref(FAR struct inode *inode);
 
 void inode_release(FAR struct inode *inode);
 
+/****************************************************************************
+ * Name: inode_cache_lookup/inode_cache_add/inode_cache_invalidate
+ *
+ * Description:
+ *   A cache of the results of full path searches of the inode tree.
+ *   inode_cache_lookup() fills in 'desc' and the search result 'ret' and
+ *   returns true if the path is cached.  inode_cache_invalidate() must be
+ *   called with the inode tree write locked whenever a node is added,
+ *   removed or changes its type.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_INODE_CACHE
+bool inode_cache_lookup(FAR struct inode_search_s *desc, FAR int *ret);
+void inode_cache_add(FAR const char *path,
+                     FAR const struct inode_search_s *desc, int ret);
+void inode_cache_invalidate(void);
+#else
+#  define inode_cache_invalidate()
+#endif
+
 /* Caller already holds the inode tree lock (inode_lock/inode_rlock). */
 
 #define INODE_CHECK_LOCKED  (1 << 0)
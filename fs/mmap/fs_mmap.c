@@ -38,6 +38,7 @@
 #include <nuttx/fs/fs.h>
 
 #include "inode/inode.h"
+#include "vfs/vfs.h"
 #include "fs_rammap.h"
 
 /****************************************************************************
@@ -151,6 +152,16 @@ static int file_mmap_(FAR struct file *filep, FAR void *start,
       return -EACCES;
     }
 
+  /* The mapping must see the data still written behind */
+
+  ret = file_readahead_sync(filep);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = -ENOTTY;
+
   /* Call driver's mmap to get the base address of the file in 'mapped'
    * in memory.
    */
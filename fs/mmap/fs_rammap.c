@@ -27,6 +27,7 @@
 #include <nuttx/config.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 
 #include <assert.h>
 #include <nuttx/debug.h>
@@ -250,6 +251,19 @@ int rammap(FAR struct file *filep, FAR struct mm_map_entry_s *entry,
       goto out;
     }
 
+#ifdef CONFIG_FS_RAMMAP_SHARED
+  /* Shared mappings of the same file share one RAM copy of it */
+
+  if ((entry->flags & MAP_SHARED) != 0)
+    {
+      ret = sharedmap(filep, entry, type);
+      if (ret != -ENOTTY)
+        {
+          return ret;
+        }
+    }
+#endif
+
   /* There is a major design flaw that I have not yet thought of fix for:
    * The goal is to have a single region of memory that represents a single
    * file and can be shared by many threads.  That is, given a filename a
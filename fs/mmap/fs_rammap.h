@@ -99,6 +99,33 @@ enum mm_map_type_e
 
 int rammap(FAR struct file *filep, FAR struct mm_map_entry_s *entry,
            enum mm_map_type_e type);
+
+#ifdef CONFIG_FS_RAMMAP_SHARED
+
+/****************************************************************************
+ * Name: sharedmap
+ *
+ * Description:
+ *   Map a range of a file for MAP_SHARED.  All shared mappings of a file
+ *   use the same RAM copy of the whole file, so stores through one mapping
+ *   are seen through all the others.  msync() and the last munmap() write
+ *   the copy back.
+ *
+ * Input Parameters:
+ *   filep   file descriptor of the backing file -- required.
+ *   entry   mmap entry information.
+ *   type    fs_heap_zalloc or kumm_zalloc
+ *
+ * Returned Value:
+ *   Zero on success; -ENOTTY if the file cannot be identified and should
+ *   be mapped by rammap; -ENOMEM if the mapping extends beyond the copy
+ *   already mapped; other negated errno values on failure.
+ *
+ ****************************************************************************/
+
+int sharedmap(FAR struct file *filep, FAR struct mm_map_entry_s *entry,
+              enum mm_map_type_e type);
+#endif
 #else
 #  define rammap(file, entry, type) (-ENOSYS)
 #endif /* CONFIG_FS_RAMMAP */
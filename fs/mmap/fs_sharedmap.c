@@ -0,0 +1,592 @@
+/****************************************************************************
+ * fs/mmap/fs_sharedmap.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <nuttx/debug.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/mutex.h>
+#include <nuttx/nuttx.h>
+#include <nuttx/queue.h>
+#include <nuttx/sched.h>
+
+#include "fs_rammap.h"
+#include "sched/sched.h"
+#include "fs_heap.h"
+
+#ifdef CONFIG_FS_RAMMAP_SHARED
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_RAMMAP_SHARED_SHADOW
+#  define SHAREDMAP_PAGESIZE CONFIG_FS_RAMMAP_SHARED_PAGESIZE
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The RAM copy of a file shared by all of its MAP_SHARED mappings.  The
+ * copy starts at the beginning of the file and covers the whole file as it
+ * was when first mapped, so that every later mapping of the file falls in
+ * it: mapped memory cannot be moved or grown.
+ */
+
+struct sharedmap_s
+{
+  dq_entry_t          node;     /* Link in g_sharedmaps */
+  mutex_t             lock;     /* Serializes the write back and filep */
+  FAR struct inode   *inode;    /* Inode of the file or of its mountpoint */
+  ino_t               ino;      /* Serial number of the file on a mountpoint */
+  FAR struct file    *filep;    /* File used to write the data back */
+  enum mm_map_type_e  type;     /* Where data is allocated from */
+  size_t              length;   /* Length of the copy */
+  size_t              filesize; /* Part of the copy backed by the file */
+  unsigned int        refs;     /* Number of mappings of the copy */
+  FAR uint8_t        *data;     /* The copy */
+#ifdef CONFIG_FS_RAMMAP_SHARED_SHADOW
+  FAR uint8_t        *shadow;   /* The file data as last synchronized */
+#endif
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static mutex_t g_sharedmap_lock = NXMUTEX_INITIALIZER;
+static dq_queue_t g_sharedmaps;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sharedmap_writable
+ ****************************************************************************/
+
+static bool sharedmap_writable(FAR struct file *filep)
+{
+  return (filep->f_oflags & O_ACCMODE) != O_RDONLY;
+}
+
+/****************************************************************************
+ * Name: sharedmap_free
+ ****************************************************************************/
+
+static void sharedmap_free(FAR struct sharedmap_s *map)
+{
+  if (map->type == MAP_KERNEL)
+    {
+      fs_heap_free(map->data);
+    }
+  else
+    {
+      kumm_free(map->data);
+    }
+
+#ifdef CONFIG_FS_RAMMAP_SHARED_SHADOW
+  fs_heap_free(map->shadow);
+#endif
+  nxmutex_destroy(&map->lock);
+  fs_heap_free(map);
+}
+
+/****************************************************************************
+ * Name: sharedmap_load
+ *
+ * Description:
+ *   Read the file into the copy and zero the part beyond the end of the
+ *   file.
+ *
+ ****************************************************************************/
+
+static int sharedmap_load(FAR struct sharedmap_s *map)
+{
+  size_t pos = 0;
+  ssize_t nread;
+
+  while (pos < map->filesize)
+    {
+      nread = file_pread(map->filep, map->data + pos, map->filesize - pos,
+                         pos);
+      if (nread < 0)
+        {
+          if (nread == -EINTR)
+            {
+              continue;
+            }
+
+          ferr("ERROR: Read failed: offset=%zu ret=%zd\n", pos, nread);
+          return nread;
+        }
+      else if (nread == 0)
+        {
+          break;
+        }
+
+      pos += nread;
+    }
+
+  map->filesize = pos;
+  memset(map->data + pos, 0, map->length - pos);
+
+#ifdef CONFIG_FS_RAMMAP_SHARED_SHADOW
+  memcpy(map->shadow, map->data, map->filesize);
+#endif
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sharedmap_write
+ *
+ * Description:
+ *   Write a part of the copy to the file.
+ *
+ ****************************************************************************/
+
+static int sharedmap_write(FAR struct sharedmap_s *map, size_t pos,
+                           size_t len)
+{
+  ssize_t nwritten;
+  size_t n;
+
+  for (n = 0; n < len; n += nwritten)
+    {
+      nwritten = file_pwrite(map->filep, map->data + pos + n, len - n,
+                             pos + n);
+      if (nwritten == -EINTR)
+        {
+          nwritten = 0;
+        }
+      else if (nwritten <= 0)
+        {
+          ferr("ERROR: Write failed: offset=%zu ret=%zd\n",
+               pos + n, nwritten);
+          return nwritten < 0 ? nwritten : -EIO;
+        }
+    }
+
+#ifdef CONFIG_FS_RAMMAP_SHARED_SHADOW
+  memcpy(map->shadow + pos, map->data + pos, len);
+#endif
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: sharedmap_writeback
+ *
+ * Description:
+ *   Write a range of the copy back to the file.  Only the part backed by
+ *   the file is written: stores beyond its end are not kept.  With a
+ *   shadow copy, only the pages that differ from it are written; without
+ *   one, stores cannot be detected and the whole range is written.
+ *
+ ****************************************************************************/
+
+static int sharedmap_writeback(FAR struct sharedmap_s *map, size_t start,
+                               size_t length)
+{
+  size_t end = MIN(start + length, map->filesize);
+#ifdef CONFIG_FS_RAMMAP_SHARED_SHADOW
+  size_t pos;
+  size_t len;
+  int ret;
+#endif
+
+  if (!sharedmap_writable(map->filep) || start >= end)
+    {
+      return OK;
+    }
+
+#ifdef CONFIG_FS_RAMMAP_SHARED_SHADOW
+  for (start = ALIGN_DOWN(start, SHAREDMAP_PAGESIZE); start < end;
+       start = pos + len)
+    {
+      /* Find the next run of modified pages */
+
+      for (pos = start; pos < end; pos += SHAREDMAP_PAGESIZE)
+        {
+          len = MIN(SHAREDMAP_PAGESIZE, end - pos);
+          if (memcmp(map->data + pos, map->shadow + pos, len) != 0)
+            {
+              break;
+            }
+        }
+
+      for (len = 0; pos + len < end; len += SHAREDMAP_PAGESIZE)
+        {
+          size_t n = MIN(SHAREDMAP_PAGESIZE, end - pos - len);
+
+          if (memcmp(map->data + pos + len, map->shadow + pos + len,
+                     n) == 0)
+            {
+              break;
+            }
+        }
+
+      len = MIN(len, end - pos);
+      if (len > 0)
+        {
+          ret = sharedmap_write(map, pos, len);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+    }
+
+  return OK;
+#else
+  return sharedmap_write(map, start, end - start);
+#endif
+}
+
+/****************************************************************************
+ * Name: sharedmap_put
+ *
+ * Description:
+ *   Drop a reference to a shared copy.  The last reference writes the
+ *   copy back and frees it.  The copy stays findable, and a new mapping of
+ *   the file waits, until the write back is done: otherwise the new
+ *   mapping could read the file before the last stores reach it.
+ *
+ ****************************************************************************/
+
+static int sharedmap_put(FAR struct sharedmap_s *map)
+{
+  int ret = OK;
+
+  nxmutex_lock(&g_sharedmap_lock);
+  if (--map->refs > 0)
+    {
+      nxmutex_unlock(&g_sharedmap_lock);
+      return OK;
+    }
+
+  nxmutex_lock(&map->lock);
+  ret = sharedmap_writeback(map, 0, map->length);
+  nxmutex_unlock(&map->lock);
+
+  dq_rem(&map->node, &g_sharedmaps);
+  nxmutex_unlock(&g_sharedmap_lock);
+
+  file_put(map->filep);
+  sharedmap_free(map);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: msync_sharedmap
+ ****************************************************************************/
+
+static int msync_sharedmap(FAR struct mm_map_entry_s *entry,
+                           FAR void *start, size_t length, int flags)
+{
+  FAR struct sharedmap_s *map = entry->priv.p;
+  size_t offset;
+  int ret;
+
+  offset = (uintptr_t)start - (uintptr_t)map->data;
+  if (offset >= map->length)
+    {
+      return -EINVAL;
+    }
+
+  if (length > map->length - offset)
+    {
+      length = map->length - offset;
+    }
+
+  ret = nxmutex_lock(&map->lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = sharedmap_writeback(map, offset, length);
+  nxmutex_unlock(&map->lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: unmap_sharedmap
+ ****************************************************************************/
+
+static int unmap_sharedmap(FAR struct task_group_s *group,
+                           FAR struct mm_map_entry_s *entry,
+                           FAR void *start, size_t length)
+{
+  FAR struct sharedmap_s *map = entry->priv.p;
+  off_t offset;
+  int ret;
+
+  /* As with rammap, the mapping can only be shortened from its end */
+
+  offset = (uintptr_t)start - (uintptr_t)entry->vaddr;
+  if (offset + length < entry->length)
+    {
+      ferr("ERROR: Cannot umap without unmapping to the end\n");
+      return -ENOSYS;
+    }
+
+  if (offset > 0)
+    {
+      entry->length = offset;
+      return OK;
+    }
+
+  ret = mm_map_remove(get_group_mm(group), entry);
+  if (ret >= 0)
+    {
+      ret = sharedmap_put(map);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: sharedmap_find
+ *
+ * Description:
+ *   Find the shared copy of a file.
+ *
+ ****************************************************************************/
+
+static FAR struct sharedmap_s *sharedmap_find(FAR struct inode *inode,
+                                              ino_t ino)
+{
+  FAR dq_entry_t *node;
+
+  dq_for_every(&g_sharedmaps, node)
+    {
+      FAR struct sharedmap_s *map =
+        container_of(node, struct sharedmap_s, node);
+
+      if (map->inode == inode && map->ino == ino)
+        {
+          return map;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: sharedmap_create
+ *
+ * Description:
+ *   Read a file into a new shared copy of 'length' bytes.
+ *
+ ****************************************************************************/
+
+static int sharedmap_create(FAR struct file *filep, ino_t ino,
+                            size_t filesize, size_t length,
+                            enum mm_map_type_e type,
+                            FAR struct sharedmap_s **mapp)
+{
+  FAR struct sharedmap_s *map;
+  int ret;
+
+  map = fs_heap_zalloc(sizeof(struct sharedmap_s));
+  if (map == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  map->inode    = filep->f_inode;
+  map->ino      = ino;
+  map->filep    = filep;
+  map->type     = type;
+  map->length   = length;
+  map->filesize = filesize;
+  map->refs     = 1;
+  nxmutex_init(&map->lock);
+  map->data     = type == MAP_KERNEL ? fs_heap_malloc(length)
+                                     : kumm_malloc(length);
+#ifdef CONFIG_FS_RAMMAP_SHARED_SHADOW
+  map->shadow   = fs_heap_malloc(MAX(filesize, 1));
+  if (map->shadow == NULL)
+    {
+      sharedmap_free(map);
+      return -ENOMEM;
+    }
+#endif
+
+  if (map->data == NULL)
+    {
+      ferr("ERROR: Region allocation failed, length: %zu\n", length);
+      sharedmap_free(map);
+      return -ENOMEM;
+    }
+
+  ret = sharedmap_load(map);
+  if (ret < 0)
+    {
+      sharedmap_free(map);
+      return ret;
+    }
+
+  file_ref(filep);
+  dq_addlast(&map->node, &g_sharedmaps);
+  *mapp = map;
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sharedmap
+ *
+ * Description:
+ *   Map a range of a file so that all MAP_SHARED mappings of the file
+ *   share the same memory.  See fs_rammap.h.
+ *
+ ****************************************************************************/
+
+int sharedmap(FAR struct file *filep, FAR struct mm_map_entry_s *entry,
+              enum mm_map_type_e type)
+{
+  FAR struct sharedmap_s *map;
+  struct stat buf;
+  size_t end;
+  int ret;
+
+  if (type == MAP_XIP || entry->offset < 0)
+    {
+      return -ENOTTY;
+    }
+
+  /* A file on a mountpoint is only known by the serial number that the
+   * file system reports.  Files without one are mapped privately.
+   */
+
+  ret = file_fstat(filep, &buf);
+  if (ret < 0)
+    {
+      return -ENOTTY;
+    }
+
+  if (!INODE_IS_MOUNTPT(filep->f_inode))
+    {
+      buf.st_ino = 0;
+    }
+  else if (buf.st_ino == 0)
+    {
+      return -ENOTTY;
+    }
+
+  ret = nxmutex_lock(&g_sharedmap_lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  end = entry->offset + entry->length;
+  map = sharedmap_find(filep->f_inode, buf.st_ino);
+  if (map != NULL)
+    {
+      /* The copy cannot be moved or grown while it is mapped, and memory
+       * from the kernel heap cannot be handed to user space in protected
+       * builds.
+       */
+
+      if (end > map->length)
+        {
+          ferr("ERROR: Mapping ends beyond the shared copy: %zu > %zu\n",
+               end, map->length);
+          ret = -ENOMEM;
+          goto errout_with_lock;
+        }
+
+#ifndef CONFIG_BUILD_FLAT
+      if (map->type == MAP_KERNEL && type != MAP_KERNEL)
+        {
+          ret = -EACCES;
+          goto errout_with_lock;
+        }
+#endif
+
+      map->refs++;
+
+      /* Keep a writable file to write the copy back through */
+
+      if (!sharedmap_writable(map->filep) && sharedmap_writable(filep))
+        {
+          nxmutex_lock(&map->lock);
+          file_ref(filep);
+          file_put(map->filep);
+          map->filep = filep;
+          nxmutex_unlock(&map->lock);
+        }
+    }
+  else
+    {
+      ret = sharedmap_create(filep, buf.st_ino, buf.st_size,
+                             MAX(end, (size_t)buf.st_size), type, &map);
+      if (ret < 0)
+        {
+          goto errout_with_lock;
+        }
+    }
+
+  nxmutex_unlock(&g_sharedmap_lock);
+
+  entry->vaddr  = map->data + entry->offset;
+  entry->priv.p = map;
+  entry->munmap = unmap_sharedmap;
+  entry->msync  = msync_sharedmap;
+
+  ret = mm_map_add(get_current_mm(), entry);
+  if (ret < 0)
+    {
+      sharedmap_put(map);
+    }
+
+  return ret;
+
+errout_with_lock:
+  nxmutex_unlock(&g_sharedmap_lock);
+  return ret;
+}
+
+#endif /* CONFIG_FS_RAMMAP_SHARED */
@@ -500,6 +500,7 @@ int nx_mount(FAR const char *source, FAR const char *target,
   /* We have it, now populate it with driver specific information. */
 
   INODE_SET_MOUNTPT(mountpt_inode);
+  inode_cache_invalidate();
 
   mountpt_inode->u.i_mops  = mops;
   mountpt_inode->i_private = fshandle;
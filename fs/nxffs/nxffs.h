@@ -38,6 +38,7 @@
 #include <nuttx/fs/nxffs.h>
 #include <nuttx/mutex.h>
 #include <nuttx/semaphore.h>
+#include <nuttx/wqueue.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -226,6 +227,19 @@ struct nxffs_entry_s
   uint32_t                  datlen;    /* Length of inode data */
 };
 
+/* One slot of the in-memory inode index.  The index maps the hash of the
+ * name of each valid inode to the FLASH offset of its header; a free slot
+ * has a zero offset (there is always a block header at offset zero).
+ */
+
+#ifdef CONFIG_NXFFS_INDEX
+struct nxffs_index_s
+{
+  uint32_t                  hash;      /* CRC32 of the inode name */
+  off_t                     hoffset;   /* FLASH offset to the inode header */
+};
+#endif
+
 /* This structure describes int in-memory representation of the data block */
 
 struct nxffs_blkentry_s
@@ -281,6 +295,15 @@ struct nxffs_volume_s
   FAR struct nxffs_ofile_s *ofiles;    /* A singly-linked list of open files */
   FAR uint8_t              *cache;     /* On cached erase block for general I/O */
   FAR uint8_t              *pack;      /* A full erase block to support packing */
+#ifdef CONFIG_NXFFS_INDEX
+  FAR struct nxffs_index_s *index;     /* Valid inodes by name hash */
+  uint32_t                  isize;     /* Slots in the index, a power of 2 */
+  uint32_t                  icount;    /* Slots in use */
+  bool                      ivalid;    /* The index holds all valid inodes */
+#endif
+#ifdef CONFIG_NXFFS_BGPACK
+  struct work_s             bgwork;    /* Background packing */
+#endif
 };
 
 /* This structure describes the state of the blocks on the NXFFS volume */
@@ -595,6 +618,29 @@ void nxffs_freeentry(FAR struct nxffs_entry_s *entry);
 int nxffs_nextentry(FAR struct nxffs_volume_s *volume, off_t offset,
                     FAR struct nxffs_entry_s *entry);
 
+/****************************************************************************
+ * Name: nxffs_rdinode
+ *
+ * Description:
+ *   Read the valid inode whose header is at the provided FLASH offset.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume.
+ *   offset - The FLASH offset of the inode header.
+ *   entry  - A pointer to memory provided by the caller in which to return
+ *     the inode description.
+ *
+ * Returned Value:
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure.
+ *
+ * Defined in nxffs_inode.c
+ *
+ ****************************************************************************/
+
+int nxffs_rdinode(FAR struct nxffs_volume_s *volume, off_t offset,
+                  FAR struct nxffs_entry_s *entry);
+
 /****************************************************************************
  * Name: nxffs_findinode
  *
@@ -1062,6 +1108,103 @@ int nxffs_rminode(FAR struct nxffs_volume_s *volume, FAR const char *name);
 
 int nxffs_pack(FAR struct nxffs_volume_s *volume);
 
+/****************************************************************************
+ * Name: nxffs_bgpack
+ *
+ * Description:
+ *   Called after an inode was deleted.  If little FLASH is left free at the
+ *   end of the volume, schedule a pack on the low priority work queue so
+ *   that a later write does not have to wait for it.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed.
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_pack.c
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_BGPACK
+void nxffs_bgpack(FAR struct nxffs_volume_s *volume);
+#endif
+
+/****************************************************************************
+ * Name: nxffs_index_free, nxffs_index_reset
+ *
+ * Description:
+ *   Drop the in-memory inode index, so that inodes are found by scanning
+ *   the volume, or start a new empty index before the volume is scanned or
+ *   after it was reformatted.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume.
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_INDEX
+void nxffs_index_free(FAR struct nxffs_volume_s *volume);
+void nxffs_index_reset(FAR struct nxffs_volume_s *volume);
+
+/****************************************************************************
+ * Name: nxffs_index_insert, nxffs_index_remove, nxffs_index_move
+ *
+ * Description:
+ *   Keep the index up to date when an inode header is written, when an
+ *   inode is deleted and when the packing logic moves an inode header.  If
+ *   the index cannot be kept up to date (no memory), it is dropped and
+ *   nxffs_findinode() scans the volume again.
+ *
+ * Input Parameters:
+ *   volume  - Describes the NXFFS volume.
+ *   name    - The name of the inode.
+ *   hoffset - FLASH offset to the inode header.
+ *   from/to - Old and new FLASH offsets to the inode header.
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+void nxffs_index_insert(FAR struct nxffs_volume_s *volume,
+                        FAR const char *name, off_t hoffset);
+void nxffs_index_remove(FAR struct nxffs_volume_s *volume,
+                        FAR const char *name, off_t hoffset);
+void nxffs_index_move(FAR struct nxffs_volume_s *volume,
+                      FAR const char *name, off_t from, off_t to);
+
+/****************************************************************************
+ * Name: nxffs_index_find
+ *
+ * Description:
+ *   Find an inode by name with the index.  Only the inode headers with the
+ *   same name hash are read.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   name   - The name of the inode to find
+ *   entry  - The location to return information about the inode.
+ *
+ * Returned Value:
+ *   Zero is returned on success, -ENOENT if there is no such inode and
+ *   -ENOSYS if the index is not usable.
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+int nxffs_index_find(FAR struct nxffs_volume_s *volume,
+                     FAR const char *name, FAR struct nxffs_entry_s *entry);
+#endif
+
 /****************************************************************************
  * Standard mountpoint operation methods
  *
@@ -0,0 +1,367 @@
+/****************************************************************************
+ * fs/nxffs/nxffs_index.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <nuttx/debug.h>
+
+#include <nuttx/crc32.h>
+
+#include "nxffs.h"
+#include "fs_heap.h"
+
+#ifdef CONFIG_NXFFS_INDEX
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_namehash
+ *
+ * Description:
+ *   Return the hash of an inode name.
+ *
+ ****************************************************************************/
+
+static uint32_t nxffs_namehash(FAR const char *name)
+{
+  return crc32((FAR const uint8_t *)name, strlen(name));
+}
+
+/****************************************************************************
+ * Name: nxffs_index_put
+ *
+ * Description:
+ *   Add an entry to a table that has at least one free slot.
+ *
+ ****************************************************************************/
+
+static void nxffs_index_put(FAR struct nxffs_index_s *index, uint32_t size,
+                            uint32_t hash, off_t hoffset)
+{
+  uint32_t mask = size - 1;
+  uint32_t slot = hash & mask;
+
+  while (index[slot].hoffset != 0)
+    {
+      slot = (slot + 1) & mask;
+    }
+
+  index[slot].hash    = hash;
+  index[slot].hoffset = hoffset;
+}
+
+/****************************************************************************
+ * Name: nxffs_index_slot
+ *
+ * Description:
+ *   Return the slot of the inode header at 'hoffset', or -ENOENT.
+ *
+ ****************************************************************************/
+
+static int nxffs_index_slot(FAR struct nxffs_volume_s *volume,
+                            uint32_t hash, off_t hoffset)
+{
+  uint32_t mask = volume->isize - 1;
+  uint32_t slot;
+
+  if (volume->index == NULL)
+    {
+      return -ENOENT;
+    }
+
+  for (slot = hash & mask; volume->index[slot].hoffset != 0;
+       slot = (slot + 1) & mask)
+    {
+      if (volume->index[slot].hash == hash &&
+          volume->index[slot].hoffset == hoffset)
+        {
+          return slot;
+        }
+    }
+
+  return -ENOENT;
+}
+
+/****************************************************************************
+ * Name: nxffs_index_grow
+ *
+ * Description:
+ *   Double the size of the table.
+ *
+ ****************************************************************************/
+
+static int nxffs_index_grow(FAR struct nxffs_volume_s *volume)
+{
+  FAR struct nxffs_index_s *index;
+  uint32_t size;
+  uint32_t i;
+
+  size = volume->isize ? volume->isize << 1 : CONFIG_NXFFS_INDEX_SIZE;
+  DEBUGASSERT((size & (size - 1)) == 0);
+
+  index = fs_heap_zalloc(size * sizeof(struct nxffs_index_s));
+  if (index == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  for (i = 0; i < volume->isize; i++)
+    {
+      if (volume->index[i].hoffset != 0)
+        {
+          nxffs_index_put(index, size, volume->index[i].hash,
+                          volume->index[i].hoffset);
+        }
+    }
+
+  fs_heap_free(volume->index);
+  volume->index = index;
+  volume->isize = size;
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_index_free
+ *
+ * Description:
+ *   Drop the inode index.  Inodes are found by scanning the volume until
+ *   the index is rebuilt at the next mount or reformat.
+ *
+ ****************************************************************************/
+
+void nxffs_index_free(FAR struct nxffs_volume_s *volume)
+{
+  fs_heap_free(volume->index);
+  volume->index  = NULL;
+  volume->isize  = 0;
+  volume->icount = 0;
+  volume->ivalid = false;
+}
+
+/****************************************************************************
+ * Name: nxffs_index_reset
+ *
+ * Description:
+ *   Start a new, empty index: the volume has no valid inodes or is about to
+ *   be scanned.
+ *
+ ****************************************************************************/
+
+void nxffs_index_reset(FAR struct nxffs_volume_s *volume)
+{
+  nxffs_index_free(volume);
+  volume->ivalid = true;
+}
+
+/****************************************************************************
+ * Name: nxffs_index_insert
+ *
+ * Description:
+ *   Add the valid inode 'name' with the header at 'hoffset'.
+ *
+ ****************************************************************************/
+
+void nxffs_index_insert(FAR struct nxffs_volume_s *volume,
+                        FAR const char *name, off_t hoffset)
+{
+  int ret;
+
+  if (!volume->ivalid)
+    {
+      return;
+    }
+
+  /* Keep the table at most three quarters full */
+
+  if ((volume->icount + 1) * 4 > volume->isize * 3)
+    {
+      ret = nxffs_index_grow(volume);
+      if (ret < 0)
+        {
+          ferr("ERROR: Failed to grow the inode index: %d\n", -ret);
+          nxffs_index_free(volume);
+          return;
+        }
+    }
+
+  nxffs_index_put(volume->index, volume->isize, nxffs_namehash(name),
+                  hoffset);
+  volume->icount++;
+}
+
+/****************************************************************************
+ * Name: nxffs_index_remove
+ *
+ * Description:
+ *   Remove the inode 'name' with the header at 'hoffset'.
+ *
+ ****************************************************************************/
+
+void nxffs_index_remove(FAR struct nxffs_volume_s *volume,
+                        FAR const char *name, off_t hoffset)
+{
+  FAR struct nxffs_index_s *index = volume->index;
+  uint32_t mask = volume->isize - 1;
+  uint32_t hole;
+  uint32_t slot;
+  uint32_t home;
+  int ret;
+
+  ret = nxffs_index_slot(volume, nxffs_namehash(name), hoffset);
+  if (ret < 0)
+    {
+      return;
+    }
+
+  /* Close the hole by moving back the following entries of the probe
+   * sequence that may not be placed after it.
+   */
+
+  hole = ret;
+  for (slot = (hole + 1) & mask; index[slot].hoffset != 0;
+       slot = (slot + 1) & mask)
+    {
+      home = index[slot].hash & mask;
+      if (((slot - home) & mask) >= ((slot - hole) & mask))
+        {
+          index[hole] = index[slot];
+          hole = slot;
+        }
+    }
+
+  index[hole].hoffset = 0;
+  volume->icount--;
+}
+
+/****************************************************************************
+ * Name: nxffs_index_move
+ *
+ * Description:
+ *   The packing logic has moved the header of the inode 'name' from
+ *   'from' to 'to'.
+ *
+ ****************************************************************************/
+
+void nxffs_index_move(FAR struct nxffs_volume_s *volume,
+                      FAR const char *name, off_t from, off_t to)
+{
+  int ret;
+
+  if (!volume->ivalid)
+    {
+      return;
+    }
+
+  ret = nxffs_index_slot(volume, nxffs_namehash(name), from);
+  if (ret < 0)
+    {
+      /* Every valid inode is indexed.  Rather scan than miss a file. */
+
+      ferr("ERROR: Inode '%s' at %jd is not indexed\n",
+           name, (intmax_t)from);
+      nxffs_index_free(volume);
+      return;
+    }
+
+  volume->index[ret].hoffset = to;
+}
+
+/****************************************************************************
+ * Name: nxffs_index_find
+ *
+ * Description:
+ *   Find the inode 'name' with the index.  Only the inode headers with the
+ *   hash of the name are read.
+ *
+ * Returned Value:
+ *   Zero on success with the inode in 'entry', -ENOENT if there is no
+ *   such inode and -ENOSYS if the index cannot be used.
+ *
+ ****************************************************************************/
+
+int nxffs_index_find(FAR struct nxffs_volume_s *volume,
+                     FAR const char *name, FAR struct nxffs_entry_s *entry)
+{
+  uint32_t hash;
+  uint32_t mask;
+  uint32_t slot;
+  int ret;
+
+  if (!volume->ivalid)
+    {
+      return -ENOSYS;
+    }
+
+  if (volume->index == NULL)
+    {
+      return -ENOENT;
+    }
+
+  hash = nxffs_namehash(name);
+  mask = volume->isize - 1;
+
+  for (slot = hash & mask; volume->index[slot].hoffset != 0;
+       slot = (slot + 1) & mask)
+    {
+      if (volume->index[slot].hash != hash)
+        {
+          continue;
+        }
+
+      ret = nxffs_rdinode(volume, volume->index[slot].hoffset, entry);
+      if (ret == -ENOMEM)
+        {
+          return ret;
+        }
+      else if (ret == OK)
+        {
+          if (strcmp(name, entry->name) == 0)
+            {
+              return OK;
+            }
+
+          nxffs_freeentry(entry);
+        }
+      else
+        {
+          ferr("ERROR: Indexed inode at %jd is not valid: %d\n",
+               (intmax_t)volume->index[slot].hoffset, ret);
+        }
+    }
+
+  return -ENOENT;
+}
+
+#endif /* CONFIG_NXFFS_INDEX */
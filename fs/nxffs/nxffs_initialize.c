@@ -355,6 +355,12 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
   int nerased;
   int ret;
 
+#ifdef CONFIG_NXFFS_INDEX
+  /* The inode index is built while the volume is scanned */
+
+  nxffs_index_reset(volume);
+#endif
+
   /* Get the offset to the first valid block on the FLASH */
 
   block = 0;
@@ -398,6 +404,10 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
       volume->inoffset = entry.hoffset;
       finfo("First inode at offset %jd\n", (intmax_t)volume->inoffset);
 
+#ifdef CONFIG_NXFFS_INDEX
+      nxffs_index_insert(volume, entry.name, entry.hoffset);
+#endif
+
       /* Discard this entry and set the next offset. */
 
       offset = nxffs_inodeend(volume, &entry);
@@ -410,6 +420,10 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
     {
       while (nxffs_nextentry(volume, offset, &entry) == OK)
         {
+#ifdef CONFIG_NXFFS_INDEX
+          nxffs_index_insert(volume, entry.name, entry.hoffset);
+#endif
+
           /* Discard the entry and guess the next offset. */
 
           offset = nxffs_inodeend(volume, &entry);
@@ -571,6 +585,17 @@ int nxffs_unbind(FAR void *handle, FAR struct inode **blkdriver,
       return -ENOSYS;
     }
 
-  return g_volume.ofiles ? -EBUSY : OK;
+  if (g_volume.ofiles)
+    {
+      return -EBUSY;
+    }
+
+#ifdef CONFIG_NXFFS_BGPACK
+  /* Do not pack the volume after it was unmounted */
+
+  work_cancel_sync(LPWORK, &g_volume.bgwork);
+#endif
+
+  return OK;
 #endif
 }
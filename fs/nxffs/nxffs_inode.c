@@ -48,7 +48,7 @@
  *
  * Description:
  *   Read the inode entry at this offset.  Called only from
- *   nxffs_nextentry().
+ *   nxffs_nextentry() and nxffs_rdinode().
  *
  * Input Parameters:
  *   volume - Describes the current volume.
@@ -347,6 +347,48 @@ int nxffs_nextentry(FAR struct nxffs_volume_s *volume, off_t offset,
   return -ENOENT;
 }
 
+/****************************************************************************
+ * Name: nxffs_rdinode
+ *
+ * Description:
+ *   Read the valid inode whose header is at the provided FLASH offset.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume.
+ *   offset - The FLASH offset of the inode header.
+ *   entry  - A pointer to memory provided by the caller in which to return
+ *     the inode description.
+ *
+ * Returned Value:
+ *   Zero is returned on success. Otherwise, a negated errno is returned
+ *   that indicates the nature of the failure.
+ *
+ ****************************************************************************/
+
+int nxffs_rdinode(FAR struct nxffs_volume_s *volume, off_t offset,
+                  FAR struct nxffs_entry_s *entry)
+{
+  int ret;
+
+  /* Make sure that the block with the inode header is in memory */
+
+  nxffs_ioseek(volume, offset);
+  ret = nxffs_rdcache(volume, volume->ioblock);
+  if (ret < 0)
+    {
+      ferr("ERROR: nxffs_rdcache failed: %d\n", -ret);
+      return ret;
+    }
+
+  if (memcmp(&volume->cache[volume->iooffset], g_inodemagic,
+             NXFFS_MAGICSIZE) != 0)
+    {
+      return -ENOENT;
+    }
+
+  return nxffs_rdentry(volume, offset, entry);
+}
+
 /****************************************************************************
  * Name: nxffs_findinode
  *
@@ -372,6 +414,16 @@ int nxffs_findinode(FAR struct nxffs_volume_s *volume, FAR const char *name,
   off_t offset;
   int ret;
 
+#ifdef CONFIG_NXFFS_INDEX
+  /* Look the name up in the inode index if it is usable */
+
+  ret = nxffs_index_find(volume, name, entry);
+  if (ret != -ENOSYS)
+    {
+      return ret;
+    }
+#endif
+
   /* Start with the first valid inode that was discovered when the volume
    * was created (or modified after the last file system re-packing).
    */
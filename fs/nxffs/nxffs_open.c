@@ -897,6 +897,13 @@ static inline int nxffs_wrclose(FAR struct nxffs_volume_s *volume,
   /* Write the inode header to FLASH */
 
   ret = nxffs_wrinode(volume, &wrfile->ofile.entry);
+#ifdef CONFIG_NXFFS_INDEX
+  if (ret >= 0)
+    {
+      nxffs_index_insert(volume, wrfile->ofile.entry.name,
+                         wrfile->ofile.entry.hoffset);
+    }
+#endif
 
   /* The volume is now available for other writers */
 
@@ -1259,10 +1266,7 @@ int nxffs_wrinode(FAR struct nxffs_volume_s *volume,
            (intmax_t)volume->ioblock, -ret);
     }
 
-  /* The volume is now available for other writers */
-
 errout:
-  nxsem_post(&volume->wrsem);
   return ret;
 }
 
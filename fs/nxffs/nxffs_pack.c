@@ -38,6 +38,14 @@
 #include "nxffs.h"
 #include "fs_heap.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Background packing starts this long after the last inode was deleted */
+
+#define NXFFS_BGPACK_DELAY MSEC2TICK(1000)
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -700,6 +708,13 @@ static int nxffs_wrinodehdr(FAR struct nxffs_volume_s *volume,
         }
     }
 
+#ifdef CONFIG_NXFFS_INDEX
+  /* The source stream still describes the old inode header */
+
+  nxffs_index_move(volume, pack->dest.entry.name, pack->src.entry.hoffset,
+                   pack->dest.entry.hoffset);
+#endif
+
   /* Reset the dest inode information */
 
   nxffs_freeentry(&pack->dest.entry);
@@ -1246,6 +1261,36 @@ static inline int nxffs_packwriter(FAR struct nxffs_volume_s *volume,
   return -ENOSYS;
 }
 
+/****************************************************************************
+ * Name: nxffs_bgpack_worker
+ *
+ * Description:
+ *   Pack the volume on the low priority work queue.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_BGPACK
+static void nxffs_bgpack_worker(FAR void *arg)
+{
+  FAR struct nxffs_volume_s *volume = arg;
+  int ret;
+
+  ret = nxmutex_lock(&volume->lock);
+  if (ret < 0)
+    {
+      return;
+    }
+
+  ret = nxffs_pack(volume);
+  if (ret < 0)
+    {
+      ferr("ERROR: Background packing failed: %d\n", -ret);
+    }
+
+  nxmutex_unlock(&volume->lock);
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -1273,6 +1318,7 @@ int nxffs_pack(FAR struct nxffs_volume_s *volume)
   off_t iooffset;
   off_t eblock;
   off_t block;
+  bool modified;
   bool packed;
   int i;
   int ret = OK;
@@ -1411,6 +1457,7 @@ start_pack:
       /* Get the starting block number of the erase block */
 
       pack.block0 = eblock * volume->blkper;
+      modified    = false;
 
 #ifndef CONFIG_NXFFS_NAND
       /* Read the erase block into the pack buffer.  We need to do this even
@@ -1453,6 +1500,7 @@ start_pack:
 
               ferr("ERROR: Failed to read block %d: %d\n", block, ret);
               nxffs_blkinit(volume, pack.iobuffer, BLOCK_STATE_BAD);
+              modified = true;
             }
         }
 #endif
@@ -1495,6 +1543,7 @@ start_pack:
 
                       /* Pack inode data into this block */
 
+                      modified = true;
                       ret = nxffs_packblock(volume, &pack);
                       if (ret < 0)
                         {
@@ -1540,6 +1589,7 @@ start_pack:
 
                       /* Pack write data into this block */
 
+                      modified = true;
                       ret = nxffs_packwriter(volume, &pack, wrfile);
                       if (ret < 0)
                         {
@@ -1571,9 +1621,15 @@ start_pack:
 
               if (pack.iooffset < volume->geo.blocksize)
                 {
-                  memset(&pack.iobuffer[pack.iooffset],
-                         CONFIG_NXFFS_ERASEDSTATE,
-                         volume->geo.blocksize - pack.iooffset);
+                  size_t nbytes = volume->geo.blocksize - pack.iooffset;
+
+                  if (nxffs_erased(&pack.iobuffer[pack.iooffset], nbytes) <
+                      nbytes)
+                    {
+                      memset(&pack.iobuffer[pack.iooffset],
+                             CONFIG_NXFFS_ERASEDSTATE, nbytes);
+                      modified = true;
+                    }
                 }
 
               /* Next time through the loop, pack.iooffset will point to the
@@ -1584,6 +1640,16 @@ start_pack:
             }
         }
 
+      /* Once everything is packed, the erase blocks up to the end of FLASH
+       * are typically already erased and formatted.  Do not wear them (and
+       * spend the time) for nothing.
+       */
+
+      if (!modified)
+        {
+          continue;
+        }
+
       /* We now have an in-memory image of how we want this erase block to
        * appear. Now it is safe to erase the block.
        */
@@ -1609,7 +1675,47 @@ start_pack:
     }
 
 errout_with_pack:
+#ifdef CONFIG_NXFFS_INDEX
+  if (ret < 0)
+    {
+      /* Some inodes may have been left half moved */
+
+      nxffs_index_free(volume);
+    }
+#endif
+
   nxffs_freeentry(&pack.src.entry);
   nxffs_freeentry(&pack.dest.entry);
   return ret;
 }
+
+/****************************************************************************
+ * Name: nxffs_bgpack
+ *
+ * Description:
+ *   Called after an inode was deleted.  If little FLASH is left free at the
+ *   end of the volume, schedule a pack on the low priority work queue so
+ *   that a later write does not have to wait for it.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_BGPACK
+void nxffs_bgpack(FAR struct nxffs_volume_s *volume)
+{
+  off_t size = volume->nblocks * volume->geo.blocksize;
+
+  if (size - volume->froffset <
+      size / 100 * CONFIG_NXFFS_BGPACK_THRESHOLD &&
+      work_available(&volume->bgwork))
+    {
+      work_queue(LPWORK, &volume->bgwork, nxffs_bgpack_worker, volume,
+                 NXFFS_BGPACK_DELAY);
+    }
+}
+#endif
@@ -114,8 +114,19 @@ int nxffs_rminode(FAR struct nxffs_volume_s *volume, FAR const char *name)
     {
       ferr("ERROR: Failed to write block %jd: %d\n",
            (intmax_t)volume->ioblock, ret);
+      goto errout_with_entry;
     }
 
+#ifdef CONFIG_NXFFS_INDEX
+  nxffs_index_remove(volume, name, entry.hoffset);
+#endif
+
+#ifdef CONFIG_NXFFS_BGPACK
+  /* The space of the inode can be recovered now */
+
+  nxffs_bgpack(volume);
+#endif
+
 errout_with_entry:
   nxffs_freeentry(&entry);
 errout:
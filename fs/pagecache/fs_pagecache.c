@@ -0,0 +1,999 @@
+/****************************************************************************
+ * fs/pagecache/fs_pagecache.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include <nuttx/clock.h>
+#include <nuttx/debug.h>
+#include <nuttx/fs/blkqueue.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/pagecache.h>
+#include <nuttx/hashtable.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/mm/mm.h>
+#include <nuttx/mutex.h>
+#include <nuttx/nuttx.h>
+#include <nuttx/queue.h>
+#include <nuttx/wqueue.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define PAGECACHE_KEY(dev, block) \
+  ((uint32_t)(block) ^ (uint32_t)((uintptr_t)(dev) >> 4))
+
+#if CONFIG_FS_PAGECACHE_ALIGNMENT != 0
+#  define pagecache_alloc_data(size) \
+     kmm_memalign(CONFIG_FS_PAGECACHE_ALIGNMENT, size)
+#else
+#  define pagecache_alloc_data(size) kmm_malloc(size)
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A block device attached to the cache */
+
+struct pagecache_dev_s
+{
+  dq_entry_t        node;     /* Link in g_pagecache_devs */
+  FAR struct inode *inode;    /* The block driver inode */
+  uint32_t          sectsize; /* The size of one sector (and page) */
+  uint32_t          refs;     /* Number of pagecache_attach calls */
+};
+
+/* One cached sector */
+
+struct pagecache_page_s
+{
+  hash_node_t                 hnode;      /* Link in g_pagecache_hash */
+  dq_entry_t                  cnode;      /* Link in g_pagecache_clock */
+  FAR struct pagecache_dev_s *dev;        /* The device of the sector */
+  blkcnt_t                    block;      /* The sector number */
+  bool                        referenced; /* Accessed since the last sweep */
+  bool                        dirty;      /* Not written back yet */
+  FAR uint8_t                *data;       /* The sector data */
+};
+
+#ifdef CONFIG_FS_BLKQUEUE
+/* The block request writing back a dirty page */
+
+struct pagecache_wb_s
+{
+  struct blk_request_s          req;      /* Must be first */
+  FAR struct pagecache_page_s  *page;     /* The page written back */
+};
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static mutex_t g_pagecache_lock = NXMUTEX_INITIALIZER;
+static DECLARE_HASHTABLE(g_pagecache_hash, CONFIG_FS_PAGECACHE_HASH_BITS);
+
+/* All pages in the order the clock hand visits them: the hand is always at
+ * the head, and pages that get a second chance are moved to the tail.
+ */
+
+static dq_queue_t g_pagecache_clock;
+static dq_queue_t g_pagecache_devs;
+static struct work_s g_pagecache_work;
+static struct pagecache_stats_s g_pagecache_stats;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: pagecache_find
+ *
+ * Description:
+ *   Find the attached device of a block driver inode.
+ *
+ ****************************************************************************/
+
+static FAR struct pagecache_dev_s *pagecache_find(FAR struct inode *inode)
+{
+  FAR dq_entry_t *entry;
+
+  dq_for_every(&g_pagecache_devs, entry)
+    {
+      FAR struct pagecache_dev_s *dev =
+        container_of(entry, struct pagecache_dev_s, node);
+
+      if (dev->inode == inode)
+        {
+          return dev;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: pagecache_lookup
+ *
+ * Description:
+ *   Find the cached page of a sector.
+ *
+ ****************************************************************************/
+
+static FAR struct pagecache_page_s *
+pagecache_lookup(FAR struct pagecache_dev_s *dev, blkcnt_t block)
+{
+  FAR hash_node_t *p;
+
+  hashtable_for_every_possible(g_pagecache_hash, p,
+                               PAGECACHE_KEY(dev, block))
+    {
+      FAR struct pagecache_page_s *page =
+        container_of(p, struct pagecache_page_s, hnode);
+
+      if (page->dev == dev && page->block == block)
+        {
+          return page;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: pagecache_release
+ *
+ * Description:
+ *   Forget a page and free its memory.
+ *
+ ****************************************************************************/
+
+static void pagecache_release(FAR struct pagecache_page_s *page)
+{
+  hashtable_delete(g_pagecache_hash, &page->hnode,
+                   PAGECACHE_KEY(page->dev, page->block));
+  dq_rem(&page->cnode, &g_pagecache_clock);
+
+  if (page->dirty)
+    {
+      g_pagecache_stats.dirty--;
+    }
+
+  g_pagecache_stats.pages--;
+  g_pagecache_stats.bytes -= page->dev->sectsize;
+
+  kmm_free(page->data);
+  kmm_free(page);
+}
+
+/****************************************************************************
+ * Name: pagecache_writeback
+ *
+ * Description:
+ *   Write a dirty page back to the media.
+ *
+ ****************************************************************************/
+
+static int pagecache_writeback(FAR struct pagecache_page_s *page)
+{
+  FAR struct inode *inode = page->dev->inode;
+  ssize_t ret;
+
+  if (!page->dirty)
+    {
+      return OK;
+    }
+
+  ret = inode->u.i_bops->write(inode, page->data, page->block, 1);
+  if (ret < 0)
+    {
+      ferr("ERROR: Write back of sector %" PRIuOFF " failed: %zd\n",
+           (off_t)page->block, ret);
+      return (int)ret;
+    }
+
+  page->dirty = false;
+  g_pagecache_stats.dirty--;
+  g_pagecache_stats.writebacks++;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: pagecache_evict
+ *
+ * Description:
+ *   Run the clock hand until a page can be reclaimed, and reclaim it.
+ *   Pages accessed since the last sweep get a second chance.
+ *
+ * Returned Value:
+ *   True if a page was reclaimed.
+ *
+ ****************************************************************************/
+
+static bool pagecache_evict(void)
+{
+  FAR struct pagecache_page_s *page;
+  uint32_t count = 2 * g_pagecache_stats.pages;
+
+  while (count-- > 0)
+    {
+      page = container_of(dq_peek(&g_pagecache_clock),
+                          struct pagecache_page_s, cnode);
+
+      if (page->referenced || pagecache_writeback(page) < 0)
+        {
+          page->referenced = false;
+          dq_rem(&page->cnode, &g_pagecache_clock);
+          dq_addlast(&page->cnode, &g_pagecache_clock);
+          continue;
+        }
+
+      pagecache_release(page);
+      g_pagecache_stats.evictions++;
+      return true;
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: pagecache_alloc
+ *
+ * Description:
+ *   Allocate a page for a sector, reclaiming other pages if the cache is
+ *   full.
+ *
+ * Returned Value:
+ *   The new page (not dirty); NULL if no memory is available.
+ *
+ ****************************************************************************/
+
+static FAR struct pagecache_page_s *
+pagecache_alloc(FAR struct pagecache_dev_s *dev, blkcnt_t block)
+{
+  FAR struct pagecache_page_s *page;
+
+  while (g_pagecache_stats.bytes + dev->sectsize > CONFIG_FS_PAGECACHE_SIZE)
+    {
+      if (!pagecache_evict())
+        {
+          return NULL;
+        }
+    }
+
+  page = kmm_zalloc(sizeof(struct pagecache_page_s));
+  if (page == NULL)
+    {
+      return NULL;
+    }
+
+  page->data = pagecache_alloc_data(dev->sectsize);
+  if (page->data == NULL)
+    {
+      kmm_free(page);
+      return NULL;
+    }
+
+  page->dev   = dev;
+  page->block = block;
+
+  hashtable_add(g_pagecache_hash, &page->hnode, PAGECACHE_KEY(dev, block));
+  dq_addlast(&page->cnode, &g_pagecache_clock);
+
+  g_pagecache_stats.pages++;
+  g_pagecache_stats.bytes += dev->sectsize;
+  return page;
+}
+
+/****************************************************************************
+ * Name: pagecache_fill
+ *
+ * Description:
+ *   Add sectors just read from the media to the cache.
+ *
+ ****************************************************************************/
+
+static void pagecache_fill(FAR struct pagecache_dev_s *dev, blkcnt_t block,
+                           FAR const uint8_t *buffer, unsigned int nsectors)
+{
+  FAR struct pagecache_page_s *page;
+  unsigned int i;
+
+  for (i = 0; i < nsectors; i++)
+    {
+      page = pagecache_alloc(dev, block + i);
+      if (page == NULL)
+        {
+          break;
+        }
+
+      memcpy(page->data, buffer + i * dev->sectsize, dev->sectsize);
+    }
+}
+
+#ifdef CONFIG_FS_BLKQUEUE
+/****************************************************************************
+ * Name: pagecache_wb_done
+ ****************************************************************************/
+
+static void pagecache_wb_done(FAR struct blk_request_s *req)
+{
+  nxsem_post(req->arg);
+}
+
+/****************************************************************************
+ * Name: pagecache_writeback_batch
+ *
+ * Description:
+ *   Write back all dirty pages of a device together: the requests are
+ *   submitted with the queue of the driver plugged, so that the pages of
+ *   adjacent sectors go out as one transfer.
+ *
+ * Returned Value:
+ *   OK, the first write back error, or -ENOMEM if there is no memory for
+ *   the requests.
+ *
+ ****************************************************************************/
+
+static int pagecache_writeback_batch(FAR struct pagecache_dev_s *dev)
+{
+  FAR struct pagecache_wb_s *wb;
+  FAR dq_entry_t *entry;
+  int result = OK;
+  size_t count = 0;
+  size_t i = 0;
+  sem_t done;
+
+  dq_for_every(&g_pagecache_clock, entry)
+    {
+      FAR struct pagecache_page_s *page =
+        container_of(entry, struct pagecache_page_s, cnode);
+
+      if (page->dev == dev && page->dirty)
+        {
+          count++;
+        }
+    }
+
+  if (count == 0)
+    {
+      return OK;
+    }
+
+  wb = kmm_malloc(count * sizeof(*wb));
+  if (wb == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  nxsem_init(&done, 0, 0);
+  blk_plug(dev->inode);
+
+  dq_for_every(&g_pagecache_clock, entry)
+    {
+      FAR struct pagecache_page_s *page =
+        container_of(entry, struct pagecache_page_s, cnode);
+
+      if (page->dev == dev && page->dirty)
+        {
+          wb[i].page         = page;
+          wb[i].req.op       = BLK_REQ_WRITE;
+          wb[i].req.buffer   = page->data;
+          wb[i].req.sector   = page->block;
+          wb[i].req.nsectors = 1;
+          wb[i].req.complete = pagecache_wb_done;
+          wb[i].req.arg      = &done;
+          blk_submit(dev->inode, &wb[i].req);
+          i++;
+        }
+    }
+
+  blk_unplug(dev->inode);
+
+  for (i = 0; i < count; i++)
+    {
+      nxsem_wait_uninterruptible(&done);
+    }
+
+  for (i = 0; i < count; i++)
+    {
+      if (wb[i].req.result < 0)
+        {
+          ferr("ERROR: Write back of sector %" PRIuOFF " failed: %zd\n",
+               (off_t)wb[i].req.sector, wb[i].req.result);
+          if (result == OK)
+            {
+              result = (int)wb[i].req.result;
+            }
+        }
+      else
+        {
+          wb[i].page->dirty = false;
+          g_pagecache_stats.dirty--;
+          g_pagecache_stats.writebacks++;
+        }
+    }
+
+  nxsem_destroy(&done);
+  kmm_free(wb);
+  return result;
+}
+#endif
+
+/****************************************************************************
+ * Name: pagecache_flush_dev
+ *
+ * Description:
+ *   Write back the dirty pages of a device, or of all devices if dev is
+ *   NULL.
+ *
+ ****************************************************************************/
+
+static int pagecache_flush_dev(FAR struct pagecache_dev_s *dev)
+{
+  FAR dq_entry_t *entry;
+  int result = OK;
+  int ret;
+
+  if (g_pagecache_stats.dirty == 0)
+    {
+      return OK;
+    }
+
+#ifdef CONFIG_FS_BLKQUEUE
+  if (dev == NULL)
+    {
+      dq_for_every(&g_pagecache_devs, entry)
+        {
+          ret = pagecache_flush_dev(container_of(entry,
+                                                 struct pagecache_dev_s,
+                                                 node));
+          if (ret < 0 && result == OK)
+            {
+              result = ret;
+            }
+        }
+
+      return result;
+    }
+
+  ret = pagecache_writeback_batch(dev);
+  if (ret != -ENOMEM)
+    {
+      return ret;
+    }
+#endif
+
+  dq_for_every(&g_pagecache_clock, entry)
+    {
+      FAR struct pagecache_page_s *page =
+        container_of(entry, struct pagecache_page_s, cnode);
+
+      if (dev == NULL || page->dev == dev)
+        {
+          ret = pagecache_writeback(page);
+          if (ret < 0 && result == OK)
+            {
+              result = ret;
+            }
+        }
+    }
+
+  return result;
+}
+
+/****************************************************************************
+ * Name: pagecache_drop_dev
+ *
+ * Description:
+ *   Release the pages of a device.  Dirty pages are only released if force
+ *   is true.
+ *
+ ****************************************************************************/
+
+static void pagecache_drop_dev(FAR struct pagecache_dev_s *dev, bool force)
+{
+  FAR dq_entry_t *entry;
+  FAR dq_entry_t *tmp;
+
+  dq_for_every_safe(&g_pagecache_clock, entry, tmp)
+    {
+      FAR struct pagecache_page_s *page =
+        container_of(entry, struct pagecache_page_s, cnode);
+
+      if (page->dev == dev && (force || !page->dirty))
+        {
+          pagecache_release(page);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: pagecache_worker
+ *
+ * Description:
+ *   The flusher: write back all dirty pages some time after they were
+ *   first written.
+ *
+ ****************************************************************************/
+
+static void pagecache_worker(FAR void *arg)
+{
+  if (nxmutex_lock(&g_pagecache_lock) >= 0)
+    {
+      pagecache_flush_dev(NULL);
+      nxmutex_unlock(&g_pagecache_lock);
+    }
+}
+
+/****************************************************************************
+ * Name: pagecache_schedule
+ *
+ * Description:
+ *   Make sure the flusher will run.
+ *
+ ****************************************************************************/
+
+static void pagecache_schedule(void)
+{
+  if (work_available(&g_pagecache_work))
+    {
+      work_queue(LPWORK, &g_pagecache_work, pagecache_worker, NULL,
+                 MSEC2TICK(CONFIG_FS_PAGECACHE_WRITEBACK_MS));
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: pagecache_attach
+ *
+ * Description:
+ *   Start caching the sectors of a block device.  Each call must be paired
+ *   with pagecache_detach; users of the same device share its pages.
+ *
+ ****************************************************************************/
+
+int pagecache_attach(FAR struct inode *inode)
+{
+  FAR struct pagecache_dev_s *dev;
+  struct geometry geo;
+  int ret;
+
+  DEBUGASSERT(inode != NULL && inode->u.i_bops != NULL);
+
+  if (inode->u.i_bops->read == NULL || inode->u.i_bops->geometry == NULL)
+    {
+      return -ENOTSUP;
+    }
+
+  ret = nxmutex_lock(&g_pagecache_lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  dev = pagecache_find(inode);
+  if (dev != NULL)
+    {
+      dev->refs++;
+      goto out;
+    }
+
+  ret = inode->u.i_bops->geometry(inode, &geo);
+  if (ret < 0)
+    {
+      goto out;
+    }
+
+  if (!geo.geo_available || geo.geo_sectorsize == 0)
+    {
+      ret = -ENODEV;
+      goto out;
+    }
+
+  dev = kmm_zalloc(sizeof(struct pagecache_dev_s));
+  if (dev == NULL)
+    {
+      ret = -ENOMEM;
+      goto out;
+    }
+
+  dev->inode    = inode;
+  dev->sectsize = geo.geo_sectorsize;
+  dev->refs     = 1;
+
+  /* The pages come from the kernel heap: give them back when it runs out */
+
+  if (dq_empty(&g_pagecache_devs))
+    {
+      mm_register_shrinker(KRN_HEAP, pagecache_shrink);
+    }
+
+  dq_addlast(&dev->node, &g_pagecache_devs);
+  g_pagecache_stats.devices++;
+
+out:
+  nxmutex_unlock(&g_pagecache_lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: pagecache_detach
+ *
+ * Description:
+ *   Drop a reference taken by pagecache_attach.  When the last reference
+ *   is dropped, the dirty pages of the device are written back and all of
+ *   its pages are released.
+ *
+ ****************************************************************************/
+
+int pagecache_detach(FAR struct inode *inode)
+{
+  FAR struct pagecache_dev_s *dev;
+  int ret;
+
+  ret = nxmutex_lock(&g_pagecache_lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  dev = pagecache_find(inode);
+  if (dev == NULL)
+    {
+      ret = -ENOENT;
+    }
+  else if (--dev->refs == 0)
+    {
+      ret = pagecache_flush_dev(dev);
+      pagecache_drop_dev(dev, true);
+
+      dq_rem(&dev->node, &g_pagecache_devs);
+      g_pagecache_stats.devices--;
+      kmm_free(dev);
+    }
+
+  nxmutex_unlock(&g_pagecache_lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: pagecache_read
+ *
+ * Description:
+ *   Read sectors of a block device through the page cache.  Devices that
+ *   are not attached are read directly.
+ *
+ ****************************************************************************/
+
+ssize_t pagecache_read(FAR struct inode *inode, FAR unsigned char *buffer,
+                       blkcnt_t start, unsigned int nsectors)
+{
+  FAR struct pagecache_dev_s *dev;
+  FAR struct pagecache_page_s *page;
+  unsigned int i;
+  unsigned int n;
+  ssize_t ret;
+
+  ret = nxmutex_lock(&g_pagecache_lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  dev = pagecache_find(inode);
+  if (dev == NULL)
+    {
+      nxmutex_unlock(&g_pagecache_lock);
+      return inode->u.i_bops->read(inode, buffer, start, nsectors);
+    }
+
+  for (i = 0; i < nsectors; i += n)
+    {
+      page = pagecache_lookup(dev, start + i);
+      if (page != NULL)
+        {
+          memcpy(buffer + i * dev->sectsize, page->data, dev->sectsize);
+          page->referenced = true;
+          g_pagecache_stats.hits++;
+          n = 1;
+          continue;
+        }
+
+      /* Read the whole run of missing sectors at once */
+
+      n = 1;
+      while (i + n < nsectors &&
+             pagecache_lookup(dev, start + i + n) == NULL)
+        {
+          n++;
+        }
+
+      ret = inode->u.i_bops->read(inode, buffer + i * dev->sectsize,
+                                  start + i, n);
+      if (ret < 0)
+        {
+          goto out;
+        }
+
+      g_pagecache_stats.misses += n;
+
+      if (ret < n)
+        {
+          ret += i;
+          goto out;
+        }
+
+      /* Only keep small runs: large ones are likely streaming data that
+       * would just push the file system metadata out of the cache.
+       */
+
+      if (n <= CONFIG_FS_PAGECACHE_FILL_SECTORS)
+        {
+          pagecache_fill(dev, start + i, buffer + i * dev->sectsize, n);
+        }
+    }
+
+  ret = nsectors;
+
+out:
+  nxmutex_unlock(&g_pagecache_lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: pagecache_write
+ *
+ * Description:
+ *   Write sectors of a block device through the page cache.  Small writes
+ *   are kept in the cache and written back later by the flusher; large
+ *   writes go straight to the media.  Devices that are not attached are
+ *   written directly.
+ *
+ ****************************************************************************/
+
+ssize_t pagecache_write(FAR struct inode *inode,
+                        FAR const unsigned char *buffer,
+                        blkcnt_t start, unsigned int nsectors)
+{
+  FAR struct pagecache_dev_s *dev;
+  FAR struct pagecache_page_s *page;
+  unsigned int i;
+  ssize_t ret;
+
+  ret = nxmutex_lock(&g_pagecache_lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  dev = pagecache_find(inode);
+  if (dev == NULL || nsectors > CONFIG_FS_PAGECACHE_FILL_SECTORS)
+    {
+      ret = inode->u.i_bops->write(inode, buffer, start, nsectors);
+
+      /* Keep the cached copies of the sectors written up to date.  They
+       * are clean now, an older dirty copy must not be written back over
+       * the new data.
+       */
+
+      for (i = 0; dev != NULL && ret > 0 && i < ret; i++)
+        {
+          page = pagecache_lookup(dev, start + i);
+          if (page != NULL)
+            {
+              memcpy(page->data, buffer + i * dev->sectsize,
+                     dev->sectsize);
+              if (page->dirty)
+                {
+                  page->dirty = false;
+                  g_pagecache_stats.dirty--;
+                }
+            }
+        }
+
+      goto out;
+    }
+
+  for (i = 0; i < nsectors; i++)
+    {
+      page = pagecache_lookup(dev, start + i);
+      if (page == NULL)
+        {
+          page = pagecache_alloc(dev, start + i);
+        }
+
+      if (page == NULL)
+        {
+          /* No room in the cache, write the sector through */
+
+          ret = inode->u.i_bops->write(inode, buffer + i * dev->sectsize,
+                                       start + i, 1);
+          if (ret < 0)
+            {
+              goto out;
+            }
+
+          continue;
+        }
+
+      memcpy(page->data, buffer + i * dev->sectsize, dev->sectsize);
+      page->referenced = true;
+      if (!page->dirty)
+        {
+          page->dirty = true;
+          g_pagecache_stats.dirty++;
+        }
+    }
+
+  if (g_pagecache_stats.dirty > 0)
+    {
+      pagecache_schedule();
+    }
+
+  ret = nsectors;
+
+out:
+  nxmutex_unlock(&g_pagecache_lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: pagecache_flush
+ *
+ * Description:
+ *   Write back the dirty pages of a block device, or of all devices if
+ *   inode is NULL.
+ *
+ ****************************************************************************/
+
+int pagecache_flush(FAR struct inode *inode)
+{
+  FAR struct pagecache_dev_s *dev = NULL;
+  int ret;
+
+  ret = nxmutex_lock(&g_pagecache_lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (inode != NULL)
+    {
+      dev = pagecache_find(inode);
+    }
+
+  if (inode == NULL || dev != NULL)
+    {
+      ret = pagecache_flush_dev(dev);
+    }
+
+  nxmutex_unlock(&g_pagecache_lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: pagecache_invalidate
+ *
+ * Description:
+ *   Write back the dirty pages of a block device and release all of its
+ *   pages, so that the next accesses read the media again.
+ *
+ ****************************************************************************/
+
+int pagecache_invalidate(FAR struct inode *inode)
+{
+  FAR struct pagecache_dev_s *dev;
+  int ret;
+
+  ret = nxmutex_lock(&g_pagecache_lock);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  dev = pagecache_find(inode);
+  if (dev != NULL)
+    {
+      /* Pages that could not be written back are kept */
+
+      ret = pagecache_flush_dev(dev);
+      pagecache_drop_dev(dev, false);
+    }
+
+  nxmutex_unlock(&g_pagecache_lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: pagecache_shrink
+ *
+ * Description:
+ *   Release clean pages to give memory back to the heap.  This is the
+ *   shrinker of the kernel heap, called when an allocation from it fails.
+ *   It never blocks: it does nothing if the cache is busy.
+ *
+ ****************************************************************************/
+
+size_t pagecache_shrink(size_t bytes)
+{
+  FAR dq_entry_t *entry;
+  FAR dq_entry_t *tmp;
+  size_t freed = 0;
+
+  if (nxmutex_trylock(&g_pagecache_lock) < 0)
+    {
+      return 0;
+    }
+
+  /* Start at the clock hand, where the least recently used pages are */
+
+  dq_for_every_safe(&g_pagecache_clock, entry, tmp)
+    {
+      FAR struct pagecache_page_s *page =
+        container_of(entry, struct pagecache_page_s, cnode);
+
+      if (page->dirty)
+        {
+          continue;
+        }
+
+      freed += page->dev->sectsize;
+      pagecache_release(page);
+      g_pagecache_stats.shrinks++;
+
+      if (freed >= bytes)
+        {
+          break;
+        }
+    }
+
+  nxmutex_unlock(&g_pagecache_lock);
+  return freed;
+}
+
+/****************************************************************************
+ * Name: pagecache_stats
+ *
+ * Description:
+ *   Return the page cache statistics.
+ *
+ ****************************************************************************/
+
+void pagecache_stats(FAR struct pagecache_stats_s *stats)
+{
+  nxmutex_lock(&g_pagecache_lock);
+  *stats = g_pagecache_stats;
+  nxmutex_unlock(&g_pagecache_lock);
+}
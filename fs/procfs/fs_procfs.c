@@ -64,6 +64,7 @@ extern const struct procfs_operations g_fdt_operations;
 extern const struct procfs_operations g_iobinfo_operations;
 extern const struct procfs_operations g_irq_operations;
 extern const struct procfs_operations g_meminfo_operations;
+extern const struct procfs_operations g_pagecache_operations;
 extern const struct procfs_operations g_memdump_operations;
 extern const struct procfs_operations g_mempool_operations;
 extern const struct procfs_operations g_module_operations;
@@ -136,6 +137,10 @@ static const struct procfs_entry_s g_procfs_entries[] =
   { "fs/mount",     &g_mount_operations,    PROCFS_FILE_TYPE   },
 #endif
 
+#if defined(CONFIG_FS_PAGECACHE) && !defined(CONFIG_FS_PROCFS_EXCLUDE_PAGECACHE)
+  { "fs/pagecache", &g_pagecache_operations, PROCFS_FILE_TYPE  },
+#endif
+
 #if defined(CONFIG_FS_SMARTFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
   { "fs/smartfs**", &g_smartfs_procfs_operations,  PROCFS_UNKOWN_TYPE },
 #endif
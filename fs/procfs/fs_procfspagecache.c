@@ -0,0 +1,127 @@
+/****************************************************************************
+ * fs/procfs/fs_procfspagecache.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/pagecache.h>
+#include <nuttx/fs/procfs.h>
+
+#if defined(CONFIG_FS_PROCFS) && defined(CONFIG_FS_PAGECACHE) && \
+    !defined(CONFIG_FS_PROCFS_EXCLUDE_PAGECACHE)
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int pagecache_procfs_open(FAR struct file *filep,
+                                 FAR const char *relpath, int oflags,
+                                 mode_t mode)
+{
+  /* This is a read-only file */
+
+  if ((oflags & O_WRONLY) != 0 || (oflags & O_RDONLY) == 0)
+    {
+      return -EACCES;
+    }
+
+  return OK;
+}
+
+static int pagecache_procfs_close(FAR struct file *filep)
+{
+  return OK;
+}
+
+static ssize_t pagecache_procfs_read(FAR struct file *filep,
+                                     FAR char *buffer, size_t buflen)
+{
+  struct pagecache_stats_s stats;
+  char buf[256];
+  size_t linesize;
+
+  pagecache_stats(&stats);
+
+  linesize = procfs_snprintf(buf, sizeof(buf),
+                             "Devices:    %10" PRIu32 "\n"
+                             "Pages:      %10" PRIu32 "\n"
+                             "Dirty:      %10" PRIu32 "\n"
+                             "Bytes:      %10zu\n"
+                             "Hits:       %10" PRIu32 "\n"
+                             "Misses:     %10" PRIu32 "\n"
+                             "Evictions:  %10" PRIu32 "\n"
+                             "Writebacks: %10" PRIu32 "\n"
+                             "Shrinks:    %10" PRIu32 "\n",
+                             stats.devices, stats.pages, stats.dirty,
+                             stats.bytes, stats.hits, stats.misses,
+                             stats.evictions, stats.writebacks,
+                             stats.shrinks);
+
+  return procfs_memcpy(buf, linesize, buffer, buflen, &filep->f_pos);
+}
+
+static int pagecache_procfs_dup(FAR const struct file *oldp,
+                                FAR struct file *newp)
+{
+  return OK;
+}
+
+static int pagecache_procfs_stat(FAR const char *relpath,
+                                 FAR struct stat *buf)
+{
+  memset(buf, 0, sizeof(struct stat));
+  buf->st_mode = S_IFREG | S_IROTH | S_IRGRP | S_IRUSR;
+  return OK;
+}
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+const struct procfs_operations g_pagecache_operations =
+{
+  pagecache_procfs_open,    /* open */
+  pagecache_procfs_close,   /* close */
+  pagecache_procfs_read,    /* read */
+  NULL,                     /* write */
+  NULL,                     /* poll */
+  pagecache_procfs_dup,     /* dup */
+  NULL,                     /* opendir */
+  NULL,                     /* closedir */
+  NULL,                     /* readdir */
+  NULL,                     /* rewinddir */
+  pagecache_procfs_stat     /* stat */
+};
+
+#endif
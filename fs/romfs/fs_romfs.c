@@ -1250,7 +1250,7 @@ static int romfs_unbind(FAR void *handle, FAR struct inode **blkdriver,
         }
 
 #ifdef CONFIG_FS_ROMFS_CACHE_NODE
-      romfs_freenode(rm->rm_root);
+      romfs_freenode(rm);
 #endif
       nxrmutex_destroy(&rm->rm_lock);
       fs_heap_free(rm);
@@ -124,11 +124,13 @@
  */
 
 struct romfs_file_s;
+struct romfs_slab_s;
 struct romfs_mountpt_s
 {
   FAR struct inode *rm_blkdriver; /* The block driver inode that hosts the romfs */
 #ifdef CONFIG_FS_ROMFS_CACHE_NODE
   FAR struct romfs_nodeinfo_s *rm_root; /* The node for root node */
+  FAR struct romfs_slab_s *rm_slab;     /* Memory of the cached nodes */
 #else
   uint32_t rm_rootoffset;         /* Saved offset to the first root directory entry */
 #endif
@@ -166,6 +168,7 @@ struct romfs_nodeinfo_s
   uint32_t rn_next;                        /* Offset of the next file header+flags */
   uint32_t rn_size;                        /* Size (if file) */
 #ifdef CONFIG_FS_ROMFS_CACHE_NODE
+  uint32_t rn_start;                       /* Offset of the file data (if file) */
   FAR struct romfs_nodeinfo_s **rn_child;  /* The node array for link to lower level */
   uint16_t rn_count;                       /* The count of node in rn_child level */
   uint8_t  rn_namesize;                    /* The length of name of the entry */
@@ -211,7 +214,7 @@ int  romfs_datastart(FAR struct romfs_mountpt_s *rm,
                      FAR struct romfs_nodeinfo_s *nodeinfo,
                      FAR uint32_t *start);
 #ifdef CONFIG_FS_ROMFS_CACHE_NODE
-void romfs_freenode(FAR struct romfs_nodeinfo_s *node);
+void romfs_freenode(FAR struct romfs_mountpt_s *rm);
 #endif
 
 #undef EXTERN
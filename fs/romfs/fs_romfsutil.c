@@ -28,6 +28,7 @@
 
 #include <nuttx/config.h>
 
+#include <sys/param.h>
 #include <sys/types.h>
 #include <inttypes.h>
 #include <stdlib.h>
@@ -51,6 +52,11 @@
 #define LINK_FOLLOWED     1
 #define NODEINFO_NINCR    4
 
+/* Allocations from a slab are aligned to pointers */
+
+#define SLAB_ALIGNUP(s)   (((s) + sizeof(uintptr_t) - 1) & \
+                           ~(sizeof(uintptr_t) - 1))
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -61,6 +67,19 @@ struct romfs_entryname_s
   size_t re_len;
 };
 
+/* The cached nodes of a mountpoint are carved from a list of slabs and are
+ * freed all at once when the file system is unmounted.
+ */
+
+#ifdef CONFIG_FS_ROMFS_CACHE_NODE
+struct romfs_slab_s
+{
+  FAR struct romfs_slab_s *rs_next; /* Next slab of the mountpoint */
+  size_t rs_size;                   /* Size of the memory after the header */
+  size_t rs_used;                   /* Bytes of the memory in use */
+};
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -267,6 +286,107 @@ static int romfs_followhardlinks(FAR struct romfs_mountpt_s *rm,
   return -ELOOP;
 }
 
+/****************************************************************************
+ * Name: romfs_finddatastart
+ *
+ * Description:
+ *   Given the offset to a file header, return the offset to the start of
+ *   the file data, which follows the name in the header.
+ *
+ ****************************************************************************/
+
+static int romfs_finddatastart(FAR struct romfs_mountpt_s *rm,
+                               uint32_t offset, FAR uint32_t *start)
+{
+  int16_t ndx;
+
+  /* Loop until the header size is obtained. */
+
+  offset += ROMFS_FHDR_NAME;
+  for (; ; )
+    {
+      /* Read the sector into memory */
+
+      ndx = romfs_devcacheread(rm, offset);
+      if (ndx < 0)
+        {
+          return ndx;
+        }
+
+      /* Get the offset to the next chunk */
+
+      offset += 16;
+      if (offset > rm->rm_volsize)
+        {
+          return -EIO;
+        }
+
+      /* Is the name terminated in this 16-byte block */
+
+      if (rm->rm_buffer[ndx + 15] == '\0')
+        {
+          /* Yes.. then the data starts at the next chunk */
+
+          *start = offset;
+          return 0;
+        }
+    }
+
+  return -EINVAL; /* Won't get here */
+}
+
+/****************************************************************************
+ * Name: romfs_slaballoc
+ *
+ * Description:
+ *   Allocate zeroed memory for the node cache.  Small allocations share
+ *   slabs of CONFIG_FS_ROMFS_CACHE_NODE_SLABSIZE bytes, larger ones get a
+ *   slab of their own.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_ROMFS_CACHE_NODE
+static FAR void *romfs_slaballoc(FAR struct romfs_mountpt_s *rm,
+                                 size_t size)
+{
+  FAR struct romfs_slab_s *slab = rm->rm_slab;
+  size_t hdrsize = SLAB_ALIGNUP(sizeof(struct romfs_slab_s));
+  FAR uint8_t *mem;
+
+  size = SLAB_ALIGNUP(size);
+  if (slab == NULL || slab->rs_size - slab->rs_used < size)
+    {
+      size_t slabsize = MAX(size, CONFIG_FS_ROMFS_CACHE_NODE_SLABSIZE);
+
+      slab = fs_heap_zalloc(hdrsize + slabsize);
+      if (slab == NULL)
+        {
+          return NULL;
+        }
+
+      slab->rs_size = slabsize;
+
+      /* Keep the slab with the most free space at the head of the list */
+
+      if (rm->rm_slab != NULL && slabsize - size <
+          rm->rm_slab->rs_size - rm->rm_slab->rs_used)
+        {
+          slab->rs_next        = rm->rm_slab->rs_next;
+          rm->rm_slab->rs_next = slab;
+        }
+      else
+        {
+          slab->rs_next = rm->rm_slab;
+          rm->rm_slab   = slab;
+        }
+    }
+
+  mem            = (FAR uint8_t *)slab + hdrsize + slab->rs_used;
+  slab->rs_used += size;
+  return mem;
+}
+#endif
+
 /****************************************************************************
  * Name: romfs_nodeinfo_search/romfs_nodeinfo_compare
  *
@@ -412,7 +532,7 @@ static int romfs_cachenode(FAR struct romfs_mountpt_s *rm,
                            uint32_t size, FAR const char *name,
                            FAR struct romfs_nodeinfo_s **pnodeinfo)
 {
-  FAR struct romfs_nodeinfo_s **child;
+  FAR struct romfs_nodeinfo_s **child = NULL;
   FAR struct romfs_nodeinfo_s *nodeinfo;
   char childname[NAME_MAX + 1];
   uint32_t linkoffset;
@@ -422,7 +542,7 @@ static int romfs_cachenode(FAR struct romfs_mountpt_s *rm,
   int ret;
 
   nsize = strlen(name);
-  nodeinfo = fs_heap_zalloc(sizeof(struct romfs_nodeinfo_s) + nsize);
+  nodeinfo = romfs_slaballoc(rm, sizeof(struct romfs_nodeinfo_s) + nsize);
   if (nodeinfo == NULL)
     {
       return -ENOMEM;
@@ -435,12 +555,15 @@ static int romfs_cachenode(FAR struct romfs_mountpt_s *rm,
   memcpy(nodeinfo->rn_name, name, nsize + 1);
   if (!IS_DIRECTORY(next))
     {
+      /* Save where the data starts, so that open() does not have to read
+       * the header again.  The header is the one of the file that a hard
+       * link refers to, which has a name of its own.
+       */
+
       nodeinfo->rn_size = size;
-      return 0;
+      return romfs_finddatastart(rm, offset, &nodeinfo->rn_start);
     }
 
-  child = nodeinfo->rn_child;
-
   do
     {
       /* Parse the directory entry at this offset (which may be re-directed
@@ -451,47 +574,50 @@ static int romfs_cachenode(FAR struct romfs_mountpt_s *rm,
                                 &size);
       if (ret < 0)
         {
-          return ret;
+          goto errout;
         }
 
       ret = romfs_parsefilename(rm, offset, childname);
       if (ret < 0)
         {
-          return ret;
+          goto errout;
         }
 
       if (strcmp(childname, ".") != 0 && strcmp(childname, "..") != 0)
         {
-          if (child == NULL || nodeinfo->rn_count == num - 1)
+          /* Collect the children in a temporary array until their number
+           * is known.
+           */
+
+          if (nodeinfo->rn_count == num)
             {
               FAR void *tmp;
 
-              tmp = fs_heap_realloc(nodeinfo->rn_child,
-                    (num + NODEINFO_NINCR) * sizeof(*nodeinfo->rn_child));
+              tmp = fs_heap_realloc(child, (num + NODEINFO_NINCR) *
+                                    sizeof(*child));
               if (tmp == NULL)
                 {
-                  return -ENOMEM;
+                  ret = -ENOMEM;
+                  goto errout;
                 }
 
-              nodeinfo->rn_child = tmp;
-              memset(nodeinfo->rn_child + num, 0, NODEINFO_NINCR *
-                     sizeof(*nodeinfo->rn_child));
+              child = tmp;
               num += NODEINFO_NINCR;
             }
 
-          child = &nodeinfo->rn_child[nodeinfo->rn_count++];
           if (IS_DIRECTORY(next))
             {
               linkoffset = info;
             }
 
-          ret = romfs_cachenode(rm, linkoffset, next, size,
-                                childname, child);
+          ret = romfs_cachenode(rm, linkoffset, next, size, childname,
+                                &child[nodeinfo->rn_count]);
           if (ret < 0)
             {
-              nodeinfo->rn_count--;
-              return ret;
+              goto errout;
             }
+
+          nodeinfo->rn_count++;
         }
 
       next &= RFNEXT_OFFSETMASK;
@@ -499,13 +625,30 @@ static int romfs_cachenode(FAR struct romfs_mountpt_s *rm,
     }
   while (next != 0);
 
-  if (nodeinfo->rn_count > 1)
+  if (nodeinfo->rn_count > 0)
     {
-      qsort(nodeinfo->rn_child, nodeinfo->rn_count,
-            sizeof(*nodeinfo->rn_child), romfs_nodeinfo_compare);
+      nodeinfo->rn_child = romfs_slaballoc(rm, nodeinfo->rn_count *
+                                           sizeof(*child));
+      if (nodeinfo->rn_child == NULL)
+        {
+          ret = -ENOMEM;
+          goto errout;
+        }
+
+      memcpy(nodeinfo->rn_child, child, nodeinfo->rn_count *
+             sizeof(*child));
+      if (nodeinfo->rn_count > 1)
+        {
+          qsort(nodeinfo->rn_child, nodeinfo->rn_count,
+                sizeof(*nodeinfo->rn_child), romfs_nodeinfo_compare);
+        }
     }
 
-  return 0;
+  ret = 0;
+
+errout:
+  fs_heap_free(child);
+  return ret;
 }
 #endif
 
@@ -776,7 +919,7 @@ int romfs_fsconfigure(FAR struct romfs_mountpt_s *rm)
                                       RFNEXT_DIRECTORY, 0, "", &rm->rm_root);
   if (ndx < 0)
     {
-      romfs_freenode(rm->rm_root);
+      romfs_freenode(rm);
       return ndx;
     }
 #else
@@ -905,21 +1048,17 @@ int romfs_checkmount(FAR struct romfs_mountpt_s *rm)
  ****************************************************************************/
 
 #ifdef CONFIG_FS_ROMFS_CACHE_NODE
-void romfs_freenode(FAR struct romfs_nodeinfo_s *nodeinfo)
+void romfs_freenode(FAR struct romfs_mountpt_s *rm)
 {
-  int i;
+  FAR struct romfs_slab_s *slab;
 
-  if (IS_DIRECTORY(nodeinfo->rn_next))
+  while ((slab = rm->rm_slab) != NULL)
     {
-      for (i = 0; i < nodeinfo->rn_count; i++)
-        {
-          romfs_freenode(nodeinfo->rn_child[i]);
-        }
-
-      fs_heap_free(nodeinfo->rn_child);
+      rm->rm_slab = slab->rs_next;
+      fs_heap_free(slab);
     }
 
-  fs_heap_free(nodeinfo);
+  rm->rm_root = NULL;
 }
 #endif
 
@@ -1180,45 +1319,9 @@ int romfs_datastart(FAR struct romfs_mountpt_s *rm,
                     FAR uint32_t *start)
 {
 #ifdef CONFIG_FS_ROMFS_CACHE_NODE
-  *start = ROMFS_ALIGNUP(nodeinfo->rn_offset +
-                         ROMFS_FHDR_NAME + nodeinfo->rn_namesize + 1);
+  *start = nodeinfo->rn_start;
   return 0;
 #else
-  uint32_t offset = nodeinfo->rn_offset;
-  int16_t ndx;
-
-  /* Loop until the header size is obtained. */
-
-  offset += ROMFS_FHDR_NAME;
-  for (; ; )
-    {
-      /* Read the sector into memory */
-
-      ndx = romfs_devcacheread(rm, offset);
-      if (ndx < 0)
-        {
-          return ndx;
-        }
-
-      /* Get the offset to the next chunk */
-
-      offset += 16;
-      if (offset > rm->rm_volsize)
-        {
-          return -EIO;
-        }
-
-      /* Is the name terminated in this 16-byte block */
-
-      if (rm->rm_buffer[ndx + 15] == '\0')
-        {
-          /* Yes.. then the data starts at the next chunk */
-
-          *start = offset;
-          return 0;
-        }
-    }
-
-  return -EINVAL; /* Won't get here */
+  return romfs_finddatastart(rm, nodeinfo->rn_offset, start);
 #endif
 }
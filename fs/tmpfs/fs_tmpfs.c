@@ -26,6 +26,7 @@
 
 #include <nuttx/config.h>
 
+#include <sys/param.h>
 #include <sys/stat.h>
 #include <sys/statfs.h>
 #include <stdint.h>
@@ -96,9 +97,27 @@ static int  tmpfs_realloc_directory(FAR struct tmpfs_directory_s *tdo,
               unsigned int nentries);
 static int  tmpfs_realloc_file(FAR struct tmpfs_file_s *tfo,
               size_t newsize);
+static void tmpfs_free_filedata(FAR struct tmpfs_file_s *tfo);
+static void tmpfs_read_filedata(FAR struct tmpfs_file_s *tfo,
+              FAR char *buffer, off_t pos, size_t nbytes);
+static int  tmpfs_write_filedata(FAR struct tmpfs_file_s *tfo,
+              FAR const char *buffer, off_t pos, size_t nbytes);
+static FAR uint8_t *tmpfs_map_filedata(FAR struct tmpfs_file_s *tfo,
+              off_t offset, size_t length);
 static void tmpfs_release_lockedobject(FAR struct tmpfs_object_s *to);
 static void tmpfs_release_lockedfile(FAR struct tmpfs_file_s *tfo);
 static int  tmpfs_release_file(FAR struct tmpfs_file_s *tfo);
+#ifdef CONFIG_FS_TMPFS_DIRECTORY_HASH
+static uint32_t tmpfs_hash_name(FAR const char *name, size_t len);
+static void tmpfs_link_dirent(FAR struct tmpfs_directory_s *tdo,
+              unsigned int index);
+static void tmpfs_unlink_dirent(FAR struct tmpfs_directory_s *tdo,
+              unsigned int index);
+static bool tmpfs_rehash_directory(FAR struct tmpfs_directory_s *tdo);
+#endif
+static void tmpfs_delete_dirent(FAR struct tmpfs_directory_s *tdo,
+              unsigned int index);
+static void tmpfs_free_dirents(FAR struct tmpfs_directory_s *tdo);
 static int  tmpfs_find_dirent(FAR struct tmpfs_directory_s *tdo,
               FAR const char *name, size_t len);
 static int  tmpfs_remove_dirent(FAR struct tmpfs_directory_s *tdo,
@@ -285,10 +304,186 @@ static int tmpfs_realloc_directory(FAR struct tmpfs_directory_s *tdo,
   return ret;
 }
 
+/****************************************************************************
+ * Name: tmpfs_page_inmap
+ *
+ * Description:
+ *   Return true if a data page is part of the contiguous block of a mapped
+ *   file rather than a separate allocation.
+ *
+ ****************************************************************************/
+
+#if TMPFS_PAGESIZE > 0
+static bool tmpfs_page_inmap(FAR struct tmpfs_file_s *tfo,
+                             FAR uint8_t *page)
+{
+  return tfo->tfo_map != NULL && page >= tfo->tfo_map &&
+         page < tfo->tfo_map + tfo->tfo_mapsize;
+}
+
+/****************************************************************************
+ * Name: tmpfs_migrate_file
+ *
+ * Description:
+ *   Move the data pages of a file into one contiguous block, so that
+ *   ranges spanning several pages can be mapped in place.  The page table
+ *   entries point into the block afterwards, so reads and writes are not
+ *   affected.  Pages mapped in place cannot move, so this fails while the
+ *   file has such mappings.
+ *
+ ****************************************************************************/
+
+static int tmpfs_migrate_file(FAR struct tmpfs_file_s *tfo)
+{
+  FAR uint8_t *block;
+  FAR uint8_t *page;
+  size_t npages;
+  size_t i;
+
+  if (tfo->tfo_nmaps > 0)
+    {
+      return -EBUSY;
+    }
+
+  npages = howmany(tfo->tfo_size, TMPFS_PAGESIZE);
+  block  = fs_heap_malloc(npages * TMPFS_PAGESIZE);
+  if (block == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  for (i = 0; i < tfo->tfo_npages; i++)
+    {
+      page = tfo->tfo_pages[i];
+      if (i < npages)
+        {
+          if (page != NULL)
+            {
+              memcpy(block + i * TMPFS_PAGESIZE, page, TMPFS_PAGESIZE);
+            }
+          else
+            {
+              memset(block + i * TMPFS_PAGESIZE, 0, TMPFS_PAGESIZE);
+            }
+
+          tfo->tfo_pages[i] = block + i * TMPFS_PAGESIZE;
+        }
+      else
+        {
+          tfo->tfo_pages[i] = NULL;
+        }
+
+      if (page != NULL && !tmpfs_page_inmap(tfo, page))
+        {
+          fs_heap_free(page);
+          tfo->tfo_alloc -= TMPFS_PAGESIZE;
+        }
+    }
+
+  fs_heap_free(tfo->tfo_map);
+  tfo->tfo_alloc  += npages * TMPFS_PAGESIZE - tfo->tfo_mapsize;
+  tfo->tfo_map     = block;
+  tfo->tfo_mapsize = npages * TMPFS_PAGESIZE;
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: tmpfs_realloc_file
  ****************************************************************************/
 
+#if TMPFS_PAGESIZE > 0
+static int tmpfs_realloc_file(FAR struct tmpfs_file_s *tfo,
+                              size_t newsize)
+{
+  FAR uint8_t **newpages;
+  size_t npages;
+  size_t nused;
+  size_t offset;
+  size_t i;
+
+  npages = howmany(newsize, TMPFS_PAGESIZE);
+  nused  = howmany(tfo->tfo_size, TMPFS_PAGESIZE);
+
+  if (npages > tfo->tfo_npages)
+    {
+      /* Grow the page table.  Only the table is reallocated, the data
+       * pages never move and new entries are holes until written.
+       */
+
+      i = MAX(npages, 2 * tfo->tfo_npages);
+      if (i > SIZE_MAX / sizeof(FAR uint8_t *))
+        {
+          return -ENOMEM;
+        }
+
+      newpages = fs_heap_realloc(tfo->tfo_pages, i * sizeof(FAR uint8_t *));
+      if (newpages == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      memset(&newpages[tfo->tfo_npages], 0,
+             (i - tfo->tfo_npages) * sizeof(FAR uint8_t *));
+
+      tfo->tfo_alloc += (i - tfo->tfo_npages) * sizeof(FAR uint8_t *);
+      tfo->tfo_pages  = newpages;
+      tfo->tfo_npages = i;
+    }
+  else if (newsize < tfo->tfo_size)
+    {
+      /* Shrinking ... Free the pages beyond the new end of the file.
+       * Pages of the contiguous block stay in place, cleared.
+       */
+
+      for (i = npages; i < nused; i++)
+        {
+          if (tfo->tfo_pages[i] == NULL)
+            {
+              continue;
+            }
+
+          if (tmpfs_page_inmap(tfo, tfo->tfo_pages[i]))
+            {
+              memset(tfo->tfo_pages[i], 0, TMPFS_PAGESIZE);
+            }
+          else
+            {
+              fs_heap_free(tfo->tfo_pages[i]);
+              tfo->tfo_pages[i] = NULL;
+              tfo->tfo_alloc -= TMPFS_PAGESIZE;
+            }
+        }
+
+      /* We should make sure the shrunk part of the last page be zero */
+
+      offset = newsize % TMPFS_PAGESIZE;
+      if (offset != 0 && tfo->tfo_pages[npages - 1] != NULL)
+        {
+          memset(tfo->tfo_pages[npages - 1] + offset, 0,
+                 TMPFS_PAGESIZE - offset);
+        }
+
+      /* Release the page table too if the file becomes empty and no
+       * mapping refers to its pages.
+       */
+
+      if (npages == 0 && tfo->tfo_nmaps == 0)
+        {
+          fs_heap_free(tfo->tfo_map);
+          fs_heap_free(tfo->tfo_pages);
+          tfo->tfo_map     = NULL;
+          tfo->tfo_mapsize = 0;
+          tfo->tfo_pages   = NULL;
+          tfo->tfo_npages  = 0;
+          tfo->tfo_alloc   = 0;
+        }
+    }
+
+  tfo->tfo_size = newsize;
+  return OK;
+}
+#else
 static int tmpfs_realloc_file(FAR struct tmpfs_file_s *tfo,
                               size_t newsize)
 {
@@ -362,6 +557,185 @@ static int tmpfs_realloc_file(FAR struct tmpfs_file_s *tfo,
   tfo->tfo_data  = newdata;
   return OK;
 }
+#endif
+
+/****************************************************************************
+ * Name: tmpfs_free_filedata
+ ****************************************************************************/
+
+static void tmpfs_free_filedata(FAR struct tmpfs_file_s *tfo)
+{
+#if TMPFS_PAGESIZE > 0
+  size_t i;
+
+  for (i = 0; i < tfo->tfo_npages; i++)
+    {
+      if (!tmpfs_page_inmap(tfo, tfo->tfo_pages[i]))
+        {
+          fs_heap_free(tfo->tfo_pages[i]);
+        }
+    }
+
+  fs_heap_free(tfo->tfo_map);
+  fs_heap_free(tfo->tfo_pages);
+  tfo->tfo_map     = NULL;
+  tfo->tfo_mapsize = 0;
+  tfo->tfo_pages   = NULL;
+  tfo->tfo_npages  = 0;
+#else
+  fs_heap_free(tfo->tfo_data);
+  tfo->tfo_data = NULL;
+#endif
+}
+
+/****************************************************************************
+ * Name: tmpfs_read_filedata
+ *
+ * Description:
+ *   Copy file data out of the file object.  Holes of a sparse file read
+ *   back as zeros.  The caller must have checked the range against the
+ *   file size.
+ *
+ ****************************************************************************/
+
+static void tmpfs_read_filedata(FAR struct tmpfs_file_s *tfo,
+                                FAR char *buffer, off_t pos, size_t nbytes)
+{
+#if TMPFS_PAGESIZE > 0
+  FAR uint8_t *page;
+  size_t offset;
+  size_t n;
+
+  while (nbytes > 0)
+    {
+      page   = tfo->tfo_pages[pos / TMPFS_PAGESIZE];
+      offset = pos % TMPFS_PAGESIZE;
+      n      = MIN(nbytes, TMPFS_PAGESIZE - offset);
+
+      if (page != NULL)
+        {
+          memcpy(buffer, page + offset, n);
+        }
+      else
+        {
+          memset(buffer, 0, n);
+        }
+
+      buffer += n;
+      pos    += n;
+      nbytes -= n;
+    }
+#else
+  if (nbytes > 0)
+    {
+      memcpy(buffer, &tfo->tfo_data[pos], nbytes);
+    }
+#endif
+}
+
+/****************************************************************************
+ * Name: tmpfs_write_filedata
+ *
+ * Description:
+ *   Copy data into the file object, allocating the pages backing holes as
+ *   they are written.  The file must already have been extended to cover
+ *   the range.
+ *
+ ****************************************************************************/
+
+static int tmpfs_write_filedata(FAR struct tmpfs_file_s *tfo,
+                                FAR const char *buffer, off_t pos,
+                                size_t nbytes)
+{
+#if TMPFS_PAGESIZE > 0
+  FAR uint8_t **page;
+  size_t offset;
+  size_t n;
+
+  while (nbytes > 0)
+    {
+      page   = &tfo->tfo_pages[pos / TMPFS_PAGESIZE];
+      offset = pos % TMPFS_PAGESIZE;
+      n      = MIN(nbytes, TMPFS_PAGESIZE - offset);
+
+      if (*page == NULL)
+        {
+          *page = fs_heap_zalloc(TMPFS_PAGESIZE);
+          if (*page == NULL)
+            {
+              return -ENOMEM;
+            }
+
+          tfo->tfo_alloc += TMPFS_PAGESIZE;
+        }
+
+      memcpy(*page + offset, buffer, n);
+
+      buffer += n;
+      pos    += n;
+      nbytes -= n;
+    }
+#else
+  if (nbytes > 0)
+    {
+      memcpy(&tfo->tfo_data[pos], buffer, nbytes);
+    }
+#endif
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: tmpfs_map_filedata
+ *
+ * Description:
+ *   Return the address of a range of file data if it is contiguous in
+ *   memory, or NULL if it is not.  With paged storage a range spanning
+ *   several pages is made contiguous by moving the file into one block,
+ *   which is only possible while no other mapping pins its pages.
+ *
+ ****************************************************************************/
+
+static FAR uint8_t *tmpfs_map_filedata(FAR struct tmpfs_file_s *tfo,
+                                       off_t offset, size_t length)
+{
+#if TMPFS_PAGESIZE > 0
+  FAR uint8_t **page;
+  size_t end;
+
+  if (tfo->tfo_size == 0)
+    {
+      return NULL;
+    }
+
+  end = offset + MAX(length, 1);
+  if (offset / TMPFS_PAGESIZE != (end - 1) / TMPFS_PAGESIZE)
+    {
+      if (end > tfo->tfo_mapsize && tmpfs_migrate_file(tfo) < 0)
+        {
+          return NULL;
+        }
+
+      return tfo->tfo_map + offset;
+    }
+
+  page = &tfo->tfo_pages[offset / TMPFS_PAGESIZE];
+  if (*page == NULL)
+    {
+      *page = fs_heap_zalloc(TMPFS_PAGESIZE);
+      if (*page == NULL)
+        {
+          return NULL;
+        }
+
+      tfo->tfo_alloc += TMPFS_PAGESIZE;
+    }
+
+  return *page + offset % TMPFS_PAGESIZE;
+#else
+  return tfo->tfo_data + offset;
+#endif
+}
 
 /****************************************************************************
  * Name: tmpfs_release_lockedobject
@@ -400,7 +774,7 @@ static void tmpfs_release_lockedfile(FAR struct tmpfs_file_s *tfo)
     {
       tmpfs_unlock_file(tfo);
       nxrmutex_destroy(&tfo->tfo_lock);
-      fs_heap_free(tfo->tfo_data);
+      tmpfs_free_filedata(tfo);
       fs_heap_free(tfo);
     }
 
@@ -435,6 +809,187 @@ static int tmpfs_release_file(FAR struct tmpfs_file_s *tfo)
   return OK;
 }
 
+#ifdef CONFIG_FS_TMPFS_DIRECTORY_HASH
+
+/****************************************************************************
+ * Name: tmpfs_hash_name
+ *
+ * Description:
+ *   FNV-1a hash of a directory entry name.
+ *
+ ****************************************************************************/
+
+static uint32_t tmpfs_hash_name(FAR const char *name, size_t len)
+{
+  uint32_t hash = 2166136261u;
+
+  while (len-- > 0)
+    {
+      hash ^= (uint8_t)*name++;
+      hash *= 16777619u;
+    }
+
+  return hash;
+}
+
+/****************************************************************************
+ * Name: tmpfs_link_dirent
+ ****************************************************************************/
+
+static void tmpfs_link_dirent(FAR struct tmpfs_directory_s *tdo,
+                              unsigned int index)
+{
+  FAR struct tmpfs_dirent_s *tde = &tdo->tdo_entry[index];
+  FAR uint16_t *bucket;
+
+  bucket        = &tdo->tdo_bucket[tde->tde_hash & (tdo->tdo_nbuckets - 1)];
+  tde->tde_next = *bucket;
+  *bucket       = index;
+}
+
+/****************************************************************************
+ * Name: tmpfs_unlink_dirent
+ ****************************************************************************/
+
+static void tmpfs_unlink_dirent(FAR struct tmpfs_directory_s *tdo,
+                                unsigned int index)
+{
+  FAR struct tmpfs_dirent_s *tde = &tdo->tdo_entry[index];
+  FAR uint16_t *next;
+
+  next = &tdo->tdo_bucket[tde->tde_hash & (tdo->tdo_nbuckets - 1)];
+  while (*next != index)
+    {
+      DEBUGASSERT(*next != TMPFS_NO_DIRENT);
+      next = &tdo->tdo_entry[*next].tde_next;
+    }
+
+  *next = tde->tde_next;
+}
+
+/****************************************************************************
+ * Name: tmpfs_rehash_directory
+ *
+ * Description:
+ *   Grow the hash table of a directory once it holds more entries than
+ *   buckets.  If the new table cannot be allocated, the old one (possibly
+ *   none, in which case lookups fall back to a linear search) is kept.
+ *
+ * Returned Value:
+ *   True if the table was rebuilt and all entries were relinked.
+ *
+ ****************************************************************************/
+
+static bool tmpfs_rehash_directory(FAR struct tmpfs_directory_s *tdo)
+{
+  FAR uint16_t *bucket;
+  unsigned int nbuckets;
+  unsigned int i;
+
+  if (tdo->tdo_nentries <= tdo->tdo_nbuckets)
+    {
+      return false;
+    }
+
+  nbuckets = tdo->tdo_nbuckets > 0 ? 2 * tdo->tdo_nbuckets : 8;
+  while (nbuckets < tdo->tdo_nentries)
+    {
+      nbuckets *= 2;
+    }
+
+  if (nbuckets > TMPFS_NO_DIRENT / 2 + 1)
+    {
+      return false;
+    }
+
+  bucket = fs_heap_malloc(nbuckets * sizeof(uint16_t));
+  if (bucket == NULL)
+    {
+      return false;
+    }
+
+  memset(bucket, 0xff, nbuckets * sizeof(uint16_t));
+  fs_heap_free(tdo->tdo_bucket);
+
+  tdo->tdo_bucket   = bucket;
+  tdo->tdo_nbuckets = nbuckets;
+
+  for (i = 0; i < tdo->tdo_nentries; i++)
+    {
+      tmpfs_link_dirent(tdo, i);
+    }
+
+  return true;
+}
+
+#endif /* CONFIG_FS_TMPFS_DIRECTORY_HASH */
+
+/****************************************************************************
+ * Name: tmpfs_delete_dirent
+ *
+ * Description:
+ *   Free the name of a directory entry and remove the entry by replacing
+ *   it with the final directory entry.
+ *
+ ****************************************************************************/
+
+static void tmpfs_delete_dirent(FAR struct tmpfs_directory_s *tdo,
+                                unsigned int index)
+{
+  unsigned int last = tdo->tdo_nentries - 1;
+
+  /* Free the object name */
+
+  if (tdo->tdo_entry[index].tde_name != NULL)
+    {
+      fs_heap_free(tdo->tdo_entry[index].tde_name);
+    }
+
+#ifdef CONFIG_FS_TMPFS_DIRECTORY_HASH
+  if (tdo->tdo_nbuckets > 0)
+    {
+      tmpfs_unlink_dirent(tdo, index);
+      if (index != last)
+        {
+          tmpfs_unlink_dirent(tdo, last);
+        }
+    }
+#endif
+
+  /* Remove by replacing this entry with the final directory entry */
+
+  if (index != last)
+    {
+      tdo->tdo_entry[index] = tdo->tdo_entry[last];
+#ifdef CONFIG_FS_TMPFS_DIRECTORY_HASH
+      if (tdo->tdo_nbuckets > 0)
+        {
+          tmpfs_link_dirent(tdo, index);
+        }
+#endif
+    }
+
+  /* And decrement the count of directory entries */
+
+  tdo->tdo_nentries = last;
+}
+
+/****************************************************************************
+ * Name: tmpfs_free_dirents
+ ****************************************************************************/
+
+static void tmpfs_free_dirents(FAR struct tmpfs_directory_s *tdo)
+{
+  fs_heap_free(tdo->tdo_entry);
+  tdo->tdo_entry = NULL;
+
+#ifdef CONFIG_FS_TMPFS_DIRECTORY_HASH
+  fs_heap_free(tdo->tdo_bucket);
+  tdo->tdo_bucket   = NULL;
+  tdo->tdo_nbuckets = 0;
+#endif
+}
+
 /****************************************************************************
  * Name: tmpfs_find_dirent
  ****************************************************************************/
@@ -458,6 +1013,30 @@ static int tmpfs_find_dirent(FAR struct tmpfs_directory_s *tdo,
         }
     }
 
+#ifdef CONFIG_FS_TMPFS_DIRECTORY_HASH
+  /* Walk the hash chain if the directory has a hash table */
+
+  if (tdo->tdo_nbuckets > 0)
+    {
+      uint32_t hash = tmpfs_hash_name(name, len);
+
+      for (i = tdo->tdo_bucket[hash & (tdo->tdo_nbuckets - 1)];
+           i != TMPFS_NO_DIRENT; i = tdo->tdo_entry[i].tde_next)
+        {
+          FAR struct tmpfs_dirent_s *tde = &tdo->tdo_entry[i];
+
+          if (tde->tde_hash == hash &&
+              strncmp(tde->tde_name, name, len) == 0 &&
+              tde->tde_name[len] == 0)
+            {
+              return i;
+            }
+        }
+
+      return -ENOENT;
+    }
+#endif
+
   /* Search the list of directory entries for a match */
 
   for (i = 0;
@@ -479,7 +1058,6 @@ static int tmpfs_remove_dirent(FAR struct tmpfs_directory_s *tdo,
                                FAR const char *name)
 {
   int index;
-  int last;
 
   /* Search the list of directory entries for a match */
 
@@ -489,24 +1067,7 @@ static int tmpfs_remove_dirent(FAR struct tmpfs_directory_s *tdo,
       return index;
     }
 
-  /* Free the object name */
-
-  if (tdo->tdo_entry[index].tde_name != NULL)
-    {
-      fs_heap_free(tdo->tdo_entry[index].tde_name);
-    }
-
-  /* Remove by replacing this entry with the final directory entry */
-
-  last = tdo->tdo_nentries - 1;
-  if (index != last)
-    {
-      tdo->tdo_entry[index] = tdo->tdo_entry[last];
-    }
-
-  /* And decrement the count of directory entries */
-
-  tdo->tdo_nentries = last;
+  tmpfs_delete_dirent(tdo, index);
   return OK;
 }
 
@@ -543,6 +1104,15 @@ static int tmpfs_add_dirent(FAR struct tmpfs_directory_s *tdo,
         }
     }
 
+#ifdef CONFIG_FS_TMPFS_DIRECTORY_HASH
+  /* The hash chains link entries by 16-bit index */
+
+  if (tdo->tdo_nentries >= TMPFS_NO_DIRENT)
+    {
+      return -ENOSPC;
+    }
+#endif
+
   newname = fs_heap_strndup(name, namelen);
   if (newname == NULL)
     {
@@ -569,6 +1139,16 @@ static int tmpfs_add_dirent(FAR struct tmpfs_directory_s *tdo,
   tde->tde_object = to;
   tde->tde_name   = newname;
 
+#ifdef CONFIG_FS_TMPFS_DIRECTORY_HASH
+  /* Hash the new entry, growing the hash table first if needed */
+
+  tde->tde_hash   = tmpfs_hash_name(newname, namelen);
+  if (!tmpfs_rehash_directory(tdo) && tdo->tdo_nbuckets > 0)
+    {
+      tmpfs_link_dirent(tdo, index);
+    }
+#endif
+
   return OK;
 }
 
@@ -749,7 +1329,15 @@ tmpfs_alloc_file(FAR struct tmpfs_directory_s *parent, mode_t mode)
   tfo->tfo_parent = parent;
   tfo->tfo_flags  = 0;
   tfo->tfo_size   = 0;
+#if TMPFS_PAGESIZE > 0
+  tfo->tfo_npages = 0;
+  tfo->tfo_pages  = NULL;
+  tfo->tfo_map    = NULL;
+  tfo->tfo_mapsize = 0;
+  tfo->tfo_nmaps  = 0;
+#else
   tfo->tfo_data   = NULL;
+#endif
 
 #ifdef CONFIG_FS_PERMISSION
   tmpfs_init_object((FAR struct tmpfs_object_s *)tfo, mode);
@@ -1368,8 +1956,14 @@ static int tmpfs_statfs_callout(FAR struct tmpfs_directory_s *tdo,
 
       tmptfo             = (FAR struct tmpfs_file_s *)to;
       tmpbuf->tsf_alloc += sizeof(struct tmpfs_file_s);
-      tmpbuf->tsf_avail += to->to_alloc - tmptfo->tfo_size;
       tmpbuf->tsf_files++;
+
+      /* Holes in sparse files are not backed by memory */
+
+      if (to->to_alloc > tmptfo->tfo_size)
+        {
+          tmpbuf->tsf_avail += to->to_alloc - tmptfo->tfo_size;
+        }
     }
   else /* if (to->to_type == TMPFS_DIRECTORY) */
     {
@@ -1399,34 +1993,13 @@ static int tmpfs_statfs_callout(FAR struct tmpfs_directory_s *tdo,
 static int tmpfs_free_callout(FAR struct tmpfs_directory_s *tdo,
                               unsigned int index, FAR void *arg)
 {
-  FAR struct tmpfs_dirent_s *tde;
   FAR struct tmpfs_object_s *to;
   FAR struct tmpfs_file_s *tfo;
-  unsigned int last;
-
-  /* Free the object name */
-
-  if (tdo->tdo_entry[index].tde_name != NULL)
-    {
-      fs_heap_free(tdo->tdo_entry[index].tde_name);
-    }
 
-  /* Remove by replacing this entry with the final directory entry */
+  /* Remove the directory entry */
 
-  tde  = &tdo->tdo_entry[index];
-  to   = tde->tde_object;
-  last = tdo->tdo_nentries - 1;
-
-  if (index != last)
-    {
-      /* Move the directory entry */
-
-      *tde = tdo->tdo_entry[last];
-    }
-
-  /* And decrement the count of directory entries */
-
-  tdo->tdo_nentries = last;
+  to = tdo->tdo_entry[index].tde_object;
+  tmpfs_delete_dirent(tdo, index);
 
   /* Is this directory entry a file object? */
 
@@ -1444,13 +2017,13 @@ static int tmpfs_free_callout(FAR struct tmpfs_directory_s *tdo,
           return TMPFS_UNLINKED;
         }
 
-      fs_heap_free(tfo->tfo_data);
+      tmpfs_free_filedata(tfo);
     }
   else /* if (to->to_type == TMPFS_DIRECTORY) */
     {
       tdo = (FAR struct tmpfs_directory_s *)to;
 
-      fs_heap_free(tdo->tdo_entry);
+      tmpfs_free_dirents(tdo);
     }
 
   /* Free the object now */
@@ -1786,15 +2359,8 @@ static ssize_t tmpfs_read(FAR struct file *filep, FAR char *buffer,
 
   /* Copy data from the memory object to the user buffer */
 
-  if (tfo->tfo_data != NULL)
-    {
-      memcpy(buffer, &tfo->tfo_data[startpos], nread);
-      filep->f_pos += nread;
-    }
-  else
-    {
-      DEBUGASSERT(tfo->tfo_size == 0 && nread == 0);
-    }
+  tmpfs_read_filedata(tfo, buffer, startpos, nread);
+  filep->f_pos += nread;
 
   /* Release the lock on the file */
 
@@ -1811,6 +2377,7 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
 {
   FAR struct tmpfs_file_s *tfo;
   ssize_t nwritten;
+  size_t oldsize;
   off_t startpos;
   off_t endpos;
   int ret;
@@ -1844,6 +2411,7 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
 
   nwritten = buflen;
   endpos   = startpos + buflen;
+  oldsize  = tfo->tfo_size;
 
   if (endpos > tfo->tfo_size)
     {
@@ -1856,15 +2424,17 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
         }
     }
 
-  /* Copy data from the memory object to the user buffer */
+  /* Copy data from the user buffer to the memory object */
 
-  if (tfo->tfo_data != NULL)
-    {
-      memcpy(&tfo->tfo_data[startpos], buffer, nwritten);
-    }
-  else
+  ret = tmpfs_write_filedata(tfo, buffer, startpos, nwritten);
+  if (ret < 0)
     {
-      DEBUGASSERT(tfo->tfo_size == 0 && nwritten == 0);
+      if (endpos > oldsize)
+        {
+          tmpfs_realloc_file(tfo, oldsize);
+        }
+
+      goto errout_with_lock;
     }
 
   filep->f_pos = endpos;
@@ -1953,7 +2523,14 @@ static int tmpfs_unmap(FAR struct task_group_s *group,
       ret = mm_map_remove(get_group_mm(group), entry);
       if (ret >= 0)
         {
-          ret = tmpfs_release_file(tfo);
+          ret = tmpfs_lock_file(tfo);
+          if (ret >= 0)
+            {
+#if TMPFS_PAGESIZE > 0
+              tfo->tfo_nmaps--;
+#endif
+              tmpfs_release_lockedfile(tfo);
+            }
         }
     }
 
@@ -1988,17 +2565,35 @@ static int tmpfs_mmap(FAR struct file *filep, FAR struct mm_map_entry_s *map)
   if (map->offset >= 0 && map->offset < tfo->tfo_size &&
       map->length && map->offset + map->length <= tfo->tfo_size)
     {
-      map->vaddr = tfo->tfo_data + map->offset;
-      map->priv.p = tfo;
-      map->munmap = tmpfs_unmap;
-      ret = mm_map_add(get_current_mm(), map);
+      tmpfs_lock_file(tfo);
 
-      if (ret >= 0)
+      /* A range that cannot be made contiguous in memory (the file has
+       * to move while another mapping pins its pages, or there is no
+       * memory for the move) cannot be mapped in place, return -ENOTTY
+       * so that the caller falls back to a copy of the file.
+       */
+
+      map->vaddr = tmpfs_map_filedata(tfo, map->offset, map->length);
+      if (map->vaddr == NULL)
         {
-          tmpfs_lock_file(tfo);
-          tfo->tfo_refs++;
-          tmpfs_unlock_file(tfo);
+          ret = -ENOTTY;
+        }
+      else
+        {
+          map->priv.p = tfo;
+          map->munmap = tmpfs_unmap;
+          ret = mm_map_add(get_current_mm(), map);
+
+          if (ret >= 0)
+            {
+              tfo->tfo_refs++;
+#if TMPFS_PAGESIZE > 0
+              tfo->tfo_nmaps++;
+#endif
+            }
         }
+
+      tmpfs_unlock_file(tfo);
     }
 
   return ret;
@@ -2042,7 +2637,16 @@ static int tmpfs_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
     {
       FAR uintptr_t *ptr = (FAR uintptr_t *)arg;
 
-      *ptr = (uintptr_t)tfo->tfo_data;
+#if TMPFS_PAGESIZE > 0
+      if (tfo->tfo_size > TMPFS_PAGESIZE)
+        {
+          return -ENOTTY;
+        }
+#endif
+
+      tmpfs_lock_file(tfo);
+      *ptr = (uintptr_t)tmpfs_map_filedata(tfo, 0, tfo->tfo_size);
+      tmpfs_unlock_file(tfo);
       return OK;
     }
 
@@ -2206,14 +2810,16 @@ static int tmpfs_truncate(FAR struct file *filep, off_t length)
           goto errout_with_lock;
         }
 
+#if TMPFS_PAGESIZE == 0
       /* If the size has increased, then we need to zero the newly added
-       * memory.
+       * memory.  Paged files read holes back as zeros already.
        */
 
       if (length > oldsize)
         {
           memset(&tfo->tfo_data[oldsize], 0, length - oldsize);
         }
+#endif
 
       ret = OK;
     }
@@ -2500,7 +3106,7 @@ static int tmpfs_unbind(FAR void *handle, FAR struct inode **blkdriver,
   /* Now we can destroy the root file system and the file system itself. */
 
   nxrmutex_destroy(&tdo->tdo_lock);
-  fs_heap_free(tdo->tdo_entry);
+  tmpfs_free_dirents(tdo);
   fs_heap_free(tdo);
 
   nxrmutex_destroy(&fs->tfs_lock);
@@ -2667,7 +3273,7 @@ static int tmpfs_unlink(FAR struct inode *mountpt, FAR const char *relpath)
   else
     {
       nxrmutex_destroy(&tfo->tfo_lock);
-      fs_heap_free(tfo->tfo_data);
+      tmpfs_free_filedata(tfo);
       fs_heap_free(tfo);
     }
 
@@ -2809,7 +3415,7 @@ static int tmpfs_rmdir(FAR struct inode *mountpt, FAR const char *relpath)
   /* Free the directory object */
 
   nxrmutex_destroy(&tdo->tdo_lock);
-  fs_heap_free(tdo->tdo_entry);
+  tmpfs_free_dirents(tdo);
   fs_heap_free(tdo);
 
   /* Release the reference and lock on the parent directory */
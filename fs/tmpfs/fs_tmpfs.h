@@ -44,6 +44,16 @@
 
 #define TFO_FLAG_UNLINKED (1 << 0)  /* Bit 0: File is unlinked */
 
+/* Size of the pages holding the file data; zero keeps each file in one
+ * contiguous allocation.
+ */
+
+#define TMPFS_PAGESIZE    CONFIG_FS_TMPFS_PAGESIZE
+
+/* Ends a chain of directory entries of a hash bucket */
+
+#define TMPFS_NO_DIRENT   UINT16_MAX
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -72,6 +82,10 @@ struct tmpfs_dirent_s
 {
   FAR struct tmpfs_object_s *tde_object;
   FAR char *tde_name;
+#ifdef CONFIG_FS_TMPFS_DIRECTORY_HASH
+  uint32_t tde_hash;     /* Hash of the name */
+  uint16_t tde_next;     /* Next entry in the same hash bucket */
+#endif
 };
 
 /* The generic form of a TMPFS memory object */
@@ -113,6 +127,13 @@ struct tmpfs_directory_s
 
   uint16_t tdo_nentries; /* Number of directory entries */
   FAR struct tmpfs_dirent_s *tdo_entry;
+#ifdef CONFIG_FS_TMPFS_DIRECTORY_HASH
+  uint16_t tdo_nbuckets; /* Number of hash buckets, a power of two */
+
+  /* First entry of each hash bucket */
+
+  FAR uint16_t *tdo_bucket;
+#endif
 };
 
 #define SIZEOF_TMPFS_DIRECTORY(n) ((n) * sizeof(struct tmpfs_dirent_s))
@@ -145,7 +166,15 @@ struct tmpfs_file_s
 
   uint8_t       tfo_flags; /* See TFO_FLAG_* definitions */
   size_t        tfo_size;  /* Valid file size */
+#if TMPFS_PAGESIZE > 0
+  size_t        tfo_npages;  /* Number of entries in tfo_pages */
+  FAR uint8_t **tfo_pages;   /* File data pages, NULL for holes */
+  FAR uint8_t  *tfo_map;     /* Contiguous pages of a mapped file */
+  size_t        tfo_mapsize; /* Size of tfo_map in bytes */
+  size_t        tfo_nmaps;   /* Number of in-place mappings */
+#else
   FAR uint8_t  *tfo_data;  /* File data starts here */
+#endif
 };
 
 /* This structure represents one instance of a TMPFS file system */
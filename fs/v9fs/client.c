@@ -374,6 +374,17 @@ struct v9fs_fid_s
   char relpath[1];
 };
 
+/* One Tread of a pipelined read */
+
+struct v9fs_rreq_s
+{
+  struct v9fs_read_s    request;
+  struct v9fs_rread_s   response;
+  struct iovec          wiov[1];
+  struct iovec          riov[2];
+  struct v9fs_payload_s payload;
+};
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -537,6 +548,47 @@ static void v9fs_fid_destroy(FAR struct v9fs_client_s *client,
   fs_heap_free(fidp);
 }
 
+/****************************************************************************
+ * v9fs_client_submit
+ ****************************************************************************/
+
+static int v9fs_client_submit(FAR struct v9fs_transport_s *transport,
+                              FAR struct v9fs_payload_s *payload,
+                              FAR struct iovec *wiov, size_t wcount,
+                              FAR struct iovec *riov, size_t rcount,
+                              uint16_t tag)
+{
+  int ret;
+
+  nxsem_init(&payload->resp, 0, 0);
+  payload->wiov = wiov;
+  payload->riov = riov;
+  payload->wcount = wcount;
+  payload->rcount = rcount;
+  payload->tag = tag;
+  payload->ret = -EIO;
+
+  ret = v9fs_transport_request(transport, payload);
+  if (ret < 0)
+    {
+      nxsem_destroy(&payload->resp);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * v9fs_client_wait
+ ****************************************************************************/
+
+static int v9fs_client_wait(FAR struct v9fs_transport_s *transport,
+                            FAR struct v9fs_payload_s *payload)
+{
+  v9fs_transport_wait(transport, payload);
+  nxsem_destroy(&payload->resp);
+  return payload->ret;
+}
+
 /****************************************************************************
  * v9fs_client_rpc
  ****************************************************************************/
@@ -549,25 +601,14 @@ static int v9fs_client_rpc(FAR struct v9fs_transport_s *transport,
   struct v9fs_payload_s payload;
   int ret;
 
-  nxsem_init(&payload.resp, 0, 0);
-  payload.wiov = wiov;
-  payload.riov = riov;
-  payload.wcount = wcount;
-  payload.rcount = rcount;
-  payload.tag = tag;
-  payload.ret = -EIO;
-
-  ret = v9fs_transport_request(transport, &payload);
+  ret = v9fs_client_submit(transport, &payload, wiov, wcount,
+                           riov, rcount, tag);
   if (ret < 0)
     {
-      nxsem_destroy(&payload.resp);
       return ret;
     }
 
-  nxsem_wait(&payload.resp);
-  nxsem_destroy(&payload.resp);
-
-  return payload.ret;
+  return v9fs_client_wait(transport, &payload);
 }
 
 /****************************************************************************
@@ -724,6 +765,37 @@ static int v9fs_client_version(FAR struct v9fs_client_s *client)
   return 0;
 }
 
+/****************************************************************************
+ * v9fs_wcache_find
+ *
+ * Description:
+ *   Find the walk cache entry of the first len characters of path.  The
+ *   client lock must be held.
+ *
+ ****************************************************************************/
+
+#if CONFIG_V9FS_WALK_CACHE > 0
+static FAR struct v9fs_wcache_s *
+v9fs_wcache_find(FAR struct v9fs_client_s *client, FAR const char *path,
+                 size_t len)
+{
+  FAR struct v9fs_wcache_s *entry;
+  int i;
+
+  for (i = 0; i < CONFIG_V9FS_WALK_CACHE; i++)
+    {
+      entry = &client->wcache[i];
+      if (entry->path != NULL && strncmp(entry->path, path, len) == 0 &&
+          entry->path[len] == '\0')
+        {
+          return entry;
+        }
+    }
+
+  return NULL;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -903,11 +975,19 @@ ssize_t v9fs_client_read(FAR struct v9fs_client_s *client, uint32_t fid,
                          FAR void *buffer, off_t offset, size_t buflen)
 {
   FAR struct v9fs_fid_s *fidp;
-  struct v9fs_read_s request;
-  struct v9fs_rread_s response;
-  struct iovec wiov[1];
-  struct iovec riov[2];
+  FAR struct v9fs_rreq_s *reqs;
+  FAR struct v9fs_rreq_s *req;
+  struct v9fs_rreq_s one;
+  size_t submitted = 0;
+  size_t inflight = 0;
   size_t nread = 0;
+  size_t head = 0;
+  size_t nreqs;
+  size_t count;
+  bool drain = false;
+  bool full = false;
+  bool eof = false;
+  int result;
   int ret = 0;
 
   /* size[4] Tread tag[2] fid[4] offset[8] count[4]
@@ -920,40 +1000,112 @@ ssize_t v9fs_client_read(FAR struct v9fs_client_s *client, uint32_t fid,
       return -ENOENT;
     }
 
-  while (buflen > 0)
+  /* Keep up to CONFIG_V9FS_READ_PIPELINE Treads of one iounit each in
+   * flight, so that large reads are not bound by the round trip time.
+   */
+
+  nreqs = MIN(howmany(buflen, fidp->iounit), CONFIG_V9FS_READ_PIPELINE);
+  reqs = nreqs > 1 ? fs_heap_malloc(nreqs * sizeof(*reqs)) : NULL;
+  if (reqs == NULL)
     {
-      request.header.size = V9FS_HDRSZ + V9FS_BIT32SZ + V9FS_BIT64SZ +
-                            V9FS_BIT32SZ;
-      request.header.type = V9FS_TREAD;
-      request.header.tag = v9fs_get_tagid(client);
-      request.fid = fid;
-      request.offset = offset;
-      request.count = buflen > fidp->iounit ? fidp->iounit : buflen;
+      reqs = &one;
+      nreqs = 1;
+    }
 
-      wiov[0].iov_base = &request;
-      wiov[0].iov_len = V9FS_HDRSZ + V9FS_BIT32SZ + V9FS_BIT64SZ +
-                        V9FS_BIT32SZ;
-      riov[0].iov_base = &response;
-      riov[0].iov_len = V9FS_HDRSZ + V9FS_BIT32SZ;
-      riov[1].iov_base = (FAR void *)buffer;
-      riov[1].iov_len = request.count;
+  for (; ; )
+    {
+      while (ret >= 0 && !drain && !full && inflight < nreqs &&
+             submitted < buflen)
+        {
+          req = &reqs[(head + inflight) % nreqs];
+          count = MIN(buflen - submitted, fidp->iounit);
+
+          req->request.header.size = V9FS_HDRSZ + V9FS_BIT32SZ +
+                                     V9FS_BIT64SZ + V9FS_BIT32SZ;
+          req->request.header.type = V9FS_TREAD;
+          req->request.header.tag = v9fs_get_tagid(client);
+          req->request.fid = fid;
+          req->request.offset = offset + submitted;
+          req->request.count = count;
+
+          req->wiov[0].iov_base = &req->request;
+          req->wiov[0].iov_len = V9FS_HDRSZ + V9FS_BIT32SZ + V9FS_BIT64SZ +
+                                 V9FS_BIT32SZ;
+          req->riov[0].iov_base = &req->response;
+          req->riov[0].iov_len = V9FS_HDRSZ + V9FS_BIT32SZ;
+          req->riov[1].iov_base = (FAR uint8_t *)buffer + submitted;
+          req->riov[1].iov_len = count;
+
+          result = v9fs_client_submit(client->transport, &req->payload,
+                                      req->wiov, 1, req->riov, 2,
+                                      req->request.header.tag);
+          if (result >= 0)
+            {
+              inflight++;
+              submitted += count;
+            }
+          else if (inflight > 0)
+            {
+              /* The transport is full, try again after the next reply */
 
-      ret = v9fs_client_rpc(client->transport, wiov, 1, riov, 2,
-                            request.header.tag);
-      if (ret < 0)
+              full = true;
+            }
+          else
+            {
+              ret = result;
+            }
+        }
+
+      if (inflight == 0)
         {
-          break;
+          if (!drain || ret < 0 || eof)
+            {
+              break;
+            }
+
+          /* After a short read, continue where it ended */
+
+          drain = false;
+          submitted = nread;
+          head = 0;
+          continue;
         }
 
-      if (response.count == 0)
+      /* The replies are taken in the order of the offsets */
+
+      req = &reqs[head];
+      head = (head + 1) % nreqs;
+      inflight--;
+      full = false;
+
+      result = v9fs_client_wait(client->transport, &req->payload);
+      if (drain || ret < 0 || eof)
         {
-          break;
+          continue;
+        }
+      else if (result < 0)
+        {
+          ret = result;
+          continue;
         }
 
-      nread += response.count;
-      offset += response.count;
-      buffer += response.count;
-      buflen -= response.count;
+      count = MIN(req->response.count, req->request.count);
+      nread += count;
+      if (count < req->request.count)
+        {
+          /* The replies in flight are for data after a short read: drop
+           * them, then read the rest again unless this was the end of the
+           * file.
+           */
+
+          eof = count == 0;
+          drain = true;
+        }
+    }
+
+  if (reqs != &one)
+    {
+      fs_heap_free(reqs);
     }
 
   return nread ? nread : ret;
@@ -1606,6 +1758,169 @@ err:
   return ret == 0 ? newfid : ret;
 }
 
+/****************************************************************************
+ * v9fs_client_lookup
+ *
+ * Description:
+ *   Like v9fs_client_walk(), but the fid may be shared: it must not be
+ *   opened, created in or removed.  With CONFIG_V9FS_WALK_CACHE, the fids
+ *   of recent lookups are kept, so that repeated lookups of a path do not
+ *   need a Twalk and a Tclunk.  The reference is dropped with
+ *   v9fs_fid_put().
+ *
+ ****************************************************************************/
+
+int v9fs_client_lookup(FAR struct v9fs_client_s *client,
+                       FAR const char *path, FAR const char **childname)
+{
+#if CONFIG_V9FS_WALK_CACHE > 0
+  FAR struct v9fs_wcache_s *entry;
+  FAR struct v9fs_fid_s *fidp;
+  FAR const char *slash;
+  uint32_t evict = V9FS_NOFID;
+  FAR char *key;
+  uint32_t gen;
+  size_t len;
+  int ret;
+  int i;
+
+  /* The key is the part of the path that is walked */
+
+  len = strlen(path);
+  if (childname != NULL)
+    {
+      slash = strrchr(path, '/');
+      len = slash != NULL ? slash - path : 0;
+    }
+
+  nxmutex_lock(&client->lock);
+  entry = v9fs_wcache_find(client, path, len);
+  if (entry != NULL)
+    {
+      fidp = idr_find(client->fids, entry->fid);
+      DEBUGASSERT(fidp != NULL);
+
+      fidp->refcount++;
+      entry->age = ++client->wage;
+      ret = entry->fid;
+      nxmutex_unlock(&client->lock);
+
+      if (childname != NULL)
+        {
+          *childname = path + len + (path[len] == '/');
+        }
+
+      return ret;
+    }
+
+  gen = client->wgen;
+  nxmutex_unlock(&client->lock);
+
+  ret = v9fs_client_walk(client, path, childname);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  key = fs_heap_malloc(len + 1);
+  if (key == NULL)
+    {
+      return ret;
+    }
+
+  memcpy(key, path, len);
+  key[len] = '\0';
+
+  /* The walk may have raced with an invalidation, whose namespace change
+   * it may predate, or with a lookup of the same path that was cached
+   * first.  The fid is then only used by the caller.
+   */
+
+  nxmutex_lock(&client->lock);
+  if (client->wgen != gen || v9fs_wcache_find(client, path, len) != NULL)
+    {
+      nxmutex_unlock(&client->lock);
+      fs_heap_free(key);
+      return ret;
+    }
+
+  /* The cache keeps a reference of its own, replace the least recently
+   * used entry.
+   */
+
+  entry = &client->wcache[0];
+  for (i = 1; i < CONFIG_V9FS_WALK_CACHE; i++)
+    {
+      if (client->wcache[i].path == NULL ||
+          (entry->path != NULL && client->wcache[i].age < entry->age))
+        {
+          entry = &client->wcache[i];
+        }
+    }
+
+  if (entry->path != NULL)
+    {
+      evict = entry->fid;
+      fs_heap_free(entry->path);
+    }
+
+  fidp = idr_find(client->fids, ret);
+  DEBUGASSERT(fidp != NULL);
+
+  fidp->refcount++;
+  entry->path = key;
+  entry->fid = ret;
+  entry->age = ++client->wage;
+  nxmutex_unlock(&client->lock);
+
+  if (evict != V9FS_NOFID)
+    {
+      v9fs_fid_put(client, evict);
+    }
+
+  return ret;
+#else
+  return v9fs_client_walk(client, path, childname);
+#endif
+}
+
+/****************************************************************************
+ * v9fs_client_invalidate
+ *
+ * Description:
+ *   Forget the lookups: the name space has changed.  Lookups that were
+ *   walking meanwhile do not cache their result.
+ *
+ ****************************************************************************/
+
+void v9fs_client_invalidate(FAR struct v9fs_client_s *client)
+{
+#if CONFIG_V9FS_WALK_CACHE > 0
+  FAR char *path;
+  uint32_t fid;
+  int i;
+
+  nxmutex_lock(&client->lock);
+  client->wgen++;
+  nxmutex_unlock(&client->lock);
+
+  for (i = 0; i < CONFIG_V9FS_WALK_CACHE; i++)
+    {
+      nxmutex_lock(&client->lock);
+      path = client->wcache[i].path;
+      fid = client->wcache[i].fid;
+      client->wcache[i].path = NULL;
+      nxmutex_unlock(&client->lock);
+
+      if (path != NULL)
+        {
+          fs_heap_free(path);
+          v9fs_fid_put(client, fid);
+        }
+    }
+#endif
+}
+
 /****************************************************************************
  * v9fs_client_init
  ****************************************************************************/
@@ -1723,6 +2038,7 @@ int v9fs_client_uninit(FAR struct v9fs_client_s *client)
 {
   int ret;
 
+  v9fs_client_invalidate(client);
   ret = v9fs_client_clunk(client, client->root_fid);
   if (ret < 0)
     {
@@ -1821,3 +2137,13 @@ ssize_t v9fs_parse_size(FAR const void *buffer)
   FAR const struct v9fs_header_s *ptr = buffer;
   return ptr->size;
 }
+
+/****************************************************************************
+ * v9fs_parse_tag
+ ****************************************************************************/
+
+uint16_t v9fs_parse_tag(FAR const void *buffer)
+{
+  FAR const struct v9fs_header_s *ptr = buffer;
+  return ptr->tag;
+}
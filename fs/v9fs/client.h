@@ -68,7 +68,24 @@ struct v9fs_transport_ops_s
   CODE int (*request)(FAR struct v9fs_transport_s *transport,
                       FAR struct v9fs_payload_s *payload);
   CODE void (*destroy)(FAR struct v9fs_transport_s *transport);
+
+  /* Optional: wait for the reply to a request.  Transports that do not
+   * complete requests on their own receive the replies here, in the
+   * context of the waiting threads.  The default waits on payload->resp.
+   */
+
+  CODE int (*wait)(FAR struct v9fs_transport_s *transport,
+                   FAR struct v9fs_payload_s *payload);
+};
+
+#if CONFIG_V9FS_WALK_CACHE > 0
+struct v9fs_wcache_s
+{
+  FAR char *path;                          /* The walked path */
+  uint32_t  fid;                           /* Its fid */
+  uint32_t  age;                           /* Time of the last lookup */
 };
+#endif
 
 struct v9fs_client_s
 {
@@ -78,6 +95,11 @@ struct v9fs_client_s
   uint32_t                     root_fid;
   uint32_t                     tag_id;
   mutex_t                      lock;
+#if CONFIG_V9FS_WALK_CACHE > 0
+  struct v9fs_wcache_s         wcache[CONFIG_V9FS_WALK_CACHE];
+  uint32_t                     wage;
+  uint32_t                     wgen;    /* Bumped on each invalidation */
+#endif
 };
 
 /****************************************************************************
@@ -117,16 +139,22 @@ int v9fs_client_getname(FAR struct v9fs_client_s *client, uint32_t fid,
                         FAR char *path);
 int v9fs_client_walk(FAR struct v9fs_client_s *client, FAR const char *path,
                      FAR const char **childname);
+int v9fs_client_lookup(FAR struct v9fs_client_s *client,
+                       FAR const char *path, FAR const char **childname);
+void v9fs_client_invalidate(FAR struct v9fs_client_s *client);
 int v9fs_client_init(FAR struct v9fs_client_s *client, FAR const char *data);
 int v9fs_client_uninit(FAR struct v9fs_client_s *client);
 int v9fs_transport_create(FAR struct v9fs_transport_s **transport,
                           FAR const char *trans_type, FAR const char *data);
 int v9fs_transport_request(FAR struct v9fs_transport_s *transport,
                            FAR struct v9fs_payload_s *payload);
+int v9fs_transport_wait(FAR struct v9fs_transport_s *transport,
+                        FAR struct v9fs_payload_s *payload);
 void v9fs_transport_destroy(FAR struct v9fs_transport_s *transport);
 void v9fs_transport_done(FAR struct v9fs_payload_s *cookie, int ret);
 int v9fs_fid_put(FAR struct v9fs_client_s *client, uint32_t fid);
 int v9fs_fid_get(FAR struct v9fs_client_s *client, uint32_t fid);
 ssize_t v9fs_parse_size(FAR const void *buffer);
+uint16_t v9fs_parse_tag(FAR const void *buffer);
 
 #endif /* __FS_V9FS_CLIENT_H */
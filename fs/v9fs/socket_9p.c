@@ -23,10 +23,13 @@
  ****************************************************************************/
 
 #include <sys/param.h>
+#include <nuttx/debug.h>
 #include <nuttx/kmalloc.h>
 #include <arpa/inet.h>
 #include <nuttx/net/net.h>
 #include <nuttx/fs/fs.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/spinlock.h>
 
 #include "client.h"
 
@@ -36,6 +39,7 @@
 
 #define V9FS_HEADER_OFFSET 7
 #define V9FS_DEAFULT_PORT ":563"
+#define V9FS_DRAIN_SIZE    32
 
 /****************************************************************************
  * Private Types
@@ -45,7 +49,10 @@ struct socket_9p_priv_s
 {
   struct v9fs_transport_s transport;
   struct socket psock;
-  mutex_t lock;
+  mutex_t lock;             /* Serializes the requests */
+  mutex_t rxlock;           /* Serializes the replies */
+  spinlock_t pendlock;      /* Protects 'pending' */
+  struct list_node pending; /* Requests waiting for their replies */
 };
 
 /****************************************************************************
@@ -57,6 +64,8 @@ static int socket_9p_create(FAR struct v9fs_transport_s **transport,
 static int socket_9p_request(FAR struct v9fs_transport_s *transport,
                              FAR struct v9fs_payload_s *payload);
 static void socket_9p_destroy(FAR struct v9fs_transport_s *transport);
+static int socket_9p_wait(FAR struct v9fs_transport_s *transport,
+                          FAR struct v9fs_payload_s *payload);
 
 /****************************************************************************
  * Public Data
@@ -67,6 +76,7 @@ const struct v9fs_transport_ops_s g_socket_9p_transport_ops =
   socket_9p_create,  /* create */
   socket_9p_request, /* request */
   socket_9p_destroy, /* close */
+  socket_9p_wait,    /* wait */
 };
 
 /****************************************************************************
@@ -127,6 +137,9 @@ static int socket_9p_create(FAR struct v9fs_transport_s **transport,
     }
 
   nxmutex_init(&priv->lock);
+  nxmutex_init(&priv->rxlock);
+  spin_lock_init(&priv->pendlock);
+  list_initialize(&priv->pending);
   priv->transport.ops = &g_socket_9p_transport_ops;
   *transport = &priv->transport;
   return 0;
@@ -138,48 +151,94 @@ out:
 }
 
 /****************************************************************************
- * Name: socket_9p_request
+ * Name: socket_9p_drain
+ *
+ * Description:
+ *   Discard the data of a reply that has no place to go.
+ *
  ****************************************************************************/
 
-static int socket_9p_request(FAR struct v9fs_transport_s *transport,
-                             FAR struct v9fs_payload_s *payload)
+static int socket_9p_drain(FAR struct socket_9p_priv_s *priv, size_t len)
 {
-  FAR struct socket_9p_priv_s *priv =
-                              (FAR struct socket_9p_priv_s *)transport;
+  char buffer[V9FS_DRAIN_SIZE];
+  int ret;
+
+  while (len > 0)
+    {
+      ret = psock_recvfrom(&priv->psock, buffer, MIN(len, sizeof(buffer)),
+                           MSG_WAITALL, NULL, NULL);
+      if (ret <= 0)
+        {
+          return ret < 0 ? ret : -ECONNRESET;
+        }
+
+      len -= ret;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: socket_9p_receive
+ *
+ * Description:
+ *   Receive one reply and complete the request with its tag.  The replies
+ *   may come in any order.
+ *
+ ****************************************************************************/
+
+static int socket_9p_receive(FAR struct socket_9p_priv_s *priv)
+{
+  FAR struct v9fs_payload_s *payload = NULL;
+  FAR struct v9fs_payload_s *entry;
+  char header[V9FS_HEADER_OFFSET];
   struct msghdr msg;
-  FAR char *ptr;
+  irqstate_t flags;
+  uint16_t tag;
   size_t len;
+  int index;
   int ret;
 
-  memset(&msg, 0, sizeof(struct msghdr));
-  msg.msg_iov = payload->wiov;
-  msg.msg_iovlen = payload->wcount;
+  ret = psock_recvfrom(&priv->psock, header, V9FS_HEADER_OFFSET,
+                       MSG_WAITALL, NULL, NULL);
+  if (ret != V9FS_HEADER_OFFSET)
+    {
+      return ret < 0 ? ret : -ECONNRESET;
+    }
 
-  nxmutex_lock(&priv->lock);
-  ret = psock_sendmsg(&priv->psock, &msg, 0);
-  if (ret < 0)
+  len = v9fs_parse_size(header);
+  tag = v9fs_parse_tag(header);
+  if (len < V9FS_HEADER_OFFSET)
     {
-      goto out;
+      return -EIO;
     }
 
-  ptr = payload->riov[0].iov_base;
-  ret = psock_recvfrom(&priv->psock, ptr, V9FS_HEADER_OFFSET,
-                       MSG_WAITALL, NULL, NULL);
-  if (ret < 0)
+  len -= V9FS_HEADER_OFFSET;
+
+  flags = spin_lock_irqsave(&priv->pendlock);
+  list_for_every_entry(&priv->pending, entry, struct v9fs_payload_s, node)
     {
-      goto out;
+      if (entry->tag == tag)
+        {
+          list_delete(&entry->node);
+          payload = entry;
+          break;
+        }
     }
 
-  len = v9fs_parse_size(ptr);
-  len -= ret;
+  spin_unlock_irqrestore(&priv->pendlock, flags);
 
-  if (len > 0)
+  if (payload == NULL)
     {
-      /* There is still data left to process */
+      ferr("ERROR: No request with tag %u\n", tag);
+      return socket_9p_drain(priv, len);
+    }
 
-      int index;
+  memcpy(payload->riov[0].iov_base, header, V9FS_HEADER_OFFSET);
 
-      /* Skip the header */
+  if (len > 0)
+    {
+      /* There is still data left to process, skip the header */
 
       payload->riov[0].iov_base += V9FS_HEADER_OFFSET;
       payload->riov[0].iov_len -= V9FS_HEADER_OFFSET;
@@ -191,26 +250,143 @@ static int socket_9p_request(FAR struct v9fs_transport_s *transport,
           len -= payload->riov[index].iov_len;
         }
 
+      memset(&msg, 0, sizeof(struct msghdr));
       msg.msg_iov = payload->riov;
       msg.msg_iovlen = payload->rcount;
 
       ret = psock_recvmsg(&priv->psock, &msg, MSG_WAITALL);
-      if (ret < 0)
-        {
-          goto out;
-        }
 
       /* Restore the header */
 
       payload->riov[0].iov_base -= V9FS_HEADER_OFFSET;
       payload->riov[0].iov_len += V9FS_HEADER_OFFSET;
+
+      if (ret >= 0 && len > 0)
+        {
+          ret = socket_9p_drain(priv, len);
+        }
+
+      if (ret < 0)
+        {
+          v9fs_transport_done(payload, ret);
+          return ret;
+        }
     }
 
-  ret = 0;
+  v9fs_transport_done(payload, 0);
+  return 0;
+}
 
-out:
+/****************************************************************************
+ * Name: socket_9p_abort
+ *
+ * Description:
+ *   The connection failed: complete all requests with an error.
+ *
+ ****************************************************************************/
+
+static void socket_9p_abort(FAR struct socket_9p_priv_s *priv, int ret)
+{
+  FAR struct v9fs_payload_s *payload;
+  irqstate_t flags;
+
+  for (; ; )
+    {
+      flags = spin_lock_irqsave(&priv->pendlock);
+      payload = list_remove_head_type(&priv->pending, struct v9fs_payload_s,
+                                      node);
+      spin_unlock_irqrestore(&priv->pendlock, flags);
+
+      if (payload == NULL)
+        {
+          break;
+        }
+
+      /* No header was received, the ret must not be taken from it */
+
+      memset(payload->riov[0].iov_base, 0, V9FS_HEADER_OFFSET);
+      v9fs_transport_done(payload, ret);
+    }
+}
+
+/****************************************************************************
+ * Name: socket_9p_request
+ ****************************************************************************/
+
+static int socket_9p_request(FAR struct v9fs_transport_s *transport,
+                             FAR struct v9fs_payload_s *payload)
+{
+  FAR struct socket_9p_priv_s *priv =
+                              (FAR struct socket_9p_priv_s *)transport;
+  struct msghdr msg;
+  irqstate_t flags;
+  int ret;
+
+  /* Only send the request, the reply is received by socket_9p_wait() so
+   * that several requests can be in flight.
+   */
+
+  flags = spin_lock_irqsave(&priv->pendlock);
+  list_add_tail(&priv->pending, &payload->node);
+  spin_unlock_irqrestore(&priv->pendlock, flags);
+
+  memset(&msg, 0, sizeof(struct msghdr));
+  msg.msg_iov = payload->wiov;
+  msg.msg_iovlen = payload->wcount;
+
+  nxmutex_lock(&priv->lock);
+  ret = psock_sendmsg(&priv->psock, &msg, 0);
   nxmutex_unlock(&priv->lock);
-  v9fs_transport_done(payload, ret);
+
+  if (ret < 0)
+    {
+      flags = spin_lock_irqsave(&priv->pendlock);
+      list_delete(&payload->node);
+      spin_unlock_irqrestore(&priv->pendlock, flags);
+      return ret;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: socket_9p_wait
+ *
+ * Description:
+ *   Receive replies until the one for 'payload' has come.  The replies for
+ *   other threads are completed on the way.
+ *
+ ****************************************************************************/
+
+static int socket_9p_wait(FAR struct v9fs_transport_s *transport,
+                          FAR struct v9fs_payload_s *payload)
+{
+  FAR struct socket_9p_priv_s *priv =
+                              (FAR struct socket_9p_priv_s *)transport;
+  int ret;
+
+  while (nxsem_trywait(&payload->resp) < 0)
+    {
+      nxmutex_lock(&priv->rxlock);
+
+      /* Another thread may have received the reply meanwhile */
+
+      if (nxsem_trywait(&payload->resp) >= 0)
+        {
+          nxmutex_unlock(&priv->rxlock);
+          break;
+        }
+
+      ret = socket_9p_receive(priv);
+      nxmutex_unlock(&priv->rxlock);
+
+      if (ret < 0)
+        {
+          ferr("ERROR: Failed to receive a reply: %d\n", ret);
+          socket_9p_abort(priv, ret);
+        }
+    }
+
   return 0;
 }
 
@@ -225,5 +401,6 @@ static void socket_9p_destroy(FAR struct v9fs_transport_s *transport)
 
   psock_close(&priv->psock);
   nxmutex_destroy(&priv->lock);
+  nxmutex_destroy(&priv->rxlock);
   kmm_free(priv);
 }
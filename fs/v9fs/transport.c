@@ -26,6 +26,8 @@
 
 #include <string.h>
 
+#include <nuttx/semaphore.h>
+
 #include "client.h"
 
 /****************************************************************************
@@ -74,6 +76,21 @@ int v9fs_transport_request(FAR struct v9fs_transport_s *transport,
   return transport->ops->request(transport, payload);
 }
 
+/****************************************************************************
+ * Name: v9fs_transport_wait
+ ****************************************************************************/
+
+int v9fs_transport_wait(FAR struct v9fs_transport_s *transport,
+                        FAR struct v9fs_payload_s *payload)
+{
+  if (transport->ops->wait != NULL)
+    {
+      return transport->ops->wait(transport, payload);
+    }
+
+  return nxsem_wait_uninterruptible(&payload->resp);
+}
+
 /****************************************************************************
  * Name: v9fs_transport_destroy
  ****************************************************************************/
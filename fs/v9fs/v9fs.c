@@ -715,7 +715,7 @@ static int v9fs_vfs_unlink(FAR struct inode *mountpt,
 
   client = mountpt->i_private;
 
-  ret = v9fs_client_walk(client, relpath, &filename);
+  ret = v9fs_client_lookup(client, relpath, &filename);
   if (ret < 0)
     {
       ferr("ERROR: Can't find the parent fid of relpath: %d\n", ret);
@@ -743,6 +743,11 @@ static int v9fs_vfs_unlink(FAR struct inode *mountpt,
       v9fs_fid_put(client, fid);
     }
 
+  if (ret >= 0)
+    {
+      v9fs_client_invalidate(client);
+    }
+
   return ret;
 }
 
@@ -765,7 +770,7 @@ static int v9fs_vfs_mkdir(FAR struct inode *mountpt,
 
   client = mountpt->i_private;
 
-  ret = v9fs_client_walk(client, relpath, &relpath);
+  ret = v9fs_client_lookup(client, relpath, &relpath);
   if (ret < 0)
     {
       ferr("ERROR: Can't find the parent fid of relpath: %d\n", ret);
@@ -798,7 +803,7 @@ static int v9fs_vfs_rmdir(FAR struct inode *mountpt,
 
   client = mountpt->i_private;
 
-  ret = v9fs_client_walk(client, relpath, &dirname);
+  ret = v9fs_client_lookup(client, relpath, &dirname);
   if (ret < 0)
     {
       ferr("ERROR: Can't find the parent fid of relpath: %d\n", ret);
@@ -826,6 +831,11 @@ static int v9fs_vfs_rmdir(FAR struct inode *mountpt,
       v9fs_fid_put(client, fid);
     }
 
+  if (ret >= 0)
+    {
+      v9fs_client_invalidate(client);
+    }
+
   return ret;
 }
 
@@ -858,7 +868,7 @@ static int v9fs_vfs_rename(FAR struct inode *mountpt,
     }
 
   oldfid = ret;
-  ret = v9fs_client_walk(client, newrelpath, &newrelpath);
+  ret = v9fs_client_lookup(client, newrelpath, &newrelpath);
   if (ret < 0)
     {
       ferr("ERROR: Can't find the new parent fid of the newrelpath: %d\n",
@@ -871,6 +881,11 @@ static int v9fs_vfs_rename(FAR struct inode *mountpt,
   ret = v9fs_client_rename(client, oldfid, newpfid, newrelpath);
   v9fs_fid_put(client, oldfid);
   v9fs_fid_put(client, newpfid);
+  if (ret >= 0)
+    {
+      v9fs_client_invalidate(client);
+    }
+
   return ret;
 }
 
@@ -894,7 +909,7 @@ static int v9fs_vfs_stat(FAR struct inode *mountpt, FAR const char *relpath,
   client = mountpt->i_private;
   memset(buf, 0, sizeof(struct stat));
 
-  ret = v9fs_client_walk(client, relpath, NULL);
+  ret = v9fs_client_lookup(client, relpath, NULL);
   if (ret < 0)
     {
       ferr("ERROR: Can't find the fid of the relpath: %d\n", ret);
@@ -927,7 +942,7 @@ static int v9fs_vfs_chstat(FAR struct inode *mountpt,
 
   client = mountpt->i_private;
 
-  ret = v9fs_client_walk(client, relpath, NULL);
+  ret = v9fs_client_lookup(client, relpath, NULL);
   if (ret < 0)
     {
       ferr("ERROR: Can't find the fid of the relpath %d\n", ret);
@@ -83,6 +83,7 @@ const struct v9fs_transport_ops_s g_virtio_9p_transport_ops =
   virtio_9p_create,  /* create */
   virtio_9p_request, /* request */
   virtio_9p_destroy, /* close */
+  NULL,              /* wait */
 };
 
 /****************************************************************************
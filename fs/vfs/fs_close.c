@@ -97,6 +97,7 @@ int file_close(FAR struct file *filep)
   FAR char *path;
 #endif
   int ret = OK;
+  int err = OK;
 
   DEBUGASSERT(filep != NULL);
   inode = filep->f_inode;
@@ -115,6 +116,12 @@ int file_close(FAR struct file *filep)
     {
       file_closelk(filep);
 
+      /* Write out the data still written behind.  A failure is reported,
+       * but the file is closed anyway.
+       */
+
+      err = file_readahead_close(filep);
+
       /* Close the file, driver, or mountpoint. */
 
       if (inode->u.i_ops && inode->u.i_ops->close)
@@ -155,7 +162,7 @@ int file_close(FAR struct file *filep)
       filep->f_inode = NULL;
     }
 
-  return ret;
+  return ret < 0 ? ret : err;
 }
 
 /****************************************************************************
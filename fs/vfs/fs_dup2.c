@@ -35,6 +35,7 @@
 #include <fcntl.h>
 
 #include "inode/inode.h"
+#include "vfs/vfs.h"
 #include "sched/sched.h"
 
 /****************************************************************************
@@ -73,6 +74,14 @@ int file_dup2(FAR struct file *filep1, FAR struct file *filep2)
       return OK;
     }
 
+  /* The position of filep1 is copied below */
+
+  ret = file_readahead_sync(filep1);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
   /* Increment the reference count on the contained inode */
 
   inode = filep1->f_inode;
@@ -0,0 +1,131 @@
+/****************************************************************************
+ * fs/vfs/fs_fadvise.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <fcntl.h>
+#include <errno.h>
+
+#include <nuttx/fs/fs.h>
+
+#include "inode/inode.h"
+#include "vfs.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: file_fadvise
+ *
+ * Description:
+ *   Equivalent to the standard posix_fadvise() function except that is
+ *   accepts a struct file instance instead of a file descriptor and
+ *   returns a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int file_fadvise(FAR struct file *filep, off_t offset, off_t len,
+                 int advice)
+{
+  FAR struct inode *inode = filep->f_inode;
+
+  if (inode == NULL)
+    {
+      return -EBADF;
+    }
+
+  if (len < 0)
+    {
+      return -EINVAL;
+    }
+
+  switch (advice)
+    {
+      case POSIX_FADV_NORMAL:
+      case POSIX_FADV_RANDOM:
+      case POSIX_FADV_SEQUENTIAL:
+      case POSIX_FADV_WILLNEED:
+      case POSIX_FADV_DONTNEED:
+      case POSIX_FADV_NOREUSE:
+        break;
+
+      default:
+        return -EINVAL;
+    }
+
+  if (INODE_IS_PIPE(inode) || INODE_IS_SOCKET(inode))
+    {
+      return -ESPIPE;
+    }
+
+  return file_readahead_advise(filep, offset, len, advice);
+}
+
+/****************************************************************************
+ * Name: posix_fadvise
+ *
+ * Description:
+ *   Advise the system how the data of the open file 'fd' in the range
+ *   from 'offset' of 'len' bytes (up to the end of the file if 'len' is
+ *   zero) is going to be accessed.  With CONFIG_FS_READAHEAD the advice
+ *   tunes the read-ahead of regular files:
+ *
+ *   POSIX_FADV_SEQUENTIAL - Read ahead at once with the largest window.
+ *   POSIX_FADV_RANDOM     - Never read ahead or write behind.
+ *   POSIX_FADV_WILLNEED   - Start reading ahead now if 'offset' is the
+ *                           current file position.
+ *   POSIX_FADV_DONTNEED   - Drop the data read ahead and write out the
+ *                           data written behind.
+ *   POSIX_FADV_NORMAL and POSIX_FADV_NOREUSE restore the default
+ *   heuristics.
+ *
+ *   Otherwise the advice is accepted and ignored.
+ *
+ * Returned Value:
+ *   Zero on success, otherwise an error number:
+ *
+ *   EBADF  - 'fd' is not a valid file descriptor.
+ *   EINVAL - 'advice' is invalid or 'len' is negative.
+ *   ESPIPE - 'fd' refers to a pipe, FIFO or socket.
+ *
+ ****************************************************************************/
+
+int posix_fadvise(int fd, off_t offset, off_t len, int advice)
+{
+  FAR struct file *filep;
+  int ret;
+
+  ret = file_get(fd, &filep);
+  if (ret < 0)
+    {
+      return -ret;
+    }
+
+  ret = file_fadvise(filep, offset, len, advice);
+  file_put(filep);
+  return -ret;
+}
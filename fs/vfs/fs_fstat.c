@@ -36,6 +36,7 @@
 #include <nuttx/mtd/mtd.h>
 #include <nuttx/net/net.h>
 #include "inode/inode.h"
+#include "vfs/vfs.h"
 
 /****************************************************************************
  * Private Functions
@@ -180,6 +181,14 @@ int file_fstat(FAR struct file *filep, FAR struct stat *buf)
       return -EBADF;
     }
 
+  /* Make the data written behind visible in the size */
+
+  ret = file_readahead_sync(filep);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
   /* The way we handle the stat depends on the type of inode that we
    * are dealing with.
    */
@@ -37,6 +37,7 @@
 #include <nuttx/fs/ioctl.h>
 
 #include "inode/inode.h"
+#include "vfs/vfs.h"
 
 /****************************************************************************
  * Public Functions
@@ -65,6 +66,14 @@ int file_fsync(FAR struct file *filep)
   inode = filep->f_inode;
   if (inode != NULL)
     {
+      /* Write out the data still written behind first */
+
+      ret = file_readahead_sync(filep);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
 #ifndef CONFIG_DISABLE_MOUNTPOINT
       if (INODE_IS_MOUNTPT(inode))
         {
@@ -61,6 +61,16 @@ static int file_vioctl(FAR struct file *filep, int req, va_list ap)
       return -EBADF;
     }
 
+  /* The file system may look at the file position */
+
+  ret = file_readahead_sync(filep);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ret = -ENOTTY;
+
   /* Does the driver support the ioctl method? */
 
   if (inode->u.i_ops != NULL && inode->u.i_ops->ioctl != NULL)
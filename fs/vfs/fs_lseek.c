@@ -33,6 +33,7 @@
 #include <assert.h>
 
 #include "inode/inode.h"
+#include "vfs/vfs.h"
 
 /****************************************************************************
  * Public Functions
@@ -64,6 +65,26 @@ off_t file_seek(FAR struct file *filep, off_t offset, int whence)
   DEBUGASSERT(filep);
   inode =  filep->f_inode;
 
+  /* Asking for the position does not need to stop the read-ahead.  Any
+   * other seek drops the data read ahead and writes out the data written
+   * behind.
+   */
+
+  if (whence == SEEK_CUR && offset == 0)
+    {
+      ret = file_readahead_tell(filep);
+      if (ret != -ENOSYS)
+        {
+          return ret;
+        }
+    }
+
+  ret = file_readahead_sync(filep);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
   /* Invoke the file seek method if available */
 
   if (inode && inode->u.i_ops && inode->u.i_ops->seek)
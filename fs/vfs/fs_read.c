@@ -219,20 +219,30 @@ ssize_t file_readv(FAR struct file *filep,
 
       FS_PROFILE_START(start_time);
 
-      if (inode->u.i_ops->readv)
+      /* Sequential access to regular files may go through the
+       * read-ahead/write-behind stream of the file.
+       */
+
+      file_readahead_coherent(filep, false);
+      ret = file_readahead_read(filep, iov, iovcnt);
+      if (ret == -ENOSYS)
         {
-          struct uio uio;
+          ret = -EBADF;
+          if (inode->u.i_ops->readv)
+            {
+              struct uio uio;
 
-          ret = uio_init(&uio, iov, iovcnt);
-          if (ret == 0)
+              ret = uio_init(&uio, iov, iovcnt);
+              if (ret == 0)
+                {
+                  ret = inode->u.i_ops->readv(filep, &uio);
+                }
+            }
+          else if (inode->u.i_ops->read)
             {
-              ret = inode->u.i_ops->readv(filep, &uio);
+              ret = file_readv_compat(filep, iov, iovcnt);
             }
         }
-      else if (inode->u.i_ops->read)
-        {
-          ret = file_readv_compat(filep, iov, iovcnt);
-        }
 
       FS_PROFILE_STOP(start_time, g_fs_profile.total_read_time,
                       g_fs_profile.reads);
@@ -0,0 +1,1229 @@
+/****************************************************************************
+ * fs/vfs/fs_readahead.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <sys/statfs.h>
+#include <sys/uio.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include <nuttx/fs/fs.h>
+#include <nuttx/list.h>
+#include <nuttx/mutex.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/wqueue.h>
+
+#include "inode/inode.h"
+#include "vfs/vfs.h"
+#include "fs_heap.h"
+
+#ifdef CONFIG_FS_READAHEAD
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define RA_MINSIZE   CONFIG_FS_READAHEAD_MINSIZE
+#define RA_MAXSIZE   CONFIG_FS_READAHEAD_MAXSIZE
+
+/* Number of back-to-back sequential accesses before the stream starts
+ * to read ahead or to write behind.
+ */
+
+#define RA_SEQTHRESH 2
+
+#if RA_MINSIZE > RA_MAXSIZE
+#  error CONFIG_FS_READAHEAD_MINSIZE exceeds CONFIG_FS_READAHEAD_MAXSIZE
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+enum readahead_mode_e
+{
+  RA_IDLE = 0,                 /* Nothing buffered */
+  RA_READ,                     /* Reading ahead */
+  RA_WRITE                     /* Writing behind */
+};
+
+/* The streams of the open files of a mountpoint.  The files of a mounted
+ * file system all share the mountpoint inode, so an access to one of them
+ * only has to look at the streams attached to that inode.
+ */
+
+struct readahead_inode_s
+{
+  mutex_t          lock;       /* Protects 'streams' */
+  struct list_node streams;    /* The streams of the files */
+  atomic_t         nstreams;   /* Number of entries in 'streams' */
+  bool             eligible;   /* The file system can have streams */
+};
+
+/* The stream state of an open file.  In RA_READ mode buffer[head..len)
+ * holds the file data starting at 'pos', and the file system position is
+ * at 'pos + len - head'.  In RA_WRITE mode buffer[0..len) holds the data
+ * to be written at the file system position, and 'pos' is that position
+ * plus 'len'.  While 'busy', the worker owns buffer[len..) when reading
+ * ahead, or buffer[0..filllen) when writing behind.
+ */
+
+struct file_readahead_s
+{
+  struct list_node node;       /* Link in the streams of the inode */
+  mutex_t          lock;       /* Serializes the users of the stream */
+  sem_t            done;       /* Waiters for the worker */
+  struct work_s    work;       /* Read-ahead and write-behind work */
+  FAR struct file *filep;      /* The file of the stream */
+  FAR uint8_t     *buffer;     /* RA_MAXSIZE bytes, allocated on demand */
+  off_t            pos;        /* The file position seen by the user */
+  off_t            next;       /* Where the next sequential access starts */
+  size_t           head;       /* First unread byte (RA_READ) */
+  size_t           len;        /* End of the valid data in the buffer */
+  size_t           window;     /* Current read-ahead size */
+  size_t           fillpos;    /* Where the worker reads to (RA_READ) */
+  size_t           filllen;    /* How much the worker reads or writes */
+  uint8_t          mode;       /* See enum readahead_mode_e */
+  uint8_t          advice;     /* POSIX_FADV_* given by the user */
+  uint8_t          nseq;       /* Number of sequential accesses */
+  uint8_t          nwaiters;   /* Number of threads waiting on 'done' */
+  bool             busy;       /* The worker is queued or running */
+  bool             eof;        /* The last read ahead hit the end of file */
+  int              error;      /* Deferred error of the worker */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Serializes the creation of the stream lists of the inodes */
+
+static mutex_t g_readahead_lock = NXMUTEX_INITIALIZER;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: readahead_rawread
+ *
+ * Description:
+ *   Read from the file system at its current position, bypassing the
+ *   stream.
+ *
+ ****************************************************************************/
+
+static ssize_t readahead_rawread(FAR struct file *filep, FAR void *buf,
+                                 size_t len)
+{
+  FAR struct inode *inode = filep->f_inode;
+
+  if (inode->u.i_ops->read)
+    {
+      return inode->u.i_ops->read(filep, buf, len);
+    }
+  else
+    {
+      struct iovec iov;
+      struct uio uio;
+      int ret;
+
+      iov.iov_base = buf;
+      iov.iov_len  = len;
+      ret = uio_init(&uio, &iov, 1);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      return inode->u.i_ops->readv(filep, &uio);
+    }
+}
+
+/****************************************************************************
+ * Name: readahead_rawwrite
+ *
+ * Description:
+ *   Write all of 'buf' to the file system at its current position,
+ *   bypassing the stream.  A short write is reported as -ENOSPC.
+ *
+ ****************************************************************************/
+
+static ssize_t readahead_rawwrite(FAR struct file *filep,
+                                  FAR const void *buf, size_t len)
+{
+  FAR struct inode *inode = filep->f_inode;
+  FAR const uint8_t *ptr = buf;
+  size_t remaining = len;
+  ssize_t nwritten;
+
+  while (remaining > 0)
+    {
+      if (inode->u.i_ops->write)
+        {
+          nwritten = inode->u.i_ops->write(filep, (FAR const char *)ptr,
+                                           remaining);
+        }
+      else
+        {
+          struct iovec iov;
+          struct uio uio;
+
+          iov.iov_base = (FAR void *)ptr;
+          iov.iov_len  = remaining;
+          nwritten = uio_init(&uio, &iov, 1);
+          if (nwritten == 0)
+            {
+              nwritten = inode->u.i_ops->writev(filep, &uio);
+            }
+        }
+
+      if (nwritten <= 0)
+        {
+          return nwritten < 0 ? nwritten : -ENOSPC;
+        }
+
+      ptr       += nwritten;
+      remaining -= nwritten;
+    }
+
+  return len;
+}
+
+/****************************************************************************
+ * Name: readahead_rawseek
+ *
+ * Description:
+ *   Move the file system position, bypassing the stream.
+ *
+ ****************************************************************************/
+
+static int readahead_rawseek(FAR struct file *filep, off_t pos)
+{
+  FAR struct inode *inode = filep->f_inode;
+  off_t ret;
+
+  if (inode->u.i_ops->seek)
+    {
+      ret = inode->u.i_ops->seek(filep, pos, SEEK_SET);
+      return ret < 0 ? (int)ret : OK;
+    }
+
+  filep->f_pos = pos;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: readahead_inode
+ *
+ * Description:
+ *   Return the stream list of a mountpoint, creating it on first use.
+ *   Pseudo file systems and file systems in RAM gain nothing from the
+ *   streams and are marked not eligible.
+ *
+ ****************************************************************************/
+
+static FAR struct readahead_inode_s *
+readahead_inode(FAR struct inode *inode)
+{
+  FAR struct readahead_inode_s *ri = inode->i_ra;
+  struct statfs buf;
+
+  if (ri != NULL)
+    {
+      return ri;
+    }
+
+  ri = fs_heap_zalloc(sizeof(struct readahead_inode_s));
+  if (ri == NULL)
+    {
+      return NULL;
+    }
+
+  nxmutex_init(&ri->lock);
+  list_initialize(&ri->streams);
+
+  ri->eligible = true;
+  if (inode->u.i_mops->statfs != NULL &&
+      inode->u.i_mops->statfs(inode, &buf) >= 0)
+    {
+      switch (buf.f_type)
+        {
+          case BINFS_MAGIC:
+          case PROCFS_MAGIC:
+          case TMPFS_MAGIC:
+            ri->eligible = false;
+            break;
+
+          default:
+            break;
+        }
+    }
+
+  /* Another thread may have raced us to it */
+
+  nxmutex_lock(&g_readahead_lock);
+  if (inode->i_ra == NULL)
+    {
+      inode->i_ra = ri;
+      ri = NULL;
+    }
+
+  nxmutex_unlock(&g_readahead_lock);
+
+  if (ri != NULL)
+    {
+      nxmutex_destroy(&ri->lock);
+      fs_heap_free(ri);
+    }
+
+  return inode->i_ra;
+}
+
+/****************************************************************************
+ * Name: readahead_eligible
+ *
+ * Description:
+ *   Streams are kept for regular files of mounted file systems that can
+ *   be read, written and seeked, and that are not in RAM.
+ *
+ ****************************************************************************/
+
+static bool readahead_eligible(FAR struct file *filep)
+{
+  FAR struct inode *inode = filep->f_inode;
+  FAR struct readahead_inode_s *ri;
+
+  if (inode == NULL || !INODE_IS_MOUNTPT(inode) ||
+      inode->u.i_mops == NULL || inode->u.i_mops->seek == NULL ||
+      (filep->f_oflags & (O_DIRECT | O_DIRECTORY)) != 0)
+    {
+      return false;
+    }
+
+  ri = readahead_inode(inode);
+  return ri != NULL && ri->eligible;
+}
+
+/****************************************************************************
+ * Name: readahead_get
+ *
+ * Description:
+ *   Return the stream of a file, creating it on first use.
+ *
+ ****************************************************************************/
+
+static FAR struct file_readahead_s *readahead_get(FAR struct file *filep)
+{
+  FAR struct readahead_inode_s *ri = filep->f_inode->i_ra;
+  FAR struct file_readahead_s *ra = filep->f_ra;
+
+  if (ra != NULL)
+    {
+      return ra;
+    }
+
+  ra = fs_heap_zalloc(sizeof(struct file_readahead_s));
+  if (ra == NULL)
+    {
+      return NULL;
+    }
+
+  nxmutex_init(&ra->lock);
+  nxsem_init(&ra->done, 0, 0);
+  ra->filep  = filep;
+  ra->next   = filep->f_pos;
+  ra->advice = POSIX_FADV_NORMAL;
+
+  /* Another thread may have raced us to it */
+
+  nxmutex_lock(&ri->lock);
+  if (filep->f_ra == NULL)
+    {
+      list_add_tail(&ri->streams, &ra->node);
+      atomic_fetch_add(&ri->nstreams, 1);
+      filep->f_ra = ra;
+      ra = NULL;
+    }
+
+  nxmutex_unlock(&ri->lock);
+
+  if (ra != NULL)
+    {
+      nxsem_destroy(&ra->done);
+      nxmutex_destroy(&ra->lock);
+      fs_heap_free(ra);
+    }
+
+  return filep->f_ra;
+}
+
+/****************************************************************************
+ * Name: readahead_wait
+ *
+ * Description:
+ *   Wait until the worker is done with the buffer.  Called and returns
+ *   with the stream locked.
+ *
+ ****************************************************************************/
+
+static void readahead_wait(FAR struct file_readahead_s *ra)
+{
+  while (ra->busy)
+    {
+      ra->nwaiters++;
+      nxmutex_unlock(&ra->lock);
+      nxsem_wait_uninterruptible(&ra->done);
+      nxmutex_lock(&ra->lock);
+    }
+}
+
+/****************************************************************************
+ * Name: readahead_worker
+ *
+ * Description:
+ *   Read ahead into, or write behind from, the stream buffer on the low
+ *   priority work queue.  The file system is accessed without the stream
+ *   lock so that the user can keep consuming or producing data.
+ *
+ ****************************************************************************/
+
+static void readahead_worker(FAR void *arg)
+{
+  FAR struct file_readahead_s *ra = arg;
+  ssize_t ret;
+
+  if (ra->mode == RA_READ)
+    {
+      ret = readahead_rawread(ra->filep, ra->buffer + ra->fillpos,
+                              ra->filllen);
+
+      nxmutex_lock(&ra->lock);
+      if (ret < 0)
+        {
+          ra->error = ret;
+        }
+      else
+        {
+          ra->len += ret;
+          ra->eof  = (size_t)ret < ra->filllen;
+        }
+    }
+  else
+    {
+      ret = readahead_rawwrite(ra->filep, ra->buffer, ra->filllen);
+
+      nxmutex_lock(&ra->lock);
+      if (ret < 0)
+        {
+          /* The data is lost, tell the user at the next opportunity */
+
+          ra->error = ret;
+          ra->len   = 0;
+        }
+      else
+        {
+          ra->len -= ret;
+          memmove(ra->buffer, ra->buffer + ret, ra->len);
+        }
+    }
+
+  ra->busy = false;
+  while (ra->nwaiters > 0)
+    {
+      ra->nwaiters--;
+      nxsem_post(&ra->done);
+    }
+
+  nxmutex_unlock(&ra->lock);
+}
+
+/****************************************************************************
+ * Name: readahead_kick
+ *
+ * Description:
+ *   Start an asynchronous read ahead once the unread data falls to half
+ *   of the window, doubling the window each time.
+ *
+ ****************************************************************************/
+
+static void readahead_kick(FAR struct file_readahead_s *ra)
+{
+  size_t avail = ra->len - ra->head;
+
+  if (ra->busy || ra->eof || ra->error < 0 || avail > ra->window / 2)
+    {
+      return;
+    }
+
+  /* Make room behind the unread data */
+
+  if (ra->head > 0)
+    {
+      memmove(ra->buffer, ra->buffer + ra->head, avail);
+      ra->head = 0;
+      ra->len  = avail;
+    }
+
+  ra->fillpos = ra->len;
+  ra->filllen = MIN(ra->window, RA_MAXSIZE - ra->len);
+  if (ra->filllen == 0)
+    {
+      return;
+    }
+
+  ra->window = MIN(ra->window * 2, RA_MAXSIZE);
+  ra->busy   = true;
+  work_queue(LPWORK, &ra->work, readahead_worker, ra, 0);
+}
+
+/****************************************************************************
+ * Name: readahead_start
+ *
+ * Description:
+ *   Switch a stream to 'mode' at the current file system position.
+ *
+ ****************************************************************************/
+
+static int readahead_start(FAR struct file_readahead_s *ra, uint8_t mode)
+{
+  if (ra->buffer == NULL)
+    {
+      ra->buffer = fs_heap_malloc(RA_MAXSIZE);
+      if (ra->buffer == NULL)
+        {
+          return -ENOMEM;
+        }
+    }
+
+  ra->mode   = mode;
+  ra->pos    = ra->filep->f_pos;
+  ra->head   = 0;
+  ra->len    = 0;
+  ra->eof    = false;
+  ra->window = ra->advice == POSIX_FADV_SEQUENTIAL ? RA_MAXSIZE : RA_MINSIZE;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: readahead_flush
+ *
+ * Description:
+ *   Return a stream to RA_IDLE: drop the data read ahead and put the file
+ *   system back at the user position, or write out the data written
+ *   behind.  Returns any deferred error.
+ *
+ ****************************************************************************/
+
+static int readahead_flush(FAR struct file_readahead_s *ra)
+{
+  ssize_t ret = OK;
+
+  readahead_wait(ra);
+
+  if (ra->mode == RA_READ && ra->len > ra->head)
+    {
+      ret = readahead_rawseek(ra->filep, ra->pos);
+    }
+  else if (ra->mode == RA_WRITE && ra->len > 0)
+    {
+      ret = readahead_rawwrite(ra->filep, ra->buffer, ra->len);
+    }
+
+  ra->mode = RA_IDLE;
+  ra->head = 0;
+  ra->len  = 0;
+  ra->next = ra->filep->f_pos;
+
+  if (ra->error < 0)
+    {
+      ret = ra->error;
+      ra->error = OK;
+    }
+
+  return ret < 0 ? (int)ret : OK;
+}
+
+/****************************************************************************
+ * Name: readahead_release
+ *
+ * Description:
+ *   Free the buffer of an idle stream.
+ *
+ ****************************************************************************/
+
+static void readahead_release(FAR struct file_readahead_s *ra)
+{
+  DEBUGASSERT(ra->mode == RA_IDLE);
+
+  if (ra->buffer != NULL)
+    {
+      fs_heap_free(ra->buffer);
+      ra->buffer = NULL;
+    }
+}
+
+/****************************************************************************
+ * Name: readahead_detect
+ *
+ * Description:
+ *   Update the sequential access detector of an idle stream and return
+ *   true if the access should go through the buffer.
+ *
+ ****************************************************************************/
+
+static bool readahead_detect(FAR struct file_readahead_s *ra)
+{
+  if (ra->filep->f_pos == ra->next)
+    {
+      if (ra->nseq < UINT8_MAX)
+        {
+          ra->nseq++;
+        }
+    }
+  else
+    {
+      ra->nseq = 0;
+    }
+
+  if (ra->advice == POSIX_FADV_RANDOM)
+    {
+      return false;
+    }
+
+  return ra->advice == POSIX_FADV_SEQUENTIAL || ra->nseq >= RA_SEQTHRESH;
+}
+
+/****************************************************************************
+ * Name: readahead_read
+ *
+ * Description:
+ *   Read through a stream in RA_READ mode.
+ *
+ ****************************************************************************/
+
+static ssize_t readahead_read(FAR struct file_readahead_s *ra,
+                              FAR uint8_t *buf, size_t len)
+{
+  size_t ncopied = 0;
+  ssize_t ret;
+
+  while (ncopied < len)
+    {
+      size_t avail = ra->len - ra->head;
+      size_t remaining = len - ncopied;
+
+      if (avail > 0)
+        {
+          size_t n = MIN(avail, remaining);
+
+          memcpy(buf + ncopied, ra->buffer + ra->head, n);
+          ra->head += n;
+          ra->pos  += n;
+          ncopied  += n;
+          continue;
+        }
+
+      /* The buffer is empty; the data may still be on its way */
+
+      if (ra->busy)
+        {
+          readahead_wait(ra);
+          continue;
+        }
+
+      if (ra->error < 0)
+        {
+          if (ncopied == 0)
+            {
+              ncopied   = ra->error;
+              ra->error = OK;
+            }
+
+          break;
+        }
+
+      /* Return what we have at the end of file, the next call reads
+       * again in case the file has grown.
+       */
+
+      if (ra->eof && ncopied > 0)
+        {
+          break;
+        }
+
+      /* Nothing read ahead, the file system is at 'pos'.  Large requests
+       * go straight to the caller's buffer, small ones refill ours.
+       */
+
+      ra->head = 0;
+      ra->len  = 0;
+
+      if (remaining >= ra->window)
+        {
+          ret = readahead_rawread(ra->filep, buf + ncopied, remaining);
+          if (ret > 0)
+            {
+              ra->pos += ret;
+              ncopied += ret;
+            }
+        }
+      else
+        {
+          ret = readahead_rawread(ra->filep, ra->buffer, ra->window);
+          if (ret > 0)
+            {
+              ra->len = ret;
+            }
+        }
+
+      if (ret <= 0)
+        {
+          if (ncopied == 0)
+            {
+              ncopied = ret;
+            }
+
+          ra->eof = true;
+          break;
+        }
+
+      ra->eof = ra->len == 0 ? (size_t)ret < remaining :
+                               (size_t)ret < ra->window;
+    }
+
+  readahead_kick(ra);
+  return ncopied;
+}
+
+#ifdef CONFIG_FS_WRITEBEHIND
+/****************************************************************************
+ * Name: readahead_write
+ *
+ * Description:
+ *   Write through a stream in RA_WRITE mode.
+ *
+ ****************************************************************************/
+
+static ssize_t readahead_write(FAR struct file_readahead_s *ra,
+                               FAR const uint8_t *buf, size_t len)
+{
+  size_t ncopied = 0;
+  ssize_t ret;
+
+  if (ra->error < 0)
+    {
+      ret = ra->error;
+      ra->error = OK;
+      return ret;
+    }
+
+  while (ncopied < len)
+    {
+      size_t n = MIN(RA_MAXSIZE - ra->len, len - ncopied);
+
+      if (n == 0)
+        {
+          /* The buffer is full, wait for the worker or write it out */
+
+          if (ra->busy)
+            {
+              readahead_wait(ra);
+            }
+          else
+            {
+              ret = readahead_rawwrite(ra->filep, ra->buffer, ra->len);
+              ra->len = 0;
+              if (ret < 0)
+                {
+                  ra->error = ret;
+                }
+            }
+
+          if (ra->error < 0)
+            {
+              ret = ra->error;
+              ra->error = OK;
+              return ncopied > 0 ? ncopied : ret;
+            }
+
+          continue;
+        }
+
+      memcpy(ra->buffer + ra->len, buf + ncopied, n);
+      ra->len += n;
+      ra->pos += n;
+      ncopied += n;
+    }
+
+  /* Write the buffer behind once it is half full */
+
+  if (!ra->busy && ra->len >= RA_MAXSIZE / 2)
+    {
+      ra->filllen = ra->len;
+      ra->busy    = true;
+      work_queue(LPWORK, &ra->work, readahead_worker, ra, 0);
+    }
+
+  return ncopied;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: file_readahead_read
+ *
+ * Description:
+ *   Serve a read of a regular file through its read-ahead stream.  Reads
+ *   are passed to the file system until a sequential pattern is seen;
+ *   then the file is read ahead in a window that doubles from
+ *   CONFIG_FS_READAHEAD_MINSIZE up to CONFIG_FS_READAHEAD_MAXSIZE, and the
+ *   next window is fetched on the low priority work queue while the
+ *   current one is consumed.
+ *
+ * Returned Value:
+ *   The number of bytes read, a negated errno value on failure, or
+ *   -ENOSYS if the caller has to read from the file system itself.
+ *
+ ****************************************************************************/
+
+ssize_t file_readahead_read(FAR struct file *filep,
+                            FAR const struct iovec *iov, int iovcnt)
+{
+  FAR struct file_readahead_s *ra;
+  ssize_t ret;
+
+  if (filep->f_ra == NULL && !readahead_eligible(filep))
+    {
+      return -ENOSYS;
+    }
+
+  ra = readahead_get(filep);
+  if (ra == NULL)
+    {
+      return -ENOSYS;
+    }
+
+  nxmutex_lock(&ra->lock);
+
+  /* Write out any data written behind first */
+
+  if (ra->mode == RA_WRITE || iovcnt != 1)
+    {
+      ret = readahead_flush(ra);
+      if (ret < 0 || iovcnt != 1)
+        {
+          goto out;
+        }
+    }
+
+  if (ra->mode == RA_IDLE)
+    {
+      if (ra->error < 0)
+        {
+          ret = ra->error;
+          ra->error = OK;
+          goto out;
+        }
+
+      if (!readahead_detect(ra) || iov->iov_len >= RA_MAXSIZE ||
+          readahead_start(ra, RA_READ) < 0)
+        {
+          ret = readahead_rawread(filep, iov->iov_base, iov->iov_len);
+          ra->next = filep->f_pos;
+          goto out;
+        }
+    }
+
+  ret = readahead_read(ra, iov->iov_base, iov->iov_len);
+
+out:
+  nxmutex_unlock(&ra->lock);
+  return iovcnt != 1 && ret >= 0 ? -ENOSYS : ret;
+}
+
+/****************************************************************************
+ * Name: file_readahead_write
+ *
+ * Description:
+ *   Serve a write of a regular file through its stream.  Once a file is
+ *   written sequentially in small pieces, the data is collected in the
+ *   stream buffer and written out on the low priority work queue.  A
+ *   write error of the worker is returned by the next write, fsync() or
+ *   close() of the file.
+ *
+ * Returned Value:
+ *   The number of bytes written, a negated errno value on failure, or
+ *   -ENOSYS if the caller has to write to the file system itself.
+ *
+ ****************************************************************************/
+
+ssize_t file_readahead_write(FAR struct file *filep,
+                             FAR const struct iovec *iov, int iovcnt)
+{
+  FAR struct file_readahead_s *ra = filep->f_ra;
+  ssize_t ret = -ENOSYS;
+
+#ifdef CONFIG_FS_WRITEBEHIND
+  if (ra == NULL && readahead_eligible(filep))
+    {
+      ra = readahead_get(filep);
+    }
+#endif
+
+  if (ra == NULL)
+    {
+      return -ENOSYS;
+    }
+
+  nxmutex_lock(&ra->lock);
+
+  /* Put the file system back at the user position first */
+
+  if (ra->mode == RA_READ)
+    {
+      ret = readahead_flush(ra);
+      if (ret < 0)
+        {
+          goto out;
+        }
+
+      ret = -ENOSYS;
+    }
+
+#ifdef CONFIG_FS_WRITEBEHIND
+  if (iovcnt == 1 && (filep->f_oflags & (O_APPEND | O_DSYNC)) == 0 &&
+      iov->iov_len < RA_MAXSIZE / 2)
+    {
+      if (ra->mode == RA_IDLE)
+        {
+          if (ra->error < 0)
+            {
+              ret = ra->error;
+              ra->error = OK;
+              goto out;
+            }
+
+          if (!readahead_detect(ra) || readahead_start(ra, RA_WRITE) < 0)
+            {
+              ret = readahead_rawwrite(filep, iov->iov_base, iov->iov_len);
+              ra->next = filep->f_pos;
+              goto out;
+            }
+        }
+
+      ret = readahead_write(ra, iov->iov_base, iov->iov_len);
+      goto out;
+    }
+#endif
+
+  /* Large or vectored writes go to the file system directly */
+
+  ret = readahead_flush(ra);
+  if (ret >= 0)
+    {
+      ret = -ENOSYS;
+    }
+
+out:
+  nxmutex_unlock(&ra->lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: file_readahead_sync
+ *
+ * Description:
+ *   Bring the file system position of a file in line with the position
+ *   seen by the user before any other operation on the file: drop the data
+ *   read ahead and write out the data written behind.
+ *
+ * Returned Value:
+ *   Zero (OK) on success, or the negated errno value of a failed write
+ *   behind.
+ *
+ ****************************************************************************/
+
+int file_readahead_sync(FAR struct file *filep)
+{
+  FAR struct file_readahead_s *ra = filep->f_ra;
+  int ret;
+
+  if (ra == NULL)
+    {
+      return OK;
+    }
+
+  nxmutex_lock(&ra->lock);
+  ret = readahead_flush(ra);
+  nxmutex_unlock(&ra->lock);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: file_readahead_coherent
+ *
+ * Description:
+ *   Make an access to a file coherent with the streams of the other open
+ *   files.  The files of a mounted file system share the mountpoint inode,
+ *   so every stream attached to that inode is treated as possibly of the
+ *   same file.  Before a read, the data written behind by the other files is
+ *   written out; before a write or truncate, their read-ahead data is
+ *   dropped as well.  The stream of 'filep' itself is left alone.  A
+ *   failed write behind is reported to the file that buffered the data,
+ *   not to the caller.
+ *
+ * Input Parameters:
+ *   filep - The file about to be accessed
+ *   write - True if the access modifies the file
+ *
+ ****************************************************************************/
+
+void file_readahead_coherent(FAR struct file *filep, bool write)
+{
+  FAR struct readahead_inode_s *ri;
+  FAR struct file_readahead_s *ra;
+  int nstreams;
+  int ret;
+
+  if (filep->f_inode == NULL || !INODE_IS_MOUNTPT(filep->f_inode))
+    {
+      return;
+    }
+
+  /* Nothing to do unless another file of the mountpoint has a stream */
+
+  ri = filep->f_inode->i_ra;
+  if (ri == NULL)
+    {
+      return;
+    }
+
+  nstreams = atomic_read(&ri->nstreams);
+  if (nstreams == 0 || (nstreams == 1 && filep->f_ra != NULL))
+    {
+      return;
+    }
+
+  nxmutex_lock(&ri->lock);
+
+  list_for_every_entry(&ri->streams, ra, struct file_readahead_s, node)
+    {
+      if (ra->filep == filep)
+        {
+          continue;
+        }
+
+      nxmutex_lock(&ra->lock);
+      if (ra->mode == RA_WRITE || (write && ra->mode == RA_READ))
+        {
+          ret = readahead_flush(ra);
+          if (ret < 0)
+            {
+              ra->error = ret;
+            }
+        }
+
+      nxmutex_unlock(&ra->lock);
+    }
+
+  nxmutex_unlock(&ri->lock);
+}
+
+/****************************************************************************
+ * Name: file_readahead_tell
+ *
+ * Description:
+ *   Return the position of a file with an active stream without stopping
+ *   it, or -ENOSYS.
+ *
+ ****************************************************************************/
+
+off_t file_readahead_tell(FAR struct file *filep)
+{
+  FAR struct file_readahead_s *ra = filep->f_ra;
+  off_t ret = -ENOSYS;
+
+  if (ra != NULL)
+    {
+      nxmutex_lock(&ra->lock);
+      if (ra->mode != RA_IDLE)
+        {
+          ret = ra->pos;
+        }
+
+      nxmutex_unlock(&ra->lock);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: file_readahead_advise
+ *
+ * Description:
+ *   Apply posix_fadvise() advice to the stream of a file.
+ *
+ ****************************************************************************/
+
+int file_readahead_advise(FAR struct file *filep, off_t offset, off_t len,
+                          int advice)
+{
+  FAR struct file_readahead_s *ra;
+  int ret = OK;
+
+  if (!readahead_eligible(filep))
+    {
+      return OK;
+    }
+
+  ra = readahead_get(filep);
+  if (ra == NULL)
+    {
+      return OK;
+    }
+
+  nxmutex_lock(&ra->lock);
+
+  switch (advice)
+    {
+      case POSIX_FADV_SEQUENTIAL:
+        ra->advice = POSIX_FADV_SEQUENTIAL;
+        if (ra->mode == RA_READ)
+          {
+            ra->window = RA_MAXSIZE;
+          }
+        break;
+
+      case POSIX_FADV_RANDOM:
+      case POSIX_FADV_DONTNEED:
+        ret = readahead_flush(ra);
+        readahead_release(ra);
+        ra->nseq = 0;
+        if (advice == POSIX_FADV_RANDOM)
+          {
+            ra->advice = POSIX_FADV_RANDOM;
+          }
+        break;
+
+      case POSIX_FADV_WILLNEED:
+
+        /* Start reading ahead now if the range begins at the current
+         * position.
+         */
+
+        if (ra->mode == RA_IDLE && ra->advice != POSIX_FADV_RANDOM &&
+            offset == filep->f_pos && ra->error == OK &&
+            readahead_start(ra, RA_READ) >= 0)
+          {
+            if (len > 0)
+              {
+                ra->window = len >= RA_MAXSIZE ? RA_MAXSIZE :
+                             MAX(len, RA_MINSIZE);
+              }
+
+            readahead_kick(ra);
+          }
+        break;
+
+      default:
+        ra->advice = POSIX_FADV_NORMAL;
+        break;
+    }
+
+  nxmutex_unlock(&ra->lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: file_readahead_close
+ *
+ * Description:
+ *   Write out the pending data of a file being closed and free its stream.
+ *
+ ****************************************************************************/
+
+int file_readahead_close(FAR struct file *filep)
+{
+  FAR struct file_readahead_s *ra = filep->f_ra;
+  FAR struct readahead_inode_s *ri;
+  int ret;
+
+  if (ra == NULL)
+    {
+      return OK;
+    }
+
+  ri = filep->f_inode->i_ra;
+  nxmutex_lock(&ri->lock);
+  list_delete(&ra->node);
+  atomic_fetch_sub(&ri->nstreams, 1);
+  nxmutex_unlock(&ri->lock);
+
+  nxmutex_lock(&ra->lock);
+  ret = readahead_flush(ra);
+  readahead_release(ra);
+  nxmutex_unlock(&ra->lock);
+
+  filep->f_ra = NULL;
+  nxsem_destroy(&ra->done);
+  nxmutex_destroy(&ra->lock);
+  fs_heap_free(ra);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: file_readahead_release
+ *
+ * Description:
+ *   Free the stream list of an inode being freed.  All of its files have
+ *   been closed.
+ *
+ ****************************************************************************/
+
+void file_readahead_release(FAR struct inode *inode)
+{
+  FAR struct readahead_inode_s *ri = inode->i_ra;
+
+  if (ri != NULL)
+    {
+      DEBUGASSERT(list_is_empty(&ri->streams));
+
+      inode->i_ra = NULL;
+      nxmutex_destroy(&ri->lock);
+      fs_heap_free(ri);
+    }
+}
+
+#endif /* CONFIG_FS_READAHEAD */
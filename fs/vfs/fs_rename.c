@@ -216,6 +216,7 @@ static int pseudorename(FAR const char *oldpath, FAR struct inode *oldinode,
   newinode->i_ctime   = oldinode->i_ctime;   /* Time of last status change */
 #endif
   newinode->i_private = oldinode->i_private; /* Per inode driver private data */
+  inode_cache_invalidate();
 
 #ifdef CONFIG_PSEUDOFS_SOFTLINKS
   /* Prevent the link target string from being deallocated.  The pointer to
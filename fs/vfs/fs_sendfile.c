@@ -233,6 +233,56 @@ static ssize_t copyfile(FAR struct file *outfile, FAR struct file *infile,
   return ntransferred;
 }
 
+/****************************************************************************
+ * Name: splicefile
+ *
+ * Description:
+ *   Transfer data into or out of a pipe straight from or into the pipe
+ *   buffer, without the I/O buffer of copyfile().
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_PIPES
+static ssize_t splicefile(FAR struct file *outfile, FAR struct file *infile,
+                          FAR off_t *offset, size_t count)
+{
+  size_t ntransferred = 0;
+  ssize_t ret;
+
+  while (ntransferred < count)
+    {
+      if (offset == NULL && pipe_ispipe(infile))
+        {
+          ret = pipe_splice_read(infile, outfile, NULL,
+                                 count - ntransferred, false);
+        }
+      else
+        {
+          ret = pipe_splice_write(outfile, infile, offset,
+                                  count - ntransferred, false);
+        }
+
+      /* Stop at end of file or on error, which is only reported if
+       * nothing was transferred.
+       */
+
+      if (ret <= 0)
+        {
+          if (ntransferred == 0)
+            {
+              return ret;
+            }
+
+          break;
+        }
+
+      ntransferred += ret;
+    }
+
+  return ntransferred;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -279,6 +329,15 @@ ssize_t file_sendfile(FAR struct file *outfile, FAR struct file *infile,
     }
 #endif
 
+#ifdef CONFIG_PIPES
+  /* Is one of the files a pipe?  Then move the data through its buffer */
+
+  if ((offset == NULL && pipe_ispipe(infile)) || pipe_ispipe(outfile))
+    {
+      return splicefile(outfile, infile, offset, count);
+    }
+#endif
+
   /* No... then this is probably a file-to-file transfer.  The generic
    * copyfile() can handle that case.
    */
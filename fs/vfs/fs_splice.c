@@ -0,0 +1,288 @@
+/****************************************************************************
+ * fs/vfs/fs_splice.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/uio.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <errno.h>
+
+#include <nuttx/fs/fs.h>
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: splice_copy
+ *
+ * Description:
+ *   Copy data between two files that are not pipes through the sendfile()
+ *   machinery.  An output offset is handled the way copyfile() handles
+ *   the input offset: by moving the file position and restoring it after.
+ *
+ ****************************************************************************/
+
+static ssize_t splice_copy(FAR struct file *infile, FAR off_t *inoff,
+                           FAR struct file *outfile, FAR off_t *outoff,
+                           size_t len)
+{
+  off_t startpos;
+  off_t pos;
+  ssize_t ret;
+
+  if (outoff == NULL)
+    {
+      return file_sendfile(outfile, infile, inoff, len);
+    }
+
+  startpos = file_seek(outfile, 0, SEEK_CUR);
+  if (startpos < 0)
+    {
+      return startpos;
+    }
+
+  pos = file_seek(outfile, *outoff, SEEK_SET);
+  if (pos < 0)
+    {
+      return pos;
+    }
+
+  ret = file_sendfile(outfile, infile, inoff, len);
+  if (ret > 0)
+    {
+      *outoff += ret;
+    }
+
+  pos = file_seek(outfile, startpos, SEEK_SET);
+  if (pos < 0 && ret >= 0)
+    {
+      ret = pos;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: file_splice
+ *
+ * Description:
+ *   Equivalent to the standard splice function except that is accepts
+ *   struct file instances instead of file descriptors.
+ *
+ ****************************************************************************/
+
+ssize_t file_splice(FAR struct file *infile, FAR off_t *inoff,
+                    FAR struct file *outfile, FAR off_t *outoff,
+                    size_t len, unsigned int flags)
+{
+  if ((infile->f_oflags & O_ACCMODE) == O_WRONLY ||
+      (outfile->f_oflags & O_ACCMODE) == O_RDONLY)
+    {
+      return -EBADF;
+    }
+
+  if (len == 0)
+    {
+      return 0;
+    }
+
+#ifdef CONFIG_PIPES
+  /* If either end is a pipe, move the data straight between the pipe
+   * buffer and the other file.
+   */
+
+  if (pipe_ispipe(infile))
+    {
+      if (inoff != NULL)
+        {
+          return -ESPIPE;
+        }
+
+      return pipe_splice_read(infile, outfile, outoff, len,
+                              (flags & SPLICE_F_NONBLOCK) != 0);
+    }
+
+  if (pipe_ispipe(outfile))
+    {
+      if (outoff != NULL)
+        {
+          return -ESPIPE;
+        }
+
+      return pipe_splice_write(outfile, infile, inoff, len,
+                               (flags & SPLICE_F_NONBLOCK) != 0);
+    }
+#endif
+
+  /* Otherwise fall back to copying the data */
+
+  return splice_copy(infile, inoff, outfile, outoff, len);
+}
+
+/****************************************************************************
+ * Name: splice
+ *
+ * Description:
+ *   splice() moves data between two file descriptors.  When one of them
+ *   refers to a pipe, the data is transferred directly between the pipe
+ *   buffer and the other file, which may be a regular file, a character
+ *   driver or a socket, without an intermediate buffer.  Otherwise the
+ *   data is copied as by sendfile().
+ *
+ *   NOTE: This interface is not specified in POSIX.  The implementation
+ *   follows the Linux interface, except that the pipe data is always
+ *   copied once (SPLICE_F_MOVE and SPLICE_F_GIFT are ignored) and that
+ *   neither end has to be a pipe.
+ *
+ * Input Parameters:
+ *   fd_in   - The descriptor to read from
+ *   off_in  - If not NULL, the offset in 'fd_in' to read from, which is
+ *             advanced by the number of bytes read.  The file offset of
+ *             'fd_in' is not changed then.  Must be NULL for a pipe.
+ *   fd_out  - The descriptor to write to
+ *   off_out - As 'off_in', for 'fd_out'
+ *   len     - The maximum number of bytes to move
+ *   flags   - SPLICE_F_* flags; SPLICE_F_NONBLOCK makes the pipe
+ *             operations non-blocking.
+ *
+ * Returned Value:
+ *   The number of bytes moved, zero at end of input.  On error, -1 is
+ *   returned, and errno is set appropriately:
+ *
+ *   EBADF  - A descriptor is invalid or not open in the proper mode.
+ *   ESPIPE - An offset was given for a pipe.
+ *   EINVAL - Both ends refer to the same pipe.
+ *   EAGAIN - SPLICE_F_NONBLOCK was given and the operation would block.
+ *
+ ****************************************************************************/
+
+ssize_t splice(int fd_in, FAR off_t *off_in, int fd_out, FAR off_t *off_out,
+               size_t len, unsigned int flags)
+{
+  FAR struct file *infile;
+  FAR struct file *outfile;
+  ssize_t ret;
+
+  ret = file_get(fd_in, &infile);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  ret = file_get(fd_out, &outfile);
+  if (ret < 0)
+    {
+      file_put(infile);
+      goto errout;
+    }
+
+  ret = file_splice(infile, off_in, outfile, off_out, len, flags);
+  file_put(outfile);
+  file_put(infile);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  return ret;
+
+errout:
+  set_errno(-ret);
+  return ERROR;
+}
+
+/****************************************************************************
+ * Name: vmsplice
+ *
+ * Description:
+ *   vmsplice() writes the user buffers described by 'iov' to the pipe 'fd'
+ *   if it is open for writing, or reads the pipe data into them otherwise.
+ *   The data is copied, so the buffers may be reused as soon as vmsplice()
+ *   returns; 'flags' is ignored.
+ *
+ * Returned Value:
+ *   The number of bytes transferred.  On error, -1 is returned, and errno
+ *   is set appropriately:
+ *
+ *   EBADF  - 'fd' is not valid or does not refer to a pipe.
+ *   EINVAL - 'nr_segs' is greater than IOV_MAX.
+ *
+ ****************************************************************************/
+
+ssize_t vmsplice(int fd, FAR const struct iovec *iov, size_t nr_segs,
+                 unsigned int flags)
+{
+  FAR struct file *filep;
+  ssize_t ret;
+
+  if (nr_segs > IOV_MAX)
+    {
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  ret = file_get(fd, &filep);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+#ifdef CONFIG_PIPES
+  if (!pipe_ispipe(filep))
+    {
+      ret = -EBADF;
+    }
+  else if ((filep->f_oflags & O_ACCMODE) != O_RDONLY)
+    {
+      ret = file_writev(filep, iov, nr_segs);
+    }
+  else
+    {
+      ret = file_readv(filep, iov, nr_segs);
+    }
+#else
+  ret = -EBADF;
+#endif
+
+  file_put(filep);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  return ret;
+
+errout:
+  set_errno(-ret);
+  return ERROR;
+}
@@ -54,6 +54,7 @@
 int file_truncate(FAR struct file *filep, off_t length)
 {
   struct inode *inode;
+  int ret;
 
   /* Was this file opened for write access? */
 
@@ -100,6 +101,17 @@ int file_truncate(FAR struct file *filep, off_t length)
       return -ENOSYS;
     }
 
+  /* Write out or drop the buffered data of the file, and of the other
+   * files that may refer to the same data, first.
+   */
+
+  file_readahead_coherent(filep, true);
+  ret = file_readahead_sync(filep);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
   /* Yes, then tell the file system to truncate this file */
 
   return inode->u.i_ops->truncate(filep, length);
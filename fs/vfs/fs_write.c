@@ -192,20 +192,30 @@ ssize_t file_writev(FAR struct file *filep,
 
       FS_PROFILE_START(start_time);
 
-      if (inode->u.i_ops->writev)
+      /* Sequential access to regular files may go through the
+       * read-ahead/write-behind stream of the file.
+       */
+
+      file_readahead_coherent(filep, true);
+      ret = file_readahead_write(filep, iov, iovcnt);
+      if (ret == -ENOSYS)
         {
-          struct uio uio;
+          ret = -EBADF;
+          if (inode->u.i_ops->writev)
+            {
+              struct uio uio;
 
-          ret = uio_init(&uio, iov, iovcnt);
-          if (ret == 0)
+              ret = uio_init(&uio, iov, iovcnt);
+              if (ret == 0)
+                {
+                  ret = inode->u.i_ops->writev(filep, &uio);
+                }
+            }
+          else if (inode->u.i_ops->write)
             {
-              ret = inode->u.i_ops->writev(filep, &uio);
+              ret = file_writev_compat(filep, iov, iovcnt);
             }
         }
-      else if (inode->u.i_ops->write)
-        {
-          ret = file_writev_compat(filep, iov, iovcnt);
-        }
 
       FS_PROFILE_STOP(start_time, g_fs_profile.total_write_time,
                       g_fs_profile.writes);
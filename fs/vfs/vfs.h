@@ -112,6 +112,29 @@ int file_setlk(FAR struct file *filep, FAR struct flock *flock,
 
 #endif /* CONFIG_FS_LOCK_BUCKET_SIZE */
 
+#ifdef CONFIG_FS_READAHEAD
+ssize_t file_readahead_read(FAR struct file *filep,
+                            FAR const struct iovec *iov, int iovcnt);
+ssize_t file_readahead_write(FAR struct file *filep,
+                             FAR const struct iovec *iov, int iovcnt);
+int file_readahead_sync(FAR struct file *filep);
+void file_readahead_coherent(FAR struct file *filep, bool write);
+off_t file_readahead_tell(FAR struct file *filep);
+int file_readahead_advise(FAR struct file *filep, off_t offset, off_t len,
+                          int advice);
+int file_readahead_close(FAR struct file *filep);
+void file_readahead_release(FAR struct inode *inode);
+#else
+#  define file_readahead_read(filep, iov, iovcnt)  (-ENOSYS)
+#  define file_readahead_write(filep, iov, iovcnt) (-ENOSYS)
+#  define file_readahead_sync(filep)               (OK)
+#  define file_readahead_coherent(filep, write)
+#  define file_readahead_tell(filep)               (-ENOSYS)
+#  define file_readahead_advise(filep, offset, len, advice) (OK)
+#  define file_readahead_close(filep)              (OK)
+#  define file_readahead_release(inode)
+#endif /* CONFIG_FS_READAHEAD */
+
 #ifdef CONFIG_FS_NOTIFY
 void notify_open(FAR const char *path, int oflags);
 void notify_close(FAR const char *path, int oflags);
@@ -0,0 +1,659 @@
+/****************************************************************************
+ * fs/zipfs/zip_index.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <nuttx/debug.h>
+#include <nuttx/fs/fs.h>
+
+#include <zlib.h>
+
+#include "zipfs.h"
+#include "fs_heap.h"
+
+#ifdef CONFIG_ZIPFS_INDEX
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The size of the deflate window, which is all the history that a
+ * checkpoint needs to resume inflation.
+ */
+
+#define ZIPFS_WSIZE (1 << MAX_WBITS)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A point at a deflate block boundary where inflation can be resumed */
+
+struct zipfs_point_s
+{
+  off_t out;                  /* Uncompressed offset */
+  off_t in;                   /* Compressed offset of the next whole byte */
+  uint8_t bits;               /* Unused bits of the byte before 'in' */
+  uint16_t wsize;             /* Size of the window */
+  FAR uint8_t *window;        /* The last uncompressed bytes before 'out' */
+};
+
+/* A block of uncompressed data */
+
+struct zipfs_cache_s
+{
+  off_t pos;                  /* Offset of the block, -1 if unused */
+  size_t len;                 /* Bytes in the block */
+  uint32_t age;               /* Time of the last access */
+};
+
+struct zipfs_index_s
+{
+  struct file file;           /* The archive */
+  off_t datapos;              /* Offset of the entry data in the archive */
+  off_t csize;                /* Compressed size */
+  off_t usize;                /* Uncompressed size */
+  bool deflated;              /* Deflated, otherwise stored */
+
+  /* Inflate state, for deflated entries */
+
+  z_stream strm;
+  bool started;               /* inflateInit2() was called */
+  bool valid;                 /* The stream is at 'out' */
+  off_t in;                   /* Compressed bytes read into 'inbuf' */
+  off_t out;                  /* Uncompressed bytes produced */
+  uint32_t crc;               /* Expected CRC of the entry */
+  uint32_t crcsum;            /* CRC of the bytes produced */
+  bool crcvalid;              /* 'crcsum' covers all bytes from the start */
+  FAR uint8_t *inbuf;         /* Compressed data */
+  FAR uint8_t *scratch;       /* Uncompressed data that is skipped */
+
+  /* Checkpoints, in ascending order, built while inflating */
+
+  FAR struct zipfs_point_s *points;
+  int npoints;
+
+#if CONFIG_ZIPFS_CACHE_BLOCKS > 0
+  /* Recently read blocks */
+
+  struct zipfs_cache_s cache[CONFIG_ZIPFS_CACHE_BLOCKS];
+  FAR uint8_t *cachebuf;
+  uint32_t age;
+#endif
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: zipfs_index_input
+ *
+ * Description:
+ *   Refill the input of the inflate stream.
+ *
+ ****************************************************************************/
+
+static int zipfs_index_input(FAR struct zipfs_index_s *index)
+{
+  ssize_t nread;
+
+  nread = MIN(index->csize - index->in, CONFIG_ZIPFS_SEEK_BUFSIZE);
+  if (nread > 0)
+    {
+      nread = file_read(&index->file, index->inbuf, nread);
+    }
+
+  if (nread <= 0)
+    {
+      return nread < 0 ? nread : -EIO;
+    }
+
+  index->strm.next_in  = index->inbuf;
+  index->strm.avail_in = nread;
+  index->in           += nread;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: zipfs_index_addpoint
+ *
+ * Description:
+ *   The stream is at a block boundary: remember the position if it is far
+ *   enough from the last checkpoint.  Failing to allocate a checkpoint only
+ *   makes the later seeks slower.
+ *
+ ****************************************************************************/
+
+static void zipfs_index_addpoint(FAR struct zipfs_index_s *index)
+{
+  FAR struct zipfs_point_s *point;
+  off_t last;
+  uInt wsize;
+
+  last = index->npoints > 0 ? index->points[index->npoints - 1].out : 0;
+  if (index->npoints >= CONFIG_ZIPFS_INDEX_MAXPOINTS ||
+      index->out < last + CONFIG_ZIPFS_INDEX_SPAN)
+    {
+      return;
+    }
+
+  if (index->points == NULL)
+    {
+      index->points = fs_heap_malloc(CONFIG_ZIPFS_INDEX_MAXPOINTS *
+                                     sizeof(struct zipfs_point_s));
+      if (index->points == NULL)
+        {
+          return;
+        }
+    }
+
+  point = &index->points[index->npoints];
+  point->window = fs_heap_malloc(MIN(index->out, ZIPFS_WSIZE));
+  if (point->window == NULL)
+    {
+      return;
+    }
+
+  if (inflateGetDictionary(&index->strm, point->window, &wsize) != Z_OK)
+    {
+      fs_heap_free(point->window);
+      return;
+    }
+
+  point->out   = index->out;
+  point->in    = index->in - index->strm.avail_in;
+  point->bits  = index->strm.data_type & 7;
+  point->wsize = wsize;
+  index->npoints++;
+
+  finfo("Checkpoint %d at %jd\n", index->npoints, (intmax_t)point->out);
+}
+
+/****************************************************************************
+ * Name: zipfs_index_restart
+ *
+ * Description:
+ *   Restart inflation at a checkpoint, or at the start of the entry if
+ *   'point' is NULL.
+ *
+ ****************************************************************************/
+
+static int zipfs_index_restart(FAR struct zipfs_index_s *index,
+                               FAR struct zipfs_point_s *point)
+{
+  off_t in = point != NULL ? point->in : 0;
+  uint8_t byte;
+  int ret;
+
+  index->valid = false;
+
+  if (!index->started)
+    {
+      memset(&index->strm, 0, sizeof(index->strm));
+      ret = inflateInit2(&index->strm, -MAX_WBITS);
+      if (ret != Z_OK)
+        {
+          return ret == Z_MEM_ERROR ? -ENOMEM : -EINVAL;
+        }
+
+      index->started = true;
+    }
+  else
+    {
+      inflateReset(&index->strm);
+    }
+
+  /* The bits of a checkpoint are in the byte before its input offset */
+
+  ret = file_seek(&index->file, index->datapos + in -
+                  (point != NULL && point->bits ? 1 : 0), SEEK_SET);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (point != NULL)
+    {
+      if (point->bits)
+        {
+          ret = file_read(&index->file, &byte, 1);
+          if (ret != 1)
+            {
+              return ret < 0 ? ret : -EIO;
+            }
+
+          inflatePrime(&index->strm, point->bits,
+                       byte >> (8 - point->bits));
+        }
+
+      inflateSetDictionary(&index->strm, point->window, point->wsize);
+      index->out      = point->out;
+      index->crcvalid = false;
+    }
+  else
+    {
+      index->out      = 0;
+      index->crcsum   = crc32(0, NULL, 0);
+      index->crcvalid = true;
+    }
+
+  index->strm.avail_in = 0;
+  index->in            = in;
+  index->valid         = true;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: zipfs_index_inflate
+ *
+ * Description:
+ *   Inflate up to 'len' bytes at the current position of the stream.
+ *
+ * Returned Value:
+ *   The number of bytes produced or a negated errno value.
+ *
+ ****************************************************************************/
+
+static ssize_t zipfs_index_inflate(FAR struct zipfs_index_s *index,
+                                   FAR uint8_t *buf, size_t len)
+{
+  FAR z_stream *strm = &index->strm;
+  uInt avail;
+  int ret;
+
+  strm->next_out  = buf;
+  strm->avail_out = len;
+
+  while (strm->avail_out > 0 && index->out < index->usize)
+    {
+      if (strm->avail_in == 0)
+        {
+          ret = zipfs_index_input(index);
+          if (ret < 0)
+            {
+              goto errout;
+            }
+        }
+
+      /* Stop at every block boundary to record the checkpoints */
+
+      avail = strm->avail_out;
+      ret = inflate(strm, Z_BLOCK);
+      avail -= strm->avail_out;
+
+      if (index->crcvalid)
+        {
+          index->crcsum = crc32(index->crcsum, strm->next_out - avail,
+                                avail);
+        }
+
+      index->out += avail;
+
+      if (ret == Z_STREAM_END)
+        {
+          break;
+        }
+      else if (ret == Z_MEM_ERROR)
+        {
+          ret = -ENOMEM;
+          goto errout;
+        }
+      else if (ret != Z_OK && !(ret == Z_BUF_ERROR && strm->avail_in == 0))
+        {
+          ferr("ERROR: inflate failed at %jd: %d\n",
+               (intmax_t)index->out, ret);
+          ret = -EIO;
+          goto errout;
+        }
+
+      if ((strm->data_type & 128) && !(strm->data_type & 64))
+        {
+          zipfs_index_addpoint(index);
+        }
+    }
+
+  if (strm->avail_out > 0 && index->out != index->usize)
+    {
+      ferr("ERROR: Entry ends at %jd instead of %jd\n",
+           (intmax_t)index->out, (intmax_t)index->usize);
+      ret = -EIO;
+      goto errout;
+    }
+
+  if (index->out == index->usize && index->crcvalid &&
+      index->crcsum != index->crc)
+    {
+      ferr("ERROR: CRC mismatch\n");
+      ret = -ESTALE;
+      goto errout;
+    }
+
+  return len - strm->avail_out;
+
+errout:
+  index->valid = false;
+  return ret;
+}
+
+/****************************************************************************
+ * Name: zipfs_index_seek
+ *
+ * Description:
+ *   Move the inflate stream to the offset 'pos'.  It is restarted at the
+ *   nearest checkpoint before 'pos' if that is ahead of the stream or if
+ *   the stream is past 'pos', and then inflated up to 'pos'.
+ *
+ ****************************************************************************/
+
+static int zipfs_index_seek(FAR struct zipfs_index_s *index, off_t pos)
+{
+  FAR struct zipfs_point_s *point = NULL;
+  ssize_t ret;
+  int i;
+
+  for (i = index->npoints - 1; i >= 0; i--)
+    {
+      if (index->points[i].out <= pos)
+        {
+          point = &index->points[i];
+          break;
+        }
+    }
+
+  if (!index->valid || index->out > pos ||
+      (point != NULL && point->out > index->out))
+    {
+      ret = zipfs_index_restart(index, point);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  while (index->out < pos)
+    {
+      ret = zipfs_index_inflate(index, index->scratch,
+                                MIN(pos - index->out,
+                                    CONFIG_ZIPFS_SEEK_BUFSIZE));
+      if (ret <= 0)
+        {
+          return ret < 0 ? ret : -EIO;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: zipfs_index_fill
+ *
+ * Description:
+ *   Read 'len' uncompressed bytes at 'pos', which are all in the entry.
+ *
+ ****************************************************************************/
+
+static ssize_t zipfs_index_fill(FAR struct zipfs_index_s *index, off_t pos,
+                                FAR uint8_t *buf, size_t len)
+{
+  ssize_t ret;
+
+  if (!index->deflated)
+    {
+      ret = file_seek(&index->file, index->datapos + pos, SEEK_SET);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      return file_read(&index->file, buf, len);
+    }
+
+  ret = zipfs_index_seek(index, pos);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  return zipfs_index_inflate(index, buf, len);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: zipfs_index_open
+ ****************************************************************************/
+
+int zipfs_index_open(FAR const char *abspath, unzFile uf,
+                     FAR struct zipfs_index_s **indexp)
+{
+  FAR struct zipfs_index_s *index;
+  unz_file_info64 file_info;
+  ZPOS64_T datapos;
+  int ret;
+
+  ret = unzGetCurrentFileInfo64(uf, &file_info, NULL, 0, NULL, 0, NULL, 0);
+  if (ret != UNZ_OK)
+    {
+      return -EINVAL;
+    }
+
+  datapos = unzGetCurrentFileZStreamPos64(uf);
+  if (datapos == 0 || (file_info.flag & 1) != 0 ||
+      (file_info.compression_method != 0 &&
+       file_info.compression_method != Z_DEFLATED))
+    {
+      return -ENOSYS;
+    }
+
+  index = fs_heap_zalloc(sizeof(struct zipfs_index_s));
+  if (index == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  index->datapos  = datapos;
+  index->csize    = file_info.compressed_size;
+  index->usize    = file_info.uncompressed_size;
+  index->crc      = file_info.crc;
+  index->deflated = file_info.compression_method == Z_DEFLATED;
+
+  if (index->deflated)
+    {
+      index->inbuf   = fs_heap_malloc(CONFIG_ZIPFS_SEEK_BUFSIZE);
+      index->scratch = fs_heap_malloc(CONFIG_ZIPFS_SEEK_BUFSIZE);
+      if (index->inbuf == NULL || index->scratch == NULL)
+        {
+          ret = -ENOMEM;
+          goto errout_with_index;
+        }
+    }
+
+  ret = file_open(&index->file, abspath, O_RDONLY);
+  if (ret < 0)
+    {
+      goto errout_with_index;
+    }
+
+#if CONFIG_ZIPFS_CACHE_BLOCKS > 0
+  for (ret = 0; ret < CONFIG_ZIPFS_CACHE_BLOCKS; ret++)
+    {
+      index->cache[ret].pos = -1;
+    }
+#endif
+
+  *indexp = index;
+  return OK;
+
+errout_with_index:
+  fs_heap_free(index->scratch);
+  fs_heap_free(index->inbuf);
+  fs_heap_free(index);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: zipfs_index_close
+ ****************************************************************************/
+
+void zipfs_index_close(FAR struct zipfs_index_s *index)
+{
+  int i;
+
+  if (index->started)
+    {
+      inflateEnd(&index->strm);
+    }
+
+  for (i = 0; i < index->npoints; i++)
+    {
+      fs_heap_free(index->points[i].window);
+    }
+
+  file_close(&index->file);
+
+#if CONFIG_ZIPFS_CACHE_BLOCKS > 0
+  fs_heap_free(index->cachebuf);
+#endif
+  fs_heap_free(index->points);
+  fs_heap_free(index->scratch);
+  fs_heap_free(index->inbuf);
+  fs_heap_free(index);
+}
+
+/****************************************************************************
+ * Name: zipfs_index_read
+ ****************************************************************************/
+
+ssize_t zipfs_index_read(FAR struct zipfs_index_s *index, off_t pos,
+                         FAR char *buffer, size_t buflen)
+{
+#if CONFIG_ZIPFS_CACHE_BLOCKS > 0
+  FAR struct zipfs_cache_s *block;
+  size_t nread = 0;
+  off_t bpos;
+  ssize_t ret;
+  size_t n;
+  int i;
+#endif
+
+  if (pos < 0 || pos >= index->usize)
+    {
+      return 0;
+    }
+
+  buflen = MIN(buflen, index->usize - pos);
+
+#if CONFIG_ZIPFS_CACHE_BLOCKS > 0
+  /* Reads of a block or more gain nothing from the cache: they are
+   * inflated straight into the buffer of the caller.
+   */
+
+  if (buflen >= CONFIG_ZIPFS_CACHE_BLOCKSIZE)
+    {
+      return zipfs_index_fill(index, pos, (FAR uint8_t *)buffer, buflen);
+    }
+
+  if (index->deflated && index->cachebuf == NULL)
+    {
+      index->cachebuf = fs_heap_malloc(CONFIG_ZIPFS_CACHE_BLOCKS *
+                                       CONFIG_ZIPFS_CACHE_BLOCKSIZE);
+    }
+
+  if (index->cachebuf == NULL)
+#endif
+    {
+      return zipfs_index_fill(index, pos, (FAR uint8_t *)buffer, buflen);
+    }
+
+#if CONFIG_ZIPFS_CACHE_BLOCKS > 0
+  /* Go through the cache, which replaces the least recently used block
+   * on a miss.
+   */
+
+  while (nread < buflen)
+    {
+      bpos  = pos - pos % CONFIG_ZIPFS_CACHE_BLOCKSIZE;
+      block = &index->cache[0];
+
+      for (i = 0; i < CONFIG_ZIPFS_CACHE_BLOCKS; i++)
+        {
+          if (index->cache[i].pos == bpos)
+            {
+              block = &index->cache[i];
+              break;
+            }
+          else if (index->cache[i].age < block->age)
+            {
+              block = &index->cache[i];
+            }
+        }
+
+      i = block - index->cache;
+      if (block->pos != bpos)
+        {
+          block->pos = -1;
+          ret = zipfs_index_fill(index, bpos,
+                                 index->cachebuf +
+                                 i * CONFIG_ZIPFS_CACHE_BLOCKSIZE,
+                                 MIN(CONFIG_ZIPFS_CACHE_BLOCKSIZE,
+                                     index->usize - bpos));
+          if (ret <= 0)
+            {
+              return nread > 0 ? nread : ret;
+            }
+
+          block->pos = bpos;
+          block->len = ret;
+        }
+
+      block->age = ++index->age;
+
+      if (pos - bpos >= block->len)
+        {
+          break;
+        }
+
+      n = MIN(buflen - nread, block->len - (pos - bpos));
+      memcpy(buffer + nread, index->cachebuf +
+             i * CONFIG_ZIPFS_CACHE_BLOCKSIZE + (pos - bpos), n);
+
+      nread += n;
+      pos   += n;
+    }
+
+  return nread;
+#endif
+}
+
+#endif /* CONFIG_ZIPFS_INDEX */
@@ -37,6 +37,7 @@
 
 #include <unzip.h>
 
+#include "zipfs.h"
 #include "fs_heap.h"
 
 /****************************************************************************
@@ -61,6 +62,9 @@ struct zipfs_file_s
   unzFile uf;
   mutex_t lock;
   FAR char *seekbuf;
+#ifdef CONFIG_ZIPFS_INDEX
+  FAR struct zipfs_index_s *index;
+#endif
   char relpath[1];
 };
 
@@ -283,6 +287,19 @@ static int zipfs_open(FAR struct file *filep, FAR const char *relpath,
       goto err_with_zip;
     }
 
+#ifdef CONFIG_ZIPFS_INDEX
+  /* Read stored and deflated entries with random access, all others
+   * through minizip.
+   */
+
+  fp->index = NULL;
+  ret = zipfs_index_open(fs->abspath, fp->uf, &fp->index);
+  if (ret == -ENOSYS)
+    {
+      ret = OK;
+    }
+#endif
+
   if (ret == OK)
     {
       fp->seekbuf = NULL;
@@ -307,6 +324,13 @@ static int zipfs_close(FAR struct file *filep)
   FAR struct zipfs_file_s *fp = filep->f_priv;
   int ret;
 
+#ifdef CONFIG_ZIPFS_INDEX
+  if (fp->index != NULL)
+    {
+      zipfs_index_close(fp->index);
+    }
+
+#endif
   ret = zipfs_convert_result(unzClose(fp->uf));
   nxmutex_destroy(&fp->lock);
   fs_heap_free(fp->seekbuf);
@@ -321,7 +345,18 @@ static ssize_t zipfs_read(FAR struct file *filep, FAR char *buffer,
   ssize_t ret;
 
   nxmutex_lock(&fp->lock);
-  ret = zipfs_convert_result(unzReadCurrentFile(fp->uf, buffer, buflen));
+#ifdef CONFIG_ZIPFS_INDEX
+  if (fp->index != NULL)
+    {
+      ret = zipfs_index_read(fp->index, filep->f_pos, buffer, buflen);
+    }
+  else
+#endif
+    {
+      ret = zipfs_convert_result(unzReadCurrentFile(fp->uf, buffer,
+                                                    buflen));
+    }
+
   if (ret > 0)
     {
       filep->f_pos += ret;
@@ -398,6 +433,24 @@ static off_t zipfs_seek(FAR struct file *filep, off_t offset,
         goto err_with_lock;
     }
 
+#ifdef CONFIG_ZIPFS_INDEX
+  /* The entry is read at the file position, only that needs to be set */
+
+  if (fp->index != NULL)
+    {
+      if (offset < 0)
+        {
+          ret = -EINVAL;
+        }
+      else
+        {
+          filep->f_pos = offset;
+        }
+
+      goto err_with_lock;
+    }
+#endif
+
   if (filep->f_pos == offset)
     {
       goto err_with_lock;
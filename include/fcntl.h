@@ -153,6 +153,22 @@
 #define DN_RENAME   4  /* A file was renamed */
 #define DN_ATTRIB   5  /* Attributes of a file were changed */
 
+/* Flags for splice() and vmsplice() */
+
+#define SPLICE_F_MOVE       0x0001 /* Move pages instead of copying (hint) */
+#define SPLICE_F_NONBLOCK   0x0002 /* Do not block on the pipe */
+#define SPLICE_F_MORE       0x0004 /* More data will follow (hint) */
+#define SPLICE_F_GIFT       0x0008 /* The pages are gifted to the kernel */
+
+/* Advice for posix_fadvise() */
+
+#define POSIX_FADV_NORMAL     0 /* No advice, the default */
+#define POSIX_FADV_RANDOM     1 /* Data will be accessed randomly */
+#define POSIX_FADV_SEQUENTIAL 2 /* Data will be accessed sequentially */
+#define POSIX_FADV_WILLNEED   3 /* Data will be accessed soon */
+#define POSIX_FADV_DONTNEED   4 /* Data will not be accessed soon */
+#define POSIX_FADV_NOREUSE    5 /* Data will be accessed only once */
+
 /* Types of seals */
 
 #define F_SEAL_SEAL         0x0001 /* Prevent further seals from being set */
@@ -179,6 +195,8 @@
  * Public Type Definitions
  ****************************************************************************/
 
+struct iovec; /* Forward reference */
+
 /* struct flock is the third argument for F_GETLK, F_SETLK and F_SETLKW */
 
 struct flock
@@ -214,8 +232,14 @@ int open(FAR const char *path, int oflag, ...);
 int openat(int dirfd, FAR const char *path, int oflag, ...);
 int fcntl(int fd, int cmd, ...);
 
+int posix_fadvise(int fd, off_t offset, off_t len, int advice);
 int posix_fallocate(int fd, off_t offset, off_t len);
 
+ssize_t splice(int fd_in, FAR off_t *off_in, int fd_out, FAR off_t *off_out,
+               size_t len, unsigned int flags);
+ssize_t vmsplice(int fd, FAR const struct iovec *iov, size_t nr_segs,
+                 unsigned int flags);
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
@@ -58,5 +58,7 @@
                                            * Argument: max retry count */
 #define TCP_MAXSEG    (__SO_PROTOCOL + 4) /* The maximum segment size */
 #define TCP_CORK      (__SO_PROTOCOL + 5) /* Coalescing of small segments */
+#define TCP_FASTOPEN  (__SO_PROTOCOL + 6) /* Enable TCP Fast Open on a listener
+                                           * Argument: int, 0 disables */
 
 #endif /* __INCLUDE_NETINET_TCP_H */
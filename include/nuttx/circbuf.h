@@ -37,11 +37,14 @@
 #include <stdbool.h>
 #include <sys/types.h>
 
+#include <nuttx/atomic.h>
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
 
 #define CIRCBUF_INITIALIZER(base, size) { base, size, 0, 0, true }
+#define CIRCBUF_LF_INITIALIZER(base, size) { base, size, 0, 0, 0, true }
 
 /****************************************************************************
  * Public Types
@@ -58,6 +61,32 @@ struct circbuf_s
   bool      external; /* The flag for external buffer */
 };
 
+/* This structure describes a lock-free circular buffer.
+ *
+ * One consumer and any number of producers may use it concurrently without
+ * a lock.  Producers reserve space by advancing 'reserve' and publish the
+ * data they copied by advancing 'commit'; the consumer frees space by
+ * advancing 'tail'.  Commits are published in the order of the
+ * reservations: a producer first waits for 'commit' to reach the start of
+ * its reservation, so the consumer sees all data up to 'commit' as soon as
+ * it is complete.  All indexes run in [0, 2 * size) so that a full buffer
+ * can be told from an empty one for any buffer size.
+ *
+ * With a single producer (circbuf_lf_write, circbuf_lf_get_writeptr) the
+ * reservation and the commit happen together.  Several producers must all
+ * use circbuf_lf_write_mp, or be serialized by the caller.
+ */
+
+struct circbuf_lf_s
+{
+  FAR void *base;     /* The pointer to buffer space */
+  size_t    size;     /* The size of buffer space */
+  atomic_t  reserve;  /* The end of the space reserved by producers */
+  atomic_t  commit;   /* The end of the data published to the consumer */
+  atomic_t  tail;     /* The tail of buffer space, moved by the consumer */
+  bool      external; /* The flag for external buffer */
+};
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -411,6 +440,319 @@ void circbuf_writecommit(FAR struct circbuf_s *circ, size_t writtensize);
 
 void circbuf_readcommit(FAR struct circbuf_s *circ, size_t readsize);
 
+/****************************************************************************
+ * Name: circbuf_lf_init
+ *
+ * Description:
+ *   Initialize a lock-free circular buffer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   base  - A pointer to circular buffer's internal buffer, or NULL to
+ *           allocate a buffer of the given size.
+ *   bytes - The size of the internal buffer.
+ *
+ * Returned Value:
+ *   Zero on success; A negated errno value is returned on any failure.
+ *
+ ****************************************************************************/
+
+int circbuf_lf_init(FAR struct circbuf_lf_s *circ,
+                    FAR void *base, size_t bytes);
+
+/****************************************************************************
+ * Name: circbuf_lf_resize
+ *
+ * Description:
+ *   Resize a lock-free circular buffer, keeping as much of the buffered
+ *   data as fits.  The caller must make sure that no producer or consumer
+ *   is using the buffer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   bytes - The new size of the internal buffer.
+ *
+ * Returned Value:
+ *   Zero on success; A negated errno value is returned on any failure.
+ *
+ ****************************************************************************/
+
+int circbuf_lf_resize(FAR struct circbuf_lf_s *circ, size_t bytes);
+
+/****************************************************************************
+ * Name: circbuf_lf_uninit
+ *
+ * Description:
+ *   Free the lock-free circular buffer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+void circbuf_lf_uninit(FAR struct circbuf_lf_s *circ);
+
+/****************************************************************************
+ * Name: circbuf_lf_reset
+ *
+ * Description:
+ *   Remove the entire circular buffer content.  The caller must make sure
+ *   that no producer or consumer is using the buffer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+void circbuf_lf_reset(FAR struct circbuf_lf_s *circ);
+
+/****************************************************************************
+ * Name: circbuf_lf_is_init
+ *
+ * Description:
+ *   Return true if the circular buffer had been initialized.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+bool circbuf_lf_is_init(FAR struct circbuf_lf_s *circ);
+
+/****************************************************************************
+ * Name: circbuf_lf_size
+ *
+ * Description:
+ *   Return size of the circular buffer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+size_t circbuf_lf_size(FAR struct circbuf_lf_s *circ);
+
+/****************************************************************************
+ * Name: circbuf_lf_used
+ *
+ * Description:
+ *   Return the bytes that are ready to be read from the circular buffer.
+ *   May be called from any context; the value is only a snapshot unless
+ *   called by the consumer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+size_t circbuf_lf_used(FAR struct circbuf_lf_s *circ);
+
+/****************************************************************************
+ * Name: circbuf_lf_space
+ *
+ * Description:
+ *   Return the remaining space of the circular buffer.  May be called from
+ *   any context; the value is only a snapshot unless called by the only
+ *   producer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+size_t circbuf_lf_space(FAR struct circbuf_lf_s *circ);
+
+/****************************************************************************
+ * Name: circbuf_lf_is_empty
+ *
+ * Description:
+ *   Return true if there is no data ready to be read.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+bool circbuf_lf_is_empty(FAR struct circbuf_lf_s *circ);
+
+/****************************************************************************
+ * Name: circbuf_lf_is_full
+ *
+ * Description:
+ *   Return true if there is no space left to write.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+bool circbuf_lf_is_full(FAR struct circbuf_lf_s *circ);
+
+/****************************************************************************
+ * Name: circbuf_lf_peekat
+ *
+ * Description:
+ *   Get data at an offset from the tail of the circular buffer without
+ *   removing it.  Consumer side only.
+ *
+ * Input Parameters:
+ *   circ   - Address of the circular buffer to be used.
+ *   offset - Offset from the oldest byte in the buffer.
+ *   dst    - Address where to store the data.
+ *   bytes  - Number of bytes to get.
+ *
+ * Returned Value:
+ *   The number of bytes copied, which may be less than requested.
+ *
+ ****************************************************************************/
+
+ssize_t circbuf_lf_peekat(FAR struct circbuf_lf_s *circ, size_t offset,
+                          FAR void *dst, size_t bytes);
+
+/****************************************************************************
+ * Name: circbuf_lf_read
+ *
+ * Description:
+ *   Get up to 'bytes' bytes from the circular buffer.  Consumer side only.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   dst   - Address where to store the data.
+ *   bytes - Number of bytes to get.
+ *
+ * Returned Value:
+ *   The number of bytes read, which may be less than requested.
+ *
+ ****************************************************************************/
+
+ssize_t circbuf_lf_read(FAR struct circbuf_lf_s *circ,
+                        FAR void *dst, size_t bytes);
+
+/****************************************************************************
+ * Name: circbuf_lf_skip
+ *
+ * Description:
+ *   Skip up to 'bytes' bytes from the circular buffer.  Consumer side only.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   bytes - Number of bytes to skip.
+ *
+ * Returned Value:
+ *   The number of bytes skipped, which may be less than requested.
+ *
+ ****************************************************************************/
+
+ssize_t circbuf_lf_skip(FAR struct circbuf_lf_s *circ, size_t bytes);
+
+/****************************************************************************
+ * Name: circbuf_lf_write
+ *
+ * Description:
+ *   Write up to 'bytes' bytes to the circular buffer.  Only one producer
+ *   may call this function at a time.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   src   - The data to be added.
+ *   bytes - Number of bytes to be added.
+ *
+ * Returned Value:
+ *   The number of bytes written, which may be less than requested.
+ *
+ ****************************************************************************/
+
+ssize_t circbuf_lf_write(FAR struct circbuf_lf_s *circ,
+                         FAR const void *src, size_t bytes);
+
+/****************************************************************************
+ * Name: circbuf_lf_write_mp
+ *
+ * Description:
+ *   Write a record to the circular buffer.  Any number of producers may
+ *   call this function concurrently, including from interrupt handlers.
+ *   The record is written as a whole or not at all.  The record is copied
+ *   and published with local interrupts disabled, after the producers that
+ *   reserved space before it have published theirs, so records should be
+ *   short.  Only available to kernel code, which can disable interrupts.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   src   - The data to be added.
+ *   bytes - Number of bytes to be added.
+ *
+ * Returned Value:
+ *   'bytes' if the record is written; -EAGAIN if there is not enough space
+ *   left; -EINVAL if the record is larger than the buffer.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_BUILD_FLAT) || defined(__KERNEL__)
+ssize_t circbuf_lf_write_mp(FAR struct circbuf_lf_s *circ,
+                            FAR const void *src, size_t bytes);
+#endif
+
+/****************************************************************************
+ * Name: circbuf_lf_get_writeptr
+ *
+ * Description:
+ *   Get the write pointer of the circular buffer for zero-copy writing.
+ *   Only one producer may call this function at a time, and the space must
+ *   be published with circbuf_lf_writecommit.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   size  - Returns the maximum size that can be written consecutively.
+ *
+ * Returned Value:
+ *   The write pointer of the circular buffer.
+ *
+ ****************************************************************************/
+
+FAR void *circbuf_lf_get_writeptr(FAR struct circbuf_lf_s *circ,
+                                  FAR size_t *size);
+
+/****************************************************************************
+ * Name: circbuf_lf_writecommit
+ *
+ * Description:
+ *   Publish the data written through circbuf_lf_get_writeptr.
+ *
+ * Input Parameters:
+ *   circ        - Address of the circular buffer to be used.
+ *   writtensize - The data that has been written to the buffer.
+ *
+ ****************************************************************************/
+
+void circbuf_lf_writecommit(FAR struct circbuf_lf_s *circ,
+                            size_t writtensize);
+
+/****************************************************************************
+ * Name: circbuf_lf_get_readptr
+ *
+ * Description:
+ *   Get the read pointer of the circular buffer for zero-copy reading.
+ *   Consumer side only; the data must be released with
+ *   circbuf_lf_readcommit.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   size  - Returns the maximum size that can be read consecutively.
+ *
+ * Returned Value:
+ *   The read pointer of the circular buffer.
+ *
+ ****************************************************************************/
+
+FAR void *circbuf_lf_get_readptr(FAR struct circbuf_lf_s *circ,
+                                 FAR size_t *size);
+
+/****************************************************************************
+ * Name: circbuf_lf_readcommit
+ *
+ * Description:
+ *   Release the data read through circbuf_lf_get_readptr.
+ *
+ * Input Parameters:
+ *   circ     - Address of the circular buffer to be used.
+ *   readsize - The data that has been read from the buffer.
+ *
+ ****************************************************************************/
+
+void circbuf_lf_readcommit(FAR struct circbuf_lf_s *circ, size_t readsize);
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
@@ -31,6 +31,23 @@
 
 #include <sys/types.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Sector cache statistics of a BCH device, returned by BIOC_CACHESTATS */
+
+struct bchlib_stats_s
+{
+  uint32_t hits;         /* Sector accesses served by the cache */
+  uint32_t misses;       /* Sector accesses that read the device */
+  uint32_t readaheads;   /* Sectors read ahead of a sequential access */
+  uint32_t reads;        /* Read requests sent to the device */
+  uint32_t writes;       /* Write requests sent to the device */
+  uint32_t coalesced;    /* Dirty sectors merged into another write */
+};
 
 /****************************************************************************
  * Public Function Prototypes
@@ -0,0 +1,260 @@
+/****************************************************************************
+ * include/nuttx/fs/blkqueue.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INCLUDE_NUTTX_FS_BLKQUEUE_H
+#define __INCLUDE_NUTTX_FS_BLKQUEUE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <nuttx/spinlock_type.h>
+
+#ifdef CONFIG_FS_BLKQUEUE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Block request operations */
+
+#define BLK_REQ_READ   0
+#define BLK_REQ_WRITE  1
+
+/* Iterate over the requests of a batch handed to the dispatch method */
+
+#define blk_batch_for_every(batch, req) \
+  for ((req) = (batch); (req) != NULL; (req) = (req)->seg)
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+struct inode;
+struct blk_request_s;
+struct blk_queue_s;
+
+/* Called when a request is done, possibly from interrupt context */
+
+typedef CODE void (*blk_complete_t)(FAR struct blk_request_s *req);
+
+/* One read or write of contiguous sectors.  The submitter fills in the
+ * fields up to 'arg'; the rest belongs to the queue until the request
+ * is completed.
+ */
+
+struct blk_request_s
+{
+  uint8_t                   op;       /* BLK_REQ_READ or BLK_REQ_WRITE */
+  FAR unsigned char        *buffer;   /* The data of the request */
+  blkcnt_t                  sector;   /* The first sector */
+  unsigned int              nsectors; /* The number of sectors */
+  blk_complete_t            complete; /* Completion callback */
+  FAR void                 *arg;      /* For use by the submitter */
+
+  /* Completion status: the number of sectors transferred or a negated
+   * errno value.
+   */
+
+  ssize_t                   result;
+
+  /* Queue private.  The requests merged into a batch are linked through
+   * 'seg' in ascending sector order; the totals of the batch are kept in
+   * its first request.
+   */
+
+  FAR struct blk_request_s *next;     /* Next batch in the queue */
+  FAR struct blk_request_s *seg;      /* Next request of the batch */
+  FAR struct blk_request_s *last;     /* Last request of the batch */
+  unsigned int              total;    /* Sectors of the batch */
+  uint16_t                  nsegs;    /* Requests in the batch */
+};
+
+/* Driver interface of a request queue */
+
+struct blk_queue_ops_s
+{
+  /* Start the transfer of a batch: requests with the same operation and
+   * contiguous sectors starting at batch->sector, batch->total sectors in
+   * all.  The driver calls blk_queue_complete() when the transfer is done,
+   * which may be before dispatch returns.  A negated errno value returned
+   * by dispatch completes the batch with that error.
+   */
+
+  CODE int (*dispatch)(FAR struct blk_queue_s *queue,
+                       FAR struct blk_request_s *batch);
+
+  /* Optional: called after one or more batches were dispatched in a row,
+   * so that the driver can notify the device once for all of them.
+   */
+
+  CODE void (*commit)(FAR struct blk_queue_s *queue);
+};
+
+/* A request queue, embedded in the driver state */
+
+struct blk_queue_s
+{
+  FAR const struct blk_queue_ops_s *ops;
+  spinlock_t                lock;
+  FAR struct blk_request_s *pending;     /* Batches in sector order */
+  FAR struct blk_request_s *active;      /* Batches in flight */
+  FAR struct blk_request_s *deferred;    /* Overlapping requests, FIFO */
+  FAR struct blk_request_s *deftail;
+  blkcnt_t                  position;    /* Elevator position */
+  uint32_t                  maxsectors;  /* Limits of a batch */
+  uint16_t                  maxsegs;
+  uint16_t                  depth;       /* Batches in flight at most */
+  uint16_t                  inflight;    /* Batches in flight */
+  uint16_t                  plugged;     /* Dispatching held back */
+  bool                      running;     /* A context is dispatching */
+
+  /* Statistics */
+
+  uint32_t                  submitted;   /* Requests submitted */
+  uint32_t                  merged;      /* Requests merged into a batch */
+  uint32_t                  dispatched;  /* Batches dispatched */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: blk_queue_init
+ *
+ * Description:
+ *   Initialize the request queue of a block driver.
+ *
+ * Input Parameters:
+ *   queue      - The queue to initialize.
+ *   ops        - The driver methods.
+ *   depth      - How many batches the driver can have in flight.
+ *   maxsegs    - How many requests (buffers) a batch may have.
+ *   maxsectors - How many sectors a batch may have.
+ *
+ ****************************************************************************/
+
+void blk_queue_init(FAR struct blk_queue_s *queue,
+                    FAR const struct blk_queue_ops_s *ops,
+                    uint16_t depth, uint16_t maxsegs, uint32_t maxsectors);
+
+/****************************************************************************
+ * Name: blk_queue_submit
+ *
+ * Description:
+ *   Queue a request.  It is merged with a queued request of adjacent
+ *   sectors if possible, and dispatched in the order of a one-way
+ *   elevator.  Requests that overlap queued requests are held back until
+ *   these are done.
+ *
+ ****************************************************************************/
+
+void blk_queue_submit(FAR struct blk_queue_s *queue,
+                      FAR struct blk_request_s *req);
+
+/****************************************************************************
+ * Name: blk_queue_complete
+ *
+ * Description:
+ *   Called by the driver when a batch is done.  'result' is negative if
+ *   the transfer failed.  May be called from interrupt context.
+ *
+ ****************************************************************************/
+
+void blk_queue_complete(FAR struct blk_queue_s *queue,
+                        FAR struct blk_request_s *batch, int result);
+
+/****************************************************************************
+ * Name: blk_queue_plug / blk_queue_unplug
+ *
+ * Description:
+ *   Hold back dispatching while a series of requests is submitted, so that
+ *   they can be merged and sorted.
+ *
+ ****************************************************************************/
+
+void blk_queue_plug(FAR struct blk_queue_s *queue);
+void blk_queue_unplug(FAR struct blk_queue_s *queue);
+
+/****************************************************************************
+ * Name: blk_queue_rdwr
+ *
+ * Description:
+ *   Synchronous read or write through a request queue, for the
+ *   block_operations methods of a driver with a queue.
+ *
+ * Returned Value:
+ *   The number of sectors transferred or a negated errno value.
+ *
+ ****************************************************************************/
+
+ssize_t blk_queue_rdwr(FAR struct blk_queue_s *queue,
+                       FAR unsigned char *buffer, blkcnt_t sector,
+                       unsigned int nsectors, bool write);
+
+/****************************************************************************
+ * Name: blk_submit
+ *
+ * Description:
+ *   Submit a request to a block driver.  Drivers with a request queue
+ *   (see BIOC_GETQUEUE) complete it asynchronously; for all others the
+ *   request is executed with the read or write method and completed
+ *   before blk_submit() returns.
+ *
+ ****************************************************************************/
+
+void blk_submit(FAR struct inode *inode, FAR struct blk_request_s *req);
+
+/****************************************************************************
+ * Name: blk_plug / blk_unplug
+ *
+ * Description:
+ *   blk_queue_plug() and blk_queue_unplug() for the queue of a block
+ *   driver, if it has one.
+ *
+ ****************************************************************************/
+
+void blk_plug(FAR struct inode *inode);
+void blk_unplug(FAR struct inode *inode);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_FS_BLKQUEUE */
+#endif /* __INCLUDE_NUTTX_FS_BLKQUEUE_H */
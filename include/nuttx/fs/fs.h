@@ -189,6 +189,7 @@ struct statfs;
 struct pollfd;
 struct mtd_dev_s;
 struct uio;
+struct file_readahead_s;
 
 /* The internal representation of type DIR is just a container for an inode
  * reference, and the path of directory.
@@ -456,6 +457,9 @@ struct inode
   struct timespec   i_ctime;    /* Time of last status change */
 #endif
   FAR void         *i_private;  /* Per inode driver private data */
+#ifdef CONFIG_FS_READAHEAD
+  FAR struct readahead_inode_s *i_ra; /* Read-ahead streams of the files */
+#endif
   char              i_name[1];  /* Name of inode (variable) */
 };
 
@@ -503,6 +507,9 @@ struct file
 #if CONFIG_FS_LOCK_BUCKET_SIZE > 0
   bool              f_locked;   /* Filelock state: false - unlocked, true - locked */
 #endif
+#ifdef CONFIG_FS_READAHEAD
+  FAR struct file_readahead_s *f_ra; /* Read-ahead/write-behind state */
+#endif
 };
 
 struct fd
@@ -529,7 +536,7 @@ struct fd
 
 struct fdlist
 {
-  spinlock_t        fl_lock;    /* Manage access to the file descriptor list */
+  seqcount_t        fl_seq;     /* Serializes updates, lookups are lockless */
   uint8_t           fl_rows;    /* The number of rows of fl_fds array */
   FAR struct fd   **fl_fds;     /* The pointer of two layer file descriptors array */
 
@@ -1675,6 +1682,19 @@ ssize_t file_pwrite(FAR struct file *filep, FAR const void *buf,
 ssize_t file_sendfile(FAR struct file *outfile, FAR struct file *infile,
                       FAR off_t *offset, size_t count);
 
+/****************************************************************************
+ * Name: file_splice
+ *
+ * Description:
+ *   Equivalent to the standard splice function except that is accepts
+ *   struct file instances instead of file descriptors.
+ *
+ ****************************************************************************/
+
+ssize_t file_splice(FAR struct file *infile, FAR off_t *inoff,
+                    FAR struct file *outfile, FAR off_t *outoff,
+                    size_t len, unsigned int flags);
+
 /****************************************************************************
  * Name: file_seek
  *
@@ -1739,6 +1759,19 @@ int file_syncfs(FAR struct file *filep);
 
 int file_truncate(FAR struct file *filep, off_t length);
 
+/****************************************************************************
+ * Name: file_fadvise
+ *
+ * Description:
+ *   Equivalent to the standard posix_fadvise() function except that is
+ *   accepts a struct file instance instead of a file descriptor and
+ *   returns a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int file_fadvise(FAR struct file *filep, off_t offset, off_t len,
+                 int advice);
+
 /****************************************************************************
  * Name: file_mmap
  *
@@ -1987,6 +2020,30 @@ int file_pipe(FAR struct file *filep[2], size_t bufsize, int flags);
 int nx_mkfifo(FAR const char *pathname, mode_t mode, size_t bufsize);
 #endif
 
+/****************************************************************************
+ * Name: pipe_ispipe, pipe_splice_read and pipe_splice_write
+ *
+ * Description:
+ *   Support for splice():  pipe_splice_read() writes the data of the pipe
+ *   'filep' to 'outfile' and pipe_splice_write() reads the data of
+ *   'infile' into the pipe 'filep', both straight from or into the pipe
+ *   buffer without any intermediate copy.  If the offset is not NULL, the
+ *   other file is accessed at that offset, which is then advanced.
+ *
+ * Returned Value:
+ *   The number of bytes moved, zero at end of file, -ENOSYS if 'filep' is
+ *   not a pipe, or a negated errno value on any other failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_PIPES
+bool pipe_ispipe(FAR struct file *filep);
+ssize_t pipe_splice_read(FAR struct file *filep, FAR struct file *outfile,
+                         FAR off_t *outoff, size_t len, bool nonblock);
+ssize_t pipe_splice_write(FAR struct file *filep, FAR struct file *infile,
+                          FAR off_t *inoff, size_t len, bool nonblock);
+#endif
+
 /****************************************************************************
  * Name: map_anonymous
  *
@@ -399,6 +399,27 @@
                                            * IN:  None
                                            * OUT: None (ioctl return value provides
                                            *      success/failure indication). */
+#define BIOC_CACHESTATS _BIOC(0x0012)     /* Get the BCH sector cache statistics
+                                           * IN:  Pointer to writable instance
+                                           *      of struct bchlib_stats_s.
+                                           * OUT: Data return in user-provided
+                                           *      buffer. */
+#define BIOC_GETQUEUE   _BIOC(0x0013)     /* Get the request queue of the block
+                                           * driver (kernel internal).
+                                           * IN:  Pointer to a pointer to
+                                           *      struct blk_queue_s.
+                                           * OUT: The queue of the driver. */
+#define BIOC_CHECKPOINT _BIOC(0x0014)     /* Save the sector map of a SMART
+                                           * volume so that the next mount
+                                           * does not need a full scan.
+                                           * IN:  None
+                                           * OUT: None */
+#define BIOC_FTLSTATS   _BIOC(0x0015)     /* Get the statistics of a
+                                           * log-structured FTL device
+                                           * IN:  Pointer to writable instance
+                                           *      of struct ftl_stats_s.
+                                           * OUT: Data return in user-provided
+                                           *      buffer. */
 
 /* NuttX MTD driver ioctl definitions ***************************************/
 
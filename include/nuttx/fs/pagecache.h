@@ -0,0 +1,214 @@
+/****************************************************************************
+ * include/nuttx/fs/pagecache.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INCLUDE_NUTTX_FS_PAGECACHE_H
+#define __INCLUDE_NUTTX_FS_PAGECACHE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#ifdef CONFIG_FS_PAGECACHE
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Page cache statistics, as reported by /proc/fs/pagecache */
+
+struct pagecache_stats_s
+{
+  uint32_t hits;       /* Sectors found in the cache */
+  uint32_t misses;     /* Sectors read from the media */
+  uint32_t evictions;  /* Pages reclaimed to make room for new ones */
+  uint32_t writebacks; /* Dirty pages written back to the media */
+  uint32_t shrinks;    /* Pages released on memory pressure */
+  uint32_t devices;    /* Block devices attached to the cache */
+  uint32_t pages;      /* Pages currently cached */
+  uint32_t dirty;      /* Pages waiting to be written back */
+  size_t   bytes;      /* Memory used by the cached data */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+struct inode;
+
+/****************************************************************************
+ * Name: pagecache_attach
+ *
+ * Description:
+ *   Start caching the sectors of a block device.  Each call must be paired
+ *   with pagecache_detach; users of the same device share its pages.
+ *
+ * Input Parameters:
+ *   inode - The block driver inode.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int pagecache_attach(FAR struct inode *inode);
+
+/****************************************************************************
+ * Name: pagecache_detach
+ *
+ * Description:
+ *   Drop a reference taken by pagecache_attach.  When the last reference
+ *   is dropped, the dirty pages of the device are written back and all of
+ *   its pages are released.
+ *
+ * Input Parameters:
+ *   inode - The block driver inode.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value if the write back failed.
+ *
+ ****************************************************************************/
+
+int pagecache_detach(FAR struct inode *inode);
+
+/****************************************************************************
+ * Name: pagecache_read
+ *
+ * Description:
+ *   Read sectors of a block device through the page cache.  Devices that
+ *   are not attached are read directly.
+ *
+ * Input Parameters:
+ *   inode    - The block driver inode.
+ *   buffer   - Where to return the data.
+ *   start    - The first sector to read.
+ *   nsectors - The number of sectors to read.
+ *
+ * Returned Value:
+ *   The number of sectors read on success; a negated errno value on
+ *   failure.
+ *
+ ****************************************************************************/
+
+ssize_t pagecache_read(FAR struct inode *inode, FAR unsigned char *buffer,
+                       blkcnt_t start, unsigned int nsectors);
+
+/****************************************************************************
+ * Name: pagecache_write
+ *
+ * Description:
+ *   Write sectors of a block device through the page cache.  Small writes
+ *   are kept in the cache and written back later by the flusher; large
+ *   writes go straight to the media.  Devices that are not attached are
+ *   written directly.
+ *
+ * Input Parameters:
+ *   inode    - The block driver inode.
+ *   buffer   - The data to write.
+ *   start    - The first sector to write.
+ *   nsectors - The number of sectors to write.
+ *
+ * Returned Value:
+ *   The number of sectors written on success; a negated errno value on
+ *   failure.
+ *
+ ****************************************************************************/
+
+ssize_t pagecache_write(FAR struct inode *inode,
+                        FAR const unsigned char *buffer,
+                        blkcnt_t start, unsigned int nsectors);
+
+/****************************************************************************
+ * Name: pagecache_flush
+ *
+ * Description:
+ *   Write back the dirty pages of a block device, or of all devices if
+ *   inode is NULL.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int pagecache_flush(FAR struct inode *inode);
+
+/****************************************************************************
+ * Name: pagecache_invalidate
+ *
+ * Description:
+ *   Write back the dirty pages of a block device and release all of its
+ *   pages, so that the next accesses read the media again.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int pagecache_invalidate(FAR struct inode *inode);
+
+/****************************************************************************
+ * Name: pagecache_shrink
+ *
+ * Description:
+ *   Release clean pages to give memory back to the heap.  This is the
+ *   shrinker of the kernel heap, called when an allocation from it fails.
+ *   It never blocks: it does nothing if the cache is busy.
+ *
+ * Input Parameters:
+ *   bytes - The amount of memory wanted.
+ *
+ * Returned Value:
+ *   The amount of memory released.
+ *
+ ****************************************************************************/
+
+size_t pagecache_shrink(size_t bytes);
+
+/****************************************************************************
+ * Name: pagecache_stats
+ *
+ * Description:
+ *   Return the page cache statistics.
+ *
+ ****************************************************************************/
+
+void pagecache_stats(FAR struct pagecache_stats_s *stats);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_FS_PAGECACHE */
+#endif /* __INCLUDE_NUTTX_FS_PAGECACHE_H */
@@ -208,6 +208,14 @@ struct mempool_init_s
   size_t            dict_expendsize;
 };
 
+/* A shrinker is called when an allocation from its heap fails.  It gives
+ * back up to 'bytes' of cached memory to the heap and returns the number of
+ * bytes it released.  It must not block and is never called from interrupt
+ * context.
+ */
+
+typedef CODE size_t (*mm_shrinker_t)(size_t bytes);
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -295,6 +303,11 @@ void mm_addregion(FAR struct mm_heap_s *heap, FAR void *heapstart,
                   size_t heapsize);
 void mm_uninitialize(FAR struct mm_heap_s *heap);
 
+#ifdef CONFIG_MM_SHRINKER
+void mm_register_shrinker(FAR struct mm_heap_s *heap,
+                          mm_shrinker_t shrinker);
+#endif
+
 /* Functions contained in umm_initialize.c **********************************/
 
 void umm_initialize(FAR void *heap_start, size_t heap_size);
@@ -175,6 +175,24 @@ struct mtd_bad_block_s
   int bad_flag;
 };
 
+/* Statistics of a log-structured FTL device, returned by BIOC_FTLSTATS.
+ * The write amplification is flashwrites / hostwrites.
+ */
+
+struct ftl_stats_s
+{
+  uint32_t hostwrites;    /* Sectors written to the block device */
+  uint32_t flashwrites;   /* Pages programmed, including summaries and
+                           * pages moved by garbage collection */
+  uint32_t relocations;   /* Pages moved by garbage collection */
+  uint32_t erases;        /* Erase blocks erased */
+  uint32_t collections;   /* Erase blocks garbage collected */
+  uint32_t wearmoves;     /* Collections for static wear leveling */
+  uint32_t freeblocks;    /* Erase blocks free or to be erased */
+  uint32_t minerase;      /* Lowest erase count */
+  uint32_t maxerase;      /* Highest erase count */
+};
+
 /* This structure defines the interface to a simple memory technology device.
  * It will likely need to be extended in the future to support more complex
  * devices.
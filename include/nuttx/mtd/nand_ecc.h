@@ -71,6 +71,45 @@ extern "C"
  * Public Function Prototypes
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: nandecc_checkpage
+ *
+ * Description:
+ *   Verifies the data area of a NAND FLASH page using the ECC information
+ *   in its spare area, and corrects a single bit error.
+ *
+ * Input Parameters:
+ *   raw   - Lower-half, raw NAND FLASH interface
+ *   data  - The data area of the page.
+ *   spare - The spare area of the page.
+ *
+ * Returned Value:
+ *   OK if the data is valid, -EUCLEAN if an error was corrected and
+ *   -EBADMSG if the data cannot be corrected.
+ *
+ ****************************************************************************/
+
+int nandecc_checkpage(FAR struct nand_raw_s *raw, FAR void *data,
+                      FAR const void *spare);
+
+/****************************************************************************
+ * Name: nandecc_fillspare
+ *
+ * Description:
+ *   Calculates the ECC for the data area of a NAND FLASH page and stores it
+ *   in the spare area.  If no data is provided, the ECC bytes are set to
+ *   0xff to keep the existing bytes.
+ *
+ * Input Parameters:
+ *   raw   - Lower-half, raw NAND FLASH interface
+ *   data  - The data area of the page, may be NULL.
+ *   spare - The spare area of the page.
+ *
+ ****************************************************************************/
+
+void nandecc_fillspare(FAR struct nand_raw_s *raw, FAR const void *data,
+                       FAR void *spare);
+
 /****************************************************************************
  * Name: nandecc_readpage
  *
@@ -93,6 +93,16 @@ int nand_ram_rawread(FAR struct nand_raw_s *raw, off_t block,
 int nand_ram_rawwrite(FAR struct nand_raw_s *raw, off_t block,
                       unsigned int page, FAR const void *data,
                       FAR const void *spare);
+#ifdef CONFIG_MTD_NAND_PIPELINE
+int nand_ram_rawreadpages(FAR struct nand_raw_s *raw, off_t block,
+                          unsigned int page, unsigned int npages,
+                          FAR void *data, FAR void *spare,
+                          nand_pagecb_t done, FAR void *arg);
+int nand_ram_rawwritepages(FAR struct nand_raw_s *raw, off_t block,
+                           unsigned int page, unsigned int npages,
+                           FAR const void *data, FAR void *spare,
+                           nand_pagecb_t prepare, FAR void *arg);
+#endif
 FAR struct mtd_dev_s *nand_ram_initialize(struct nand_raw_s *raw);
 
 #undef EXTERN
@@ -226,10 +226,75 @@
 #  define NAND_WRITEPAGE(r,b,p,d,s) ((r)->rawwrite(r,b,p,d,s))
 #endif
 
+/****************************************************************************
+ * Name: NAND_RAWREADPAGES
+ *
+ * Description:
+ *   Reads the data and/or the spare areas of consecutive pages of one block
+ *   of a NAND FLASH chip.  The data of page i is stored at
+ *   data + i * pagesize; the spare area of each page is stored in the same
+ *   'spare' buffer.  After the transfer of each page, 'done' is called with
+ *   the data and spare of that page.  The lower half should start loading
+ *   the next page (cache read) before it calls 'done', so that the check of
+ *   one page overlaps with the read of the next one.
+ *
+ * Input Parameters:
+ *   raw    - Lower-half, raw NAND FLASH interface
+ *   block  - Number of the block where the pages to read reside.
+ *   page   - Number of the first page to read inside the given block.
+ *   npages - Number of pages to read.
+ *   data   - Buffer where the data areas will be stored.
+ *   spare  - Buffer where the spare area of each page will be stored.
+ *   done   - Called after each page, may be NULL.  A negated errno value
+ *            returned by 'done' ends the transfer with that error.
+ *   arg    - Argument of 'done'.
+ *
+ * Returned Value:
+ *   OK is returned in success; a negated errno value is returned on failure.
+ *
+ ****************************************************************************/
+
+#define NAND_RAWREADPAGES(r,b,p,n,d,s,c,a) \
+  ((r)->rawreadpages(r,b,p,n,d,s,c,a))
+
+/****************************************************************************
+ * Name: NAND_RAWWRITEPAGES
+ *
+ * Description:
+ *   Writes the data and/or the spare areas of consecutive pages of one
+ *   block of a NAND FLASH chip.  Before the transfer of each page,
+ *   'prepare' is called to fill in the 'spare' buffer for the data of that
+ *   page.  The lower half should not wait for the program operation of a
+ *   page to complete (cache program) before it calls 'prepare' for the next
+ *   one.
+ *
+ * Input Parameters:
+ *   raw     - Lower-half, raw NAND FLASH interface
+ *   block   - Number of the block where the pages to write reside.
+ *   page    - Number of the first page to write inside the given block.
+ *   npages  - Number of pages to write.
+ *   data    - Buffer containing the data to be written.
+ *   spare   - Buffer for the spare area of each page, may be NULL.
+ *   prepare - Called before each page, may be NULL.
+ *   arg     - Argument of 'prepare'.
+ *
+ * Returned Value:
+ *   OK is returned in success; a negated errno value is returned on failure.
+ *
+ ****************************************************************************/
+
+#define NAND_RAWWRITEPAGES(r,b,p,n,d,s,c,a) \
+  ((r)->rawwritepages(r,b,p,n,d,s,c,a))
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
 
+/* Called for each page by the multi-page transfer methods */
+
+typedef CODE int (*nand_pagecb_t)(FAR void *arg, FAR void *data,
+                                  FAR void *spare);
+
 /* This type represents the visible portion of the lower-half, raw NAND MTD
  * device.  The lower-half driver may freely append additional information
  * after this required header information.
@@ -254,6 +319,19 @@ struct nand_raw_s
                        unsigned int page, FAR const void *data,
                        FAR const void *spare);
 
+#ifdef CONFIG_MTD_NAND_PIPELINE
+  /* Optional multi-page transfers, NULL if not supported */
+
+  CODE int (*rawreadpages)(FAR struct nand_raw_s *raw, off_t block,
+                           unsigned int page, unsigned int npages,
+                           FAR void *data, FAR void *spare,
+                           nand_pagecb_t done, FAR void *arg);
+  CODE int (*rawwritepages)(FAR struct nand_raw_s *raw, off_t block,
+                            unsigned int page, unsigned int npages,
+                            FAR const void *data, FAR void *spare,
+                            nand_pagecb_t prepare, FAR void *arg);
+#endif
+
 #ifdef CONFIG_MTD_NAND_HWECC
   CODE int (*readpage)(FAR struct nand_raw_s *raw, off_t block,
                        unsigned int page, FAR void *data, FAR void *spare);
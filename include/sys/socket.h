@@ -139,6 +139,7 @@
 #define MSG_CMSG_CLOEXEC 0x100000 /* Set close_on_exit for file
                                    * descriptor received through SCM_RIGHTS.
                                    */
+#define MSG_FASTOPEN     0x200000 /* Send data in the TCP SYN.  */
 
 /* Protocol levels supported by get/setsockopt(): */
 
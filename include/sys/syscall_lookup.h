@@ -220,6 +220,7 @@ SYSCALL_LOOKUP(readv,                      3)
 SYSCALL_LOOKUP(writev,                     3)
 SYSCALL_LOOKUP(pread,                      4)
 SYSCALL_LOOKUP(pwrite,                     4)
+SYSCALL_LOOKUP(posix_fadvise,              4)
 #ifdef CONFIG_FS_AIO
   SYSCALL_LOOKUP(aio_read,                 1)
   SYSCALL_LOOKUP(aio_write,                1)
@@ -269,6 +270,8 @@ SYSCALL_LOOKUP(fstat,                      2)
 SYSCALL_LOOKUP(statfs,                     2)
 SYSCALL_LOOKUP(fstatfs,                    2)
 SYSCALL_LOOKUP(sendfile,                   4)
+SYSCALL_LOOKUP(splice,                     6)
+SYSCALL_LOOKUP(vmsplice,                   4)
 SYSCALL_LOOKUP(sync,                       0)
 SYSCALL_LOOKUP(fsync,                      1)
 SYSCALL_LOOKUP(chmod,                      2)
@@ -0,0 +1,764 @@
+/****************************************************************************
+ * libs/libc/misc/lib_circbuf_lf.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <nuttx/circbuf.h>
+#include <nuttx/irq.h>
+#include <nuttx/lib/lib.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The indexes are kept in atomic_t, which is signed */
+
+#define circbuf_lf_load(v)         ((size_t)(uint32_t)atomic_read(v))
+#define circbuf_lf_load_acquire(v) ((size_t)(uint32_t)atomic_read_acquire(v))
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: circbuf_lf_add
+ *
+ * Description:
+ *   Advance an index by n bytes.  Indexes wrap at twice the buffer size.
+ *
+ ****************************************************************************/
+
+static inline size_t circbuf_lf_add(FAR struct circbuf_lf_s *circ,
+                                    size_t index, size_t n)
+{
+  index += n;
+  if (index >= 2 * circ->size)
+    {
+      index -= 2 * circ->size;
+    }
+
+  return index;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_dist
+ *
+ * Description:
+ *   Return the number of bytes from index 'from' up to index 'to'.
+ *
+ ****************************************************************************/
+
+static inline size_t circbuf_lf_dist(FAR struct circbuf_lf_s *circ,
+                                     size_t to, size_t from)
+{
+  return to >= from ? to - from : to + 2 * circ->size - from;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_offset
+ *
+ * Description:
+ *   Return the offset in the buffer space of an index.
+ *
+ ****************************************************************************/
+
+static inline size_t circbuf_lf_offset(FAR struct circbuf_lf_s *circ,
+                                       size_t index)
+{
+  return index >= circ->size ? index - circ->size : index;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_avail
+ *
+ * Description:
+ *   Return the number of bytes the consumer can read at index 'tail'.
+ *
+ ****************************************************************************/
+
+static size_t circbuf_lf_avail(FAR struct circbuf_lf_s *circ, size_t tail)
+{
+  size_t used = circbuf_lf_dist(circ,
+                                circbuf_lf_load_acquire(&circ->commit),
+                                tail);
+
+  /* A snapshot taken outside of the consumer may mix an old head with a
+   * newer tail.
+   */
+
+  return used > circ->size ? 0 : used;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_copyin
+ *
+ * Description:
+ *   Copy data into the buffer space at an index.
+ *
+ ****************************************************************************/
+
+static void circbuf_lf_copyin(FAR struct circbuf_lf_s *circ, size_t index,
+                              FAR const void *src, size_t bytes)
+{
+  size_t off = circbuf_lf_offset(circ, index);
+  size_t len = MIN(bytes, circ->size - off);
+
+  memcpy((FAR char *)circ->base + off, src, len);
+  memcpy(circ->base, (FAR const char *)src + len, bytes - len);
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_copyout
+ *
+ * Description:
+ *   Copy data out of the buffer space at an index.
+ *
+ ****************************************************************************/
+
+static void circbuf_lf_copyout(FAR struct circbuf_lf_s *circ, size_t index,
+                               FAR void *dst, size_t bytes)
+{
+  size_t off = circbuf_lf_offset(circ, index);
+  size_t len = MIN(bytes, circ->size - off);
+
+  memcpy(dst, (FAR const char *)circ->base + off, len);
+  memcpy((FAR char *)dst + len, circ->base, bytes - len);
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_publish
+ *
+ * Description:
+ *   Publish data written by the only producer.
+ *
+ ****************************************************************************/
+
+static void circbuf_lf_publish(FAR struct circbuf_lf_s *circ, size_t head)
+{
+  atomic_set(&circ->reserve, head);
+  atomic_set_release(&circ->commit, head);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: circbuf_lf_init
+ *
+ * Description:
+ *   Initialize a lock-free circular buffer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   base  - A pointer to circular buffer's internal buffer, or NULL to
+ *           allocate a buffer of the given size.
+ *   bytes - The size of the internal buffer.
+ *
+ * Returned Value:
+ *   Zero on success; A negated errno value is returned on any failure.
+ *
+ ****************************************************************************/
+
+int circbuf_lf_init(FAR struct circbuf_lf_s *circ,
+                    FAR void *base, size_t bytes)
+{
+  DEBUGASSERT(circ);
+  DEBUGASSERT(!base || bytes);
+
+  /* Indexes run up to twice the size and must fit into an atomic_t */
+
+  if (bytes > INT32_MAX / 2)
+    {
+      return -EINVAL;
+    }
+
+  circ->external = !!base;
+
+  if (!base && bytes)
+    {
+      base = lib_malloc(bytes);
+      if (!base)
+        {
+          return -ENOMEM;
+        }
+    }
+
+  circ->base = base;
+  circ->size = bytes;
+  circbuf_lf_reset(circ);
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_resize
+ *
+ * Description:
+ *   Resize a lock-free circular buffer, keeping as much of the buffered
+ *   data as fits.  The caller must make sure that no producer or consumer
+ *   is using the buffer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   bytes - The new size of the internal buffer.
+ *
+ * Returned Value:
+ *   Zero on success; A negated errno value is returned on any failure.
+ *
+ ****************************************************************************/
+
+int circbuf_lf_resize(FAR struct circbuf_lf_s *circ, size_t bytes)
+{
+  FAR void *tmp = NULL;
+  size_t len = 0;
+
+  DEBUGASSERT(circ);
+  DEBUGASSERT(!circ->external);
+
+  if (bytes == circ->size)
+    {
+      return 0;
+    }
+
+  if (bytes > INT32_MAX / 2)
+    {
+      return -EINVAL;
+    }
+
+  if (bytes)
+    {
+      tmp = lib_malloc(bytes);
+      if (!tmp)
+        {
+          return -ENOMEM;
+        }
+
+      len = circbuf_lf_used(circ);
+      if (bytes < len)
+        {
+          circbuf_lf_skip(circ, len - bytes);
+          len = bytes;
+        }
+
+      circbuf_lf_read(circ, tmp, len);
+    }
+
+  lib_free(circ->base);
+
+  circ->base = tmp;
+  circ->size = bytes;
+  circbuf_lf_reset(circ);
+  circbuf_lf_publish(circ, len);
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_uninit
+ *
+ * Description:
+ *   Free the lock-free circular buffer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+void circbuf_lf_uninit(FAR struct circbuf_lf_s *circ)
+{
+  DEBUGASSERT(circ);
+
+  if (!circ->external)
+    {
+      lib_free(circ->base);
+    }
+
+  memset(circ, 0, sizeof(*circ));
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_reset
+ *
+ * Description:
+ *   Remove the entire circular buffer content.  The caller must make sure
+ *   that no producer or consumer is using the buffer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+void circbuf_lf_reset(FAR struct circbuf_lf_s *circ)
+{
+  DEBUGASSERT(circ);
+
+  atomic_set(&circ->reserve, 0);
+  atomic_set(&circ->commit, 0);
+  atomic_set(&circ->tail, 0);
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_is_init
+ *
+ * Description:
+ *   Return true if the circular buffer had been initialized.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+bool circbuf_lf_is_init(FAR struct circbuf_lf_s *circ)
+{
+  return !!circ->base;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_size
+ *
+ * Description:
+ *   Return size of the circular buffer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+size_t circbuf_lf_size(FAR struct circbuf_lf_s *circ)
+{
+  DEBUGASSERT(circ);
+  return circ->size;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_used
+ *
+ * Description:
+ *   Return the bytes that are ready to be read from the circular buffer.
+ *   May be called from any context; the value is only a snapshot unless
+ *   called by the consumer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+size_t circbuf_lf_used(FAR struct circbuf_lf_s *circ)
+{
+  DEBUGASSERT(circ);
+  return circbuf_lf_avail(circ, circbuf_lf_load_acquire(&circ->tail));
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_space
+ *
+ * Description:
+ *   Return the remaining space of the circular buffer.  May be called from
+ *   any context; the value is only a snapshot unless called by the only
+ *   producer.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+size_t circbuf_lf_space(FAR struct circbuf_lf_s *circ)
+{
+  size_t tail;
+  size_t used;
+
+  DEBUGASSERT(circ);
+
+  tail = circbuf_lf_load_acquire(&circ->tail);
+  used = circbuf_lf_dist(circ, circbuf_lf_load(&circ->reserve), tail);
+  return used > circ->size ? 0 : circ->size - used;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_is_empty
+ *
+ * Description:
+ *   Return true if there is no data ready to be read.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+bool circbuf_lf_is_empty(FAR struct circbuf_lf_s *circ)
+{
+  return !circbuf_lf_used(circ);
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_is_full
+ *
+ * Description:
+ *   Return true if there is no space left to write.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ ****************************************************************************/
+
+bool circbuf_lf_is_full(FAR struct circbuf_lf_s *circ)
+{
+  return !circbuf_lf_space(circ);
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_peekat
+ *
+ * Description:
+ *   Get data at an offset from the tail of the circular buffer without
+ *   removing it.  Consumer side only.
+ *
+ * Input Parameters:
+ *   circ   - Address of the circular buffer to be used.
+ *   offset - Offset from the oldest byte in the buffer.
+ *   dst    - Address where to store the data.
+ *   bytes  - Number of bytes to get.
+ *
+ * Returned Value:
+ *   The number of bytes copied, which may be less than requested.
+ *
+ ****************************************************************************/
+
+ssize_t circbuf_lf_peekat(FAR struct circbuf_lf_s *circ, size_t offset,
+                          FAR void *dst, size_t bytes)
+{
+  size_t tail;
+  size_t avail;
+
+  DEBUGASSERT(circ);
+
+  if (!circ->size)
+    {
+      return 0;
+    }
+
+  tail  = circbuf_lf_load(&circ->tail);
+  avail = circbuf_lf_avail(circ, tail);
+  if (offset >= avail)
+    {
+      return 0;
+    }
+
+  bytes = MIN(bytes, avail - offset);
+  circbuf_lf_copyout(circ, circbuf_lf_add(circ, tail, offset), dst, bytes);
+  return bytes;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_read
+ *
+ * Description:
+ *   Get up to 'bytes' bytes from the circular buffer.  Consumer side only.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   dst   - Address where to store the data.
+ *   bytes - Number of bytes to get.
+ *
+ * Returned Value:
+ *   The number of bytes read, which may be less than requested.
+ *
+ ****************************************************************************/
+
+ssize_t circbuf_lf_read(FAR struct circbuf_lf_s *circ,
+                        FAR void *dst, size_t bytes)
+{
+  size_t tail;
+
+  DEBUGASSERT(circ);
+  DEBUGASSERT(dst || !bytes);
+
+  if (!circ->size)
+    {
+      return 0;
+    }
+
+  tail  = circbuf_lf_load(&circ->tail);
+  bytes = MIN(bytes, circbuf_lf_avail(circ, tail));
+
+  /* Release the space only after the data has been copied out */
+
+  circbuf_lf_copyout(circ, tail, dst, bytes);
+  atomic_set_release(&circ->tail, circbuf_lf_add(circ, tail, bytes));
+  return bytes;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_skip
+ *
+ * Description:
+ *   Skip up to 'bytes' bytes from the circular buffer.  Consumer side only.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   bytes - Number of bytes to skip.
+ *
+ * Returned Value:
+ *   The number of bytes skipped, which may be less than requested.
+ *
+ ****************************************************************************/
+
+ssize_t circbuf_lf_skip(FAR struct circbuf_lf_s *circ, size_t bytes)
+{
+  size_t tail;
+
+  DEBUGASSERT(circ);
+
+  if (!circ->size)
+    {
+      return 0;
+    }
+
+  tail  = circbuf_lf_load(&circ->tail);
+  bytes = MIN(bytes, circbuf_lf_avail(circ, tail));
+  atomic_set_release(&circ->tail, circbuf_lf_add(circ, tail, bytes));
+  return bytes;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_write
+ *
+ * Description:
+ *   Write up to 'bytes' bytes to the circular buffer.  Only one producer
+ *   may call this function at a time.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   src   - The data to be added.
+ *   bytes - Number of bytes to be added.
+ *
+ * Returned Value:
+ *   The number of bytes written, which may be less than requested.
+ *
+ ****************************************************************************/
+
+ssize_t circbuf_lf_write(FAR struct circbuf_lf_s *circ,
+                         FAR const void *src, size_t bytes)
+{
+  size_t head;
+
+  DEBUGASSERT(circ);
+  DEBUGASSERT(src || !bytes);
+
+  head  = circbuf_lf_load(&circ->reserve);
+  bytes = MIN(bytes, circbuf_lf_space(circ));
+
+  circbuf_lf_copyin(circ, head, src, bytes);
+  circbuf_lf_publish(circ, circbuf_lf_add(circ, head, bytes));
+  return bytes;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_write_mp
+ *
+ * Description:
+ *   Write a record to the circular buffer.  Any number of producers may
+ *   call this function concurrently, including from interrupt handlers.
+ *   The record is written as a whole or not at all.  The record is copied
+ *   and published with local interrupts disabled, after the producers that
+ *   reserved space before it have published theirs.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   src   - The data to be added.
+ *   bytes - Number of bytes to be added.
+ *
+ * Returned Value:
+ *   'bytes' if the record is written; -EAGAIN if there is not enough space
+ *   left; -EINVAL if the record is larger than the buffer.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_BUILD_FLAT) || defined(__KERNEL__)
+ssize_t circbuf_lf_write_mp(FAR struct circbuf_lf_s *circ,
+                            FAR const void *src, size_t bytes)
+{
+  irqstate_t flags;
+  int32_t start;
+  size_t used;
+
+  DEBUGASSERT(circ);
+  DEBUGASSERT(src || !bytes);
+
+  if (bytes > circ->size)
+    {
+      return -EINVAL;
+    }
+
+  /* A producer that reserved space must not be preempted on its CPU
+   * before it publishes the data: a later producer would wait for it
+   * forever.
+   */
+
+  flags = up_irq_save();
+
+  /* Reserve the space */
+
+  start = atomic_read(&circ->reserve);
+  do
+    {
+      used = circbuf_lf_dist(circ, (uint32_t)start,
+                             circbuf_lf_load_acquire(&circ->tail));
+      if (used + bytes > circ->size)
+        {
+          up_irq_restore(flags);
+          return -EAGAIN;
+        }
+    }
+  while (!atomic_try_cmpxchg(&circ->reserve, &start,
+                             circbuf_lf_add(circ, (uint32_t)start, bytes)));
+
+  circbuf_lf_copyin(circ, (uint32_t)start, src, bytes);
+
+  /* Publish in the order of the reservations.  The producers ahead of us
+   * run with interrupts disabled on other CPUs, so the wait is short.
+   */
+
+  while (atomic_read_acquire(&circ->commit) != start)
+    {
+    }
+
+  atomic_set_release(&circ->commit,
+                     circbuf_lf_add(circ, (uint32_t)start, bytes));
+  up_irq_restore(flags);
+
+  return bytes;
+}
+#endif
+
+/****************************************************************************
+ * Name: circbuf_lf_get_writeptr
+ *
+ * Description:
+ *   Get the write pointer of the circular buffer for zero-copy writing.
+ *   Only one producer may call this function at a time, and the space must
+ *   be published with circbuf_lf_writecommit.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   size  - Returns the maximum size that can be written consecutively.
+ *
+ * Returned Value:
+ *   The write pointer of the circular buffer.
+ *
+ ****************************************************************************/
+
+FAR void *circbuf_lf_get_writeptr(FAR struct circbuf_lf_s *circ,
+                                  FAR size_t *size)
+{
+  size_t off;
+
+  DEBUGASSERT(circ);
+  DEBUGASSERT(size);
+
+  off   = circbuf_lf_offset(circ, circbuf_lf_load(&circ->reserve));
+  *size = MIN(circbuf_lf_space(circ), circ->size - off);
+  return (FAR char *)circ->base + off;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_writecommit
+ *
+ * Description:
+ *   Publish the data written through circbuf_lf_get_writeptr.
+ *
+ * Input Parameters:
+ *   circ        - Address of the circular buffer to be used.
+ *   writtensize - The data that has been written to the buffer.
+ *
+ ****************************************************************************/
+
+void circbuf_lf_writecommit(FAR struct circbuf_lf_s *circ,
+                            size_t writtensize)
+{
+  DEBUGASSERT(circ);
+  DEBUGASSERT(writtensize <= circbuf_lf_space(circ));
+
+  circbuf_lf_publish(circ, circbuf_lf_add(circ,
+                                          circbuf_lf_load(&circ->reserve),
+                                          writtensize));
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_get_readptr
+ *
+ * Description:
+ *   Get the read pointer of the circular buffer for zero-copy reading.
+ *   Consumer side only; the data must be released with
+ *   circbuf_lf_readcommit.
+ *
+ * Input Parameters:
+ *   circ  - Address of the circular buffer to be used.
+ *   size  - Returns the maximum size that can be read consecutively.
+ *
+ * Returned Value:
+ *   The read pointer of the circular buffer.
+ *
+ ****************************************************************************/
+
+FAR void *circbuf_lf_get_readptr(FAR struct circbuf_lf_s *circ,
+                                 FAR size_t *size)
+{
+  size_t tail;
+  size_t off;
+
+  DEBUGASSERT(circ);
+  DEBUGASSERT(size);
+
+  tail  = circbuf_lf_load(&circ->tail);
+  off   = circbuf_lf_offset(circ, tail);
+  *size = MIN(circbuf_lf_avail(circ, tail), circ->size - off);
+  return (FAR char *)circ->base + off;
+}
+
+/****************************************************************************
+ * Name: circbuf_lf_readcommit
+ *
+ * Description:
+ *   Release the data read through circbuf_lf_get_readptr.
+ *
+ * Input Parameters:
+ *   circ     - Address of the circular buffer to be used.
+ *   readsize - The data that has been read from the buffer.
+ *
+ ****************************************************************************/
+
+void circbuf_lf_readcommit(FAR struct circbuf_lf_s *circ, size_t readsize)
+{
+  size_t tail;
+
+  DEBUGASSERT(circ);
+
+  tail = circbuf_lf_load(&circ->tail);
+  DEBUGASSERT(readsize <= circbuf_lf_avail(circ, tail));
+
+  atomic_set_release(&circ->tail, circbuf_lf_add(circ, tail, readsize));
+}
@@ -271,6 +271,12 @@ struct mm_heap_s
   struct procfs_meminfo_entry_s mm_procfs;
 #endif
 
+  /* Releases cached memory when an allocation fails */
+
+#ifdef CONFIG_MM_SHRINKER
+  mm_shrinker_t mm_shrinker;
+#endif
+
   /* Kasan is disable or enable for this heap */
 
   bool mm_nokasan;
@@ -408,3 +408,28 @@ void mm_uninitialize(FAR struct mm_heap_s *heap)
 #endif
   nxmutex_destroy(&heap->mm_lock);
 }
+
+/****************************************************************************
+ * Name: mm_register_shrinker
+ *
+ * Description:
+ *   Register the shrinker of a heap.  It is called when an allocation from
+ *   the heap fails, and the allocation is retried for as long as it
+ *   releases memory.
+ *
+ * Input Parameters:
+ *   heap     - The heap that holds the cached memory
+ *   shrinker - The function that releases it, or NULL
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MM_SHRINKER
+void mm_register_shrinker(FAR struct mm_heap_s *heap,
+                          mm_shrinker_t shrinker)
+{
+  heap->mm_shrinker = shrinker;
+}
+#endif
@@ -210,6 +210,10 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 
   DEBUGASSERT(alignsize >= MM_ALIGN);
 
+#ifdef CONFIG_MM_SHRINKER
+retry:
+#endif
+
   /* We need to hold the MM mutex while we muck with the nodelist. */
 
   DEBUGVERIFY(mm_lock(heap));
@@ -351,6 +355,18 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
     }
 #endif
 
+#ifdef CONFIG_MM_SHRINKER
+  /* Try again after the shrinker released cached memory, for as long as it
+   * finds something to release.
+   */
+
+  else if (heap->mm_shrinker != NULL && !up_interrupt_context() &&
+           heap->mm_shrinker(alignsize) > 0)
+    {
+      goto retry;
+    }
+#endif
+
 #ifdef CONFIG_DEBUG_MM
   else if (MM_INTERNAL_HEAP(heap))
     {
@@ -113,6 +113,12 @@ struct mm_heap_s
   struct procfs_meminfo_entry_s mm_procfs;
 #endif
 
+  /* Releases cached memory when an allocation fails */
+
+#ifdef CONFIG_MM_SHRINKER
+  mm_shrinker_t mm_shrinker;
+#endif
+
   /* Kasan is disable or enable for this heap */
 
   bool mm_nokasan;
@@ -1400,6 +1406,10 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 
   free_delaylist(heap, false);
 
+#ifdef CONFIG_MM_SHRINKER
+retry:
+#endif
+
   /* Allocate from the tlsf pool */
 
   DEBUGVERIFY(mm_lock(heap));
@@ -1449,6 +1459,18 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
     }
 #endif
 
+#ifdef CONFIG_MM_SHRINKER
+  /* Try again after the shrinker released cached memory, for as long as it
+   * finds something to release.
+   */
+
+  else if (heap->mm_shrinker != NULL && !up_interrupt_context() &&
+           heap->mm_shrinker(size) > 0)
+    {
+      goto retry;
+    }
+#endif
+
   return ret;
 }
 
@@ -1715,6 +1737,31 @@ void mm_uninitialize(FAR struct mm_heap_s *heap)
   tlsf_destroy(&heap->mm_tlsf);
 }
 
+/****************************************************************************
+ * Name: mm_register_shrinker
+ *
+ * Description:
+ *   Register the shrinker of a heap.  It is called when an allocation from
+ *   the heap fails, and the allocation is retried for as long as it
+ *   releases memory.
+ *
+ * Input Parameters:
+ *   heap     - The heap that holds the cached memory
+ *   shrinker - The function that releases it, or NULL
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MM_SHRINKER
+void mm_register_shrinker(FAR struct mm_heap_s *heap,
+                          mm_shrinker_t shrinker)
+{
+  heap->mm_shrinker = shrinker;
+}
+#endif
+
 /****************************************************************************
  * Name: mm_zalloc
  *
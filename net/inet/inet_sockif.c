@@ -1810,6 +1810,15 @@ static ssize_t inet_sendto(FAR struct socket *psock, FAR const void *buf,
       return -EBADF;
     }
 
+#ifdef CONFIG_NET_TCP_FASTOPEN
+  /* MSG_FASTOPEN connects a stream socket, sending the data in the SYN */
+
+  if (psock->s_type == SOCK_STREAM && (flags & MSG_FASTOPEN) != 0)
+    {
+      return psock_tcp_fastopen(psock, buf, len, flags, to, tolen);
+    }
+#endif
+
 #ifdef CONFIG_NET_UDP
   if (psock->s_type != SOCK_DGRAM)
     {
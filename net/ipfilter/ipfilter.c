@@ -218,6 +218,7 @@ static int ipv4_filter_match(FAR const struct net_driver_s *indev,
   FAR const sq_entry_t *entry;
   FAR const void *l4hdr;
   in_addr_t ipaddr;
+  bool forward;
   bool matched;
 
   /* Handle unexpected status, return ACCEPT to indicate doing nothing. */
@@ -227,6 +228,14 @@ static int ipv4_filter_match(FAR const struct net_driver_s *indev,
       return IPFILTER_TARGET_ACCEPT;
     }
 
+  /* Packets of an already accepted flow bypass the rules. */
+
+  forward = chain == IPFILTER_CHAIN_FORWARD;
+  if (ipfilter_conntrack_lookup(PF_INET, ipv4, indev, outdev, forward))
+    {
+      return IPFILTER_TARGET_ACCEPT;
+    }
+
   l4hdr = IPv4_L4HDR(ipv4);
 
   sq_for_every(queue, entry)
@@ -265,7 +274,15 @@ static int ipv4_filter_match(FAR const struct net_driver_s *indev,
           continue;
         }
 
-      /* Return the target action if matched. */
+      /* Return the target action if matched, and track the flow if it is
+       * accepted.
+       */
+
+      if (filter->common.target == IPFILTER_TARGET_ACCEPT)
+        {
+          ipfilter_conntrack_add(PF_INET, ipv4, indev, outdev,
+                                 forward);
+        }
 
       return filter->common.target;
     }
@@ -288,6 +305,7 @@ static int ipv6_filter_match(FAR const struct net_driver_s *indev,
   FAR const sq_entry_t *entry;
   FAR const void *l4hdr;
   uint8_t proto;
+  bool forward;
   bool matched;
 
   /* Handle unexpected status, return ACCEPT to indicate doing nothing. */
@@ -297,6 +315,14 @@ static int ipv6_filter_match(FAR const struct net_driver_s *indev,
       return IPFILTER_TARGET_ACCEPT;
     }
 
+  /* Packets of an already accepted flow bypass the rules. */
+
+  forward = chain == IPFILTER_CHAIN_FORWARD;
+  if (ipfilter_conntrack_lookup(PF_INET6, ipv6, indev, outdev, forward))
+    {
+      return IPFILTER_TARGET_ACCEPT;
+    }
+
   l4hdr = IPv6_L4HDR(ipv6, proto);
 
   sq_for_every(queue, entry)
@@ -335,7 +361,15 @@ static int ipv6_filter_match(FAR const struct net_driver_s *indev,
           continue;
         }
 
-      /* Return the target action if matched. */
+      /* Return the target action if matched, and track the flow if it is
+       * accepted.
+       */
+
+      if (filter->common.target == IPFILTER_TARGET_ACCEPT)
+        {
+          ipfilter_conntrack_add(PF_INET6, ipv6, indev, outdev,
+                                 forward);
+        }
 
       return filter->common.target;
     }
@@ -427,7 +461,8 @@ void ipfilter_cfg_add(FAR struct ipfilter_entry_s *entry,
  *
  * Description:
  *   Clear all filter configuration entries for the given address family from
- *   the specified chain.
+ *   the specified chain.  The tracked connections of the family are flushed
+ *   as well, since they were accepted by the old rules.
  *
  * Input Parameters:
  *   family - The address family of the filter entry to clear
@@ -448,6 +483,8 @@ void ipfilter_cfg_clear(sa_family_t family, enum ipfilter_chain_e chain)
         {
           kmm_free(sq_remfirst(queue));
         }
+
+      ipfilter_conntrack_flush(PF_INET);
     }
 #endif
 
@@ -459,6 +496,8 @@ void ipfilter_cfg_clear(sa_family_t family, enum ipfilter_chain_e chain)
         {
           kmm_free(sq_remfirst(queue));
         }
+
+      ipfilter_conntrack_flush(PF_INET6);
     }
 #endif
 }
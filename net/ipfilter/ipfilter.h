@@ -32,6 +32,7 @@
 #include <stdint.h>
 
 #include <nuttx/compiler.h>
+#include <nuttx/hashtable.h>
 #include <nuttx/net/ip.h>
 
 #ifdef CONFIG_NET_IPFILTER
@@ -44,6 +45,12 @@
 #define IPFILTER_TARGET_DROP   (-1)
 #define IPFILTER_TARGET_REJECT (-2)
 
+/* Directions of a tracked connection */
+
+#define IPFILTER_CT_DIR_ORIGINAL 0 /* Same direction as the first packet */
+#define IPFILTER_CT_DIR_REPLY    1 /* Reverse direction */
+#define IPFILTER_CT_DIR_MAX      2
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -123,6 +130,55 @@ struct ipv6_filter_entry_s
   net_ipv6addr_t dmsk;
 };
 
+#ifdef CONFIG_NET_IPFILTER_CONNTRACK
+
+/* The TCP states of a tracked connection */
+
+enum ipfilter_ct_tcpstate_e
+{
+  IPFILTER_CT_TCP_NONE = 0,    /* Not a TCP connection */
+  IPFILTER_CT_TCP_SYN_SENT,    /* SYN seen in original direction */
+  IPFILTER_CT_TCP_SYN_RECV,    /* SYN+ACK seen in reply direction */
+  IPFILTER_CT_TCP_ESTABLISHED, /* Three-way handshake completed */
+  IPFILTER_CT_TCP_FIN_WAIT,    /* FIN seen in one direction */
+  IPFILTER_CT_TCP_TIME_WAIT,   /* FIN seen in both directions */
+  IPFILTER_CT_TCP_CLOSE        /* RST seen */
+};
+
+/* The connection tracking entry, addresses and ports are in network order
+ * and describe the first packet (original direction) of the flow.
+ */
+
+struct ipfilter_ct_entry_s
+{
+  hash_node_t     node;
+
+  /* The input and output devices of the original direction, only compared
+   * and never dereferenced.
+   */
+
+  FAR const struct net_driver_s *dev[2];
+  union ip_addr_u src;
+  union ip_addr_u dst;
+  uint16_t        sport;       /* Source port, or id for ICMP echo */
+  uint16_t        dport;       /* Destination port, or id for ICMP echo */
+  uint8_t         family;      /* PF_INET or PF_INET6 */
+  uint8_t         proto;       /* L4 protocol */
+  uint8_t         tcpstate;    /* See enum ipfilter_ct_tcpstate_e */
+  uint8_t         finseen;     /* Directions in which FIN is seen */
+  bool            forward;     /* Accepted by the forward chain */
+  bool            replied;     /* Packet seen in reply direction */
+
+  uint32_t        key;         /* Hash key of the entry */
+  int32_t         expire_time; /* The expiration time in seconds */
+  uint32_t        packets[IPFILTER_CT_DIR_MAX];
+};
+
+typedef CODE int (*ipfilter_ct_cb_t)(FAR struct ipfilter_ct_entry_s *ct,
+                                     int32_t timeout, FAR void *arg);
+
+#endif /* CONFIG_NET_IPFILTER_CONNTRACK */
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -264,5 +320,106 @@ int ipv6_filter_fwd(FAR struct net_driver_s *indev,
                     FAR struct ipv6_hdr_s *ipv6);
 #endif
 
+/****************************************************************************
+ * Name: ipfilter_conntrack_lookup
+ *
+ * Description:
+ *   Look up the connection tracking table for the packet.  If the packet
+ *   belongs to a tracked flow, the state and the timeout of the flow are
+ *   updated.
+ *
+ * Input Parameters:
+ *   family  - The address family of the packet
+ *   iphdr   - The IPv4/IPv6 header of the packet
+ *   indev   - The device the packet is received from, or NULL
+ *   outdev  - The device the packet is sent to, or NULL
+ *   forward - Whether the packet is being forwarded
+ *
+ * Returned Value:
+ *   true if the packet belongs to a tracked flow and should be accepted
+ *   without walking the rules, false otherwise.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPFILTER_CONNTRACK
+bool ipfilter_conntrack_lookup(uint8_t family, FAR const void *iphdr,
+                               FAR const struct net_driver_s *indev,
+                               FAR const struct net_driver_s *outdev,
+                               bool forward);
+
+/****************************************************************************
+ * Name: ipfilter_conntrack_add
+ *
+ * Description:
+ *   Start tracking the flow of a packet which has just been accepted by
+ *   the rules.  Packets which can not start a flow (e.g. a TCP segment
+ *   without SYN) are ignored and will be checked against the rules again.
+ *
+ * Input Parameters:
+ *   family  - The address family of the packet
+ *   iphdr   - The IPv4/IPv6 header of the packet
+ *   indev   - The device the packet is received from, or NULL
+ *   outdev  - The device the packet is sent to, or NULL
+ *   forward - Whether the packet is being forwarded
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+void ipfilter_conntrack_add(uint8_t family, FAR const void *iphdr,
+                            FAR const struct net_driver_s *indev,
+                            FAR const struct net_driver_s *outdev,
+                            bool forward);
+
+/****************************************************************************
+ * Name: ipfilter_conntrack_flush
+ *
+ * Description:
+ *   Remove all entries of the given address family, e.g. when the rules
+ *   are changed and the accept decisions made before may be invalid.
+ *
+ * Input Parameters:
+ *   family - The address family of the entries to remove
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void ipfilter_conntrack_flush(uint8_t family);
+
+/****************************************************************************
+ * Name: ipfilter_conntrack_foreach
+ *
+ * Description:
+ *   Call the callback function for each valid entry, stop iterating if the
+ *   callback returns non-zero.
+ *
+ * Input Parameters:
+ *   cb  - The callback function
+ *   arg - The argument to pass to the callback function
+ *
+ * Returned Value:
+ *   The last value returned by the callback.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+int ipfilter_conntrack_foreach(ipfilter_ct_cb_t cb, FAR void *arg);
+#else
+#  define ipfilter_conntrack_lookup(f,h,i,o,fwd) ((void)(fwd), false)
+#  define ipfilter_conntrack_add(f,h,i,o,fwd)    UNUSED(fwd)
+#  define ipfilter_conntrack_flush(f)
+#endif
+
 #endif /* CONFIG_NET_IPFILTER */
 #endif /* __NET_IPFILTER_IPFILTER_H */
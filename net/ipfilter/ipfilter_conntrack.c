@@ -0,0 +1,752 @@
+/****************************************************************************
+ * net/ipfilter/ipfilter_conntrack.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <nuttx/debug.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <nuttx/clock.h>
+#include <nuttx/hashtable.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/net/icmp.h>
+#include <nuttx/net/icmpv6.h>
+#include <nuttx/net/net.h>
+#include <nuttx/net/tcp.h>
+#include <nuttx/net/udp.h>
+#include <nuttx/nuttx.h>
+
+#include "ipfilter/ipfilter.h"
+#include "utils/utils.h"
+
+#ifdef CONFIG_NET_IPFILTER_CONNTRACK
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Getting L4 header from IPv4/IPv6 header. */
+
+#define IPv4_L4HDR(ipv4) \
+  ((FAR void *)((FAR uint8_t *)(ipv4) + (((ipv4)->vhl & IPv4_HLMASK) << 2)))
+
+#define IPv6_L4HDR(ipv6, proto) \
+  ((FAR void *)(net_ipv6_payload((FAR struct ipv6_hdr_s *)(ipv6), &(proto))))
+
+/* Whether the IPv4 packet is a fragment (first or not). */
+
+#define IPv4_ISFRAG(ipv4) \
+  (((ipv4)->ipoffset[0] & 0x3f) != 0 || (ipv4)->ipoffset[1] != 0)
+
+/* The TCP flags we care about when tracking the connection state. */
+
+#define CT_TCP_FLAGS (TCP_FIN | TCP_SYN | TCP_RST | TCP_ACK)
+
+/* Flags of FIN seen in each direction. */
+
+#define CT_FIN_ORIG  (1 << IPFILTER_CT_DIR_ORIGINAL)
+#define CT_FIN_REPLY (1 << IPFILTER_CT_DIR_REPLY)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The tuple of the packet being checked, ports are in network order */
+
+struct ipfilter_ct_tuple_s
+{
+  FAR const struct net_driver_s *dev[2]; /* Input and output devices */
+  union ip_addr_u src;
+  union ip_addr_u dst;
+  uint16_t        sport;
+  uint16_t        dport;
+  uint8_t         family;
+  uint8_t         proto;
+  uint8_t         tcpflags;
+  bool            create;    /* Whether the packet may start a new flow */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static DECLARE_HASHTABLE(g_conntrack,
+                         CONFIG_NET_IPFILTER_CONNTRACK_HASH_BITS);
+static uint16_t g_conntrack_count;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ipfilter_ct_addr_key
+ *
+ * Description:
+ *   Fold an address into 32 bits for hashing.
+ *
+ ****************************************************************************/
+
+static inline uint32_t ipfilter_ct_addr_key(uint8_t family,
+                                            FAR const union ip_addr_u *addr)
+{
+#ifdef CONFIG_NET_IPv6
+  if (family == PF_INET6)
+    {
+      FAR const uint16_t *ip = addr->ipv6;
+      return ((uint32_t)ip[0] << 16 | ip[1]) ^
+             ((uint32_t)ip[2] << 16 | ip[3]) ^
+             ((uint32_t)ip[4] << 16 | ip[5]) ^
+             ((uint32_t)ip[6] << 16 | ip[7]);
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv4
+  return NTOHL(addr->ipv4);
+#else
+  return 0;
+#endif
+}
+
+/****************************************************************************
+ * Name: ipfilter_ct_key
+ *
+ * Description:
+ *   Create the hash key of a tuple.  The key is symmetric, so that the
+ *   packets of both directions of one flow fall into the same bucket.
+ *
+ ****************************************************************************/
+
+static uint32_t ipfilter_ct_key(FAR const struct ipfilter_ct_tuple_s *tuple)
+{
+  uintptr_t dev = (uintptr_t)tuple->dev[0] + (uintptr_t)tuple->dev[1];
+
+  return ipfilter_ct_addr_key(tuple->family, &tuple->src) ^
+         ipfilter_ct_addr_key(tuple->family, &tuple->dst) ^
+         ((uint32_t)(tuple->sport ^ tuple->dport) << 16) ^
+         ((uint32_t)tuple->proto << 8) ^ (uint32_t)(dev >> 4);
+}
+
+/****************************************************************************
+ * Name: ipfilter_ct_addr_cmp
+ ****************************************************************************/
+
+static inline bool ipfilter_ct_addr_cmp(uint8_t family,
+                                        FAR const union ip_addr_u *addr1,
+                                        FAR const union ip_addr_u *addr2)
+{
+#ifdef CONFIG_NET_IPv6
+  if (family == PF_INET6)
+    {
+      return net_ipv6addr_cmp(addr1->ipv6, addr2->ipv6);
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv4
+  return net_ipv4addr_cmp(addr1->ipv4, addr2->ipv4);
+#else
+  return false;
+#endif
+}
+
+/****************************************************************************
+ * Name: ipfilter_ct_timeout
+ *
+ * Description:
+ *   Get the idle timeout (in seconds) of an entry in its current state.
+ *
+ ****************************************************************************/
+
+static int32_t ipfilter_ct_timeout(FAR const struct ipfilter_ct_entry_s *ct)
+{
+  switch (ct->proto)
+    {
+      case IP_PROTO_TCP:
+        switch (ct->tcpstate)
+          {
+            case IPFILTER_CT_TCP_ESTABLISHED:
+              return CONFIG_NET_IPFILTER_CONNTRACK_TCP_ESTABLISHED_SEC;
+
+            case IPFILTER_CT_TCP_CLOSE:
+              return CONFIG_NET_IPFILTER_CONNTRACK_TCP_CLOSE_SEC;
+
+            default:
+              return CONFIG_NET_IPFILTER_CONNTRACK_TCP_TRANSIENT_SEC;
+          }
+
+      case IP_PROTO_UDP:
+        return CONFIG_NET_IPFILTER_CONNTRACK_UDP_SEC;
+
+      default:
+        return CONFIG_NET_IPFILTER_CONNTRACK_ICMP_SEC;
+    }
+}
+
+/****************************************************************************
+ * Name: ipfilter_ct_refresh
+ ****************************************************************************/
+
+static void ipfilter_ct_refresh(FAR struct ipfilter_ct_entry_s *ct,
+                                int32_t current_time)
+{
+  ct->expire_time = current_time + ipfilter_ct_timeout(ct);
+}
+
+/****************************************************************************
+ * Name: ipfilter_ct_delete
+ ****************************************************************************/
+
+static void ipfilter_ct_delete(FAR struct ipfilter_ct_entry_s *ct)
+{
+  hashtable_delete(g_conntrack, &ct->node, ct->key);
+  g_conntrack_count--;
+  kmm_free(ct);
+}
+
+/****************************************************************************
+ * Name: ipfilter_ct_tcp_update
+ *
+ * Description:
+ *   Update the TCP state of an entry with the flags of a packet.  This is a
+ *   simplified version of the Linux state machine, it only cares about the
+ *   handshake and the teardown, not about sequence windows.
+ *
+ ****************************************************************************/
+
+static void ipfilter_ct_tcp_update(FAR struct ipfilter_ct_entry_s *ct,
+                                   uint8_t flags, uint8_t dir)
+{
+  flags &= CT_TCP_FLAGS;
+
+  if ((flags & TCP_RST) != 0)
+    {
+      ct->tcpstate = IPFILTER_CT_TCP_CLOSE;
+      return;
+    }
+
+  switch (ct->tcpstate)
+    {
+      case IPFILTER_CT_TCP_SYN_SENT:
+        if (dir == IPFILTER_CT_DIR_REPLY && flags == (TCP_SYN | TCP_ACK))
+          {
+            ct->tcpstate = IPFILTER_CT_TCP_SYN_RECV;
+          }
+        break;
+
+      case IPFILTER_CT_TCP_SYN_RECV:
+        if (dir == IPFILTER_CT_DIR_ORIGINAL && (flags & TCP_SYN) == 0 &&
+            (flags & TCP_ACK) != 0)
+          {
+            ct->tcpstate = IPFILTER_CT_TCP_ESTABLISHED;
+          }
+
+        /* Fall through to detect a FIN piggybacked on the final ACK */
+
+      case IPFILTER_CT_TCP_ESTABLISHED:
+      case IPFILTER_CT_TCP_FIN_WAIT:
+        if ((flags & TCP_FIN) != 0)
+          {
+            ct->finseen |= 1 << dir;
+            ct->tcpstate = ct->finseen == (CT_FIN_ORIG | CT_FIN_REPLY) ?
+                           IPFILTER_CT_TCP_TIME_WAIT :
+                           IPFILTER_CT_TCP_FIN_WAIT;
+          }
+        break;
+
+      case IPFILTER_CT_TCP_TIME_WAIT:
+      case IPFILTER_CT_TCP_CLOSE:
+        if (dir == IPFILTER_CT_DIR_ORIGINAL && flags == TCP_SYN)
+          {
+            /* The same tuple is reused by a new connection. */
+
+            ct->tcpstate = IPFILTER_CT_TCP_SYN_SENT;
+            ct->finseen  = 0;
+          }
+        break;
+
+      default:
+        break;
+    }
+}
+
+/****************************************************************************
+ * Name: ipfilter_ct_l4tuple
+ *
+ * Description:
+ *   Fill the L4 part of the tuple.
+ *
+ * Returned Value:
+ *   true if the packet is trackable, false otherwise.
+ *
+ ****************************************************************************/
+
+static bool ipfilter_ct_l4tuple(FAR struct ipfilter_ct_tuple_s *tuple,
+                                FAR const void *l4hdr, uint8_t proto)
+{
+  tuple->proto = proto;
+
+  switch (proto)
+    {
+      case IP_PROTO_TCP:
+        {
+          FAR const struct tcp_hdr_s *tcp = l4hdr;
+
+          tuple->sport    = tcp->srcport;
+          tuple->dport    = tcp->destport;
+          tuple->tcpflags = tcp->flags;
+          tuple->create   = (tcp->flags & (TCP_SYN | TCP_ACK | TCP_RST)) ==
+                            TCP_SYN;
+          return true;
+        }
+
+      case IP_PROTO_UDP:
+        {
+          FAR const struct udp_hdr_s *udp = l4hdr;
+
+          tuple->sport  = udp->srcport;
+          tuple->dport  = udp->destport;
+          tuple->create = true;
+          return true;
+        }
+
+#ifdef CONFIG_NET_IPv4
+      case IP_PROTO_ICMP:
+        {
+          FAR const struct icmp_hdr_s *icmp = l4hdr;
+
+          if (icmp->type != ICMP_ECHO_REQUEST &&
+              icmp->type != ICMP_ECHO_REPLY)
+            {
+              return false;
+            }
+
+          tuple->sport  = icmp->id;
+          tuple->dport  = icmp->id;
+          tuple->create = icmp->type == ICMP_ECHO_REQUEST;
+          return true;
+        }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+      case IP_PROTO_ICMP6:
+        {
+          FAR const struct icmpv6_hdr_s *icmpv6 = l4hdr;
+
+          if (icmpv6->type != ICMPv6_ECHO_REQUEST &&
+              icmpv6->type != ICMPv6_ECHO_REPLY)
+            {
+              return false;
+            }
+
+          tuple->sport  = icmpv6->data[0];
+          tuple->dport  = icmpv6->data[0];
+          tuple->create = icmpv6->type == ICMPv6_ECHO_REQUEST;
+          return true;
+        }
+#endif
+
+      default:
+        return false;
+    }
+}
+
+/****************************************************************************
+ * Name: ipfilter_ct_tuple
+ *
+ * Description:
+ *   Extract the tuple from an IPv4/IPv6 packet and the devices it
+ *   travels.
+ *
+ * Returned Value:
+ *   true if the packet is trackable, false otherwise.
+ *
+ ****************************************************************************/
+
+static bool ipfilter_ct_tuple(FAR struct ipfilter_ct_tuple_s *tuple,
+                              uint8_t family, FAR const void *iphdr,
+                              FAR const struct net_driver_s *indev,
+                              FAR const struct net_driver_s *outdev)
+{
+  memset(tuple, 0, sizeof(*tuple));
+  tuple->family = family;
+
+  /* A forwarded flow is identified by both of its devices, the replies
+   * travel them in the opposite order.  A local flow uses one device in
+   * both directions.
+   */
+
+  tuple->dev[0] = indev != NULL ? indev : outdev;
+  tuple->dev[1] = outdev != NULL ? outdev : indev;
+
+#ifdef CONFIG_NET_IPv4
+  if (family == PF_INET)
+    {
+      FAR const struct ipv4_hdr_s *ipv4 = iphdr;
+
+      /* Fragments don't carry complete L4 info, leave them to the rules. */
+
+      if (IPv4_ISFRAG(ipv4))
+        {
+          return false;
+        }
+
+      net_ipv4addr_copy(tuple->src.ipv4,
+                        net_ip4addr_conv32(ipv4->srcipaddr));
+      net_ipv4addr_copy(tuple->dst.ipv4,
+                        net_ip4addr_conv32(ipv4->destipaddr));
+      return ipfilter_ct_l4tuple(tuple, IPv4_L4HDR(ipv4), ipv4->proto);
+    }
+#endif
+
+#ifdef CONFIG_NET_IPv6
+  if (family == PF_INET6)
+    {
+      FAR const struct ipv6_hdr_s *ipv6 = iphdr;
+      FAR const void *l4hdr;
+      uint8_t proto;
+
+      l4hdr = IPv6_L4HDR(ipv6, proto);
+      net_ipv6addr_copy(tuple->src.ipv6, ipv6->srcipaddr);
+      net_ipv6addr_copy(tuple->dst.ipv6, ipv6->destipaddr);
+      return ipfilter_ct_l4tuple(tuple, l4hdr, proto);
+    }
+#endif
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: ipfilter_ct_find
+ *
+ * Description:
+ *   Find the entry of a tuple, expired entries in the same bucket are
+ *   removed during the search.
+ *
+ ****************************************************************************/
+
+static FAR struct ipfilter_ct_entry_s *
+ipfilter_ct_find(FAR const struct ipfilter_ct_tuple_s *tuple, bool forward,
+                 int32_t current_time, FAR uint8_t *dir)
+{
+  FAR hash_node_t *p;
+  FAR hash_node_t *tmp;
+
+  hashtable_for_every_possible_safe(g_conntrack, p, tmp,
+                                    ipfilter_ct_key(tuple))
+    {
+      FAR struct ipfilter_ct_entry_s *ct =
+        container_of(p, struct ipfilter_ct_entry_s, node);
+
+      if (ct->expire_time - current_time <= 0)
+        {
+          ipfilter_ct_delete(ct);
+          continue;
+        }
+
+      if (ct->family != tuple->family || ct->proto != tuple->proto ||
+          ct->forward != forward)
+        {
+          continue;
+        }
+
+      if (ct->sport == tuple->sport && ct->dport == tuple->dport &&
+          ct->dev[0] == tuple->dev[0] && ct->dev[1] == tuple->dev[1] &&
+          ipfilter_ct_addr_cmp(ct->family, &ct->src, &tuple->src) &&
+          ipfilter_ct_addr_cmp(ct->family, &ct->dst, &tuple->dst))
+        {
+          *dir = IPFILTER_CT_DIR_ORIGINAL;
+          return ct;
+        }
+
+      if (ct->sport == tuple->dport && ct->dport == tuple->sport &&
+          ct->dev[0] == tuple->dev[1] && ct->dev[1] == tuple->dev[0] &&
+          ipfilter_ct_addr_cmp(ct->family, &ct->src, &tuple->dst) &&
+          ipfilter_ct_addr_cmp(ct->family, &ct->dst, &tuple->src))
+        {
+          *dir = IPFILTER_CT_DIR_REPLY;
+          return ct;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: ipfilter_ct_reclaim
+ *
+ * Description:
+ *   Reclaim all expired entries, called when the table is full or every
+ *   CONFIG_NET_IPFILTER_CONNTRACK_RECLAIM_SEC.
+ *
+ ****************************************************************************/
+
+static void ipfilter_ct_reclaim(int32_t current_time)
+{
+  FAR hash_node_t *p;
+  FAR hash_node_t *tmp;
+  int i;
+
+  hashtable_for_every_safe(g_conntrack, p, tmp, i)
+    {
+      FAR struct ipfilter_ct_entry_s *ct =
+        container_of(p, struct ipfilter_ct_entry_s, node);
+
+      if (ct->expire_time - current_time <= 0)
+        {
+          ipfilter_ct_delete(ct);
+        }
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ipfilter_conntrack_lookup
+ *
+ * Description:
+ *   Look up the connection tracking table for the packet.  If the packet
+ *   belongs to a tracked flow, the state and the timeout of the flow are
+ *   updated.
+ *
+ * Input Parameters:
+ *   family  - The address family of the packet
+ *   iphdr   - The IPv4/IPv6 header of the packet
+ *   indev   - The device the packet is received from, or NULL
+ *   outdev  - The device the packet is sent to, or NULL
+ *   forward - Whether the packet is being forwarded
+ *
+ * Returned Value:
+ *   true if the packet belongs to a tracked flow and should be accepted
+ *   without walking the rules, false otherwise.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+bool ipfilter_conntrack_lookup(uint8_t family, FAR const void *iphdr,
+                               FAR const struct net_driver_s *indev,
+                               FAR const struct net_driver_s *outdev,
+                               bool forward)
+{
+  struct ipfilter_ct_tuple_s tuple;
+  FAR struct ipfilter_ct_entry_s *ct;
+  int32_t current_time;
+  uint8_t dir;
+
+  if (g_conntrack_count == 0 ||
+      !ipfilter_ct_tuple(&tuple, family, iphdr, indev, outdev))
+    {
+      return false;
+    }
+
+  current_time = TICK2SEC(clock_systime_ticks());
+  ct = ipfilter_ct_find(&tuple, forward, current_time, &dir);
+  if (ct == NULL)
+    {
+      return false;
+    }
+
+  if (ct->proto == IP_PROTO_TCP)
+    {
+      ipfilter_ct_tcp_update(ct, tuple.tcpflags, dir);
+    }
+
+  if (dir == IPFILTER_CT_DIR_REPLY)
+    {
+      ct->replied = true;
+    }
+
+  ct->packets[dir]++;
+  ipfilter_ct_refresh(ct, current_time);
+  return true;
+}
+
+/****************************************************************************
+ * Name: ipfilter_conntrack_add
+ *
+ * Description:
+ *   Start tracking the flow of a packet which has just been accepted by
+ *   the rules.  Packets which can not start a flow (e.g. a TCP segment
+ *   without SYN) are ignored and will be checked against the rules again.
+ *
+ * Input Parameters:
+ *   family  - The address family of the packet
+ *   iphdr   - The IPv4/IPv6 header of the packet
+ *   indev   - The device the packet is received from, or NULL
+ *   outdev  - The device the packet is sent to, or NULL
+ *   forward - Whether the packet is being forwarded
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+void ipfilter_conntrack_add(uint8_t family, FAR const void *iphdr,
+                            FAR const struct net_driver_s *indev,
+                            FAR const struct net_driver_s *outdev,
+                            bool forward)
+{
+  struct ipfilter_ct_tuple_s tuple;
+  FAR struct ipfilter_ct_entry_s *ct;
+  static int32_t next_reclaim_time;
+  int32_t current_time;
+
+  if (!ipfilter_ct_tuple(&tuple, family, iphdr, indev, outdev) ||
+      !tuple.create)
+    {
+      return;
+    }
+
+  current_time = TICK2SEC(clock_systime_ticks());
+  if (next_reclaim_time - current_time <= 0 ||
+      g_conntrack_count >= CONFIG_NET_IPFILTER_CONNTRACK_MAX)
+    {
+      ipfilter_ct_reclaim(current_time);
+      next_reclaim_time = current_time +
+                          CONFIG_NET_IPFILTER_CONNTRACK_RECLAIM_SEC;
+    }
+
+  if (g_conntrack_count >= CONFIG_NET_IPFILTER_CONNTRACK_MAX)
+    {
+      nwarn("WARNING: Connection tracking table is full\n");
+      return;
+    }
+
+  ct = kmm_zalloc(sizeof(struct ipfilter_ct_entry_s));
+  if (ct == NULL)
+    {
+      nwarn("WARNING: Failed to allocate conntrack entry\n");
+      return;
+    }
+
+  ct->dev[0]   = tuple.dev[0];
+  ct->dev[1]   = tuple.dev[1];
+  ct->src      = tuple.src;
+  ct->dst      = tuple.dst;
+  ct->sport    = tuple.sport;
+  ct->dport    = tuple.dport;
+  ct->family   = tuple.family;
+  ct->proto    = tuple.proto;
+  ct->forward  = forward;
+  ct->key      = ipfilter_ct_key(&tuple);
+  ct->tcpstate = tuple.proto == IP_PROTO_TCP ? IPFILTER_CT_TCP_SYN_SENT :
+                                               IPFILTER_CT_TCP_NONE;
+  ct->packets[IPFILTER_CT_DIR_ORIGINAL] = 1;
+
+  ipfilter_ct_refresh(ct, current_time);
+  hashtable_add(g_conntrack, &ct->node, ct->key);
+  g_conntrack_count++;
+}
+
+/****************************************************************************
+ * Name: ipfilter_conntrack_flush
+ *
+ * Description:
+ *   Remove all entries of the given address family, e.g. when the rules
+ *   are changed and the accept decisions made before may be invalid.
+ *
+ * Input Parameters:
+ *   family - The address family of the entries to remove
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void ipfilter_conntrack_flush(uint8_t family)
+{
+  FAR hash_node_t *p;
+  FAR hash_node_t *tmp;
+  int i;
+
+  net_lock();
+  hashtable_for_every_safe(g_conntrack, p, tmp, i)
+    {
+      FAR struct ipfilter_ct_entry_s *ct =
+        container_of(p, struct ipfilter_ct_entry_s, node);
+
+      if (ct->family == family)
+        {
+          ipfilter_ct_delete(ct);
+        }
+    }
+
+  net_unlock();
+}
+
+/****************************************************************************
+ * Name: ipfilter_conntrack_foreach
+ *
+ * Description:
+ *   Call the callback function for each valid entry, stop iterating if the
+ *   callback returns non-zero.
+ *
+ * Input Parameters:
+ *   cb  - The callback function
+ *   arg - The argument to pass to the callback function
+ *
+ * Returned Value:
+ *   The last value returned by the callback.
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+int ipfilter_conntrack_foreach(ipfilter_ct_cb_t cb, FAR void *arg)
+{
+  FAR hash_node_t *p;
+  int32_t current_time = TICK2SEC(clock_systime_ticks());
+  int ret = 0;
+  int i;
+
+  hashtable_for_every(g_conntrack, p, i)
+    {
+      FAR struct ipfilter_ct_entry_s *ct =
+        container_of(p, struct ipfilter_ct_entry_s, node);
+
+      if (ct->expire_time - current_time <= 0)
+        {
+          continue;
+        }
+
+      ret = cb(ct, ct->expire_time - current_time, arg);
+      if (ret != 0)
+        {
+          return ret;
+        }
+    }
+
+  return ret;
+}
+
+#endif /* CONFIG_NET_IPFILTER_CONNTRACK */
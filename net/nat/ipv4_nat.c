@@ -138,24 +138,56 @@ static void ipv4_nat_ip_adjust(FAR struct ipv4_hdr_s *ipv4,
 }
 
 /****************************************************************************
- * Name: ipv4_nat_port_adjust
+ * Name: ipv4_nat_ip_rewrite
  *
  * Description:
- *   Adjust port and checksum for network packet.
+ *   Rewrite address for network packet matching a NAT entry, adjusting the
+ *   checksums with the delta precomputed in the entry.
+ *
+ * Input Parameters:
+ *   ipv4       - Points to the IPv4 header to adjust.
+ *   l4chksum   - Points to the L4 checksum to adjust, NULL for not adjust.
+ *   old_ip     - The IP to be set.
+ *   new_ip     - The IP to set into header.
+ *   delta      - The checksum delta of old_ip -> new_ip.
+ *
+ ****************************************************************************/
+
+static void ipv4_nat_ip_rewrite(FAR struct ipv4_hdr_s *ipv4,
+                                FAR uint16_t *l4chksum, FAR uint16_t *old_ip,
+                                in_addr_t new_ip, uint16_t delta)
+{
+  if (l4chksum != NULL)
+    {
+      nat_chksum_apply(l4chksum, delta);
+    }
+
+  nat_chksum_apply(&ipv4->ipchksum, delta);
+  net_ipv4addr_hdrcopy(old_ip, &new_ip);
+}
+
+/****************************************************************************
+ * Name: ipv4_nat_port_rewrite
+ *
+ * Description:
+ *   Rewrite port for network packet matching a NAT entry, adjusting the
+ *   checksum with the delta precomputed in the entry.
  *
  * Input Parameters:
  *   l4chksum - Points to the L4 checksum to adjust, NULL for not adjust.
  *   old_port - The port to be set.
  *   new_port - The port to set into header.
+ *   delta    - The checksum delta of old_port -> new_port.
  *
  ****************************************************************************/
 
-static void ipv4_nat_port_adjust(FAR uint16_t *l4chksum,
-                                 FAR uint16_t *old_port, uint16_t new_port)
+static void ipv4_nat_port_rewrite(FAR uint16_t *l4chksum,
+                                  FAR uint16_t *old_port, uint16_t new_port,
+                                  uint16_t delta)
 {
   if (l4chksum != NULL)
     {
-      nat_chksum_adjust(l4chksum, old_port, &new_port, sizeof(new_port));
+      nat_chksum_apply(l4chksum, delta);
     }
 
   *old_port = new_port;
@@ -207,8 +239,10 @@ ipv4_nat_inbound_tcp(FAR struct ipv4_hdr_s *ipv4,
    * address (IOB >= IP + ICMP + IP + TCP), so we can update it safely.
    */
 
-  ipv4_nat_port_adjust(&tcp->tcpchksum, external_port, entry->local_port);
-  ipv4_nat_ip_adjust(ipv4, &tcp->tcpchksum, external_ip, entry->local_ip);
+  ipv4_nat_port_rewrite(&tcp->tcpchksum, external_port, entry->local_port,
+                        nat_chksum_invert(entry->chksum_port));
+  ipv4_nat_ip_rewrite(ipv4, &tcp->tcpchksum, external_ip, entry->local_ip,
+                      nat_chksum_invert(entry->chksum_ip));
 
   return entry;
 }
@@ -261,8 +295,17 @@ ipv4_nat_inbound_udp(FAR struct ipv4_hdr_s *ipv4,
 
   udpchksum = udp->udpchksum != 0 ? &udp->udpchksum : NULL;
 
-  ipv4_nat_port_adjust(udpchksum, external_port, entry->local_port);
-  ipv4_nat_ip_adjust(ipv4, udpchksum, external_ip, entry->local_ip);
+  ipv4_nat_port_rewrite(udpchksum, external_port, entry->local_port,
+                        nat_chksum_invert(entry->chksum_port));
+  ipv4_nat_ip_rewrite(ipv4, udpchksum, external_ip, entry->local_ip,
+                      nat_chksum_invert(entry->chksum_ip));
+
+  /* A computed checksum of zero is transmitted as all ones (RFC768). */
+
+  if (udpchksum != NULL && *udpchksum == 0)
+    {
+      *udpchksum = 0xffff;
+    }
 
   return entry;
 }
@@ -312,9 +355,11 @@ ipv4_nat_inbound_icmp(FAR struct ipv4_hdr_s *ipv4,
             return NULL;
           }
 
-        ipv4_nat_port_adjust(&icmp->icmpchksum,
-                             &icmp->id, entry->local_port);
-        ipv4_nat_ip_adjust(ipv4, NULL, external_ip, entry->local_ip);
+        ipv4_nat_port_rewrite(&icmp->icmpchksum, &icmp->id,
+                              entry->local_port,
+                              nat_chksum_invert(entry->chksum_port));
+        ipv4_nat_ip_rewrite(ipv4, NULL, external_ip, entry->local_ip,
+                            nat_chksum_invert(entry->chksum_ip));
         return entry;
 
       case ICMP_DEST_UNREACHABLE:
@@ -370,7 +415,9 @@ ipv4_nat_inbound_icmp(FAR struct ipv4_hdr_s *ipv4,
                 return NULL;
               }
 
-            /* Adjust outer IP */
+            /* Adjust outer IP, which is not necessarily the address in the
+             * entry, so the checksum delta is computed from the header.
+             */
 
             ipv4_nat_ip_adjust(ipv4, NULL, external_ip, entry->local_ip);
 
@@ -439,8 +486,10 @@ ipv4_nat_outbound_tcp(FAR struct net_driver_s *dev,
    * address (IOB >= IP + ICMP + IP + TCP), so we can update it safely.
    */
 
-  ipv4_nat_port_adjust(&tcp->tcpchksum, local_port, entry->external_port);
-  ipv4_nat_ip_adjust(ipv4, &tcp->tcpchksum, local_ip, entry->external_ip);
+  ipv4_nat_port_rewrite(&tcp->tcpchksum, local_port, entry->external_port,
+                        entry->chksum_port);
+  ipv4_nat_ip_rewrite(ipv4, &tcp->tcpchksum, local_ip, entry->external_ip,
+                      entry->chksum_ip);
 
   return entry;
 }
@@ -495,8 +544,17 @@ ipv4_nat_outbound_udp(FAR struct net_driver_s *dev,
 
   udpchksum = udp->udpchksum != 0 ? &udp->udpchksum : NULL;
 
-  ipv4_nat_port_adjust(udpchksum, local_port, entry->external_port);
-  ipv4_nat_ip_adjust(ipv4, udpchksum, local_ip, entry->external_ip);
+  ipv4_nat_port_rewrite(udpchksum, local_port, entry->external_port,
+                        entry->chksum_port);
+  ipv4_nat_ip_rewrite(ipv4, udpchksum, local_ip, entry->external_ip,
+                      entry->chksum_ip);
+
+  /* A computed checksum of zero is transmitted as all ones (RFC768). */
+
+  if (udpchksum != NULL && *udpchksum == 0)
+    {
+      *udpchksum = 0xffff;
+    }
 
   return entry;
 }
@@ -551,9 +609,10 @@ ipv4_nat_outbound_icmp(FAR struct net_driver_s *dev,
             return NULL;
           }
 
-        ipv4_nat_port_adjust(&icmp->icmpchksum,
-                             &icmp->id, entry->external_port);
-        ipv4_nat_ip_adjust(ipv4, NULL, local_ip, entry->external_ip);
+        ipv4_nat_port_rewrite(&icmp->icmpchksum, &icmp->id,
+                              entry->external_port, entry->chksum_port);
+        ipv4_nat_ip_rewrite(ipv4, NULL, local_ip, entry->external_ip,
+                            entry->chksum_ip);
         return entry;
 
       case ICMP_DEST_UNREACHABLE:
@@ -609,7 +668,9 @@ ipv4_nat_outbound_icmp(FAR struct net_driver_s *dev,
                 return NULL;
               }
 
-            /* Adjust outer IP */
+            /* Adjust outer IP, which is not necessarily the address in the
+             * entry, so the checksum delta is computed from the header.
+             */
 
             ipv4_nat_ip_adjust(ipv4, NULL, local_ip, entry->external_ip);
 
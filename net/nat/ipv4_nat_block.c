@@ -0,0 +1,389 @@
+/****************************************************************************
+ * net/nat/ipv4_nat_block.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <nuttx/debug.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include <nuttx/hashtable.h>
+#include <nuttx/kmalloc.h>
+#include <nuttx/nuttx.h>
+
+#include "nat/nat.h"
+
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define NAT44_BLOCK_MIN      CONFIG_NET_NAT44_PORT_BLOCK_MIN
+#define NAT44_BLOCK_MAX      CONFIG_NET_NAT44_PORT_BLOCK_MAX
+#define NAT44_BLOCK_SIZE     CONFIG_NET_NAT44_PORT_BLOCK_SIZE
+#define NAT44_BLOCK_WORDS    (NAT44_BLOCK_SIZE / 32)
+#define NAT44_BLOCK_NUM      ((NAT44_BLOCK_MAX - NAT44_BLOCK_MIN + 1) / \
+                              NAT44_BLOCK_SIZE)
+
+#if NAT44_BLOCK_SIZE % 32 != 0
+#  error CONFIG_NET_NAT44_PORT_BLOCK_SIZE must be a multiple of 32
+#endif
+
+#if NAT44_BLOCK_NUM < 1
+#  error NAT44 port block range is smaller than one block
+#endif
+
+/* TCP and UDP have separate port spaces, so each block keeps one bitmap
+ * per protocol.
+ */
+
+#define NAT44_BLOCK_PROTO(proto) ((proto) == IP_PROTO_TCP ? 0 : 1)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct ipv4_nat_block_s
+{
+  uint16_t index;                        /* Index in the port block range */
+  uint16_t nused;                        /* Number of ports in use */
+  uint32_t bitmap[2][NAT44_BLOCK_WORDS]; /* Ports in use, per protocol */
+};
+
+struct ipv4_nat_host_s
+{
+  hash_node_t node;
+  in_addr_t   local_ip;                  /* The local host */
+  uint8_t     nblocks;                   /* Number of blocks owned */
+  struct ipv4_nat_block_s blocks[CONFIG_NET_NAT44_PORT_BLOCK_PER_HOST];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static DECLARE_HASHTABLE(g_nat44_hosts, CONFIG_NET_NAT_HASH_BITS);
+
+/* The owner of each block in the port block range, NULL if free. */
+
+static FAR struct ipv4_nat_host_s *g_nat44_block_owner[NAT44_BLOCK_NUM];
+static uint16_t g_nat44_block_next; /* Where to look for a free block */
+static uint32_t g_nat44_nhosts;
+static uint32_t g_nat44_nblocks;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ipv4_nat_host_find
+ *
+ * Description:
+ *   Find the port block owner of a local host.
+ *
+ ****************************************************************************/
+
+static FAR struct ipv4_nat_host_s *ipv4_nat_host_find(in_addr_t local_ip)
+{
+  FAR hash_node_t *p;
+
+  hashtable_for_every_possible(g_nat44_hosts, p, NTOHL(local_ip))
+    {
+      FAR struct ipv4_nat_host_s *host =
+        container_of(p, struct ipv4_nat_host_s, node);
+
+      if (net_ipv4addr_cmp(host->local_ip, local_ip))
+        {
+          return host;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: ipv4_nat_host_release
+ *
+ * Description:
+ *   Forget a local host that owns no port block anymore.
+ *
+ ****************************************************************************/
+
+static void ipv4_nat_host_release(FAR struct ipv4_nat_host_s *host)
+{
+  DEBUGASSERT(host->nblocks == 0);
+
+  hashtable_delete(g_nat44_hosts, &host->node, NTOHL(host->local_ip));
+  g_nat44_nhosts--;
+  kmm_free(host);
+}
+
+/****************************************************************************
+ * Name: ipv4_nat_block_reserve
+ *
+ * Description:
+ *   Reserve a free block of the port block range for a local host.
+ *
+ * Returned Value:
+ *   The new block on success; NULL if all blocks are in use.
+ *
+ ****************************************************************************/
+
+static FAR struct ipv4_nat_block_s *
+ipv4_nat_block_reserve(FAR struct ipv4_nat_host_s *host)
+{
+  FAR struct ipv4_nat_block_s *block;
+  uint16_t index = g_nat44_block_next;
+
+  while (g_nat44_block_owner[index] != NULL)
+    {
+      if (++index >= NAT44_BLOCK_NUM)
+        {
+          index = 0;
+        }
+
+      if (index == g_nat44_block_next)
+        {
+          return NULL;
+        }
+    }
+
+  g_nat44_block_owner[index] = host;
+  g_nat44_block_next = (index + 1) % NAT44_BLOCK_NUM;
+  g_nat44_nblocks++;
+
+  block = &host->blocks[host->nblocks++];
+  memset(block, 0, sizeof(*block));
+  block->index = index;
+
+  ninfo("INFO: NAT44 port block %" PRIu16 " reserved for %" PRIx32 "\n",
+        index, host->local_ip);
+  return block;
+}
+
+/****************************************************************************
+ * Name: ipv4_nat_block_take
+ *
+ * Description:
+ *   Take a free port of a protocol from a block.
+ *
+ * Returned Value:
+ *   True if a port is taken and returned in external_port.
+ *
+ ****************************************************************************/
+
+static bool ipv4_nat_block_take(FAR struct ipv4_nat_block_s *block,
+                                uint8_t protocol,
+                                FAR uint16_t *external_port)
+{
+  FAR uint32_t *bitmap = block->bitmap[NAT44_BLOCK_PROTO(protocol)];
+  int i;
+
+  for (i = 0; i < NAT44_BLOCK_WORDS; i++)
+    {
+      if (bitmap[i] != UINT32_MAX)
+        {
+          int bit = ffs(~bitmap[i]) - 1;
+
+          bitmap[i] |= UINT32_C(1) << bit;
+          block->nused++;
+
+          *external_port = HTONS(NAT44_BLOCK_MIN +
+                                 block->index * NAT44_BLOCK_SIZE +
+                                 i * 32 + bit);
+          return true;
+        }
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ipv4_nat_block_alloc
+ *
+ * Description:
+ *   Allocate an external TCP/UDP port for a local host from the port
+ *   blocks reserved for that host, reserving a new block if needed.
+ *
+ * Input Parameters:
+ *   protocol      - The L4 protocol, IP_PROTO_TCP or IP_PROTO_UDP.
+ *   local_ip      - The local host owning the port.
+ *   external_port - The selected external port (in network byte order).
+ *
+ * Returned Value:
+ *   The owner of the port to pass to ipv4_nat_block_free on success;
+ *   NULL if the host has used up its blocks or no block is left.
+ *
+ * Assumptions:
+ *   The caller holds the NAT lock.
+ *
+ ****************************************************************************/
+
+FAR struct ipv4_nat_host_s *
+ipv4_nat_block_alloc(uint8_t protocol, in_addr_t local_ip,
+                     FAR uint16_t *external_port)
+{
+  FAR struct ipv4_nat_host_s *host = ipv4_nat_host_find(local_ip);
+  FAR struct ipv4_nat_block_s *block;
+  int i;
+
+  if (host == NULL)
+    {
+      host = kmm_zalloc(sizeof(struct ipv4_nat_host_s));
+      if (host == NULL)
+        {
+          return NULL;
+        }
+
+      host->local_ip = local_ip;
+      hashtable_add(g_nat44_hosts, &host->node, NTOHL(local_ip));
+      g_nat44_nhosts++;
+    }
+
+  for (i = 0; i < host->nblocks; i++)
+    {
+      if (ipv4_nat_block_take(&host->blocks[i], protocol, external_port))
+        {
+          return host;
+        }
+    }
+
+  if (host->nblocks < CONFIG_NET_NAT44_PORT_BLOCK_PER_HOST)
+    {
+      block = ipv4_nat_block_reserve(host);
+      if (block != NULL &&
+          ipv4_nat_block_take(block, protocol, external_port))
+        {
+          return host;
+        }
+    }
+
+  nwarn("WARNING: No NAT44 port left for %" PRIx32 "\n", local_ip);
+
+  if (host->nblocks == 0)
+    {
+      ipv4_nat_host_release(host);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: ipv4_nat_block_free
+ *
+ * Description:
+ *   Release an external port allocated by ipv4_nat_block_alloc.  Blocks
+ *   without ports in use are returned to the global pool, and the host is
+ *   forgotten once it owns no block.
+ *
+ * Assumptions:
+ *   The caller holds the NAT lock.
+ *
+ ****************************************************************************/
+
+void ipv4_nat_block_free(FAR struct ipv4_nat_host_s *host,
+                         uint8_t protocol, uint16_t external_port)
+{
+  uint16_t offset = NTOHS(external_port) - NAT44_BLOCK_MIN;
+  uint16_t index  = offset / NAT44_BLOCK_SIZE;
+  uint16_t bit    = offset % NAT44_BLOCK_SIZE;
+  int i;
+
+  for (i = 0; i < host->nblocks; i++)
+    {
+      FAR struct ipv4_nat_block_s *block = &host->blocks[i];
+
+      if (block->index != index)
+        {
+          continue;
+        }
+
+      block->bitmap[NAT44_BLOCK_PROTO(protocol)][bit / 32] &=
+        ~(UINT32_C(1) << (bit % 32));
+
+      if (--block->nused == 0)
+        {
+          g_nat44_block_owner[index] = NULL;
+          g_nat44_nblocks--;
+
+          /* Keep the blocks of the host packed. */
+
+          *block = host->blocks[--host->nblocks];
+        }
+
+      break;
+    }
+
+  if (host->nblocks == 0)
+    {
+      ipv4_nat_host_release(host);
+    }
+}
+
+/****************************************************************************
+ * Name: ipv4_nat_block_inuse
+ *
+ * Description:
+ *   Check whether a port (in network byte order) lies in a block reserved
+ *   for some local host.
+ *
+ ****************************************************************************/
+
+bool ipv4_nat_block_inuse(uint16_t port)
+{
+  uint16_t hport = NTOHS(port);
+  uint16_t index;
+
+  if (hport < NAT44_BLOCK_MIN || hport > NAT44_BLOCK_MAX)
+    {
+      return false;
+    }
+
+  index = (hport - NAT44_BLOCK_MIN) / NAT44_BLOCK_SIZE;
+  return index < NAT44_BLOCK_NUM && g_nat44_block_owner[index] != NULL;
+}
+
+/****************************************************************************
+ * Name: ipv4_nat_block_stats
+ *
+ * Description:
+ *   Fill in the port block part of the NAT44 statistics.
+ *
+ ****************************************************************************/
+
+void ipv4_nat_block_stats(FAR struct ipv4_nat_stats_s *stats)
+{
+  stats->hosts  = g_nat44_nhosts;
+  stats->blocks = g_nat44_nblocks;
+}
+
+#endif /* CONFIG_NET_NAT44_PORT_BLOCK */
@@ -33,12 +33,26 @@
 #include <nuttx/hashtable.h>
 #include <nuttx/kmalloc.h>
 #include <nuttx/nuttx.h>
+#include <nuttx/queue.h>
+#include <nuttx/wqueue.h>
 
 #include "nat/nat.h"
 #include "netlink/netlink.h"
 
 #ifdef CONFIG_NET_NAT44
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define NAT44_WHEEL_SLOTS CONFIG_NET_NAT44_EXPIRE_WHEEL_SLOTS
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static void ipv4_nat_wheel_work(FAR void *arg);
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -46,6 +60,18 @@
 static DECLARE_HASHTABLE(g_nat44_inbound, CONFIG_NET_NAT_HASH_BITS);
 static DECLARE_HASHTABLE(g_nat44_outbound, CONFIG_NET_NAT_HASH_BITS);
 
+/* Expiry timer wheel, one slot per second.  An entry is queued in the slot
+ * of its expiration time when it is created; refreshing an entry only
+ * updates expire_time, and the entry is moved to its new slot when the
+ * wheel reaches the old one.
+ */
+
+static dq_queue_t g_nat44_wheel[NAT44_WHEEL_SLOTS];
+static struct work_s g_nat44_wheel_work;
+static int32_t g_nat44_wheel_time; /* The last second processed */
+
+static struct ipv4_nat_stats_s g_nat44_stats;
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -98,6 +124,33 @@ static void ipv4_nat_entry_refresh(FAR ipv4_nat_entry_t *entry)
   entry->expire_time = nat_expire_time(entry->protocol);
 }
 
+/****************************************************************************
+ * Name: ipv4_nat_wheel_slot
+ *
+ * Description:
+ *   Get the expiry timer wheel slot of a time (in seconds).
+ *
+ ****************************************************************************/
+
+static inline uint16_t ipv4_nat_wheel_slot(int32_t time)
+{
+  return (uint32_t)time % NAT44_WHEEL_SLOTS;
+}
+
+/****************************************************************************
+ * Name: ipv4_nat_wheel_insert
+ *
+ * Description:
+ *   Queue an entry in the expiry timer wheel slot of its expiration time.
+ *
+ ****************************************************************************/
+
+static void ipv4_nat_wheel_insert(FAR ipv4_nat_entry_t *entry)
+{
+  entry->wheel_slot = ipv4_nat_wheel_slot(entry->expire_time);
+  dq_addlast(&entry->wheel_node, &g_nat44_wheel[entry->wheel_slot]);
+}
+
 /****************************************************************************
  * Name: ipv4_nat_entry_create
  *
@@ -131,6 +184,21 @@ ipv4_nat_entry_create(uint8_t protocol,
       return NULL;
     }
 
+  /* The expiry timer only runs while there are entries, restart it from
+   * the current second when the first entry is created.
+   */
+
+  if (g_nat44_stats.entries == 0)
+    {
+      g_nat44_wheel_time = TICK2SEC(clock_systime_ticks());
+    }
+
+  if (work_available(&g_nat44_wheel_work))
+    {
+      work_queue(LPWORK, &g_nat44_wheel_work, ipv4_nat_wheel_work, NULL,
+                 SEC2TICK(1));
+    }
+
   entry->protocol      = protocol;
   entry->external_ip   = external_ip;
   entry->external_port = external_port;
@@ -140,8 +208,24 @@ ipv4_nat_entry_create(uint8_t protocol,
   entry->peer_ip       = peer_ip;
   entry->peer_port     = peer_port;
 #endif
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+  entry->host          = NULL;
+#endif
+
+  entry->chksum_ip     = nat_chksum_delta(&local_ip, &external_ip,
+                                          sizeof(in_addr_t));
+  entry->chksum_port   = nat_chksum_delta(&local_port, &external_port,
+                                          sizeof(uint16_t));
 
   ipv4_nat_entry_refresh(entry);
+  ipv4_nat_wheel_insert(entry);
+
+  if (++g_nat44_stats.entries > g_nat44_stats.peak)
+    {
+      g_nat44_stats.peak = g_nat44_stats.entries;
+    }
+
+  g_nat44_stats.created++;
 
   hashtable_add(g_nat44_inbound, &entry->hash_inbound,
                 ipv4_nat_inbound_key(external_ip, external_port, protocol));
@@ -181,6 +265,16 @@ static void ipv4_nat_entry_delete(FAR ipv4_nat_entry_t *entry)
                    ipv4_nat_outbound_key(entry->local_ip,
                                          entry->local_port,
                                          entry->protocol));
+  dq_rem(&entry->wheel_node, &g_nat44_wheel[entry->wheel_slot]);
+  g_nat44_stats.entries--;
+
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+  if (entry->host != NULL)
+    {
+      ipv4_nat_block_free(entry->host, entry->protocol,
+                          entry->external_port);
+    }
+#endif
 
 #ifdef CONFIG_NETLINK_NETFILTER
   netlink_conntrack_notify(IPCTNL_MSG_CT_DELETE, PF_INET, entry);
@@ -190,47 +284,82 @@ static void ipv4_nat_entry_delete(FAR ipv4_nat_entry_t *entry)
 }
 
 /****************************************************************************
- * Name: ipv4_nat_reclaim_entry
+ * Name: ipv4_nat_wheel_expire
  *
  * Description:
- *   Try reclaim all expired NAT entries.
- *   Only works after every CONFIG_NET_NAT_ENTRY_RECLAIM_SEC (low frequency).
+ *   Remove the expired entries queued in one slot of the expiry timer
+ *   wheel, and move the entries refreshed since they were queued to the
+ *   slot of their new expiration time.
  *
- *   Although expired entries will be automatically reclaimed when matching
- *   inbound/outbound entries, there might be some situations that entries
- *   will be kept in memory, e.g. big hashtable with only a few connections.
- *
- * Assumptions:
- *   NAT is initialized.
+ * Input Parameters:
+ *   slot - The slot to process.
+ *   now  - The current time in seconds.
  *
  ****************************************************************************/
 
-#if CONFIG_NET_NAT_ENTRY_RECLAIM_SEC > 0
-static void ipv4_nat_reclaim_entry_cb(FAR ipv4_nat_entry_t *entry,
-                                      FAR void *arg)
+static void ipv4_nat_wheel_expire(uint16_t slot, int32_t now)
 {
-  int32_t current_time = *(FAR int32_t *)arg;
+  FAR dq_entry_t *node;
+  FAR dq_entry_t *next;
 
-  if (entry->expire_time - current_time <= 0)
+  for (node = dq_peek(&g_nat44_wheel[slot]); node != NULL; node = next)
     {
-      ipv4_nat_entry_delete(entry);
+      FAR ipv4_nat_entry_t *entry =
+        container_of(node, ipv4_nat_entry_t, wheel_node);
+
+      next = dq_next(node);
+
+      if (entry->expire_time - now <= 0)
+        {
+          g_nat44_stats.expired++;
+          ipv4_nat_entry_delete(entry);
+        }
+      else if (ipv4_nat_wheel_slot(entry->expire_time) != slot)
+        {
+          dq_rem(node, &g_nat44_wheel[slot]);
+          ipv4_nat_wheel_insert(entry);
+        }
     }
 }
 
-static void ipv4_nat_reclaim_entry(int32_t current_time)
+/****************************************************************************
+ * Name: ipv4_nat_wheel_work
+ *
+ * Description:
+ *   Advance the expiry timer wheel up to the current second.  Runs once per
+ *   second on the low priority work queue while there are NAT44 entries.
+ *
+ ****************************************************************************/
+
+static void ipv4_nat_wheel_work(FAR void *arg)
 {
-  static int32_t next_reclaim_time = CONFIG_NET_NAT_ENTRY_RECLAIM_SEC;
+  int32_t now = TICK2SEC(clock_systime_ticks());
+
+  nat_lock();
+
+  /* Catch up with the seconds missed if the work was delayed, but there is
+   * no need to walk the wheel more than once.
+   */
+
+  if (now - g_nat44_wheel_time > NAT44_WHEEL_SLOTS)
+    {
+      g_nat44_wheel_time = now - NAT44_WHEEL_SLOTS;
+    }
+
+  while (g_nat44_wheel_time - now < 0)
+    {
+      g_nat44_wheel_time++;
+      ipv4_nat_wheel_expire(ipv4_nat_wheel_slot(g_nat44_wheel_time), now);
+    }
 
-  if (next_reclaim_time - current_time <= 0)
+  if (g_nat44_stats.entries > 0)
     {
-      ninfo("INFO: Reclaiming all expired NAT44 entries.\n");
-      ipv4_nat_entry_foreach(ipv4_nat_reclaim_entry_cb, &current_time);
-      next_reclaim_time = current_time + CONFIG_NET_NAT_ENTRY_RECLAIM_SEC;
+      work_queue(LPWORK, &g_nat44_wheel_work, ipv4_nat_wheel_work, NULL,
+                 SEC2TICK(1));
     }
+
+  nat_unlock();
 }
-#else
-#  define ipv4_nat_reclaim_entry(t)
-#endif
 
 /****************************************************************************
  * Name: ipv4_nat_entry_clear_cb
@@ -248,6 +377,7 @@ static void ipv4_nat_entry_clear_cb(FAR ipv4_nat_entry_t *entry,
 
   if (net_ipv4addr_cmp(entry->external_ip, dev->d_ipaddr))
     {
+      g_nat44_stats.evicted++;
       ipv4_nat_entry_delete(entry);
     }
 }
@@ -336,22 +466,12 @@ ipv4_nat_inbound_entry_find(uint8_t protocol, in_addr_t external_ip,
 #endif
   int32_t current_time = TICK2SEC(clock_systime_ticks());
 
-  ipv4_nat_reclaim_entry(current_time);
-
   hashtable_for_every_possible_safe(g_nat44_inbound, p, tmp,
                   ipv4_nat_inbound_key(external_ip, external_port, protocol))
     {
       FAR ipv4_nat_entry_t *entry =
         container_of(p, ipv4_nat_entry_t, hash_inbound);
 
-      /* Remove expired entries. */
-
-      if (entry->expire_time - current_time <= 0)
-        {
-          ipv4_nat_entry_delete(entry);
-          continue;
-        }
-
       if (entry->protocol == protocol &&
           (skip_ip || net_ipv4addr_cmp(entry->external_ip, external_ip)) &&
           entry->external_port == external_port
@@ -361,6 +481,15 @@ ipv4_nat_inbound_entry_find(uint8_t protocol, in_addr_t external_ip,
 #endif
           )
         {
+          /* The entry may have expired since the last wheel tick. */
+
+          if (entry->expire_time - current_time <= 0)
+            {
+              g_nat44_stats.expired++;
+              ipv4_nat_entry_delete(entry);
+              continue;
+            }
+
           if (refresh)
             {
               ipv4_nat_entry_refresh(entry);
@@ -409,25 +538,18 @@ ipv4_nat_outbound_entry_find(FAR struct net_driver_s *dev, uint8_t protocol,
 {
   FAR hash_node_t *p;
   FAR hash_node_t *tmp;
+  FAR ipv4_nat_entry_t *entry;
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+  FAR struct ipv4_nat_host_s *host = NULL;
+#endif
   uint16_t external_port;
   int32_t current_time = TICK2SEC(clock_systime_ticks());
   int ret;
 
-  ipv4_nat_reclaim_entry(current_time);
-
   hashtable_for_every_possible_safe(g_nat44_outbound, p, tmp,
                       ipv4_nat_outbound_key(local_ip, local_port, protocol))
     {
-      FAR ipv4_nat_entry_t *entry =
-        container_of(p, ipv4_nat_entry_t, hash_outbound);
-
-      /* Remove expired entries. */
-
-      if (entry->expire_time - current_time <= 0)
-        {
-          ipv4_nat_entry_delete(entry);
-          continue;
-        }
+      entry = container_of(p, ipv4_nat_entry_t, hash_outbound);
 
       if (entry->protocol == protocol &&
           net_ipv4addr_cmp(entry->external_ip, dev->d_ipaddr) &&
@@ -439,6 +561,15 @@ ipv4_nat_outbound_entry_find(FAR struct net_driver_s *dev, uint8_t protocol,
 #endif
           )
         {
+          /* The entry may have expired since the last wheel tick. */
+
+          if (entry->expire_time - current_time <= 0)
+            {
+              g_nat44_stats.expired++;
+              ipv4_nat_entry_delete(entry);
+              continue;
+            }
+
           ipv4_nat_entry_refresh(entry);
           return entry;
         }
@@ -455,17 +586,68 @@ ipv4_nat_outbound_entry_find(FAR struct net_driver_s *dev, uint8_t protocol,
         "proto=%" PRIu8 ", local=%" PRIx32 ":%" PRIu16 ", try create one.\n",
         protocol, local_ip, local_port);
 
-  ret = nat_port_select(dev, PF_INET, protocol,
-                        (FAR union ip_addr_u *)&dev->d_ipaddr, local_port,
-                        &external_port);
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+  if (protocol == IP_PROTO_TCP || protocol == IP_PROTO_UDP)
+    {
+      host = ipv4_nat_block_alloc(protocol, local_ip, &external_port);
+      ret  = host != NULL ? OK : -EADDRINUSE;
+    }
+  else
+#endif
+    {
+      ret = nat_port_select(dev, PF_INET, protocol,
+                            (FAR union ip_addr_u *)&dev->d_ipaddr,
+                            local_port, &external_port);
+    }
+
   if (ret < 0)
     {
       nwarn("WARNING: Failed to find an available port!\n");
+      g_nat44_stats.failed++;
+      return NULL;
+    }
+
+  entry = ipv4_nat_entry_create(protocol, dev->d_ipaddr, external_port,
+                                local_ip, local_port, peer_ip, peer_port);
+  if (entry == NULL)
+    {
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+      if (host != NULL)
+        {
+          ipv4_nat_block_free(host, protocol, external_port);
+        }
+#endif
+
+      g_nat44_stats.failed++;
       return NULL;
     }
 
-  return ipv4_nat_entry_create(protocol, dev->d_ipaddr, external_port,
-                               local_ip, local_port, peer_ip, peer_port);
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+  entry->host = host;
+#endif
+
+  return entry;
+}
+
+/****************************************************************************
+ * Name: ipv4_nat_stats
+ *
+ * Description:
+ *   Get a snapshot of the NAT44 table statistics.
+ *
+ * Input Parameters:
+ *   stats - The location to return the statistics.
+ *
+ ****************************************************************************/
+
+void ipv4_nat_stats(FAR struct ipv4_nat_stats_s *stats)
+{
+  nat_lock();
+  *stats = g_nat44_stats;
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+  ipv4_nat_block_stats(stats);
+#endif
+  nat_unlock();
 }
 
 #endif /* CONFIG_NET_NAT44 */
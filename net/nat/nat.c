@@ -197,8 +197,22 @@ bool nat_port_inuse(uint8_t domain, uint8_t protocol,
 #ifdef CONFIG_NET_NAT44
   if (domain == PF_INET)
     {
-      ret = !!ipv4_nat_inbound_entry_find(protocol, ip->ipv4, port,
-                                          INADDR_ANY, 0, false);
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+      /* Ports in a reserved block are kept for the NAT even if they are
+       * not mapped yet.
+       */
+
+      if ((protocol == IP_PROTO_TCP || protocol == IP_PROTO_UDP) &&
+          ipv4_nat_block_inuse(port))
+        {
+          ret = true;
+        }
+      else
+#endif
+        {
+          ret = !!ipv4_nat_inbound_entry_find(protocol, ip->ipv4, port,
+                                              INADDR_ANY, 0, false);
+        }
     }
 #endif
 
@@ -35,6 +35,7 @@
 #include <netinet/in.h>
 
 #include <nuttx/hashtable.h>
+#include <nuttx/queue.h>
 #include <nuttx/net/ip.h>
 #include <nuttx/net/netdev.h>
 
@@ -66,10 +67,20 @@
 #define PEER_PORT(l4hdr,manip_type) \
   ((manip_type) != NAT_MANIP_SRC ? &(l4hdr)->srcport : &(l4hdr)->destport)
 
+/* Negate a precomputed checksum delta, i.e. turn a local->external delta
+ * into the external->local one.
+ */
+
+#define nat_chksum_invert(delta) ((uint16_t)~(delta))
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
 
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+struct ipv4_nat_host_s;   /* Forward reference */
+#endif
+
 struct ipv4_nat_entry_s
 {
   hash_node_t hash_inbound;
@@ -100,6 +111,23 @@ struct ipv4_nat_entry_s
   uint8_t    protocol;       /* L4 protocol (TCP, UDP etc). */
 
   int32_t    expire_time;    /* The expiration time of this entry. */
+
+  /* Checksum deltas of the local -> external rewrite, precomputed when the
+   * entry is created so that translating a packet does not need to walk
+   * the old and new header fields again.
+   */
+
+  uint16_t   chksum_ip;      /* Delta of local_ip -> external_ip */
+  uint16_t   chksum_port;    /* Delta of local_port -> external_port */
+
+  /* Expiry timer wheel linkage. */
+
+  dq_entry_t wheel_node;
+  uint16_t   wheel_slot;     /* Wheel slot the entry is queued in */
+
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+  FAR struct ipv4_nat_host_s *host; /* Owner of external_port, or NULL */
+#endif
 };
 
 struct ipv6_nat_entry_s
@@ -122,6 +150,22 @@ struct ipv6_nat_entry_s
   int32_t        expire_time;   /* The expiration time of this entry. */
 };
 
+/* NAT44 table statistics, reported through procfs. */
+
+struct ipv4_nat_stats_s
+{
+  uint32_t entries;          /* Number of entries in the table */
+  uint32_t peak;             /* Highest number of entries seen */
+  uint32_t created;          /* Number of entries created */
+  uint32_t expired;          /* Entries removed because they timed out */
+  uint32_t evicted;          /* Entries removed when NAT was disabled */
+  uint32_t failed;           /* Entries that could not be created */
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+  uint32_t hosts;            /* Local hosts owning port blocks */
+  uint32_t blocks;           /* Port blocks in use */
+#endif
+};
+
 typedef struct ipv4_nat_entry_s ipv4_nat_entry_t;
 typedef struct ipv6_nat_entry_s ipv6_nat_entry_t;
 
@@ -140,6 +184,72 @@ enum nat_manip_type_e
   NAT_MANIP_DST
 };
 
+/****************************************************************************
+ * Inline Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nat_chksum_fold
+ *
+ * Description:
+ *   Fold a 32-bit ones' complement sum into 16 bits.
+ *
+ ****************************************************************************/
+
+static inline uint16_t nat_chksum_fold(uint32_t sum)
+{
+  sum = (sum & 0xffff) + (sum >> 16);
+  sum = (sum & 0xffff) + (sum >> 16);
+  return (uint16_t)sum;
+}
+
+/****************************************************************************
+ * Name: nat_chksum_delta
+ *
+ * Description:
+ *   Compute the ones' complement difference (~old + new, RFC1624) between
+ *   two header fields of the same even length, for later use with
+ *   nat_chksum_apply.
+ *
+ * Input Parameters:
+ *   optr - The old value of the field (in network byte order).
+ *   nptr - The new value of the field (in network byte order).
+ *   len  - The length of the field in bytes, must be even.
+ *
+ ****************************************************************************/
+
+static inline uint16_t nat_chksum_delta(FAR const void *optr,
+                                        FAR const void *nptr, int len)
+{
+  FAR const uint16_t *o = optr;
+  FAR const uint16_t *n = nptr;
+  uint32_t sum = 0;
+
+  for (; len > 1; len -= 2)
+    {
+      sum += (uint16_t)~NTOHS(*o++);
+      sum += NTOHS(*n++);
+    }
+
+  return nat_chksum_fold(sum);
+}
+
+/****************************************************************************
+ * Name: nat_chksum_apply
+ *
+ * Description:
+ *   Update a checksum in a header with a precomputed delta, using
+ *   HC' = ~(~HC + delta) (RFC1624, Eqn. 3).
+ *
+ ****************************************************************************/
+
+static inline void nat_chksum_apply(FAR uint16_t *chksum, uint16_t delta)
+{
+  uint32_t sum = (uint16_t)~NTOHS(*chksum);
+
+  *chksum = HTONS((uint16_t)~nat_chksum_fold(sum + delta));
+}
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -402,6 +512,85 @@ ipv6_nat_outbound_entry_find(FAR struct net_driver_s *dev, uint8_t protocol,
                              uint16_t peer_port, bool try_create);
 #endif
 
+/****************************************************************************
+ * Name: ipv4_nat_stats
+ *
+ * Description:
+ *   Get a snapshot of the NAT44 table statistics.
+ *
+ * Input Parameters:
+ *   stats - The location to return the statistics.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_NAT44
+void ipv4_nat_stats(FAR struct ipv4_nat_stats_s *stats);
+#endif
+
+/****************************************************************************
+ * Name: ipv4_nat_block_alloc
+ *
+ * Description:
+ *   Allocate an external TCP/UDP port for a local host from the port
+ *   blocks reserved for that host, reserving a new block if needed.
+ *
+ * Input Parameters:
+ *   protocol      - The L4 protocol, IP_PROTO_TCP or IP_PROTO_UDP.
+ *   local_ip      - The local host owning the port.
+ *   external_port - The selected external port (in network byte order).
+ *
+ * Returned Value:
+ *   The owner of the port to pass to ipv4_nat_block_free on success;
+ *   NULL if the host has used up its blocks or no block is left.
+ *
+ * Assumptions:
+ *   The caller holds the NAT lock.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+FAR struct ipv4_nat_host_s *
+ipv4_nat_block_alloc(uint8_t protocol, in_addr_t local_ip,
+                     FAR uint16_t *external_port);
+
+/****************************************************************************
+ * Name: ipv4_nat_block_free
+ *
+ * Description:
+ *   Release an external port allocated by ipv4_nat_block_alloc.  Blocks
+ *   without ports in use are returned to the global pool, and the host is
+ *   forgotten once it owns no block.
+ *
+ * Assumptions:
+ *   The caller holds the NAT lock.
+ *
+ ****************************************************************************/
+
+void ipv4_nat_block_free(FAR struct ipv4_nat_host_s *host,
+                         uint8_t protocol, uint16_t external_port);
+
+/****************************************************************************
+ * Name: ipv4_nat_block_inuse
+ *
+ * Description:
+ *   Check whether a port (in network byte order) lies in a block reserved
+ *   for some local host.
+ *
+ ****************************************************************************/
+
+bool ipv4_nat_block_inuse(uint16_t port);
+
+/****************************************************************************
+ * Name: ipv4_nat_block_stats
+ *
+ * Description:
+ *   Fill in the port block part of the NAT44 statistics.
+ *
+ ****************************************************************************/
+
+void ipv4_nat_block_stats(FAR struct ipv4_nat_stats_s *stats);
+#endif
+
 /****************************************************************************
  * Name: nat_lock
  *
@@ -0,0 +1,200 @@
+/****************************************************************************
+ * net/procfs/net_conntrack.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <nuttx/debug.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <nuttx/net/net.h>
+
+#include "ipfilter/ipfilter.h"
+#include "procfs/procfs.h"
+
+#ifdef CONFIG_NET_IPFILTER_CONNTRACK
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPv6
+#  define CONNTRACK_LINELEN 200
+#else
+#  define CONNTRACK_LINELEN 120
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct netprocfs_conntrack_s
+{
+  FAR struct netprocfs_file_s *priv;
+  FAR char *buffer;
+  size_t buflen;
+  size_t len;
+  int skip;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static FAR const char *g_tcpstate_names[] =
+{
+  "NONE",
+  "SYN_SENT",
+  "SYN_RECV",
+  "ESTABLISHED",
+  "FIN_WAIT",
+  "TIME_WAIT",
+  "CLOSE"
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static FAR const char *netprocfs_ct_proto(uint8_t proto)
+{
+  switch (proto)
+    {
+      case IP_PROTO_TCP:
+        return "tcp";
+
+      case IP_PROTO_UDP:
+        return "udp";
+
+      case IP_PROTO_ICMP:
+        return "icmp";
+
+      case IP_PROTO_ICMP6:
+        return "icmpv6";
+
+      default:
+        return "unknown";
+    }
+}
+
+static int netprocfs_ct_entry(FAR struct ipfilter_ct_entry_s *ct,
+                              int32_t timeout, FAR void *arg)
+{
+  FAR struct netprocfs_conntrack_s *info = arg;
+  char line[CONNTRACK_LINELEN];
+  char src[INET6_ADDRSTRLEN];
+  char dst[INET6_ADDRSTRLEN];
+  size_t len;
+
+  if (++info->skip <= info->priv->offset)
+    {
+      return 0;
+    }
+
+  len = snprintf(line, sizeof(line),
+                 "%-4s %-6s %-11s %6" PRId32
+                 " src=%s dst=%s sport=%" PRIu16 " dport=%" PRIu16
+                 " packets=%" PRIu32 "/%" PRIu32 "%s%s\n",
+                 ct->family == PF_INET ? "ipv4" : "ipv6",
+                 netprocfs_ct_proto(ct->proto),
+                 g_tcpstate_names[ct->tcpstate], timeout,
+                 inet_ntop(ct->family, &ct->src, src, sizeof(src)),
+                 inet_ntop(ct->family, &ct->dst, dst, sizeof(dst)),
+                 ntohs(ct->sport), ntohs(ct->dport),
+                 ct->packets[IPFILTER_CT_DIR_ORIGINAL],
+                 ct->packets[IPFILTER_CT_DIR_REPLY],
+                 ct->replied ? "" : " [UNREPLIED]",
+                 ct->forward ? " [FORWARD]" : "");
+  len = MIN(len, sizeof(line) - 1);
+
+  /* Stop when the line does not fit, the next read starts with it.  A
+   * buffer too small for even one line gets the line truncated, so that
+   * the reader does not mistake an empty read for the end of the table.
+   */
+
+  if (info->buflen - info->len < len)
+    {
+      if (info->len > 0)
+        {
+          return 1;
+        }
+
+      len = info->buflen;
+    }
+
+  memcpy(info->buffer + info->len, line, len);
+  info->len += len;
+  info->priv->offset++;
+  return 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: netprocfs_read_conntrack
+ *
+ * Description:
+ *   Read and format the connection tracking table.
+ *
+ * Input Parameters:
+ *   priv - A reference to the network procfs file structure
+ *   buffer - The user-provided buffer into which network status will be
+ *            returned.
+ *   bulen  - The size in bytes of the user provided buffer.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned
+ *   on failure.
+ *
+ ****************************************************************************/
+
+ssize_t netprocfs_read_conntrack(FAR struct netprocfs_file_s *priv,
+                                 FAR char *buffer, size_t buflen)
+{
+  struct netprocfs_conntrack_s info;
+
+  info.priv   = priv;
+  info.buffer = buffer;
+  info.buflen = buflen;
+  info.len    = 0;
+  info.skip   = 0;
+
+  net_lock();
+  ipfilter_conntrack_foreach(netprocfs_ct_entry, &info);
+  net_unlock();
+
+  return info.len;
+}
+
+#endif /* CONFIG_NET_IPFILTER_CONNTRACK */
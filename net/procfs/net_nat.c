@@ -0,0 +1,108 @@
+/****************************************************************************
+ * net/procfs/net_nat.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <nuttx/debug.h>
+
+#include <nuttx/net/net.h>
+
+#include "nat/nat.h"
+#include "procfs/procfs.h"
+
+#ifdef CONFIG_NET_NAT44
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: netprocfs_read_nat
+ *
+ * Description:
+ *   Read and format the NAT44 table statistics.
+ *
+ * Input Parameters:
+ *   priv - A reference to the network procfs file structure
+ *   buffer - The user-provided buffer into which network status will be
+ *            returned.
+ *   bulen  - The size in bytes of the user provided buffer.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned
+ *   on failure.
+ *
+ ****************************************************************************/
+
+ssize_t netprocfs_read_nat(FAR struct netprocfs_file_s *priv,
+                           FAR char *buffer, size_t buflen)
+{
+  struct ipv4_nat_stats_s stats;
+  int len;
+
+  /* The statistics are reported at once, nothing is left after that. */
+
+  if (priv->offset > 0)
+    {
+      return 0;
+    }
+
+  ipv4_nat_stats(&stats);
+
+  len = snprintf(buffer, buflen,
+                 "entries: %" PRIu32 "\n"
+                 "peak:    %" PRIu32 "\n"
+                 "created: %" PRIu32 "\n"
+                 "expired: %" PRIu32 "\n"
+                 "evicted: %" PRIu32 "\n"
+                 "failed:  %" PRIu32 "\n",
+                 stats.entries, stats.peak, stats.created,
+                 stats.expired, stats.evicted, stats.failed);
+
+#ifdef CONFIG_NET_NAT44_PORT_BLOCK
+  if (len > 0 && (size_t)len < buflen)
+    {
+      len += snprintf(buffer + len, buflen - len,
+                      "hosts:   %" PRIu32 "\n"
+                      "blocks:  %" PRIu32 "\n",
+                      stats.hosts, stats.blocks);
+    }
+#endif
+
+  if (len < 0 || (size_t)len >= buflen)
+    {
+      return -ENOSPC;
+    }
+
+  priv->offset = len;
+  return len;
+}
+
+#endif /* CONFIG_NET_NAT44 */
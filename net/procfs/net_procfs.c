@@ -139,6 +139,22 @@ static const struct netprocfs_entry_s g_net_entries[] =
   },
 #  endif
 #endif
+#ifdef CONFIG_NET_IPFILTER_CONNTRACK
+  {
+    DTYPE_FILE, "conntrack",
+    {
+      netprocfs_read_conntrack
+    }
+  },
+#endif
+#ifdef CONFIG_NET_NAT44
+  {
+    DTYPE_FILE, "nat",
+    {
+      netprocfs_read_nat
+    }
+  },
+#endif
 #ifdef CONFIG_NET_ROUTE
   {
     DTYPE_DIRECTORY, "route",
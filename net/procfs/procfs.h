@@ -61,7 +61,7 @@ struct netprocfs_file_s
   FAR struct net_driver_s *dev;      /* Current network device */
   uint8_t lineno;                    /* Line number */
   uint8_t linesize;                  /* Number of valid characters in line[] */
-  uint8_t offset;                    /* Offset to first valid character in line[] */
+  uint16_t offset;                   /* Offset to first valid character in line[] */
   uint8_t entry;                     /* Entry index of netprocfs_entry_s */
   char line[NET_LINELEN];            /* Pre-allocated buffer for formatted lines */
 };
@@ -213,6 +213,52 @@ ssize_t netprocfs_read_udpstats(FAR struct netprocfs_file_s *priv,
                                 FAR char *buffer, size_t buflen);
 #endif
 
+/****************************************************************************
+ * Name: netprocfs_read_conntrack
+ *
+ * Description:
+ *   Read and format the connection tracking table.
+ *
+ * Input Parameters:
+ *   priv - A reference to the network procfs file structure
+ *   buffer - The user-provided buffer into which network status will be
+ *            returned.
+ *   bulen  - The size in bytes of the user provided buffer.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned
+ *   on failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPFILTER_CONNTRACK
+ssize_t netprocfs_read_conntrack(FAR struct netprocfs_file_s *priv,
+                                 FAR char *buffer, size_t buflen);
+#endif
+
+/****************************************************************************
+ * Name: netprocfs_read_nat
+ *
+ * Description:
+ *   Read and format the NAT44 table statistics.
+ *
+ * Input Parameters:
+ *   priv - A reference to the network procfs file structure
+ *   buffer - The user-provided buffer into which network status will be
+ *            returned.
+ *   bulen  - The size in bytes of the user provided buffer.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned
+ *   on failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_NAT44
+ssize_t netprocfs_read_nat(FAR struct netprocfs_file_s *priv,
+                           FAR char *buffer, size_t buflen);
+#endif
+
 /****************************************************************************
  * Name: netprocfs_read_routes
  *
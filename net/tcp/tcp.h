@@ -114,6 +114,20 @@
 
 #endif
 
+#ifdef CONFIG_NET_TCP_FASTOPEN
+/* The TCP flags for TCP Fast Open */
+
+#define TCP_TFO               0x20U /* Fast Open enabled on the socket */
+#define TCP_TFO_COOKIE        0x40U /* Send a Fast Open cookie in SYN-ACK */
+
+/* Length of the Fast Open cookies we generate, and the longest cookie
+ * accepted from a server (RFC 7413)
+ */
+
+#define TCP_FASTOPEN_COOKIE_LEN 8
+#define TCP_FASTOPEN_COOKIE_MAX 16
+#endif
+
 /* The Max Range count of TCP Selective ACKs */
 
 #define TCP_SACK_RANGES_MAX   4
@@ -127,6 +141,10 @@
 #define TCP_RTO_MAX 240 /* 120s,The unit is half a second */
 #define TCP_RTO_MIN 1   /* 0.5s */
 
+/* Number of hash buckets of the half-open connection table of a listener */
+
+#define TCP_REQSOCK_NBUCKETS 8
+
 /****************************************************************************
  * Public Type Definitions
  ****************************************************************************/
@@ -277,6 +295,14 @@ struct tcp_conn_s
   uint16_t tx_unacked;    /* Number bytes sent but not yet ACKed */
 #endif
   uint16_t flags;         /* Flags of TCP-specific options */
+#ifdef CONFIG_NET_TCP_FASTOPEN
+
+  /* Data to be sent in the SYN by a Fast Open client */
+
+  FAR const uint8_t *tfo_data;
+  uint16_t tfo_len;       /* Length of tfo_data not yet sent */
+  uint16_t tfo_sent;      /* Number of bytes sent (then ACKed) in the SYN */
+#endif
 #ifdef CONFIG_NET_SOLINGER
   clock_t ltimeout;       /* Linger timeout expiration */
 #endif
@@ -431,13 +457,61 @@ struct tcp_blcontainer_s
   FAR struct tcp_conn_s *bc_conn; /* Holds reference to the new connection structure */
 };
 
+#if defined(CONFIG_NET_TCP_REQSOCK) || defined(CONFIG_NET_TCP_SYNCOOKIES)
+/* struct tcp_reqsock_s describes one half-open connection of a listener:
+ * the SYN has been received and the SYN-ACK sent, but no connection
+ * structure has been allocated yet.  It is also used to carry the state
+ * decoded from a SYN cookie.
+ */
+
+struct tcp_reqsock_s
+{
+  sq_entry_t rs_node;             /* Hash chain or free list link */
+  union ip_binding_u rs_u;        /* Local and remote addresses */
+  clock_t    rs_expire;           /* Time when the request is discarded */
+  uint32_t   rs_irs;              /* Initial receive sequence (peer's ISN) */
+  uint32_t   rs_iss;              /* Initial send sequence (our ISN) */
+  uint16_t   rs_rport;            /* Remote port (network order) */
+  uint16_t   rs_mss;              /* MSS offered by the peer (0: none) */
+  uint8_t    rs_domain;           /* PF_INET or PF_INET6 */
+  uint8_t    rs_flags;            /* TCP_WSCALE, TCP_SACK, TCP_TFO_COOKIE */
+  uint8_t    rs_snd_scale;        /* Peer window scale factor */
+};
+#endif
+
 struct tcp_backlog_s
 {
   sq_queue_t bl_free;             /* Implements a singly-linked list of free containers */
   sq_queue_t bl_pending;          /* Implements a singly-linked list of pending connections */
+#ifdef CONFIG_NET_TCP_REQSOCK
+  sq_queue_t bl_reqfree;          /* Free request structures */
+
+  /* Half-open requests hashed by remote address and port */
+
+  sq_queue_t bl_synq[TCP_REQSOCK_NBUCKETS];
+#endif
 };
 #endif
 
+/* struct tcp_options_s holds the options of a received segment as decoded
+ * by tcp_option_decode(), for the connection, the request socket or the
+ * Fast Open code to pick what applies to them.
+ */
+
+#define TCP_OPTF_MSS     (1 << 0) /* MSS option present */
+#define TCP_OPTF_WS      (1 << 1) /* Window scale option present */
+#define TCP_OPTF_SACK    (1 << 2) /* SACK permitted option present */
+#define TCP_OPTF_TFO     (1 << 3) /* Fast Open option present */
+
+struct tcp_options_s
+{
+  uint8_t    flags;               /* See TCP_OPTF_* definitions */
+  uint8_t    snd_scale;           /* Peer window scale factor */
+  uint16_t   mss;                 /* MSS offered by the peer */
+  FAR const uint8_t *tfo_cookie;  /* Fast Open cookie */
+  uint8_t    tfo_len;             /* Fast Open cookie length (0: request) */
+};
+
 struct tcp_callback_s
 {
   FAR struct tcp_conn_s *tc_conn;
@@ -940,6 +1014,21 @@ uint32_t tcp_getsequence(FAR uint8_t *seqno);
 
 uint32_t tcp_addsequence(FAR uint8_t *seqno, uint16_t len);
 
+/****************************************************************************
+ * Name: tcp_isn
+ *
+ * Description:
+ *   Return the initial sequence number for the connection described by the
+ *   address binding and the ports (network order).
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+uint32_t tcp_isn(FAR const union ip_binding_u *u, uint8_t domain,
+                 uint16_t lport, uint16_t rport);
+
 /****************************************************************************
  * Name: tcp_initsequence
  *
@@ -1278,6 +1367,34 @@ uint16_t tcp_rx_mss(FAR struct net_driver_s *dev);
 void tcp_synack(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
                 uint8_t ack);
 
+/****************************************************************************
+ * Name: tcp_synack_stateless
+ *
+ * Description:
+ *   Answer the SYN in the device buffer with a SYN-ACK without any
+ *   connection structure.  The reply is built in place, like tcp_reset().
+ *
+ * Input Parameters:
+ *   dev      - The device driver structure holding the received SYN
+ *   listener - The listening connection
+ *   iss      - Our initial sequence number
+ *   flags    - TCP_WSCALE, TCP_SACK and/or TCP_TFO_COOKIE if these options
+ *              are to be sent
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_NET_TCP_REQSOCK) || defined(CONFIG_NET_TCP_SYNCOOKIES)
+void tcp_synack_stateless(FAR struct net_driver_s *dev,
+                          FAR struct tcp_conn_s *listener,
+                          uint32_t iss, uint8_t flags);
+#endif
+
 /****************************************************************************
  * Name: tcp_appsend
  *
@@ -1343,6 +1460,28 @@ void tcp_rexmit(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
 void tcp_send_txnotify(FAR struct socket *psock,
                        FAR struct tcp_conn_s *conn);
 
+/****************************************************************************
+ * Name: tcp_option_decode
+ *
+ * Description:
+ *   Decode the options of the TCP segment in the device buffer.
+ *
+ * Input Parameters:
+ *   dev   - The device driver structure containing the received segment
+ *   iplen - Length of the IP header (IPv4_HDRLEN or IPv6_HDRLEN)
+ *   opts  - Location to return the options
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+void tcp_option_decode(FAR struct net_driver_s *dev, unsigned int iplen,
+                       FAR struct tcp_options_s *opts);
+
 /****************************************************************************
  * Name: tcp_ipv4_input
  *
@@ -1578,6 +1717,272 @@ int tcp_backlogdelete(FAR struct tcp_conn_s *conn,
 #  define tcp_backlogdelete(c,b) (-ENOSYS)
 #endif
 
+/****************************************************************************
+ * Name: tcp_reqsock_syn
+ *
+ * Description:
+ *   Handle a SYN received on a listener with a backlog: remember the
+ *   half-open connection in the request table of the backlog (or, if the
+ *   table or the backlog is full, encode it in a SYN cookie) and prepare
+ *   the SYN-ACK in the device buffer.
+ *
+ * Input Parameters:
+ *   dev      - The device driver structure holding the received SYN
+ *   listener - The listening connection
+ *   iplen    - Length of the IP header
+ *
+ * Returned Value:
+ *   OK if a SYN-ACK is ready to be sent; a negated errno value if the SYN
+ *   must be dropped.
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_REQSOCK
+int tcp_reqsock_syn(FAR struct net_driver_s *dev,
+                    FAR struct tcp_conn_s *listener, unsigned int iplen);
+#endif
+
+/****************************************************************************
+ * Name: tcp_reqsock_ack
+ *
+ * Description:
+ *   Handle an ACK received on a listener: if it completes a half-open
+ *   connection (or carries a valid SYN cookie), allocate the connection
+ *   structure in the TCP_SYN_RCVD state, ready to be moved to ESTABLISHED
+ *   by the normal input processing.
+ *
+ * Input Parameters:
+ *   dev      - The device driver structure holding the received ACK
+ *   listener - The listening connection
+ *   iplen    - Length of the IP header
+ *   newconn  - Location to return the new connection
+ *
+ * Returned Value:
+ *   OK on success; -ENOENT if the ACK matches no half-open connection (a
+ *   reset should be sent); any other negated errno value if the ACK must
+ *   be dropped.
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_NET_TCP_REQSOCK) || defined(CONFIG_NET_TCP_SYNCOOKIES)
+int tcp_reqsock_ack(FAR struct net_driver_s *dev,
+                    FAR struct tcp_conn_s *listener, unsigned int iplen,
+                    FAR struct tcp_conn_s **newconn);
+#endif
+
+/****************************************************************************
+ * Name: tcp_syncookie_synack
+ *
+ * Description:
+ *   Answer a SYN that cannot be queued with a SYN cookie SYN-ACK.
+ *
+ * Input Parameters:
+ *   dev      - The device driver structure holding the received SYN
+ *   listener - The listening connection
+ *   iplen    - Length of the IP header
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_SYNCOOKIES
+void tcp_syncookie_synack(FAR struct net_driver_s *dev,
+                          FAR struct tcp_conn_s *listener,
+                          unsigned int iplen);
+
+/****************************************************************************
+ * Name: tcp_syncookie_make
+ *
+ * Description:
+ *   Generate the SYN cookie (our initial sequence number) for a connection.
+ *
+ * Input Parameters:
+ *   u      - Local and remote addresses
+ *   domain - PF_INET or PF_INET6
+ *   lport  - Local port (network order)
+ *   rport  - Remote port (network order)
+ *   irs    - Initial sequence number of the peer
+ *   mss    - In: MSS offered by the peer.  Out: MSS encoded in the cookie
+ *
+ * Returned Value:
+ *   The cookie.
+ *
+ ****************************************************************************/
+
+uint32_t tcp_syncookie_make(FAR const union ip_binding_u *u, uint8_t domain,
+                            uint16_t lport, uint16_t rport, uint32_t irs,
+                            FAR uint16_t *mss);
+
+/****************************************************************************
+ * Name: tcp_syncookie_check
+ *
+ * Description:
+ *   Validate a SYN cookie returned by the peer in its ACK.
+ *
+ * Input Parameters:
+ *   u      - Local and remote addresses
+ *   domain - PF_INET or PF_INET6
+ *   lport  - Local port (network order)
+ *   rport  - Remote port (network order)
+ *   irs    - Initial sequence number of the peer (the ACK sequence - 1)
+ *   cookie - The cookie (the acknowledgement number of the ACK - 1)
+ *
+ * Returned Value:
+ *   The MSS encoded in the cookie, or zero if the cookie is not valid.
+ *
+ ****************************************************************************/
+
+uint16_t tcp_syncookie_check(FAR const union ip_binding_u *u,
+                             uint8_t domain, uint16_t lport, uint16_t rport,
+                             uint32_t irs, uint32_t cookie);
+#endif
+
+#ifdef CONFIG_NET_TCP_FASTOPEN
+/****************************************************************************
+ * Name: tcp_fastopen_option
+ *
+ * Description:
+ *   Build the Fast Open option of a SYN or SYN-ACK sent on a connection.
+ *   A client SYN carries the cookie cached for the server, or an empty
+ *   cookie request; a server SYN-ACK carries the cookie of the client.
+ *   A client that holds no cookie gives up the data of the SYN.
+ *
+ * Input Parameters:
+ *   conn    - The TCP connection in the SYN_SENT or SYN_RCVD state
+ *   optdata - Where the option is written
+ *
+ * Returned Value:
+ *   The length of the option, padded to a multiple of four bytes.
+ *
+ ****************************************************************************/
+
+int tcp_fastopen_option(FAR struct tcp_conn_s *conn, FAR uint8_t *optdata);
+
+/****************************************************************************
+ * Name: tcp_fastopen_peeroption
+ *
+ * Description:
+ *   Build the Fast Open option of a SYN-ACK built in place from a SYN,
+ *   with the cookie of the source address of the SYN.
+ *
+ * Input Parameters:
+ *   dev     - The device driver structure holding the received SYN
+ *   optdata - Where the option is written
+ *
+ * Returned Value:
+ *   The length of the option, padded to a multiple of four bytes.
+ *
+ ****************************************************************************/
+
+int tcp_fastopen_peeroption(FAR struct net_driver_s *dev,
+                            FAR uint8_t *optdata);
+
+/****************************************************************************
+ * Name: tcp_fastopen_syndata
+ *
+ * Description:
+ *   Append the data to be sent in the SYN of a client to the packet being
+ *   built in the device buffer.
+ *
+ * Input Parameters:
+ *   dev  - The device driver structure holding the SYN
+ *   conn - The TCP connection in the SYN_SENT state
+ *
+ * Returned Value:
+ *   The number of bytes appended.
+ *
+ ****************************************************************************/
+
+uint16_t tcp_fastopen_syndata(FAR struct net_driver_s *dev,
+                              FAR struct tcp_conn_s *conn);
+
+/****************************************************************************
+ * Name: tcp_fastopen_cache
+ *
+ * Description:
+ *   Remember the cookie received from a server in its SYN-ACK.
+ *
+ * Input Parameters:
+ *   conn   - The TCP connection in the SYN_SENT state
+ *   cookie - The cookie
+ *   len    - The length of the cookie
+ *
+ ****************************************************************************/
+
+void tcp_fastopen_cache(FAR struct tcp_conn_s *conn,
+                        FAR const uint8_t *cookie, unsigned int len);
+
+/****************************************************************************
+ * Name: tcp_fastopen_connected
+ *
+ * Description:
+ *   Account for the data of the SYN acknowledged by the SYN-ACK of the
+ *   server.  Data that was not acknowledged is sent again after the
+ *   connection is established.
+ *
+ * Input Parameters:
+ *   conn   - The TCP connection leaving the SYN_SENT state
+ *   ackseq - The acknowledgement number of the SYN-ACK
+ *
+ ****************************************************************************/
+
+void tcp_fastopen_connected(FAR struct tcp_conn_s *conn, uint32_t ackseq);
+
+/****************************************************************************
+ * Name: tcp_fastopen_syn
+ *
+ * Description:
+ *   Check the Fast Open option of a SYN received by a listener.
+ *
+ * Input Parameters:
+ *   dev      - The device driver structure holding the received SYN
+ *   listener - The listening connection
+ *   iplen    - Length of the IP header
+ *
+ * Returned Value:
+ *   TCP_TFO if the SYN carries data and a valid cookie, TCP_TFO_COOKIE if
+ *   a cookie is to be sent in the SYN-ACK, zero otherwise.
+ *
+ ****************************************************************************/
+
+int tcp_fastopen_syn(FAR struct net_driver_s *dev,
+                     FAR struct tcp_conn_s *listener, unsigned int iplen);
+
+/****************************************************************************
+ * Name: psock_tcp_fastopen
+ *
+ * Description:
+ *   Implements sendto() with MSG_FASTOPEN: connect the socket and send the
+ *   data, in the SYN if a cookie for the server is known.
+ *
+ * Input Parameters:
+ *   psock - An instance of the internal socket structure.
+ *   buf   - Data to send
+ *   len   - Length of data to send
+ *   flags - Send flags
+ *   to    - Address of the server
+ *   tolen - The length of the address structure
+ *
+ * Returned Value:
+ *   The number of bytes sent on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t psock_tcp_fastopen(FAR struct socket *psock, FAR const void *buf,
+                           size_t len, int flags,
+                           FAR const struct sockaddr *to, socklen_t tolen);
+#endif
+
 /****************************************************************************
  * Name: tcp_accept
  *
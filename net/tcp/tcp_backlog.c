@@ -60,6 +60,10 @@ int tcp_backlogcreate(FAR struct tcp_conn_s *conn, int nblg)
 {
   FAR struct tcp_backlog_s     *bls = NULL;
   FAR struct tcp_blcontainer_s *blc;
+#ifdef CONFIG_NET_TCP_REQSOCK
+  FAR struct tcp_reqsock_s     *rs;
+  int rsoffset;
+#endif
   int size;
   int offset;
   int i;
@@ -98,6 +102,14 @@ int tcp_backlogcreate(FAR struct tcp_conn_s *conn, int nblg)
 
       size = offset + nblg * sizeof(struct tcp_blcontainer_s);
 
+#ifdef CONFIG_NET_TCP_REQSOCK
+      /* Followed by the pre-allocated half-open request structures */
+
+      rsoffset = (size + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1);
+      size     = rsoffset +
+                 CONFIG_NET_TCP_REQSOCK_NUM * sizeof(struct tcp_reqsock_s);
+#endif
+
       /* Then allocate that much */
 
       bls = kmm_zalloc(size);
@@ -115,6 +127,15 @@ int tcp_backlogcreate(FAR struct tcp_conn_s *conn, int nblg)
           sq_addfirst(&blc->bc_node, &bls->bl_free);
           blc++;
         }
+
+#ifdef CONFIG_NET_TCP_REQSOCK
+      rs = (FAR struct tcp_reqsock_s *)(((FAR uint8_t *)bls) + rsoffset);
+      for (i = 0; i < CONFIG_NET_TCP_REQSOCK_NUM; i++)
+        {
+          sq_addfirst(&rs->rs_node, &bls->bl_reqfree);
+          rs++;
+        }
+#endif
     }
 
   /* Destroy any existing backlog (shouldn't be any) */
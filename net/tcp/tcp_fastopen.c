@@ -0,0 +1,500 @@
+/****************************************************************************
+ * net/tcp/tcp_fastopen.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#if defined(CONFIG_NET) && defined(CONFIG_NET_TCP) && \
+    defined(CONFIG_NET_TCP_FASTOPEN)
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <nuttx/debug.h>
+
+#include <crypto/siphash.h>
+#include <nuttx/mm/iob.h>
+#include <nuttx/net/net.h>
+#include <nuttx/net/netconfig.h>
+#include <nuttx/net/netdev.h>
+#include <nuttx/net/ip.h>
+#include <nuttx/net/tcp.h>
+
+#include "tcp/tcp.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define IPDATA(hl) (*(FAR uint8_t *)IPBUF(hl))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A cookie received from a server */
+
+struct tcp_fastopen_cache_s
+{
+  union ip_addr_u addr;           /* Address of the server */
+  uint8_t domain;                 /* PF_INET or PF_INET6 (0: unused) */
+  uint8_t len;                    /* Length of the cookie */
+  uint8_t cookie[TCP_FASTOPEN_COOKIE_MAX];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static SIPHASH_KEY g_fastopen_key;
+
+/* Client cookie cache, replaced round robin */
+
+static struct tcp_fastopen_cache_s
+  g_fastopen_cache[CONFIG_NET_TCP_FASTOPEN_CACHE_SIZE];
+static unsigned int g_fastopen_next;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_fastopen_cookie
+ *
+ * Description:
+ *   Generate the cookie of a client: a keyed hash of its address.
+ *
+ ****************************************************************************/
+
+static void tcp_fastopen_cookie(FAR const void *raddr, size_t addrlen,
+                                FAR uint8_t *cookie)
+{
+  SIPHASH_CTX ctx;
+  uint64_t hash;
+
+  /* Make sure we have a secret key */
+
+  if (g_fastopen_key.k0 == 0 && g_fastopen_key.k1 == 0)
+    {
+      arc4random_buf(&g_fastopen_key, sizeof(g_fastopen_key));
+    }
+
+  siphash_init(&ctx, &g_fastopen_key);
+  siphash_update(&ctx, 2, 4, raddr, addrlen);
+  hash = siphash_finish(&ctx, 2, 4);
+
+  memcpy(cookie, &hash, TCP_FASTOPEN_COOKIE_LEN);
+}
+
+/****************************************************************************
+ * Name: tcp_fastopen_peercookie
+ *
+ * Description:
+ *   Generate the cookie of the source address of the packet in the device
+ *   buffer.
+ *
+ ****************************************************************************/
+
+static void tcp_fastopen_peercookie(FAR struct net_driver_s *dev,
+                                    FAR uint8_t *cookie)
+{
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  if (IFF_IS_IPv6(dev->d_flags))
+#endif
+    {
+      tcp_fastopen_cookie(IPv6BUF->srcipaddr, sizeof(net_ipv6addr_t),
+                          cookie);
+    }
+#endif /* CONFIG_NET_IPv6 */
+
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+  else
+#endif
+    {
+      in_addr_t raddr = net_ip4addr_conv32(IPv4BUF->srcipaddr);
+
+      tcp_fastopen_cookie(&raddr, sizeof(raddr), cookie);
+    }
+#endif /* CONFIG_NET_IPv4 */
+}
+
+/****************************************************************************
+ * Name: tcp_fastopen_putopt
+ *
+ * Description:
+ *   Write a Fast Open option, preceded by the NOOPs needed to end it on a
+ *   32-bit boundary.
+ *
+ ****************************************************************************/
+
+static int tcp_fastopen_putopt(FAR uint8_t *optdata,
+                               FAR const uint8_t *cookie, unsigned int len)
+{
+  int optlen = 0;
+
+  while (((TCP_OPT_FASTOPEN_LEN + len + optlen) & 3) != 0)
+    {
+      optdata[optlen++] = TCP_OPT_NOOP;
+    }
+
+  optdata[optlen++] = TCP_OPT_FASTOPEN;
+  optdata[optlen++] = TCP_OPT_FASTOPEN_LEN + len;
+  memcpy(&optdata[optlen], cookie, len);
+
+  return optlen + len;
+}
+
+/****************************************************************************
+ * Name: tcp_fastopen_lookup
+ *
+ * Description:
+ *   Find the cached cookie of a server.
+ *
+ ****************************************************************************/
+
+static FAR struct tcp_fastopen_cache_s *
+tcp_fastopen_lookup(uint8_t domain, FAR const void *raddr, size_t addrlen)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_NET_TCP_FASTOPEN_CACHE_SIZE; i++)
+    {
+      FAR struct tcp_fastopen_cache_s *entry = &g_fastopen_cache[i];
+
+      if (entry->domain == domain &&
+          memcmp(&entry->addr, raddr, addrlen) == 0)
+        {
+          return entry;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_fastopen_option
+ *
+ * Description:
+ *   Build the Fast Open option of a SYN or SYN-ACK sent on a connection.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+int tcp_fastopen_option(FAR struct tcp_conn_s *conn, FAR uint8_t *optdata)
+{
+  uint8_t domain = net_ip_domain_select(conn->domain, PF_INET, PF_INET6);
+  size_t addrlen = net_ip_domain_select(domain, sizeof(in_addr_t),
+                                        sizeof(net_ipv6addr_t));
+  FAR const void *raddr = net_ip_binding_raddr(&conn->u, domain);
+  FAR struct tcp_fastopen_cache_s *entry;
+  uint8_t cookie[TCP_FASTOPEN_COOKIE_LEN];
+
+  if ((conn->tcpstateflags & TCP_STATE_MASK) == TCP_SYN_SENT)
+    {
+      if ((conn->flags & TCP_TFO) == 0)
+        {
+          return 0;
+        }
+
+      entry = tcp_fastopen_lookup(domain, raddr, addrlen);
+      if (entry == NULL)
+        {
+          /* Request a cookie.  The data will be sent once the connection
+           * is established.
+           */
+
+          conn->tfo_len = 0;
+          return tcp_fastopen_putopt(optdata, NULL, 0);
+        }
+
+      return tcp_fastopen_putopt(optdata, entry->cookie, entry->len);
+    }
+
+  if ((conn->flags & TCP_TFO_COOKIE) == 0)
+    {
+      return 0;
+    }
+
+  tcp_fastopen_cookie(raddr, addrlen, cookie);
+  return tcp_fastopen_putopt(optdata, cookie, sizeof(cookie));
+}
+
+/****************************************************************************
+ * Name: tcp_fastopen_peeroption
+ *
+ * Description:
+ *   Build the Fast Open option of a SYN-ACK built in place from a SYN.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+int tcp_fastopen_peeroption(FAR struct net_driver_s *dev,
+                            FAR uint8_t *optdata)
+{
+  uint8_t cookie[TCP_FASTOPEN_COOKIE_LEN];
+
+  tcp_fastopen_peercookie(dev, cookie);
+  return tcp_fastopen_putopt(optdata, cookie, sizeof(cookie));
+}
+
+/****************************************************************************
+ * Name: tcp_fastopen_syndata
+ *
+ * Description:
+ *   Append the data to be sent in the SYN of a client to the packet being
+ *   built in the device buffer.  Only the first SYN carries data; if it is
+ *   lost, the data is sent after the handshake.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+uint16_t tcp_fastopen_syndata(FAR struct net_driver_s *dev,
+                              FAR struct tcp_conn_s *conn)
+{
+  int space;
+  int len;
+
+  /* The MSS of the server is not known yet, stay within our initial MSS
+   * which is what any peer must accept.
+   */
+
+  space = conn->mss - (dev->d_len - tcpip_hdrsize(conn));
+  len   = MIN(conn->tfo_len, space);
+
+  conn->tfo_len = 0;
+  if (len <= 0)
+    {
+      return 0;
+    }
+
+  len = iob_trycopyin(dev->d_iob, conn->tfo_data, len, dev->d_len, false);
+  if (len < 0)
+    {
+      nwarn("WARNING: Failed to copy %d bytes into the SYN\n", len);
+      return 0;
+    }
+
+  conn->tfo_sent = len;
+  return len;
+}
+
+/****************************************************************************
+ * Name: tcp_fastopen_cache
+ *
+ * Description:
+ *   Remember the cookie received from a server in its SYN-ACK.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+void tcp_fastopen_cache(FAR struct tcp_conn_s *conn,
+                        FAR const uint8_t *cookie, unsigned int len)
+{
+  uint8_t domain = net_ip_domain_select(conn->domain, PF_INET, PF_INET6);
+  size_t addrlen = net_ip_domain_select(domain, sizeof(in_addr_t),
+                                        sizeof(net_ipv6addr_t));
+  FAR const void *raddr = net_ip_binding_raddr(&conn->u, domain);
+  FAR struct tcp_fastopen_cache_s *entry;
+
+  if (len == 0 || len > TCP_FASTOPEN_COOKIE_MAX)
+    {
+      return;
+    }
+
+  entry = tcp_fastopen_lookup(domain, raddr, addrlen);
+  if (entry == NULL)
+    {
+      entry = &g_fastopen_cache[g_fastopen_next];
+      g_fastopen_next = (g_fastopen_next + 1) %
+                        CONFIG_NET_TCP_FASTOPEN_CACHE_SIZE;
+
+      memset(&entry->addr, 0, sizeof(entry->addr));
+      memcpy(&entry->addr, raddr, addrlen);
+      entry->domain = domain;
+    }
+
+  entry->len = len;
+  memcpy(entry->cookie, cookie, len);
+}
+
+/****************************************************************************
+ * Name: tcp_fastopen_connected
+ *
+ * Description:
+ *   Account for the data of the SYN acknowledged by the SYN-ACK of the
+ *   server.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+void tcp_fastopen_connected(FAR struct tcp_conn_s *conn, uint32_t ackseq)
+{
+  uint32_t acked = TCP_SEQ_SUB(ackseq, conn->rexmit_seq + 1);
+
+  /* The server may acknowledge the SYN only, the data is then sent again
+   * as ordinary data.
+   */
+
+  conn->tfo_sent = acked <= conn->tfo_sent ? acked : 0;
+  conn->tfo_data = NULL;
+  conn->tfo_len  = 0;
+
+  tcp_setsequence(conn->sndseq, conn->rexmit_seq + 1 + conn->tfo_sent);
+#ifdef CONFIG_NET_TCP_WRITE_BUFFERS
+  conn->sndseq_max = tcp_getsequence(conn->sndseq);
+#endif
+}
+
+/****************************************************************************
+ * Name: tcp_fastopen_syn
+ *
+ * Description:
+ *   Check the Fast Open option of a SYN received by a listener.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+int tcp_fastopen_syn(FAR struct net_driver_s *dev,
+                     FAR struct tcp_conn_s *listener, unsigned int iplen)
+{
+  FAR struct tcp_hdr_s *tcp = IPBUF(iplen);
+  unsigned int hdrlen = (tcp->tcpoffset >> 4) << 2;
+  uint8_t cookie[TCP_FASTOPEN_COOKIE_LEN];
+  struct tcp_options_s opts;
+
+  if ((listener->flags & TCP_TFO) == 0)
+    {
+      return 0;
+    }
+
+  tcp_option_decode(dev, iplen, &opts);
+  if ((opts.flags & TCP_OPTF_TFO) == 0)
+    {
+      return 0;
+    }
+
+  /* Accept the data only along with a valid cookie, otherwise hand out
+   * the cookie for the next connection.
+   */
+
+  if (opts.tfo_len == TCP_FASTOPEN_COOKIE_LEN &&
+      dev->d_len > iplen + hdrlen)
+    {
+      tcp_fastopen_peercookie(dev, cookie);
+      if (memcmp(cookie, opts.tfo_cookie, TCP_FASTOPEN_COOKIE_LEN) == 0)
+        {
+          return TCP_TFO;
+        }
+    }
+
+  return TCP_TFO_COOKIE;
+}
+
+/****************************************************************************
+ * Name: psock_tcp_fastopen
+ *
+ * Description:
+ *   Implements sendto() with MSG_FASTOPEN.  On a blocking socket the data
+ *   is attached to the SYN while connect() waits for the handshake; a
+ *   non-blocking socket only requests a cookie and returns -EINPROGRESS.
+ *
+ ****************************************************************************/
+
+ssize_t psock_tcp_fastopen(FAR struct socket *psock, FAR const void *buf,
+                           size_t len, int flags,
+                           FAR const struct sockaddr *to, socklen_t tolen)
+{
+  FAR struct tcp_conn_s *conn = psock->s_conn;
+  ssize_t sent;
+  ssize_t ret;
+
+  if (_SS_ISCONNECTED(conn->sconn.s_flags))
+    {
+      return -EISCONN;
+    }
+
+  net_lock();
+  conn->flags   |= TCP_TFO;
+  conn->tfo_sent = 0;
+  if (!_SS_ISNONBLOCK(conn->sconn.s_flags) && (flags & MSG_DONTWAIT) == 0)
+    {
+      conn->tfo_data = buf;
+      conn->tfo_len  = MIN(len, UINT16_MAX);
+    }
+
+  net_unlock();
+
+  ret = psock_connect(psock, to, tolen);
+
+  net_lock();
+  sent           = conn->tfo_sent;
+  conn->tfo_data = NULL;
+  conn->tfo_len  = 0;
+  conn->tfo_sent = 0;
+  net_unlock();
+
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* Send what the SYN did not carry */
+
+  if ((size_t)sent < len)
+    {
+      ret = psock_tcp_send(psock, (FAR const uint8_t *)buf + sent,
+                           len - sent, flags & ~MSG_FASTOPEN);
+      if (ret < 0)
+        {
+          return sent > 0 ? sent : ret;
+        }
+
+      sent += ret;
+    }
+
+  return sent;
+}
+
+#endif /* CONFIG_NET && CONFIG_NET_TCP && CONFIG_NET_TCP_FASTOPEN */
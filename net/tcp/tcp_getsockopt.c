@@ -240,6 +240,22 @@ int tcp_getsockopt(FAR struct socket *psock, int option,
           }
         break;
 
+#ifdef CONFIG_NET_TCP_FASTOPEN
+      case TCP_FASTOPEN: /* Fast Open enabled on a listener */
+        if (*value_len < sizeof(int))
+          {
+            ret          = -EINVAL;
+          }
+        else
+          {
+            FAR int *qlen = (FAR int *)value;
+            *qlen         = (conn->flags & TCP_TFO) != 0;
+            *value_len    = sizeof(int);
+            ret           = OK;
+          }
+        break;
+#endif
+
       default:
         nerr("ERROR: Unrecognized TCP option: %d\n", option);
         ret = -ENOPROTOOPT;
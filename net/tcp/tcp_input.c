@@ -531,7 +531,7 @@ prepare:
  * Name: tcp_parse_option
  *
  * Description:
- *   Parse incoming TCP options
+ *   Apply the options of an incoming segment to a connection
  *
  * Input Parameters:
  *   dev    - The device driver structure containing the received TCP packet.
@@ -550,90 +550,49 @@ static void tcp_parse_option(FAR struct net_driver_s *dev,
                              FAR struct tcp_conn_s *conn,
                              unsigned int iplen)
 {
-  FAR struct tcp_hdr_s *tcp;
-  unsigned int tcpiplen;
-  uint16_t tmp16;
-  uint8_t  opt;
-  int i;
-
-  tcp = IPBUF(iplen);
-
-  if ((tcp->tcpoffset & 0xf0) <= 0x50)
-    {
-      return;
-    }
+  struct tcp_options_s opts;
 
-  tcpiplen = iplen + TCP_HDRLEN;
+  tcp_option_decode(dev, iplen, &opts);
 
-  for (i = 0; i < ((tcp->tcpoffset >> 4) - 5) << 2 ; )
+  if ((opts.flags & TCP_OPTF_MSS) != 0)
     {
-      opt = IPDATA(tcpiplen + i);
-      if (opt == TCP_OPT_END)
-        {
-          /* End of options. */
+      uint16_t tcp_mss = TCP_MSS(dev, iplen);
 
-          break;
-        }
-      else if (opt == TCP_OPT_NOOP)
+#ifdef CONFIG_NET_TCPPROTO_OPTIONS
+      if (conn->user_mss > 0 && conn->user_mss < tcp_mss)
         {
-          /* NOP option. */
-
-          ++i;
-          continue;
+          tcp_mss = conn->user_mss;
         }
-      else if (opt == TCP_OPT_MSS &&
-               IPDATA(tcpiplen + 1 + i) == TCP_OPT_MSS_LEN)
-        {
-          uint16_t tcp_mss = TCP_MSS(dev, iplen);
-
-          /* An MSS option with the right option length. */
-
-          tmp16 = ((uint16_t)IPDATA(tcpiplen + 2 + i) << 8) |
-                   (uint16_t)IPDATA(tcpiplen + 3 + i);
-#ifdef CONFIG_NET_TCPPROTO_OPTIONS
-          if (conn->user_mss > 0 && conn->user_mss < tcp_mss)
-            {
-              tcp_mss = conn->user_mss;
-            }
 #endif
 
-          conn->mss = tmp16 > tcp_mss ? tcp_mss : tmp16;
-        }
+      conn->mss = opts.mss > tcp_mss ? tcp_mss : opts.mss;
+    }
+
 #ifdef CONFIG_NET_TCP_WINDOW_SCALE
-      else if (opt == TCP_OPT_WS &&
-               IPDATA(tcpiplen + 1 + i) == TCP_OPT_WS_LEN)
-        {
-          conn->snd_scale = IPDATA(tcpiplen + 2 + i);
-          conn->rcv_scale = CONFIG_NET_TCP_WINDOW_SCALE_FACTOR;
-          conn->flags    |= TCP_WSCALE;
-        }
+  if ((opts.flags & TCP_OPTF_WS) != 0)
+    {
+      conn->snd_scale = opts.snd_scale;
+      conn->rcv_scale = CONFIG_NET_TCP_WINDOW_SCALE_FACTOR;
+      conn->flags    |= TCP_WSCALE;
+    }
 #endif
+
 #ifdef CONFIG_NET_TCP_SELECTIVE_ACK
-      else if (opt == TCP_OPT_SACK_PERM &&
-               IPDATA(tcpiplen + 1 + i) ==
-               TCP_OPT_SACK_PERM_LEN)
-        {
-          conn->flags    |= TCP_SACK;
-        }
+  if ((opts.flags & TCP_OPTF_SACK) != 0)
+    {
+      conn->flags    |= TCP_SACK;
+    }
 #endif
-      else
-        {
-          /* All other options have a length field, so that we
-           * easily can skip past them.
-           */
 
-          if (IPDATA(tcpiplen + 1 + i) == 0)
-            {
-              /* If the length field is zero, the options are
-               * malformed and we don't process them further.
-               */
-
-              break;
-            }
-        }
+#ifdef CONFIG_NET_TCP_FASTOPEN
+  if ((opts.flags & TCP_OPTF_TFO) != 0 && opts.tfo_len > 0 &&
+      (conn->tcpstateflags & TCP_STATE_MASK) == TCP_SYN_SENT)
+    {
+      /* The cookie of the server for our next connections */
 
-      i += IPDATA(tcpiplen + 1 + i);
+      tcp_fastopen_cache(conn, opts.tfo_cookie, opts.tfo_len);
     }
+#endif
 }
 
 /****************************************************************************
@@ -693,6 +652,7 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
                       unsigned int iplen)
 {
   FAR struct tcp_conn_s *conn = NULL;
+  FAR struct tcp_conn_s *listener;
   FAR struct tcp_hdr_s *tcp;
   union ip_binding_u uaddr;
   unsigned int tcpiplen;
@@ -700,6 +660,9 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
   uint16_t tmp16;
   uint16_t result;
   int      len;
+#ifdef CONFIG_NET_TCP_FASTOPEN
+  int      tfo;
+#endif
 
 #ifdef CONFIG_NET_STATISTICS
   /* Bump up the count of TCP packets received */
@@ -766,7 +729,14 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
           if ((tcp->flags & TCP_ACK) != 0)
             {
               ackseq = tcp_getsequence(tcp->ackno);
+#ifdef CONFIG_NET_TCP_FASTOPEN
+              /* The ACK may also cover the data sent with the SYN */
+
+              if (TCP_SEQ_SUB(ackseq, tcp_getsequence(conn->sndseq)) >
+                  conn->tfo_sent)
+#else
               if (ackseq != tcp_getsequence(conn->sndseq))
+#endif
                 {
                   if ((tcp->flags & TCP_RST) != 0)
                     {
@@ -911,9 +881,9 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
 #endif
 
 #if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
-  if ((conn = tcp_findlistener(&uaddr, tmp16, domain)) != NULL)
+  if ((listener = tcp_findlistener(&uaddr, tmp16, domain)) != NULL)
 #else
-  if ((conn = tcp_findlistener(&uaddr, tmp16)) != NULL)
+  if ((listener = tcp_findlistener(&uaddr, tmp16)) != NULL)
 #endif
     {
       /* According rfc793 p65&66, In LISTEN state, first ignore packet
@@ -923,18 +893,67 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
 
       if ((tcp->flags & TCP_CTL) != TCP_SYN)
         {
+#if defined(CONFIG_NET_TCP_REQSOCK) || defined(CONFIG_NET_TCP_SYNCOOKIES)
+          /* The ACK may complete a handshake that has no connection
+           * structure yet.
+           */
+
+          if ((tcp->flags & (TCP_RST | TCP_SYN | TCP_ACK)) == TCP_ACK)
+            {
+              int ret = tcp_reqsock_ack(dev, listener, iplen, &conn);
+              if (ret == OK)
+                {
+                  goto found;
+                }
+              else if (ret != -ENOENT)
+                {
+                  goto drop;
+                }
+            }
+#endif
+
           if ((tcp->flags & TCP_ACK) != 0)
             {
+              conn = listener;
               goto reset;
             }
 
           goto drop;
         }
 
-      if (!tcp_backlogavailable(conn))
+#ifdef CONFIG_NET_TCP_FASTOPEN
+      tfo = tcp_fastopen_syn(dev, listener, iplen);
+#endif
+
+#ifdef CONFIG_NET_TCP_REQSOCK
+      /* Queue the half-open connection without allocating a connection
+       * structure.  A Fast Open SYN with a valid cookie needs one right
+       * away to hold its data.
+       */
+
+#ifdef CONFIG_NET_TCP_FASTOPEN
+      if (tfo != TCP_TFO)
+#endif
         {
+          if (tcp_reqsock_syn(dev, listener, iplen) < 0)
+            {
+              goto drop;
+            }
+
+          return;
+        }
+#endif
+
+#if !defined(CONFIG_NET_TCP_REQSOCK) || defined(CONFIG_NET_TCP_FASTOPEN)
+      if (!tcp_backlogavailable(listener))
+        {
+#ifdef CONFIG_NET_TCP_SYNCOOKIES
+          tcp_syncookie_synack(dev, listener, iplen);
+          return;
+#else
           nerr("ERROR: no free containers for TCP BACKLOG!\n");
           goto drop;
+#endif
         }
 
       /* We matched the incoming packet with a connection in LISTEN.
@@ -946,7 +965,7 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
        * any user application to accept it.
        */
 
-      conn = tcp_alloc_accept(dev, tcp, conn);
+      conn = tcp_alloc_accept(dev, tcp, listener);
       if (conn)
         {
           /* The connection structure was successfully allocated and has
@@ -980,11 +999,16 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
            * or someone waiting to accept the connection.
            */
 
+#ifdef CONFIG_NET_TCP_SYNCOOKIES
+          tcp_syncookie_synack(dev, listener, iplen);
+          return;
+#else
 #ifdef CONFIG_NET_STATISTICS
           g_netstats.tcp.syndrop++;
 #endif
           nerr("ERROR: No free TCP connections\n");
           goto drop;
+#endif
         }
 
       net_incr32(conn->rcvseq, 1); /* ack SYN */
@@ -993,10 +1017,30 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
 
       tcp_parse_option(dev, conn, iplen);
 
+#ifdef CONFIG_NET_TCP_FASTOPEN
+      if (tfo == TCP_TFO)
+        {
+          /* The cookie is valid: queue the data carried by the SYN.  It is
+           * acknowledged by our SYNACK and is ready to be read as soon as
+           * the connection is accepted.
+           */
+
+          len            = (tcp->tcpoffset >> 4) << 2;
+          dev->d_appdata = IPBUF(iplen + len);
+          dev->d_len    -= iplen + len;
+          tcp_callback(dev, conn, TCP_NEWDATA);
+        }
+      else
+        {
+          conn->flags |= tfo;
+        }
+#endif
+
       /* Our response will be a SYNACK. */
 
       tcp_synack(dev, conn, TCP_ACK | TCP_SYN);
       return;
+#endif /* !CONFIG_NET_TCP_REQSOCK || CONFIG_NET_TCP_FASTOPEN */
     }
 
   nwarn("WARNING: SYN with no listener (or old packet) .. reset\n");
@@ -1482,6 +1526,13 @@ skip_rtt:
             net_incr32(conn->rcvseq, 1); /* ack SYN */
             conn->tx_unacked    = 0;
 
+#ifdef CONFIG_NET_TCP_FASTOPEN
+            if ((conn->flags & TCP_TFO) != 0)
+              {
+                tcp_fastopen_connected(conn, tcp_getsequence(tcp->ackno));
+              }
+#endif
+
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
             conn->isn           = tcp_getsequence(tcp->ackno);
             tcp_setsequence(conn->sndseq, conn->isn);
@@ -1848,6 +1899,98 @@ bool tcp_reorder_ofosegs(int nofosegs, FAR struct tcp_ofoseg_s *ofosegs)
   return reordered;
 }
 
+/****************************************************************************
+ * Name: tcp_option_decode
+ *
+ * Description:
+ *   Decode the options of the TCP segment in the device buffer.
+ *
+ * Input Parameters:
+ *   dev   - The device driver structure containing the received segment
+ *   iplen - Length of the IP header (IPv4_HDRLEN or IPv6_HDRLEN)
+ *   opts  - Location to return the options
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   The network is locked.
+ *
+ ****************************************************************************/
+
+void tcp_option_decode(FAR struct net_driver_s *dev, unsigned int iplen,
+                       FAR struct tcp_options_s *opts)
+{
+  FAR struct tcp_hdr_s *tcp = IPBUF(iplen);
+  unsigned int tcpiplen = iplen + TCP_HDRLEN;
+  uint8_t optlen;
+  uint8_t opt;
+  int i;
+
+  memset(opts, 0, sizeof(*opts));
+
+  if ((tcp->tcpoffset & 0xf0) <= 0x50)
+    {
+      return;
+    }
+
+  for (i = 0; i < ((tcp->tcpoffset >> 4) - 5) << 2; )
+    {
+      opt = IPDATA(tcpiplen + i);
+      if (opt == TCP_OPT_END)
+        {
+          /* End of options. */
+
+          break;
+        }
+      else if (opt == TCP_OPT_NOOP)
+        {
+          /* NOP option. */
+
+          ++i;
+          continue;
+        }
+
+      /* All other options have a length field, so that we easily can
+       * skip past them.
+       */
+
+      optlen = IPDATA(tcpiplen + 1 + i);
+      if (opt == TCP_OPT_MSS && optlen == TCP_OPT_MSS_LEN)
+        {
+          opts->mss    = ((uint16_t)IPDATA(tcpiplen + 2 + i) << 8) |
+                          (uint16_t)IPDATA(tcpiplen + 3 + i);
+          opts->flags |= TCP_OPTF_MSS;
+        }
+      else if (opt == TCP_OPT_WS && optlen == TCP_OPT_WS_LEN)
+        {
+          opts->snd_scale = IPDATA(tcpiplen + 2 + i);
+          opts->flags    |= TCP_OPTF_WS;
+        }
+      else if (opt == TCP_OPT_SACK_PERM && optlen == TCP_OPT_SACK_PERM_LEN)
+        {
+          opts->flags |= TCP_OPTF_SACK;
+        }
+      else if (opt == TCP_OPT_FASTOPEN && optlen >= TCP_OPT_FASTOPEN_LEN &&
+               (opts->flags & TCP_OPTF_TFO) == 0)
+        {
+          opts->tfo_cookie = IPBUF(tcpiplen + 2 + i);
+          opts->tfo_len    = optlen - TCP_OPT_FASTOPEN_LEN;
+          opts->flags     |= TCP_OPTF_TFO;
+        }
+      else if (optlen == 0)
+        {
+          /* If the length field is zero, the options are malformed and
+           * we don't process them further.
+           */
+
+          break;
+        }
+
+      i += optlen;
+    }
+}
+
 /****************************************************************************
  * Name: tcp_ipv4_input
  *
@@ -0,0 +1,594 @@
+/****************************************************************************
+ * net/tcp/tcp_reqsock.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#if defined(CONFIG_NET) && defined(CONFIG_NET_TCP) && \
+    (defined(CONFIG_NET_TCP_REQSOCK) || defined(CONFIG_NET_TCP_SYNCOOKIES))
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <nuttx/debug.h>
+
+#include <nuttx/clock.h>
+#include <nuttx/queue.h>
+#include <nuttx/net/netconfig.h>
+#include <nuttx/net/netdev.h>
+#include <nuttx/net/ip.h>
+#include <nuttx/net/tcp.h>
+
+#include "devif/devif.h"
+#include "utils/utils.h"
+#include "tcp/tcp.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define IPDATA(hl) (*(FAR uint8_t *)IPBUF(hl))
+
+/* The default MSS when the peer does not send the option (RFC 1122) */
+
+#define TCP_REQSOCK_DEFMSS 536
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_reqsock_init
+ *
+ * Description:
+ *   Initialize a request structure from the addresses and ports of the
+ *   packet in the device buffer.
+ *
+ ****************************************************************************/
+
+static void tcp_reqsock_init(FAR struct net_driver_s *dev,
+                             unsigned int iplen,
+                             FAR struct tcp_reqsock_s *req)
+{
+  FAR struct tcp_hdr_s *tcp = IPBUF(iplen);
+
+  memset(req, 0, sizeof(*req));
+
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  if (IFF_IS_IPv6(dev->d_flags))
+#endif
+    {
+      FAR struct ipv6_hdr_s *ip = IPv6BUF;
+
+      net_ipv6addr_copy(req->rs_u.ipv6.laddr, ip->destipaddr);
+      net_ipv6addr_copy(req->rs_u.ipv6.raddr, ip->srcipaddr);
+      req->rs_domain = PF_INET6;
+    }
+#endif /* CONFIG_NET_IPv6 */
+
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+  else
+#endif
+    {
+      FAR struct ipv4_hdr_s *ip = IPv4BUF;
+
+      net_ipv4addr_copy(req->rs_u.ipv4.laddr,
+                        net_ip4addr_conv32(ip->destipaddr));
+      net_ipv4addr_copy(req->rs_u.ipv4.raddr,
+                        net_ip4addr_conv32(ip->srcipaddr));
+      req->rs_domain = PF_INET;
+    }
+#endif /* CONFIG_NET_IPv4 */
+
+  req->rs_rport = tcp->srcport;
+}
+
+/****************************************************************************
+ * Name: tcp_reqsock_option
+ *
+ * Description:
+ *   Remember the options of the SYN in the device buffer.  The ACK that
+ *   completes the handshake does not repeat them.
+ *
+ ****************************************************************************/
+
+static void tcp_reqsock_option(FAR struct net_driver_s *dev,
+                               unsigned int iplen,
+                               FAR struct tcp_reqsock_s *req)
+{
+  struct tcp_options_s opts;
+
+  tcp_option_decode(dev, iplen, &opts);
+
+  if ((opts.flags & TCP_OPTF_MSS) != 0)
+    {
+      req->rs_mss = opts.mss;
+    }
+
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  if ((opts.flags & TCP_OPTF_WS) != 0)
+    {
+      req->rs_snd_scale = opts.snd_scale;
+      req->rs_flags    |= TCP_WSCALE;
+    }
+#endif
+
+#ifdef CONFIG_NET_TCP_SELECTIVE_ACK
+  if ((opts.flags & TCP_OPTF_SACK) != 0)
+    {
+      req->rs_flags    |= TCP_SACK;
+    }
+#endif
+
+#ifdef CONFIG_NET_TCP_FASTOPEN
+  if ((opts.flags & TCP_OPTF_TFO) != 0)
+    {
+      /* Answered with a cookie if the listener enabled Fast Open */
+
+      req->rs_flags    |= TCP_TFO_COOKIE;
+    }
+#endif
+}
+
+/****************************************************************************
+ * Name: tcp_reqsock_newconn
+ *
+ * Description:
+ *   Allocate the connection structure of a completed handshake.  The
+ *   connection is left in the TCP_SYN_RCVD state with the SYN-ACK
+ *   outstanding, exactly as if it had been allocated when the SYN was
+ *   received, so that the ACK is then processed by the normal path.
+ *
+ ****************************************************************************/
+
+static FAR struct tcp_conn_s *
+tcp_reqsock_newconn(FAR struct net_driver_s *dev,
+                    FAR struct tcp_conn_s *listener, unsigned int iplen,
+                    FAR const struct tcp_reqsock_s *req)
+{
+  FAR struct tcp_conn_s *conn;
+  uint16_t tcp_mss;
+
+  conn = tcp_alloc_accept(dev, IPBUF(iplen), listener);
+  if (conn == NULL)
+    {
+      return NULL;
+    }
+
+  /* Our SYN (the ISS) is the one outstanding byte */
+
+  tcp_setsequence(conn->sndseq, req->rs_iss + 1);
+  conn->rexmit_seq = req->rs_iss;
+#ifdef CONFIG_NET_TCP_WRITE_BUFFERS
+  conn->sndseq_max = req->rs_iss + 1;
+#endif
+
+  tcp_setsequence(conn->rcvseq, req->rs_irs + 1);
+  conn->rcv_adv    = req->rs_irs + 1;
+
+  if (req->rs_mss != 0)
+    {
+      tcp_mss = TCP_MSS(dev, iplen);
+#ifdef CONFIG_NET_TCPPROTO_OPTIONS
+      if (conn->user_mss > 0 && conn->user_mss < tcp_mss)
+        {
+          tcp_mss = conn->user_mss;
+        }
+#endif
+
+      conn->mss = req->rs_mss > tcp_mss ? tcp_mss : req->rs_mss;
+    }
+
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  if ((req->rs_flags & TCP_WSCALE) != 0)
+    {
+      conn->snd_scale = req->rs_snd_scale;
+      conn->rcv_scale = CONFIG_NET_TCP_WINDOW_SCALE_FACTOR;
+    }
+#endif
+
+  conn->flags |= req->rs_flags;
+  conn->crefs  = 1;
+
+  return conn;
+}
+
+#ifdef CONFIG_NET_TCP_REQSOCK
+/****************************************************************************
+ * Name: tcp_reqsock_hash
+ *
+ * Description:
+ *   Select the hash bucket of a request from the remote address and port.
+ *
+ ****************************************************************************/
+
+static unsigned int tcp_reqsock_hash(FAR const struct tcp_reqsock_s *req)
+{
+  uint32_t key = req->rs_rport;
+
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  if (req->rs_domain == PF_INET6)
+#endif
+    {
+      key ^= ((uint32_t)req->rs_u.ipv6.raddr[6] << 16) ^
+             req->rs_u.ipv6.raddr[7];
+    }
+#endif /* CONFIG_NET_IPv6 */
+
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+  else
+#endif
+    {
+      key ^= req->rs_u.ipv4.raddr;
+    }
+#endif /* CONFIG_NET_IPv4 */
+
+  key ^= key >> 16;
+  key ^= key >> 8;
+  return key & (TCP_REQSOCK_NBUCKETS - 1);
+}
+
+/****************************************************************************
+ * Name: tcp_reqsock_match
+ *
+ * Description:
+ *   Return true if the two requests describe the same connection.
+ *
+ ****************************************************************************/
+
+static bool tcp_reqsock_match(FAR const struct tcp_reqsock_s *a,
+                              FAR const struct tcp_reqsock_s *b)
+{
+  if (a->rs_rport != b->rs_rport || a->rs_domain != b->rs_domain)
+    {
+      return false;
+    }
+
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  if (a->rs_domain == PF_INET6)
+#endif
+    {
+      return net_ipv6addr_cmp(a->rs_u.ipv6.raddr, b->rs_u.ipv6.raddr) &&
+             net_ipv6addr_cmp(a->rs_u.ipv6.laddr, b->rs_u.ipv6.laddr);
+    }
+#endif /* CONFIG_NET_IPv6 */
+
+#ifdef CONFIG_NET_IPv4
+  return net_ipv4addr_cmp(a->rs_u.ipv4.raddr, b->rs_u.ipv4.raddr) &&
+         net_ipv4addr_cmp(a->rs_u.ipv4.laddr, b->rs_u.ipv4.laddr);
+#endif /* CONFIG_NET_IPv4 */
+}
+
+/****************************************************************************
+ * Name: tcp_reqsock_find
+ *
+ * Description:
+ *   Find the request matching 'key' in its hash bucket.  Expired requests
+ *   met on the way are returned to the free list.
+ *
+ ****************************************************************************/
+
+static FAR struct tcp_reqsock_s *
+tcp_reqsock_find(FAR struct tcp_backlog_s *bls,
+                 FAR const struct tcp_reqsock_s *key, clock_t now)
+{
+  FAR sq_queue_t *bucket = &bls->bl_synq[tcp_reqsock_hash(key)];
+  FAR struct tcp_reqsock_s *rs;
+  FAR sq_entry_t *entry;
+  FAR sq_entry_t *next;
+
+  sq_for_every_safe(bucket, entry, next)
+    {
+      rs = (FAR struct tcp_reqsock_s *)entry;
+      if (clock_compare(rs->rs_expire, now))
+        {
+          sq_rem(entry, bucket);
+          sq_addfirst(entry, &bls->bl_reqfree);
+        }
+      else if (tcp_reqsock_match(rs, key))
+        {
+          return rs;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: tcp_reqsock_reclaim
+ *
+ * Description:
+ *   Return every expired request of the listener to the free list.
+ *
+ ****************************************************************************/
+
+static void tcp_reqsock_reclaim(FAR struct tcp_backlog_s *bls, clock_t now)
+{
+  FAR struct tcp_reqsock_s *rs;
+  FAR sq_entry_t *entry;
+  FAR sq_entry_t *next;
+  int i;
+
+  for (i = 0; i < TCP_REQSOCK_NBUCKETS; i++)
+    {
+      sq_for_every_safe(&bls->bl_synq[i], entry, next)
+        {
+          rs = (FAR struct tcp_reqsock_s *)entry;
+          if (clock_compare(rs->rs_expire, now))
+            {
+              sq_rem(entry, &bls->bl_synq[i]);
+              sq_addfirst(entry, &bls->bl_reqfree);
+            }
+        }
+    }
+}
+#endif /* CONFIG_NET_TCP_REQSOCK */
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_reqsock_syn
+ *
+ * Description:
+ *   Handle a SYN received on a listener: remember the half-open connection
+ *   in the request table of the backlog (or, if the table or the backlog is
+ *   full, encode it in a SYN cookie) and prepare the SYN-ACK in the device
+ *   buffer.  A retransmitted SYN finds its request and gets the same
+ *   SYN-ACK again.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_REQSOCK
+int tcp_reqsock_syn(FAR struct net_driver_s *dev,
+                    FAR struct tcp_conn_s *listener, unsigned int iplen)
+{
+  FAR struct tcp_backlog_s *bls = listener->backlog;
+  FAR struct tcp_hdr_s *tcp = IPBUF(iplen);
+  FAR struct tcp_reqsock_s *rs;
+  struct tcp_reqsock_s req;
+  clock_t now = clock_systime_ticks();
+
+  if (bls == NULL)
+    {
+      return -ENOTCONN;
+    }
+
+  tcp_reqsock_init(dev, iplen, &req);
+  req.rs_irs = tcp_getsequence(tcp->seqno);
+
+  rs = tcp_reqsock_find(bls, &req, now);
+  if (rs == NULL)
+    {
+      if (!tcp_backlogavailable(listener))
+        {
+          goto overflow;
+        }
+
+      if (sq_empty(&bls->bl_reqfree))
+        {
+          tcp_reqsock_reclaim(bls, now);
+          if (sq_empty(&bls->bl_reqfree))
+            {
+              goto overflow;
+            }
+        }
+
+      rs = (FAR struct tcp_reqsock_s *)sq_remfirst(&bls->bl_reqfree);
+      sq_addlast(&rs->rs_node, &bls->bl_synq[tcp_reqsock_hash(&req)]);
+    }
+  else if (rs->rs_irs == req.rs_irs)
+    {
+      /* The SYN-ACK was lost, send it again */
+
+      tcp_synack_stateless(dev, listener, rs->rs_iss, rs->rs_flags);
+      return OK;
+    }
+
+  /* A new request, or a new SYN from the same peer port with another
+   * sequence number which replaces the old request.
+   */
+
+  tcp_reqsock_option(dev, iplen, &req);
+#ifdef CONFIG_NET_TCP_FASTOPEN
+  if ((listener->flags & TCP_TFO) == 0)
+    {
+      req.rs_flags &= ~TCP_TFO_COOKIE;
+    }
+#endif
+
+  req.rs_iss    = tcp_isn(&req.rs_u, req.rs_domain, tcp->destport,
+                          req.rs_rport);
+  req.rs_expire = now + SEC2TICK(CONFIG_NET_TCP_REQSOCK_TIMEOUT);
+  req.rs_node   = rs->rs_node;
+  *rs           = req;
+
+  ninfo("SYN queued on port %d\n", NTOHS(tcp->destport));
+  tcp_synack_stateless(dev, listener, rs->rs_iss, rs->rs_flags);
+  return OK;
+
+overflow:
+#ifdef CONFIG_NET_TCP_SYNCOOKIES
+  tcp_syncookie_synack(dev, listener, iplen);
+  return OK;
+#else
+#ifdef CONFIG_NET_STATISTICS
+  g_netstats.tcp.syndrop++;
+#endif
+  nwarn("WARNING: SYN queue of port %d is full\n", NTOHS(tcp->destport));
+  return -ENOBUFS;
+#endif
+}
+#endif /* CONFIG_NET_TCP_REQSOCK */
+
+/****************************************************************************
+ * Name: tcp_reqsock_ack
+ *
+ * Description:
+ *   Handle an ACK received on a listener: if it completes a half-open
+ *   connection (or carries a valid SYN cookie), allocate the connection
+ *   structure.
+ *
+ * Returned Value:
+ *   OK on success; -ENOENT if the ACK matches no half-open connection;
+ *   any other negated errno value if the ACK must be dropped.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+int tcp_reqsock_ack(FAR struct net_driver_s *dev,
+                    FAR struct tcp_conn_s *listener, unsigned int iplen,
+                    FAR struct tcp_conn_s **newconn)
+{
+  FAR struct tcp_hdr_s *tcp = IPBUF(iplen);
+  struct tcp_reqsock_s req;
+#ifdef CONFIG_NET_TCP_REQSOCK
+  FAR struct tcp_backlog_s *bls = listener->backlog;
+  FAR struct tcp_reqsock_s *rs;
+#endif
+
+  tcp_reqsock_init(dev, iplen, &req);
+  req.rs_irs = tcp_getsequence(tcp->seqno) - 1;
+  req.rs_iss = tcp_getsequence(tcp->ackno) - 1;
+
+#ifdef CONFIG_NET_TCP_REQSOCK
+  rs = bls != NULL ? tcp_reqsock_find(bls, &req, clock_systime_ticks()) :
+                     NULL;
+  /* An ACK for another ISS than the queued request's may still carry a
+   * valid SYN cookie: the request may be a stale one left behind by an
+   * earlier SYN of the same peer.
+   */
+
+  if (rs != NULL && rs->rs_iss == req.rs_iss)
+    {
+      if (rs->rs_irs != req.rs_irs)
+        {
+          return -EINVAL;
+        }
+
+      /* Leave the request in place if the connection cannot be created
+       * now, the peer will retransmit.
+       */
+
+      if (!tcp_backlogavailable(listener))
+        {
+          return -ENOBUFS;
+        }
+
+      *newconn = tcp_reqsock_newconn(dev, listener, iplen, rs);
+      if (*newconn == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      sq_rem(&rs->rs_node, &bls->bl_synq[tcp_reqsock_hash(rs)]);
+      sq_addfirst(&rs->rs_node, &bls->bl_reqfree);
+      return OK;
+    }
+#endif
+
+#ifdef CONFIG_NET_TCP_SYNCOOKIES
+  req.rs_mss = tcp_syncookie_check(&req.rs_u, req.rs_domain, tcp->destport,
+                                   req.rs_rport, req.rs_irs, req.rs_iss);
+  if (req.rs_mss != 0)
+    {
+      if (!tcp_backlogavailable(listener))
+        {
+          return -ENOBUFS;
+        }
+
+      ninfo("SYN cookie accepted on port %d\n", NTOHS(tcp->destport));
+      *newconn = tcp_reqsock_newconn(dev, listener, iplen, &req);
+      if (*newconn == NULL)
+        {
+          return -ENOMEM;
+        }
+
+#ifdef CONFIG_NET_TCP_REQSOCK
+      /* The connection supersedes the stale request */
+
+      if (rs != NULL)
+        {
+          sq_rem(&rs->rs_node, &bls->bl_synq[tcp_reqsock_hash(rs)]);
+          sq_addfirst(&rs->rs_node, &bls->bl_reqfree);
+        }
+#endif
+
+      return OK;
+    }
+#endif
+
+  return -ENOENT;
+}
+
+/****************************************************************************
+ * Name: tcp_syncookie_synack
+ *
+ * Description:
+ *   Answer a SYN that cannot be queued with a SYN cookie SYN-ACK.  Only the
+ *   MSS option is negotiated: the cookie has no room for the others.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_SYNCOOKIES
+void tcp_syncookie_synack(FAR struct net_driver_s *dev,
+                          FAR struct tcp_conn_s *listener,
+                          unsigned int iplen)
+{
+  FAR struct tcp_hdr_s *tcp = IPBUF(iplen);
+  struct tcp_reqsock_s req;
+  uint32_t iss;
+
+  tcp_reqsock_init(dev, iplen, &req);
+  tcp_reqsock_option(dev, iplen, &req);
+  if (req.rs_mss == 0)
+    {
+      req.rs_mss = TCP_REQSOCK_DEFMSS;
+    }
+
+  iss = tcp_syncookie_make(&req.rs_u, req.rs_domain, tcp->destport,
+                           req.rs_rport, tcp_getsequence(tcp->seqno),
+                           &req.rs_mss);
+
+  ninfo("SYN cookie sent on port %d\n", NTOHS(tcp->destport));
+  tcp_synack_stateless(dev, listener, iss, 0);
+}
+#endif /* CONFIG_NET_TCP_SYNCOOKIES */
+
+#endif /* CONFIG_NET && CONFIG_NET_TCP && (REQSOCK || SYNCOOKIES) */
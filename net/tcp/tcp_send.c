@@ -673,14 +673,208 @@ void tcp_synack(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
     }
 #endif
 
+#ifdef CONFIG_NET_TCP_FASTOPEN
+  if ((conn->flags & (TCP_TFO | TCP_TFO_COOKIE)) != 0)
+    {
+      optlen += tcp_fastopen_option(conn, &tcp->optdata[optlen]);
+    }
+#endif
+
   tcp->tcpoffset         = ((TCP_HDRLEN + optlen) / 4) << 4;
   dev->d_len            += optlen;
 
+#ifdef CONFIG_NET_TCP_FASTOPEN
+  /* A Fast Open client with a cookie sends its data along with the SYN */
+
+  if (conn->tfo_len > 0)
+    {
+      dev->d_len += tcp_fastopen_syndata(dev, conn);
+    }
+#endif
+
   /* Complete the common portions of the TCP message */
 
   tcp_sendcommon(dev, conn, tcp);
 }
 
+/****************************************************************************
+ * Name: tcp_synack_stateless
+ *
+ * Description:
+ *   Answer the SYN in the device buffer with a SYN-ACK without any
+ *   connection structure.  Like tcp_reset(), the reply is built in place
+ *   from the received SYN.
+ *
+ * Input Parameters:
+ *   dev      - The device driver structure holding the received SYN
+ *   listener - The listening connection
+ *   iss      - Our initial sequence number
+ *   flags    - TCP_WSCALE, TCP_SACK and/or TCP_TFO_COOKIE if these options
+ *              are to be sent
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_NET_TCP_REQSOCK) || defined(CONFIG_NET_TCP_SYNCOOKIES)
+void tcp_synack_stateless(FAR struct net_driver_s *dev,
+                          FAR struct tcp_conn_s *listener,
+                          uint32_t iss, uint8_t flags)
+{
+  FAR struct tcp_hdr_s *tcp;
+  uint32_t recvwndo;
+  uint16_t tcp_mss;
+  uint16_t tmp16;
+  int16_t optlen = 0;
+
+  if (dev->d_iob == NULL)
+    {
+      return;
+    }
+
+  tcp = tcp_header(dev);
+
+  /* Acknowledge the SYN of the peer and send our own */
+
+  tcp_setsequence(tcp->ackno, tcp_getsequence(tcp->seqno) + 1);
+  tcp_setsequence(tcp->seqno, iss);
+
+  /* Swap port numbers. */
+
+  tmp16         = tcp->srcport;
+  tcp->srcport  = tcp->destport;
+  tcp->destport = tmp16;
+
+  tcp->flags    = TCP_SYN | TCP_ACK;
+
+#ifdef CONFIG_NET_TCPPROTO_OPTIONS
+  if (listener->user_mss != 0 && listener->user_mss < tcp_rx_mss(dev))
+    {
+      tcp_mss = listener->user_mss;
+    }
+  else
+#endif
+    {
+      tcp_mss = tcp_rx_mss(dev);
+    }
+
+  tcp->optdata[optlen++] = TCP_OPT_MSS;
+  tcp->optdata[optlen++] = TCP_OPT_MSS_LEN;
+  tcp->optdata[optlen++] = tcp_mss >> 8;
+  tcp->optdata[optlen++] = tcp_mss & 0xff;
+
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  if ((flags & TCP_WSCALE) != 0)
+    {
+      tcp->optdata[optlen++] = TCP_OPT_NOOP;
+      tcp->optdata[optlen++] = TCP_OPT_WS;
+      tcp->optdata[optlen++] = TCP_OPT_WS_LEN;
+      tcp->optdata[optlen++] = CONFIG_NET_TCP_WINDOW_SCALE_FACTOR;
+    }
+#endif
+
+#ifdef CONFIG_NET_TCP_SELECTIVE_ACK
+  if ((flags & TCP_SACK) != 0)
+    {
+      tcp->optdata[optlen++] = TCP_OPT_NOOP;
+      tcp->optdata[optlen++] = TCP_OPT_NOOP;
+      tcp->optdata[optlen++] = TCP_OPT_SACK_PERM;
+      tcp->optdata[optlen++] = TCP_OPT_SACK_PERM_LEN;
+    }
+#endif
+
+#ifdef CONFIG_NET_TCP_FASTOPEN
+  if ((flags & TCP_TFO_COOKIE) != 0)
+    {
+      optlen += tcp_fastopen_peeroption(dev, &tcp->optdata[optlen]);
+    }
+#endif
+
+  tcp->tcpoffset = ((TCP_HDRLEN + optlen) / 4) << 4;
+
+  /* The window of a SYN segment is never scaled (RFC 7323) */
+
+  recvwndo = tcp_get_recvwindow(dev, listener);
+  if (recvwndo > UINT16_MAX)
+    {
+      recvwndo = UINT16_MAX;
+    }
+
+  tcp->wnd[0]  = recvwndo >> 8;
+  tcp->wnd[1]  = recvwndo & 0xff;
+  tcp->urgp[0] = 0;
+  tcp->urgp[1] = 0;
+
+  /* Set the packet length and build the IP header in place */
+
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  if (IFF_IS_IPv6(dev->d_flags))
+#endif
+    {
+      FAR struct ipv6_hdr_s *ipv6 = IPv6BUF;
+
+      dev->d_len = IPv6TCP_HDRLEN + optlen;
+      iob_update_pktlen(dev->d_iob, dev->d_len, false);
+
+      ipv6_build_header(ipv6, dev->d_len - IPv6_HDRLEN,
+                        IP_PROTO_TCP,
+                        netdev_ipv6_srcaddr(dev, ipv6->destipaddr),
+                        ipv6->srcipaddr,
+                        listener->sconn.s_ttl, listener->sconn.s_tclass);
+      tcp->tcpchksum = 0;
+
+#ifdef CONFIG_NET_TCP_CHECKSUMS
+      if ((dev->d_features & NETDEV_TX_CSUM) == 0)
+        {
+          tcp->tcpchksum = ~tcp_ipv6_chksum(dev);
+        }
+#endif
+
+#ifdef CONFIG_NET_STATISTICS
+      g_netstats.ipv6.sent++;
+#endif
+    }
+#endif /* CONFIG_NET_IPv6 */
+
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+  else
+#endif
+    {
+      FAR struct ipv4_hdr_s *ipv4 = IPv4BUF;
+
+      dev->d_len = IPv4TCP_HDRLEN + optlen;
+      iob_update_pktlen(dev->d_iob, dev->d_len, false);
+
+      ipv4_build_header(IPv4BUF, dev->d_len, IP_PROTO_TCP,
+                        &dev->d_ipaddr, (FAR in_addr_t *)ipv4->srcipaddr,
+                        listener->sconn.s_ttl, listener->sconn.s_tos, NULL);
+      tcp->tcpchksum = 0;
+
+#ifdef CONFIG_NET_TCP_CHECKSUMS
+      if ((dev->d_features & NETDEV_TX_CSUM) == 0)
+        {
+          tcp->tcpchksum = ~tcp_ipv4_chksum(dev);
+        }
+#endif
+
+#ifdef CONFIG_NET_STATISTICS
+      g_netstats.ipv4.sent++;
+#endif
+    }
+#endif /* CONFIG_NET_IPv4 */
+
+#ifdef CONFIG_NET_STATISTICS
+  g_netstats.tcp.sent++;
+#endif
+}
+#endif /* CONFIG_NET_TCP_REQSOCK || CONFIG_NET_TCP_SYNCOOKIES */
+
 /****************************************************************************
  * Name: tcp_send_txnotify
  *
@@ -85,9 +85,11 @@ static uint32_t g_tcpsequence;
  ****************************************************************************/
 
 #ifdef CONFIG_NET_TCP_ISN_RFC6528
-static uint32_t tcp_isn_rfc6528(FAR struct tcp_conn_s *conn)
+static uint32_t tcp_isn_rfc6528(FAR const union ip_binding_u *u,
+                                uint8_t domain, uint16_t lport,
+                                uint16_t rport)
 {
-  const size_t addrlen = net_ip_domain_select(conn->domain,
+  const size_t addrlen = net_ip_domain_select(domain,
                                   sizeof(in_addr_t), sizeof(net_ipv6addr_t));
   MD5_CTX ctx;
   uint32_t digest[MD5_DIGEST_LENGTH / 4];
@@ -110,10 +112,10 @@ static uint32_t tcp_isn_rfc6528(FAR struct tcp_conn_s *conn)
 
   /* Calculate F(localip, localport, remoteip, remoteport, secretkey) */
 
-  md5update(&ctx, net_ip_binding_laddr(&conn->u, conn->domain), addrlen);
-  md5update(&ctx, &conn->lport, sizeof(conn->lport));
-  md5update(&ctx, net_ip_binding_raddr(&conn->u, conn->domain), addrlen);
-  md5update(&ctx, &conn->rport, sizeof(conn->rport));
+  md5update(&ctx, net_ip_binding_laddr(u, domain), addrlen);
+  md5update(&ctx, &lport, sizeof(lport));
+  md5update(&ctx, net_ip_binding_raddr(u, domain), addrlen);
+  md5update(&ctx, &rport, sizeof(rport));
   md5update(&ctx, g_tcp_isnkey, sizeof(g_tcp_isnkey));
 
   md5final((FAR uint8_t *)digest, &ctx);
@@ -193,22 +195,23 @@ uint32_t tcp_addsequence(FAR uint8_t *seqno, uint16_t len)
 }
 
 /****************************************************************************
- * Name: tcp_initsequence
+ * Name: tcp_isn
  *
  * Description:
- *   Set the (initial) the TCP/IP sequence number when a TCP connection is
- *   established.
+ *   Return the initial sequence number for a connection described by its
+ *   addresses and ports (in network order).  This is used by the listen
+ *   logic before any connection structure exists.
  *
  * Assumptions:
- *   This function must be called with the network locked if seqno refers
- *   to a shared, global resource.
+ *   This function must be called with the network locked.
  *
  ****************************************************************************/
 
-void tcp_initsequence(FAR struct tcp_conn_s *conn)
+uint32_t tcp_isn(FAR const union ip_binding_u *u, uint8_t domain,
+                 uint16_t lport, uint16_t rport)
 {
 #ifdef CONFIG_NET_TCP_ISN_RFC6528
-  tcp_setsequence(conn->sndseq, tcp_isn_rfc6528(conn));
+  return tcp_isn_rfc6528(u, domain, lport, rport);
 #else
   /* If g_tcpsequence is already initialized, just copy it */
 
@@ -230,10 +233,31 @@ void tcp_initsequence(FAR struct tcp_conn_s *conn)
         }
     }
 
-  tcp_setsequence(conn->sndseq, g_tcpsequence);
+  return g_tcpsequence;
 #endif
 }
 
+/****************************************************************************
+ * Name: tcp_initsequence
+ *
+ * Description:
+ *   Set the (initial) the TCP/IP sequence number when a TCP connection is
+ *   established.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked if seqno refers
+ *   to a shared, global resource.
+ *
+ ****************************************************************************/
+
+void tcp_initsequence(FAR struct tcp_conn_s *conn)
+{
+  uint8_t domain = net_ip_domain_select(conn->domain, PF_INET, PF_INET6);
+
+  tcp_setsequence(conn->sndseq, tcp_isn(&conn->u, domain,
+                                        conn->lport, conn->rport));
+}
+
 /****************************************************************************
  * Name: tcp_nextsequence
  *
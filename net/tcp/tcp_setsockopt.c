@@ -263,6 +263,23 @@ int tcp_setsockopt(FAR struct socket *psock, int option,
           }
         break;
 
+#ifdef CONFIG_NET_TCP_FASTOPEN
+      case TCP_FASTOPEN: /* Issue Fast Open cookies on a listener */
+        if (value_len != sizeof(int))
+          {
+            ret = -EINVAL;
+          }
+        else if (*(FAR int *)value > 0)
+          {
+            conn->flags |= TCP_TFO;
+          }
+        else
+          {
+            conn->flags &= ~TCP_TFO;
+          }
+        break;
+#endif
+
       default:
         nerr("ERROR: Unrecognized TCP option: %d\n", option);
         ret = -ENOPROTOOPT;
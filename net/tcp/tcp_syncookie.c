@@ -0,0 +1,208 @@
+/****************************************************************************
+ * net/tcp/tcp_syncookie.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#if defined(CONFIG_NET) && defined(CONFIG_NET_TCP) && \
+    defined(CONFIG_NET_TCP_SYNCOOKIES)
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/param.h>
+
+#include <crypto/siphash.h>
+#include <nuttx/clock.h>
+#include <nuttx/net/netconfig.h>
+
+#include "tcp/tcp.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The cookie is laid out as in the classic BSD/Linux scheme:
+ *
+ *   cookie = H0(addrs, ports) + irs + (count << 24) +
+ *            ((H1(addrs, ports, count) + mssind) & 0xffffff)
+ *
+ * where count is a minute counter.  The top 8 bits carry the counter so
+ * that a cookie older than TCP_SYNCOOKIE_MAXAGE minutes is rejected, the
+ * low 24 bits authenticate the MSS index.
+ */
+
+#define TCP_SYNCOOKIE_BITS    24
+#define TCP_SYNCOOKIE_MASK    (((uint32_t)1 << TCP_SYNCOOKIE_BITS) - 1)
+#define TCP_SYNCOOKIE_MAXAGE  2
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* MSS values that can be encoded in a cookie */
+
+static const uint16_t g_syncookie_msstab[] =
+{
+  536, 1220, 1440, 1460
+};
+
+static SIPHASH_KEY g_syncookie_key;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_syncookie_hash
+ *
+ * Description:
+ *   Keyed hash of the connection addresses, the counter and a selector.
+ *
+ ****************************************************************************/
+
+static uint32_t tcp_syncookie_hash(FAR const union ip_binding_u *u,
+                                   uint8_t domain, uint16_t lport,
+                                   uint16_t rport, uint32_t count,
+                                   uint8_t sel)
+{
+  const size_t addrlen = net_ip_domain_select(domain,
+                                  sizeof(in_addr_t), sizeof(net_ipv6addr_t));
+  SIPHASH_CTX ctx;
+
+  /* Make sure we have a secret key */
+
+  if (g_syncookie_key.k0 == 0 && g_syncookie_key.k1 == 0)
+    {
+      arc4random_buf(&g_syncookie_key, sizeof(g_syncookie_key));
+    }
+
+  siphash_init(&ctx, &g_syncookie_key);
+  siphash_update(&ctx, 2, 4, net_ip_binding_laddr(u, domain), addrlen);
+  siphash_update(&ctx, 2, 4, net_ip_binding_raddr(u, domain), addrlen);
+  siphash_update(&ctx, 2, 4, &lport, sizeof(lport));
+  siphash_update(&ctx, 2, 4, &rport, sizeof(rport));
+  siphash_update(&ctx, 2, 4, &count, sizeof(count));
+  siphash_update(&ctx, 2, 4, &sel, sizeof(sel));
+
+  return (uint32_t)siphash_finish(&ctx, 2, 4);
+}
+
+/****************************************************************************
+ * Name: tcp_syncookie_count
+ *
+ * Description:
+ *   Return the current value of the minute counter.
+ *
+ ****************************************************************************/
+
+static inline uint32_t tcp_syncookie_count(void)
+{
+  return TICK2SEC(clock_systime_ticks()) / 60;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_syncookie_make
+ *
+ * Description:
+ *   Generate the SYN cookie (our initial sequence number) for a connection.
+ *   The MSS offered by the peer is rounded down to one of the values that
+ *   can be encoded in the cookie.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+uint32_t tcp_syncookie_make(FAR const union ip_binding_u *u, uint8_t domain,
+                            uint16_t lport, uint16_t rport, uint32_t irs,
+                            FAR uint16_t *mss)
+{
+  uint32_t count = tcp_syncookie_count();
+  uint32_t index;
+
+  for (index = nitems(g_syncookie_msstab) - 1; index > 0; index--)
+    {
+      if (*mss >= g_syncookie_msstab[index])
+        {
+          break;
+        }
+    }
+
+  *mss = g_syncookie_msstab[index];
+
+  return tcp_syncookie_hash(u, domain, lport, rport, 0, 0) + irs +
+         (count << TCP_SYNCOOKIE_BITS) +
+         ((tcp_syncookie_hash(u, domain, lport, rport, count, 1) + index) &
+          TCP_SYNCOOKIE_MASK);
+}
+
+/****************************************************************************
+ * Name: tcp_syncookie_check
+ *
+ * Description:
+ *   Validate a SYN cookie returned by the peer in its ACK.
+ *
+ * Returned Value:
+ *   The MSS encoded in the cookie, or zero if the cookie is not valid.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+uint16_t tcp_syncookie_check(FAR const union ip_binding_u *u,
+                             uint8_t domain, uint16_t lport, uint16_t rport,
+                             uint32_t irs, uint32_t cookie)
+{
+  uint32_t count = tcp_syncookie_count();
+  uint32_t index;
+  uint32_t diff;
+
+  /* Strip the first hash and the sequence of the peer, then check the age
+   * carried in the top bits.
+   */
+
+  cookie -= tcp_syncookie_hash(u, domain, lport, rport, 0, 0) + irs;
+  diff    = (count - (cookie >> TCP_SYNCOOKIE_BITS)) &
+            ((uint32_t)-1 >> TCP_SYNCOOKIE_BITS);
+  if (diff >= TCP_SYNCOOKIE_MAXAGE)
+    {
+      return 0;
+    }
+
+  /* The remaining bits must be the MSS index */
+
+  index = (cookie - tcp_syncookie_hash(u, domain, lport, rport,
+                                       count - diff, 1)) &
+          TCP_SYNCOOKIE_MASK;
+
+  return index < nitems(g_syncookie_msstab) ?
+         g_syncookie_msstab[index] : 0;
+}
+
+#endif /* CONFIG_NET && CONFIG_NET_TCP && CONFIG_NET_TCP_SYNCOOKIES */
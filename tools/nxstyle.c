@@ -711,18 +711,26 @@ static const char *g_white_content_list[] =
 
   /* Ref:
    * fs/zipfs/zip_vfs.c
+   * fs/zipfs/zip_index.c
    */
 
   "unzFile",
   "uLong",
+  "uInt",
   "unzOpen2_64",
   "unzLocateFile",
   "unzOpenCurrentFile",
   "unzClose",
   "unzReadCurrentFile",
   "unzGetCurrentFileInfo64",
+  "unzGetCurrentFileZStreamPos64",
   "unzGoToNextFile",
   "unzGoToFirstFile",
+  "inflateInit2",
+  "inflateReset",
+  "inflatePrime",
+  "inflateSetDictionary",
+  "inflateGetDictionary",
 
   /* Ref:
    * apps/netutils/telnetc/telnetc.c